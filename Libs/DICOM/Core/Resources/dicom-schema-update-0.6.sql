@@ -0,0 +1,64 @@
+-- 
+-- Update of a version 0.5.3 database to the schema 0.6 in place, without
+-- reinserting the files: adds the children counts with their triggers and
+-- the composite indexes used by the queries of ctkDICOMModel
+-- 
+-- Note: the semicolon at the end is necessary for the simple parser to separate
+--       the statements since the SQlite driver does not handle multiple
+--       commands per QSqlQuery::exec call!
+-- Note: keep the result identical to a database created with dicom-schema.sql
+-- ;
+
+ALTER TABLE 'Patients' ADD COLUMN 'StudiesCount' INT NOT NULL DEFAULT 0 ;
+ALTER TABLE 'Studies' ADD COLUMN 'SeriesCount' INT NOT NULL DEFAULT 0 ;
+ALTER TABLE 'Series' ADD COLUMN 'ImagesCount' INT NOT NULL DEFAULT 0 ;
+
+UPDATE 'Series' SET ImagesCount = ( SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID ) ;
+UPDATE 'Studies' SET SeriesCount = ( SELECT COUNT(*) FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID ) ;
+UPDATE 'Patients' SET StudiesCount = ( SELECT COUNT(*) FROM Studies WHERE Studies.PatientsUID = Patients.UID ) ;
+
+DROP INDEX IF EXISTS 'ImagesSeriesIndex' ;
+DROP INDEX IF EXISTS 'SeriesStudyIndex' ;
+DROP INDEX IF EXISTS 'StudiesPatientIndex' ;
+
+CREATE INDEX IF NOT EXISTS 'ImagesSeriesIndex' ON 'Images' ('SeriesInstanceUID', 'Filename');
+CREATE INDEX IF NOT EXISTS 'SeriesStudyIndex' ON 'Series' ('StudyInstanceUID', 'SeriesNumber');
+CREATE INDEX IF NOT EXISTS 'StudiesPatientIndex' ON 'Studies' ('PatientsUID', 'StudyDate');
+CREATE INDEX IF NOT EXISTS 'StudiesDateIndex' ON 'Studies' ('StudyDate');
+CREATE INDEX IF NOT EXISTS 'StudiesModalitiesIndex' ON 'Studies' ('ModalitiesInStudy');
+CREATE INDEX IF NOT EXISTS 'PatientsIDIndex' ON 'Patients' ('PatientID', 'PatientsName');
+
+CREATE TRIGGER 'ImagesInsertCount' AFTER INSERT ON 'Images' BEGIN
+  UPDATE Series SET ImagesCount = ImagesCount + 1 WHERE SeriesInstanceUID = NEW.SeriesInstanceUID ;
+  END;
+CREATE TRIGGER 'ImagesDeleteCount' AFTER DELETE ON 'Images' BEGIN
+  UPDATE Series SET ImagesCount = ImagesCount - 1 WHERE SeriesInstanceUID = OLD.SeriesInstanceUID ;
+  END;
+CREATE TRIGGER 'ImagesUpdateCount' AFTER UPDATE OF 'SeriesInstanceUID' ON 'Images' BEGIN
+  UPDATE Series SET ImagesCount = ImagesCount - 1 WHERE SeriesInstanceUID = OLD.SeriesInstanceUID ;
+  UPDATE Series SET ImagesCount = ImagesCount + 1 WHERE SeriesInstanceUID = NEW.SeriesInstanceUID ;
+  END;
+CREATE TRIGGER 'SeriesInsertCount' AFTER INSERT ON 'Series' BEGIN
+  UPDATE Series SET ImagesCount = ( SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = NEW.SeriesInstanceUID ) WHERE SeriesInstanceUID = NEW.SeriesInstanceUID ;
+  UPDATE Studies SET SeriesCount = SeriesCount + 1 WHERE StudyInstanceUID = NEW.StudyInstanceUID ;
+  END;
+CREATE TRIGGER 'SeriesDeleteCount' AFTER DELETE ON 'Series' BEGIN
+  UPDATE Studies SET SeriesCount = SeriesCount - 1 WHERE StudyInstanceUID = OLD.StudyInstanceUID ;
+  END;
+CREATE TRIGGER 'SeriesUpdateCount' AFTER UPDATE OF 'StudyInstanceUID' ON 'Series' BEGIN
+  UPDATE Studies SET SeriesCount = SeriesCount - 1 WHERE StudyInstanceUID = OLD.StudyInstanceUID ;
+  UPDATE Studies SET SeriesCount = SeriesCount + 1 WHERE StudyInstanceUID = NEW.StudyInstanceUID ;
+  END;
+CREATE TRIGGER 'StudiesInsertCount' AFTER INSERT ON 'Studies' BEGIN
+  UPDATE Studies SET SeriesCount = ( SELECT COUNT(*) FROM Series WHERE Series.StudyInstanceUID = NEW.StudyInstanceUID ) WHERE StudyInstanceUID = NEW.StudyInstanceUID ;
+  UPDATE Patients SET StudiesCount = StudiesCount + 1 WHERE UID = NEW.PatientsUID ;
+  END;
+CREATE TRIGGER 'StudiesDeleteCount' AFTER DELETE ON 'Studies' BEGIN
+  UPDATE Patients SET StudiesCount = StudiesCount - 1 WHERE UID = OLD.PatientsUID ;
+  END;
+CREATE TRIGGER 'StudiesUpdateCount' AFTER UPDATE OF 'PatientsUID' ON 'Studies' BEGIN
+  UPDATE Patients SET StudiesCount = StudiesCount - 1 WHERE UID = OLD.PatientsUID ;
+  UPDATE Patients SET StudiesCount = StudiesCount + 1 WHERE UID = NEW.PatientsUID ;
+  END;
+
+UPDATE 'SchemaInfo' SET Version = '0.6' ;
@@ -19,9 +19,12 @@ DROP INDEX IF EXISTS 'ImagesFilenameIndex' ;
 DROP INDEX IF EXISTS 'ImagesSeriesIndex' ;
 DROP INDEX IF EXISTS 'SeriesStudyIndex' ;
 DROP INDEX IF EXISTS 'StudiesPatientIndex' ;
+DROP INDEX IF EXISTS 'StudiesDateIndex' ;
+DROP INDEX IF EXISTS 'StudiesModalitiesIndex' ;
+DROP INDEX IF EXISTS 'PatientsIDIndex' ;
 
 CREATE TABLE 'SchemaInfo' ( 'Version' VARCHAR(1024) NOT NULL );
-INSERT INTO 'SchemaInfo' VALUES('0.5.3');
+INSERT INTO 'SchemaInfo' VALUES('0.6');
 
 CREATE TABLE 'Images' (
   'SOPInstanceUID' VARCHAR(64) NOT NULL,
@@ -37,7 +40,8 @@ CREATE TABLE 'Patients' (
   'PatientsBirthTime' TIME NULL ,
   'PatientsSex' varchar(1) NULL ,
   'PatientsAge' varchar(10) NULL ,
-  'PatientsComments' VARCHAR(255) NULL );
+  'PatientsComments' VARCHAR(255) NULL ,
+  'StudiesCount' INT NOT NULL DEFAULT 0 );
 CREATE TABLE 'Series' (
   'SeriesInstanceUID' VARCHAR(64) NOT NULL ,
   'StudyInstanceUID' VARCHAR(64) NOT NULL ,
@@ -53,6 +57,7 @@ CREATE TABLE 'Series' (
   'ScanningSequence' VARCHAR(45) NULL ,
   'EchoNumber' INT NULL ,
   'TemporalPosition' INT NULL ,
+  'ImagesCount' INT NOT NULL DEFAULT 0 ,
   PRIMARY KEY ('SeriesInstanceUID') );
 CREATE TABLE 'Studies' (
   'StudyInstanceUID' VARCHAR(64) NOT NULL ,
@@ -66,12 +71,52 @@ CREATE TABLE 'Studies' (
   'ReferringPhysician' VARCHAR(255) NULL ,
   'PerformingPhysiciansName' VARCHAR(255) NULL ,
   'StudyDescription' VARCHAR(255) NULL ,
+  'SeriesCount' INT NOT NULL DEFAULT 0 ,
   PRIMARY KEY ('StudyInstanceUID') );
 
 CREATE UNIQUE INDEX IF NOT EXISTS 'ImagesFilenameIndex' ON 'Images' ('Filename');
-CREATE INDEX IF NOT EXISTS 'ImagesSeriesIndex' ON 'Images' ('SeriesInstanceUID');
-CREATE INDEX IF NOT EXISTS 'SeriesStudyIndex' ON 'Series' ('StudyInstanceUID');
-CREATE INDEX IF NOT EXISTS 'StudiesPatientIndex' ON 'Studies' ('PatientsUID');
+CREATE INDEX IF NOT EXISTS 'ImagesSeriesIndex' ON 'Images' ('SeriesInstanceUID', 'Filename');
+CREATE INDEX IF NOT EXISTS 'SeriesStudyIndex' ON 'Series' ('StudyInstanceUID', 'SeriesNumber');
+CREATE INDEX IF NOT EXISTS 'StudiesPatientIndex' ON 'Studies' ('PatientsUID', 'StudyDate');
+CREATE INDEX IF NOT EXISTS 'StudiesDateIndex' ON 'Studies' ('StudyDate');
+CREATE INDEX IF NOT EXISTS 'StudiesModalitiesIndex' ON 'Studies' ('ModalitiesInStudy');
+CREATE INDEX IF NOT EXISTS 'PatientsIDIndex' ON 'Patients' ('PatientID', 'PatientsName');
+
+-- The children counts are maintained by the triggers below, the count
+-- of a new parent is computed in case its children were inserted first ;
+
+CREATE TRIGGER 'ImagesInsertCount' AFTER INSERT ON 'Images' BEGIN
+  UPDATE Series SET ImagesCount = ImagesCount + 1 WHERE SeriesInstanceUID = NEW.SeriesInstanceUID ;
+  END;
+CREATE TRIGGER 'ImagesDeleteCount' AFTER DELETE ON 'Images' BEGIN
+  UPDATE Series SET ImagesCount = ImagesCount - 1 WHERE SeriesInstanceUID = OLD.SeriesInstanceUID ;
+  END;
+CREATE TRIGGER 'ImagesUpdateCount' AFTER UPDATE OF 'SeriesInstanceUID' ON 'Images' BEGIN
+  UPDATE Series SET ImagesCount = ImagesCount - 1 WHERE SeriesInstanceUID = OLD.SeriesInstanceUID ;
+  UPDATE Series SET ImagesCount = ImagesCount + 1 WHERE SeriesInstanceUID = NEW.SeriesInstanceUID ;
+  END;
+CREATE TRIGGER 'SeriesInsertCount' AFTER INSERT ON 'Series' BEGIN
+  UPDATE Series SET ImagesCount = ( SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = NEW.SeriesInstanceUID ) WHERE SeriesInstanceUID = NEW.SeriesInstanceUID ;
+  UPDATE Studies SET SeriesCount = SeriesCount + 1 WHERE StudyInstanceUID = NEW.StudyInstanceUID ;
+  END;
+CREATE TRIGGER 'SeriesDeleteCount' AFTER DELETE ON 'Series' BEGIN
+  UPDATE Studies SET SeriesCount = SeriesCount - 1 WHERE StudyInstanceUID = OLD.StudyInstanceUID ;
+  END;
+CREATE TRIGGER 'SeriesUpdateCount' AFTER UPDATE OF 'StudyInstanceUID' ON 'Series' BEGIN
+  UPDATE Studies SET SeriesCount = SeriesCount - 1 WHERE StudyInstanceUID = OLD.StudyInstanceUID ;
+  UPDATE Studies SET SeriesCount = SeriesCount + 1 WHERE StudyInstanceUID = NEW.StudyInstanceUID ;
+  END;
+CREATE TRIGGER 'StudiesInsertCount' AFTER INSERT ON 'Studies' BEGIN
+  UPDATE Studies SET SeriesCount = ( SELECT COUNT(*) FROM Series WHERE Series.StudyInstanceUID = NEW.StudyInstanceUID ) WHERE StudyInstanceUID = NEW.StudyInstanceUID ;
+  UPDATE Patients SET StudiesCount = StudiesCount + 1 WHERE UID = NEW.PatientsUID ;
+  END;
+CREATE TRIGGER 'StudiesDeleteCount' AFTER DELETE ON 'Studies' BEGIN
+  UPDATE Patients SET StudiesCount = StudiesCount - 1 WHERE UID = OLD.PatientsUID ;
+  END;
+CREATE TRIGGER 'StudiesUpdateCount' AFTER UPDATE OF 'PatientsUID' ON 'Studies' BEGIN
+  UPDATE Patients SET StudiesCount = StudiesCount - 1 WHERE UID = OLD.PatientsUID ;
+  UPDATE Patients SET StudiesCount = StudiesCount + 1 WHERE UID = NEW.PatientsUID ;
+  END;
 
 CREATE TABLE 'Directories' (
   'Dirname' VARCHAR(1024) ,
@@ -142,6 +142,38 @@ int ctkDICOMDatabaseTest4( int argc, char * argv [] )
     return EXIT_FAILURE;
     }
 
+  //
+  // Test the bulk lookup of several tags
+  //
+  QString studyDescriptionTag("0008,1030");
+  QList<QStringList> values = database.instanceValues(
+    QStringList() << instanceUID, QStringList() << tag << badTag << studyDescriptionTag);
+  if (values.count() != 1 || values[0].count() != 3
+      || values[0][0] != knownSeriesDescription
+      || values[0][1] != QString("")
+      || values[0][2] != database.instanceValue(instanceUID, studyDescriptionTag))
+    {
+    std::cerr << "ctkDICOMDatabase: instanceValues should match instanceValue" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Test the in-memory part of the tag cache
+  //
+  database.resetTagCacheStatistics();
+  database.cachedTag(instanceUID, tag);
+  if (database.tagCacheHits() != 1 || database.tagCacheMisses() != 0)
+    {
+    std::cerr << "ctkDICOMDatabase: cached tag should be answered from memory" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!database.flushTagCache())
+    {
+    std::cerr << "ctkDICOMDatabase: could not write pending tags to the tag cache" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   database.closeDatabase();
 
   std::cerr << "Database is in " << databaseDirectory.path().toStdString() << std::endl;
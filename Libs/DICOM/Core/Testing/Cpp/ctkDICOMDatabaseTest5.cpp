@@ -0,0 +1,133 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QTime>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMDataset.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcuid.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+//------------------------------------------------------------------------------
+// Benchmark of the bulk insert mode: the file given on the command line is
+// duplicated with new instance uids and the copies are inserted with
+// different batch sizes. The number of instances inserted per second is
+// reported for each batch size.
+int ctkDICOMDatabaseTest5( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "ctkDICOMDatabaseTest5: missing dicom filePath argument";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QString dicomFilePath(argv[1]);
+  int numberOfInstances = argc > 2 ? QString(argv[2]).toInt() : 500;
+
+  QDir tempDirectory = QDir::temp();
+  QString instancesDirectoryName("ctkDICOMDatabaseTest5");
+  tempDirectory.mkpath(instancesDirectoryName);
+  QDir instancesDirectory(tempDirectory.filePath(instancesDirectoryName));
+
+  QStringList instanceFiles;
+  ctkDICOMDataset dataset;
+  dataset.InitializeFromFile(dicomFilePath);
+  if (!dataset.IsInitialized())
+    {
+    std::cerr << "ctkDICOMDatabaseTest5: could not read " << qPrintable(dicomFilePath) << std::endl;
+    return EXIT_FAILURE;
+    }
+  char uid[100];
+  for (int i = 0; i < numberOfInstances; ++i)
+    {
+    dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT);
+    dataset.SetElementAsString(DCM_SOPInstanceUID, QString(uid));
+    QString instanceFile = instancesDirectory.filePath(QString("instance%1.dcm").arg(i));
+    if (!dataset.SaveToFile(instanceFile))
+      {
+      std::cerr << "ctkDICOMDatabaseTest5: could not write " << qPrintable(instanceFile) << std::endl;
+      return EXIT_FAILURE;
+      }
+    instanceFiles << instanceFile;
+    }
+
+  QList<int> batchSizes;
+  batchSizes << 1 << 100 << 1000;
+  foreach (int batchSize, batchSizes)
+    {
+    tempDirectory.remove("ctkDICOMDatabaseTest5.sql");
+    tempDirectory.remove("ctkDICOMTagCache.sql");
+
+    ctkDICOMDatabase database;
+    QFileInfo databaseFile(tempDirectory, QString("ctkDICOMDatabaseTest5.sql"));
+    database.openDatabase(databaseFile.absoluteFilePath(),
+                          QString("ctkDICOMDatabaseTest5-%1").arg(batchSize));
+    if (!database.initializeDatabase())
+      {
+      std::cerr << "ctkDICOMDatabase::initializeDatabase() failed." << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    QTime timer;
+    timer.start();
+    database.insertBatch(instanceFiles, false, false, batchSize);
+    int elapsed = qMax(1, timer.elapsed());
+
+    if (database.isBatchInsertActive())
+      {
+      std::cerr << "ctkDICOMDatabase: batch should be ended after insertBatch" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    if (database.allFiles().count() != numberOfInstances)
+      {
+      std::cerr << "ctkDICOMDatabase: expected " << numberOfInstances
+                << " instances in database, found " << database.allFiles().count() << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    std::cout << "batch size " << batchSize << ": "
+              << numberOfInstances << " instances in " << elapsed << " ms, "
+              << (1000.0 * numberOfInstances / elapsed) << " instances/sec" << std::endl;
+
+    database.closeDatabase();
+    }
+
+  foreach (const QString& instanceFile, instanceFiles)
+    {
+    QFile::remove(instanceFile);
+    }
+  tempDirectory.rmdir(instancesDirectoryName);
+
+  return EXIT_SUCCESS;
+}
@@ -88,6 +88,45 @@ int ctkDICOMModelTest1( int argc, char * argv [] )
     qDebug() << model.rowCount() << model.columnCount();
     qDebug() << model.index(0,0);
 
+    // sorting pages through the same rows in another order
+    int patientCount = model.rowCount();
+    model.sort(0, Qt::DescendingOrder);
+    while (model.canFetchMore(QModelIndex()))
+      {
+      model.fetchMore(QModelIndex());
+      }
+    if (model.rowCount() != patientCount)
+      {
+      std::cerr << "ctkDICOMModel: sorting changed the number of patients "
+                << patientCount << " -> " << model.rowCount() << std::endl;
+      return EXIT_FAILURE;
+      }
+    QSqlQuery names("SELECT PatientsName FROM Patients "
+                    "ORDER BY IFNULL(PatientsName, '') DESC, rowid", myCTK.database());
+    for (int row = 0; names.next(); ++row)
+      {
+      QString expected = names.value(0).isNull() ?
+        QString("No description") : names.value(0).toString();
+      QString name = model.data(model.index(row, 0)).toString();
+      if (name != expected)
+        {
+        std::cerr << "ctkDICOMModel: patient " << row << " is "
+                  << qPrintable(name) << " instead of " << qPrintable(expected)
+                  << " when sorted by descending name" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    if (patientCount > 0 && model.hasChildren(model.index(0,0))
+        && model.rowCount(model.index(0,0)) == 0)
+      {
+      model.fetchMore(model.index(0,0));
+      if (model.rowCount(model.index(0,0)) == 0)
+        {
+        std::cerr << "ctkDICOMModel: patient with children has no study" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
     return EXIT_SUCCESS;
   }
   catch (std::exception e)
@@ -0,0 +1,319 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDate>
+#include <QDateTime>
+#include <QDir>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QTime>
+#include <QVariant>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMModel.h"
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+const int ImagesPerSeries = 20;
+const int SeriesPerStudy = 5;
+const int StudiesPerPatient = 2;
+
+//------------------------------------------------------------------------------
+// Fill the tables with generated rows, as many as the given number of
+// instances, without going through files.
+bool populate(QSqlDatabase db, int numberOfInstances)
+{
+  QSqlQuery insertPatient(db);
+  insertPatient.prepare("INSERT INTO Patients ( 'UID', 'PatientsName', 'PatientID', 'PatientsBirthDate' ) VALUES ( NULL, ?, ?, ? )");
+  QSqlQuery insertStudy(db);
+  insertStudy.prepare("INSERT INTO Studies ( 'StudyInstanceUID', 'PatientsUID', 'StudyDate', 'ModalitiesInStudy', 'StudyDescription' ) VALUES ( ?, ?, ?, ?, ? )");
+  QSqlQuery insertSeries(db);
+  insertSeries.prepare("INSERT INTO Series ( 'SeriesInstanceUID', 'StudyInstanceUID', 'SeriesNumber', 'SeriesDescription', 'Modality' ) VALUES ( ?, ?, ?, ?, ? )");
+  QSqlQuery insertImage(db);
+  insertImage.prepare("INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ? )");
+
+  QDate firstDate(2000, 1, 1);
+  QString timestamp = QDateTime::currentDateTime().toString(Qt::ISODate);
+  int imagesPerPatient = ImagesPerSeries * SeriesPerStudy * StudiesPerPatient;
+  int numberOfPatients = qMax(1, numberOfInstances / imagesPerPatient);
+
+  db.transaction();
+  for (int patient = 0; patient < numberOfPatients; ++patient)
+    {
+    insertPatient.bindValue(0, QString("Doe^Name%1").arg(patient));
+    insertPatient.bindValue(1, QString("ID%1").arg(patient));
+    insertPatient.bindValue(2, firstDate.addDays(patient).toString("yyyy-MM-dd"));
+    if (!insertPatient.exec())
+      {
+      return false;
+      }
+    int patientUID = insertPatient.lastInsertId().toInt();
+    for (int study = 0; study < StudiesPerPatient; ++study)
+      {
+      QString studyUID = QString("1.2.3.%1.%2").arg(patient).arg(study);
+      insertStudy.bindValue(0, studyUID);
+      insertStudy.bindValue(1, patientUID);
+      insertStudy.bindValue(2, firstDate.addDays(patient * StudiesPerPatient + study).toString("yyyy-MM-dd"));
+      insertStudy.bindValue(3, study % 2 ? "CT" : "MR");
+      insertStudy.bindValue(4, QString("Head Study%1").arg(patient));
+      if (!insertStudy.exec())
+        {
+        return false;
+        }
+      for (int series = 0; series < SeriesPerStudy; ++series)
+        {
+        QString seriesUID = QString("%1.%2").arg(studyUID).arg(series);
+        insertSeries.bindValue(0, seriesUID);
+        insertSeries.bindValue(1, studyUID);
+        insertSeries.bindValue(2, series);
+        insertSeries.bindValue(3, QString("Axial Series%1").arg(series));
+        insertSeries.bindValue(4, study % 2 ? "CT" : "MR");
+        if (!insertSeries.exec())
+          {
+          return false;
+          }
+        for (int image = 0; image < ImagesPerSeries; ++image)
+          {
+          QString instanceUID = QString("%1.%2").arg(seriesUID).arg(image);
+          insertImage.bindValue(0, instanceUID);
+          insertImage.bindValue(1, "/data/" + instanceUID + ".dcm");
+          insertImage.bindValue(2, seriesUID);
+          insertImage.bindValue(3, timestamp);
+          if (!insertImage.exec())
+            {
+            return false;
+            }
+          }
+        }
+      }
+    }
+  return db.commit();
+}
+
+//------------------------------------------------------------------------------
+int count(QSqlDatabase db, const QString& statement)
+{
+  QSqlQuery query(db);
+  if (!query.exec(statement) || !query.next())
+    {
+    return -1;
+    }
+  return query.value(0).toInt();
+}
+
+//------------------------------------------------------------------------------
+// Number of studies of the patient shown at the given row, which are
+// the ones matching the study search parameters.
+int studyRows(ctkDICOMModel& model, int patientRow)
+{
+  QModelIndex patient = model.index(patientRow, 0);
+  while (model.canFetchMore(patient))
+    {
+    model.fetchMore(patient);
+    }
+  return model.rowCount(patient);
+}
+
+//------------------------------------------------------------------------------
+int searchRows(ctkDICOMModel& model, QSqlDatabase db,
+               const QMap<QString, QVariant>& parameters, int& elapsed)
+{
+  QTime timer;
+  timer.start();
+  model.setDatabase(db, parameters);
+  int rows = model.rowCount();
+  elapsed = timer.elapsed();
+  return rows;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+// Test of the queries of ctkDICOMModel on generated databases: the
+// number of instances of each database is given on the command line
+// (10000 by default, e.g. pass 100000 1000000 to benchmark large ones).
+// The results of showing the patients, searching a name, a description and
+// a date range and expanding a patient are checked, and their time is
+// reported for each size, as well as the children counts kept by the
+// database.
+int ctkDICOMModelTest2( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  QList<int> sizes;
+  for (int i = 1; i < argc; ++i)
+    {
+    sizes << QString(argv[i]).toInt();
+    }
+  if (sizes.isEmpty())
+    {
+    sizes << 10000;
+    }
+
+  QDir tempDirectory = QDir::temp();
+  foreach (int numberOfInstances, sizes)
+    {
+    // the searches below check the patients 0, 1 and 20
+    int imagesPerPatient = ImagesPerSeries * SeriesPerStudy * StudiesPerPatient;
+    if (numberOfInstances < 21 * imagesPerPatient)
+      {
+      std::cerr << "ctkDICOMModelTest2: at least " << 21 * imagesPerPatient
+                << " instances are needed" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    tempDirectory.remove("ctkDICOMModelTest2.sql");
+
+    ctkDICOMDatabase database;
+    QFileInfo databaseFile(tempDirectory, QString("ctkDICOMModelTest2.sql"));
+    database.openDatabase(databaseFile.absoluteFilePath(),
+                          QString("ctkDICOMModelTest2-%1").arg(numberOfInstances));
+    if (!database.initializeDatabase())
+      {
+      std::cerr << "ctkDICOMDatabase::initializeDatabase() failed." << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (database.schemaVersionLoaded() != database.schemaVersion())
+      {
+      std::cerr << "ctkDICOMDatabase: unexpected schema version "
+                << qPrintable(database.schemaVersionLoaded()) << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    QSqlDatabase db = database.database();
+    QTime timer;
+    timer.start();
+    if (!populate(db, numberOfInstances))
+      {
+      std::cerr << "ctkDICOMModelTest2: could not populate the database" << std::endl;
+      return EXIT_FAILURE;
+      }
+    int populateTime = timer.elapsed();
+
+    int images = count(db, "SELECT COUNT(*) FROM Images");
+    if (count(db, "SELECT SUM(ImagesCount) FROM Series") != images
+        || count(db, "SELECT SUM(SeriesCount) FROM Studies") != count(db, "SELECT COUNT(*) FROM Series")
+        || count(db, "SELECT SUM(StudiesCount) FROM Patients") != count(db, "SELECT COUNT(*) FROM Studies"))
+      {
+      std::cerr << "ctkDICOMDatabase: children counts do not match the tables" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    ctkDICOMModel model;
+    int showTime = 0;
+    QMap<QString, QVariant> parameters;
+    int patients = searchRows(model, db, parameters, showTime);
+    if (patients <= 0)
+      {
+      std::cerr << "ctkDICOMModel: no patient shown" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    timer.start();
+    QModelIndex firstPatient = model.index(0, 0);
+    while (model.canFetchMore(firstPatient))
+      {
+      model.fetchMore(firstPatient);
+      }
+    int studies = model.rowCount(firstPatient);
+    int expandTime = timer.elapsed();
+    if (studies != StudiesPerPatient)
+      {
+      std::cerr << "ctkDICOMModel: expected " << StudiesPerPatient
+                << " studies, found " << studies << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    int nameTime = 0;
+    parameters["Name"] = "name1";
+    int namePatients = searchRows(model, db, parameters, nameTime);
+    parameters.clear();
+    if (namePatients <= 0)
+      {
+      std::cerr << "ctkDICOMModel: name search found nothing" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // the studies of patient N are described as "Head StudyN"
+    int descriptionTime = 0;
+    parameters["Study"] = "Study1";
+    searchRows(model, db, parameters, descriptionTime);
+    parameters.clear();
+    if (studyRows(model, 1) != StudiesPerPatient || studyRows(model, 0) != 0)
+      {
+      std::cerr << "ctkDICOMModel: description search found the wrong studies" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // the studies of patient N are dated StudiesPerPatient * N days and
+    // more after 2000-01-01
+    int dateTime = 0;
+    parameters["StartDate"] = "20000101";
+    parameters["EndDate"] = "20000131";
+    searchRows(model, db, parameters, dateTime);
+    parameters.clear();
+    if (studyRows(model, 0) != StudiesPerPatient || studyRows(model, 20) != 0)
+      {
+      std::cerr << "ctkDICOMModel: date range search found the wrong studies" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    timer.start();
+    database.cleanup();
+    int cleanupTime = timer.elapsed();
+
+    // removing all the images of a series leaves an empty series that
+    // cleanup() removes with its counts
+    QSqlQuery removeImages(db);
+    removeImages.exec("DELETE FROM Images WHERE SeriesInstanceUID = '1.2.3.0.0.0'");
+    if (count(db, "SELECT ImagesCount FROM Series WHERE SeriesInstanceUID = '1.2.3.0.0.0'") != 0)
+      {
+      std::cerr << "ctkDICOMDatabase: series count not updated on delete" << std::endl;
+      return EXIT_FAILURE;
+      }
+    database.cleanup();
+    if (count(db, "SELECT COUNT(*) FROM Series WHERE SeriesInstanceUID = '1.2.3.0.0.0'") != 0
+        || count(db, "SELECT SeriesCount FROM Studies WHERE StudyInstanceUID = '1.2.3.0.0'") != SeriesPerStudy - 1)
+      {
+      std::cerr << "ctkDICOMDatabase: cleanup did not remove the empty series" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    std::cout << images << " instances: populated in " << populateTime << " ms, "
+              << "patients shown in " << showTime << " ms, "
+              << "patient expanded in " << expandTime << " ms, "
+              << "name search (" << namePatients << " patients) in " << nameTime << " ms, "
+              << "description search in " << descriptionTime << " ms, "
+              << "date range in " << dateTime << " ms, "
+              << "cleanup in " << cleanupTime << " ms" << std::endl;
+
+    database.closeDatabase();
+    }
+
+  tempDirectory.remove("ctkDICOMModelTest2.sql");
+  return EXIT_SUCCESS;
+}
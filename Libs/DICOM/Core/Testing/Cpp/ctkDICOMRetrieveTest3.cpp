@@ -0,0 +1,147 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QStringList>
+#include <QTime>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMDataset.h"
+#include "ctkDICOMQuery.h"
+#include "ctkDICOMRetrieve.h"
+#include "ctkDICOMTester.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+void ctkDICOMRetrieveTest3PrintUsage()
+{
+  std::cout << " ctkDICOMRetrieveTest3 images" << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Query and retrieve on several associations at once against a local
+// dcmqrscp: the time of the series level queries and of the retrieve of all
+// the studies is reported for 1 and 4 associations. The retrieved files must
+// be complete DICOM files in the database directory.
+int ctkDICOMRetrieveTest3( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  QStringList arguments = app.arguments();
+  arguments.pop_front(); // remove application name
+  arguments.pop_front(); // remove test name
+  if (!arguments.count())
+    {
+    ctkDICOMRetrieveTest3PrintUsage();
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMTester tester;
+  tester.startDCMQRSCP();
+  tester.storeData(arguments);
+
+  QList<int> associations;
+  associations << 1 << 4;
+  foreach(int maximumAssociations, associations)
+    {
+    ctkDICOMDatabase queryDatabase;
+    ctkDICOMQuery query;
+    query.setCallingAETitle("CTK_AE");
+    query.setCalledAETitle("CTK_AE");
+    query.setHost("localhost");
+    query.setPort(tester.dcmqrscpPort());
+    query.setMaximumAssociations(maximumAssociations);
+    if (query.maximumAssociations() != maximumAssociations)
+      {
+      std::cerr << "ctkDICOMQuery::setMaximumAssociations() failed" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    QTime timer;
+    timer.start();
+    if (!query.query(queryDatabase) || query.studyInstanceUIDQueried().count() == 0)
+      {
+      std::cerr << "ctkDICOMQuery::query() failed" << std::endl;
+      return EXIT_FAILURE;
+      }
+    int queryTime = timer.elapsed();
+
+    QString databaseName = QString("ctkDICOMRetrieveTest3-%1.sql").arg(maximumAssociations);
+    QDir::temp().remove(databaseName);
+    QSharedPointer<ctkDICOMDatabase> retrieveDatabase(new ctkDICOMDatabase);
+    retrieveDatabase->openDatabase(QDir::temp().filePath(databaseName), databaseName);
+
+    ctkDICOMRetrieve retrieve;
+    retrieve.setCallingAETitle("CTK_AE");
+    retrieve.setCalledAETitle("CTK_AE");
+    retrieve.setPort(tester.dcmqrscpPort());
+    retrieve.setHost("localhost");
+    retrieve.setDatabase(retrieveDatabase);
+    retrieve.setMaximumAssociations(maximumAssociations);
+
+    timer.start();
+    if (!retrieve.getStudies(query.studyInstanceUIDQueried()))
+      {
+      std::cerr << "ctkDICOMRetrieve::getStudies() failed" << std::endl;
+      return EXIT_FAILURE;
+      }
+    int retrieveTime = timer.elapsed();
+
+    int instances = retrieveDatabase->allFiles().count();
+    if (instances != arguments.count())
+      {
+      std::cerr << "ctkDICOMRetrieve::getStudies() retrieved " << instances
+                << " instances instead of " << arguments.count() << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // the instances are written straight to the database directory
+    foreach(const QString& file, retrieveDatabase->allFiles())
+      {
+      ctkDICOMDataset dataset;
+      dataset.InitializeFromFile(file);
+      if (!file.startsWith(retrieveDatabase->databaseDirectory() + "/dicom/")
+          || !dataset.IsInitialized()
+          || retrieveDatabase->instanceForFile(file) != dataset.GetElementAsString(DCM_SOPInstanceUID))
+        {
+        std::cerr << "ctkDICOMRetrieve::getStudies() stored an invalid file "
+                  << qPrintable(file) << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
+    std::cout << maximumAssociations << " associations: "
+              << query.studyInstanceUIDQueried().count() << " studies queried in "
+              << queryTime << " ms, " << instances << " instances retrieved in "
+              << retrieveTime << " ms" << std::endl;
+
+    retrieveDatabase->closeDatabase();
+    }
+
+  return EXIT_SUCCESS;
+}
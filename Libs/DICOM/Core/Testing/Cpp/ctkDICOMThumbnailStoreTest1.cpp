@@ -0,0 +1,93 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+
+// ctkDICOMCore includes
+#include "ctkDICOMThumbnailStore.h"
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+int ctkDICOMThumbnailStoreTest1( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  QString databaseDirectory = QDir::tempPath();
+  QFile::remove(ctkDICOMThumbnailStore::storeFileName(databaseDirectory));
+
+  QDateTime beforeStore = QDateTime::currentDateTime().addSecs(-2);
+  QByteArray imageData("not really a png");
+
+  {
+    ctkDICOMThumbnailStore store(databaseDirectory);
+    if (!store.isOpen())
+      {
+      std::cerr << "ctkDICOMThumbnailStore: store could not be opened" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    if (store.contains("1.2.3.1") || !store.thumbnail("1.2.3.1").isEmpty())
+      {
+      std::cerr << "ctkDICOMThumbnailStore: new store should be empty" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    if (!store.storeThumbnail("1.2.3.1", "1.2.3", imageData)
+        || !store.storeThumbnail("1.2.3.2", "1.2.3", imageData)
+        || !store.storeThumbnail("1.2.4.1", "1.2.4", imageData))
+      {
+      std::cerr << "ctkDICOMThumbnailStore: could not store thumbnails" << std::endl;
+      return EXIT_FAILURE;
+      }
+  }
+
+  // thumbnails are persistent
+  ctkDICOMThumbnailStore store(databaseDirectory);
+  if (!store.contains("1.2.3.1") || store.thumbnail("1.2.3.1") != imageData)
+    {
+    std::cerr << "ctkDICOMThumbnailStore: stored thumbnail not found" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!store.contains("1.2.3.1", beforeStore)
+      || store.contains("1.2.3.1", QDateTime::currentDateTime().addSecs(60)))
+    {
+    std::cerr << "ctkDICOMThumbnailStore: wrong thumbnail timestamp" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!store.removeThumbnails(QStringList() << "1.2.4.1") || store.contains("1.2.4.1"))
+    {
+    std::cerr << "ctkDICOMThumbnailStore: thumbnail not removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!store.removeSeriesThumbnails("1.2.3")
+      || store.contains("1.2.3.1") || store.contains("1.2.3.2"))
+    {
+    std::cerr << "ctkDICOMThumbnailStore: thumbnails of series not removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -23,6 +23,10 @@
 #include "ctkDICOMAbstractThumbnailGenerator.h"
 #include "ctkLogger.h"
 
+// Qt includes
+#include <QDir>
+#include <QTemporaryFile>
+
 static ctkLogger logger ( "org.commontk.dicom.DICOMAbstractThumbnailGenerator" );
 struct Node;
 
@@ -62,3 +66,21 @@ ctkDICOMAbstractThumbnailGenerator::ctkDICOMAbstractThumbnailGenerator(QObject*
 ctkDICOMAbstractThumbnailGenerator::~ctkDICOMAbstractThumbnailGenerator()
 {
 }
+
+//------------------------------------------------------------------------------
+bool ctkDICOMAbstractThumbnailGenerator::generateThumbnailData(DicomImage* dcmImage, QByteArray& imageData)
+{
+  QTemporaryFile thumbnailFile(QDir::tempPath() + "/ctkDICOMThumbnail-XXXXXX.png");
+  if (!thumbnailFile.open())
+    {
+    logger.error("Could not create temporary thumbnail file " + thumbnailFile.fileName());
+    return false;
+    }
+  thumbnailFile.close();
+  if (!this->generateThumbnail(dcmImage, thumbnailFile.fileName()) || !thumbnailFile.open())
+    {
+    return false;
+    }
+  imageData = thumbnailFile.readAll();
+  return !imageData.isEmpty();
+}
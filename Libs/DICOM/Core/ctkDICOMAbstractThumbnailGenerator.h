@@ -45,6 +45,14 @@ public:
 
   virtual bool generateThumbnail(DicomImage* dcmImage, const QString& path ) = 0;
 
+  /// Render the thumbnail of dcmImage into imageData, encoded in a format
+  /// QImage::loadFromData() understands (e.g. PNG).
+  /// The default implementation renders into a temporary file with
+  /// generateThumbnail(DicomImage*, const QString&) and reads it back,
+  /// subclasses should render directly into memory.
+  /// Called from the thumbnail threads of ctkDICOMDatabase.
+  virtual bool generateThumbnailData(DicomImage* dcmImage, QByteArray& imageData);
+
 protected:
   QScopedPointer<ctkDICOMAbstractThumbnailGeneratorPrivate> d_ptr;
 
@@ -0,0 +1,223 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QMutexLocker>
+
+// ctkDICOMCore includes
+#include "ctkDICOMAssociationPool_p.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdatset.h>
+
+//------------------------------------------------------------------------------
+ctkDICOMAssociationPool::ctkDICOMAssociationPool()
+{
+  this->Threads.setMaxThreadCount(4);
+  this->TotalRequests = 0;
+  this->CompletedRequests = 0;
+  this->FailedRequests = 0;
+  this->FailedAssociations = 0;
+  this->RunningWorkers = 0;
+  this->MaximumPendingResults = 64;
+  this->Canceled = false;
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMAssociationPool::~ctkDICOMAssociationPool()
+{
+  this->cancel();
+  this->waitForDone();
+  qDeleteAll(this->Results);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::setMaximumAssociations(int maximumAssociations)
+{
+  this->Threads.setMaxThreadCount(qMax(1, maximumAssociations));
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::maximumAssociations()const
+{
+  return this->Threads.maxThreadCount();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::setMaximumPendingResults(int maximumPendingResults)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->MaximumPendingResults = qMax(1, maximumPendingResults);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::setRequests(const QList<QStringList>& requests)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->Requests.clear();
+  this->Requests.append(requests);
+  this->TotalRequests = requests.count();
+  this->CompletedRequests = 0;
+  this->FailedRequests = 0;
+  this->FailedAssociations = 0;
+  this->Canceled = false;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::requestCount()const
+{
+  return this->TotalRequests;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::start(const QList<QRunnable*>& workers)
+{
+  QMutexLocker locker(&this->Mutex);
+  foreach(QRunnable* worker, workers)
+    {
+    worker->setAutoDelete(true);
+    ++this->RunningWorkers;
+    this->Threads.start(worker);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMAssociationPool::nextRequest(QStringList& request)
+{
+  QMutexLocker locker(&this->Mutex);
+  if (this->Canceled || this->Requests.isEmpty())
+    {
+    return false;
+    }
+  request = this->Requests.dequeue();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::requestDone(bool success)
+{
+  QMutexLocker locker(&this->Mutex);
+  ++this->CompletedRequests;
+  if (!success)
+    {
+    ++this->FailedRequests;
+    }
+  this->ResultsAvailable.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::associationFailed()
+{
+  QMutexLocker locker(&this->Mutex);
+  ++this->FailedAssociations;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMAssociationPool::addResult(DcmDataset* dataset, const QString& fileName)
+{
+  QMutexLocker locker(&this->Mutex);
+  while (!this->Canceled && this->Results.count() >= this->MaximumPendingResults)
+    {
+    this->ResultsTaken.wait(&this->Mutex);
+    }
+  if (this->Canceled)
+    {
+    delete dataset;
+    return false;
+    }
+  this->Results.append(dataset);
+  this->ResultFileNames.append(fileName);
+  this->ResultsAvailable.wakeAll();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::workerFinished()
+{
+  QMutexLocker locker(&this->Mutex);
+  --this->RunningWorkers;
+  this->ResultsAvailable.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMAssociationPool::takeResults(QList<DcmDataset*>& results, int timeout)
+{
+  QStringList fileNames;
+  return this->takeResults(results, fileNames, timeout);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMAssociationPool::takeResults(QList<DcmDataset*>& results, QStringList& fileNames, int timeout)
+{
+  QMutexLocker locker(&this->Mutex);
+  if (this->Results.isEmpty() && this->RunningWorkers > 0)
+    {
+    this->ResultsAvailable.wait(&this->Mutex, timeout);
+    }
+  results += this->Results;
+  fileNames += this->ResultFileNames;
+  this->Results.clear();
+  this->ResultFileNames.clear();
+  this->ResultsTaken.wakeAll();
+  return this->RunningWorkers > 0 || !results.isEmpty();
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::completedRequests()
+{
+  QMutexLocker locker(&this->Mutex);
+  return this->CompletedRequests;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::failedRequests()
+{
+  QMutexLocker locker(&this->Mutex);
+  return this->FailedRequests;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::failedAssociations()
+{
+  QMutexLocker locker(&this->Mutex);
+  return this->FailedAssociations;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::cancel()
+{
+  QMutexLocker locker(&this->Mutex);
+  this->Canceled = true;
+  this->Requests.clear();
+  this->ResultsTaken.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMAssociationPool::isCanceled()
+{
+  QMutexLocker locker(&this->Mutex);
+  return this->Canceled;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::waitForDone()
+{
+  this->Threads.waitForDone();
+}
@@ -0,0 +1,114 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMAssociationPool_p_h
+#define __ctkDICOMAssociationPool_p_h
+
+// Qt includes
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+#include <QRunnable>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+class DcmDataset;
+
+//------------------------------------------------------------------------------
+/// Runs the requests of a query or a retrieve on several associations to the
+/// same peer at once. Each association is served by one worker thread that
+/// takes the next pending request as soon as its previous one is answered;
+/// the datasets received by the workers are handed over to the thread that
+/// owns the database, which inserts them while the requests go on.
+class ctkDICOMAssociationPool
+{
+public:
+  ctkDICOMAssociationPool();
+  /// Cancels the pending requests and waits for the workers
+  ~ctkDICOMAssociationPool();
+
+  /// Number of associations opened at most, 4 by default
+  void setMaximumAssociations(int maximumAssociations);
+  int maximumAssociations()const;
+
+  /// Number of results that can wait for the database before the workers
+  /// stop reading from the network, 64 by default
+  void setMaximumPendingResults(int maximumPendingResults);
+
+  /// Queue the requests, each one is a list of uids
+  void setRequests(const QList<QStringList>& requests);
+  int requestCount()const;
+
+  /// Start one worker per association, with no more workers than requests.
+  /// The pool takes the ownership of the workers.
+  void start(const QList<QRunnable*>& workers);
+
+  /// Functions called by the workers:
+  /// take the next request, returns false when there is none left
+  bool nextRequest(QStringList& request);
+  /// the previous request of the worker is answered, or failed
+  void requestDone(bool success = true);
+  /// the worker could not negotiate its association and serves no request
+  void associationFailed();
+  /// take the ownership of a received dataset, blocks while there are too
+  /// many results pending. Returns false and deletes the dataset if the pool
+  /// is canceled. fileName is the file the worker already wrote the
+  /// instance to, if any.
+  bool addResult(DcmDataset* dataset, const QString& fileName = QString());
+  /// the worker returns from QRunnable::run()
+  void workerFinished();
+
+  /// Functions called by the thread that owns the database:
+  /// wait at most timeout ms for results, the caller takes the ownership of
+  /// the results. Returns false once all the workers are finished and all
+  /// the results have been taken.
+  bool takeResults(QList<DcmDataset*>& results, int timeout = 100);
+  /// same as above, with the file names given to addResult()
+  bool takeResults(QList<DcmDataset*>& results, QStringList& fileNames, int timeout = 100);
+  /// number of requests answered so far, failed ones included
+  int completedRequests();
+  int failedRequests();
+  /// number of workers that could not negotiate their association
+  int failedAssociations();
+  /// drop the pending requests, the workers finish their current one
+  void cancel();
+  bool isCanceled();
+  /// wait for the workers to return
+  void waitForDone();
+
+protected:
+  QThreadPool Threads;
+  QMutex Mutex;
+  QWaitCondition ResultsAvailable;
+  QWaitCondition ResultsTaken;
+  QQueue<QStringList> Requests;
+  QList<DcmDataset*> Results;
+  QStringList ResultFileNames;
+  int TotalRequests;
+  int CompletedRequests;
+  int FailedRequests;
+  int FailedAssociations;
+  int RunningWorkers;
+  int MaximumPendingResults;
+  bool Canceled;
+};
+
+#endif
@@ -27,18 +27,26 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QAtomicInt>
+#include <QCache>
+#include <QHash>
 #include <QMutexLocker>
+#include <QPair>
+#include <QRunnable>
 #include <QSet>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QStringList>
+#include <QThreadPool>
 #include <QVariant>
+#include <QtConcurrentMap>
 
 // ctkDICOM includes
 #include "ctkDICOMDatabase.h"
 #include "ctkDICOMAbstractThumbnailGenerator.h"
 #include "ctkDICOMDataset.h"
+#include "ctkDICOMThumbnailStore.h"
 
 #include "ctkLogger.h"
 
@@ -66,6 +74,164 @@ static ctkLogger logger("org.commontk.dicom.DICOMDatabase" );
 // tags that do no exist.
 static QString TagNotInInstance("__TAG_NOT_IN_INSTANCE__");
 
+//------------------------------------------------------------------------------
+/// In-memory LRU cache in front of the TagCache table. Each entry holds the
+/// cached tags of one SOPInstanceUID, its cost being the number of tags, so
+/// that all the tags of an instance are removed at once. The entries are
+/// spread over independently locked shards, so that concurrent readers
+/// rarely contend on the same mutex.
+class ctkDICOMTagMemoryCache
+{
+public:
+  ctkDICOMTagMemoryCache(int maxEntries);
+
+  bool find(const QString& sopInstanceUID, const QString& tag, QString& value);
+  void insert(const QString& sopInstanceUID, const QString& tag, const QString& value);
+  void remove(const QString& sopInstanceUID);
+  void clear();
+  void setMaxEntries(int maxEntries);
+
+  QAtomicInt Hits;
+  QAtomicInt Misses;
+
+private:
+  enum { NumberOfShards = 16 };
+  struct Shard
+  {
+    QMutex Mutex;
+    QCache<QString, QHash<QString, QString> > Entries;
+  };
+  Shard& shard(const QString& sopInstanceUID);
+
+  Shard Shards[NumberOfShards];
+};
+
+//------------------------------------------------------------------------------
+ctkDICOMTagMemoryCache::ctkDICOMTagMemoryCache(int maxEntries)
+{
+  this->setMaxEntries(maxEntries);
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMTagMemoryCache::Shard& ctkDICOMTagMemoryCache::shard(const QString& sopInstanceUID)
+{
+  return this->Shards[qHash(sopInstanceUID) % NumberOfShards];
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMTagMemoryCache::find(const QString& sopInstanceUID, const QString& tag, QString& value)
+{
+  Shard& cacheShard = this->shard(sopInstanceUID);
+  QMutexLocker lock(&cacheShard.Mutex);
+  // QCache::object() moves the entry to the front of the LRU list
+  QHash<QString, QString>* cachedTags = cacheShard.Entries.object(sopInstanceUID);
+  QHash<QString, QString>::const_iterator cachedValue;
+  if (!cachedTags || (cachedValue = cachedTags->constFind(tag)) == cachedTags->constEnd())
+    {
+    this->Misses.ref();
+    return false;
+    }
+  this->Hits.ref();
+  value = cachedValue.value();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMTagMemoryCache::insert(const QString& sopInstanceUID, const QString& tag, const QString& value)
+{
+  Shard& cacheShard = this->shard(sopInstanceUID);
+  QMutexLocker lock(&cacheShard.Mutex);
+  // the entry is inserted again to update its cost
+  QHash<QString, QString>* cachedTags = cacheShard.Entries.take(sopInstanceUID);
+  if (!cachedTags)
+    {
+    cachedTags = new QHash<QString, QString>;
+    }
+  cachedTags->insert(tag, value);
+  cacheShard.Entries.insert(sopInstanceUID, cachedTags, cachedTags->size());
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMTagMemoryCache::remove(const QString& sopInstanceUID)
+{
+  Shard& cacheShard = this->shard(sopInstanceUID);
+  QMutexLocker lock(&cacheShard.Mutex);
+  cacheShard.Entries.remove(sopInstanceUID);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMTagMemoryCache::clear()
+{
+  for (int i = 0; i < NumberOfShards; ++i)
+    {
+    QMutexLocker lock(&this->Shards[i].Mutex);
+    this->Shards[i].Entries.clear();
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMTagMemoryCache::setMaxEntries(int maxEntries)
+{
+  for (int i = 0; i < NumberOfShards; ++i)
+    {
+    QMutexLocker lock(&this->Shards[i].Mutex);
+    this->Shards[i].Entries.setMaxCost(qMax(1, maxEntries / NumberOfShards));
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Tags of one file that were not found in the tag cache
+struct ctkDICOMTagRequest
+{
+  QString SOPInstanceUID;
+  QString FileName;
+  QList<DcmTagKey> Tags;
+  /// position of each tag in the list of requested tags
+  QList<int> TagIndexes;
+};
+
+//------------------------------------------------------------------------------
+/// Reads all requested tags of a file with a single header parse, used to
+/// read the files of instanceValues() in parallel
+class ReadTagsFunctor
+{
+public:
+  typedef QStringList result_type;
+
+  QStringList operator()(const ctkDICOMTagRequest& request) const
+  {
+    ctkDICOMDataset dataset;
+    dataset.InitializeFromFileHeader(request.FileName);
+    QStringList values;
+    foreach (const DcmTagKey& tagKey, request.Tags)
+      {
+      values << (dataset.IsInitialized() ? dataset.GetAllElementValuesAsString(tagKey) : QString());
+      }
+    return values;
+  }
+};
+
+class ctkDICOMDatabasePrivate;
+
+//------------------------------------------------------------------------------
+/// Generates the thumbnail of one instance, run by the thumbnail pool of
+/// the database so that inserts don't wait for the pixel data to be rendered
+class ctkDICOMThumbnailTask : public QRunnable
+{
+public:
+  ctkDICOMThumbnailTask(ctkDICOMDatabasePrivate* database,
+                        const QString& studyInstanceUID, const QString& seriesInstanceUID,
+                        const QString& sopInstanceUID, const QString& fileName);
+  virtual void run();
+
+private:
+  ctkDICOMDatabasePrivate* Database;
+  QString StudyInstanceUID;
+  QString SeriesInstanceUID;
+  QString SOPInstanceUID;
+  QString FileName;
+};
+
 //------------------------------------------------------------------------------
 class ctkDICOMDatabasePrivate
 {
@@ -79,6 +245,24 @@ public:
   void init(QString databaseFile);
   void registerCompressionLibraries();
   bool executeScript(const QString script);
+  /// update a database of a known older schema version without reading
+  /// the files again, returns false if there is no such update or if it
+  /// failed. The caller emits schemaUpdateStarted() when
+  /// canMigrateSchema() is true.
+  bool migrateSchema(const QString& version);
+  static bool canMigrateSchema(const QString& version);
+  /// reinitialize the database with the schema and insert all the files
+  /// again, schemaUpdateStarted() is emitted unless already done
+  bool reloadSchema(const char* schemaFile, bool started);
+  /// create the full text tables of the patient names and study and
+  /// series descriptions if they do not exist, returns false if the
+  /// SQLite library has no full text search
+  bool createFullTextIndex();
+  void dropFullTextIndex();
+  /// check whether the full text tables exist, without creating them
+  bool hasFullTextIndex()const;
+  /// the full text tables exist
+  bool FullTextSearch;
   ///
   /// \brief runs a query and prints debug output of status
   ///
@@ -86,6 +270,12 @@ public:
   bool loggedExec(QSqlQuery& query, const QString& queryString);
   bool LoggedExecVerbose;
 
+  ///
+  /// \brief returns a query prepared with the given statement
+  /// While a batch insert is active, the prepared query is kept and
+  /// shared by all further calls with the same statement.
+  QSqlQuery preparedQuery(const QString& statement);
+
   // dataset must be set always
   // filePath has to be set if this is an import of an actual file
   void insert ( const ctkDICOMDataset& ctkDataset, const QString& filePath, bool storeFile = true, bool generateThumbnail = true);
@@ -128,6 +318,46 @@ public:
   /// parallel inserts are not allowed (yet)
   QMutex insertMutex;
 
+  /// state of the bulk insert mode, see ctkDICOMDatabase::beginBatchInsert()
+  bool BatchInsertActive;
+  int BatchSize;
+  int BatchPendingInserts;
+  QHash<QString, QSqlQuery> BatchStatements;
+  /// uid lookups answered from memory while the batch is active
+  QHash<QString, int> BatchPatientUIDs;
+  QSet<QString> BatchStudyInstanceUIDs;
+  QSet<QString> BatchSeriesInstanceUIDs;
+  /// instances of the files removed while the batch is active, their
+  /// thumbnails and the emptied series are removed when the batch ends
+  QSet<QString> BatchRemovedInstances;
+  void removeBatchedFiles();
+
+  /// commit the pending inserts and, if requested, open a new transaction.
+  /// The batch ends if it is not continued or the transaction can not be
+  /// opened, the next inserts are then committed one by one.
+  void commitBatch(bool continueBatch);
+
+  /// thumbnails are generated by ctkDICOMThumbnailTask in their own pool
+  /// and kept in a single packed store in the database directory
+  QThreadPool ThumbnailPool;
+  QScopedPointer<ctkDICOMThumbnailStore> ThumbnailStore;
+  QMutex ThumbnailMutex;
+  /// store of a file based database, created with the first thumbnail.
+  /// In-memory databases have none: their directory is the current one.
+  ctkDICOMThumbnailStore* thumbnailStore(bool create);
+  /// instances with a thumbnail task queued or running
+  QSet<QString> PendingThumbnails;
+  /// series that already got a thumbnail task, the first instance of
+  /// each series is generated first so that every series soon has one
+  QSet<QString> ThumbnailSeries;
+
+  /// queue the generation of a thumbnail unless it is already pending
+  void queueThumbnail(const QString& studyInstanceUID, const QString& seriesInstanceUID,
+                      const QString& sopInstanceUID, const QString& fileName);
+  /// render and store the thumbnail, called from the thumbnail pool
+  void generateThumbnail(const QString& studyInstanceUID, const QString& seriesInstanceUID,
+                         const QString& sopInstanceUID, const QString& fileName);
+
   /// tagCache table has been checked to exist
   bool TagCacheVerified;
   /// tag cache has independent database to avoid locking issue
@@ -136,7 +366,25 @@ public:
   QSqlDatabase TagCacheDatabase;
   QString TagCacheDatabaseFilename;
   QStringList TagsToPrecache;
-  void precacheTags( const QString sopInstanceUID );
+  void precacheTags( const ctkDICOMDataset& dataset, const QString sopInstanceUID );
+
+  /// hot tags are served from memory, see ctkDICOMTagMemoryCache
+  ctkDICOMTagMemoryCache TagMemoryCache;
+  /// cached tags not written to the TagCache table yet (write-behind)
+  QMutex PendingTagsMutex;
+  QHash<QString, QPair<QString, QString> > PendingTags;
+  int PendingTagsBatchSize;
+  /// file name to instance uid, to avoid a query for every fileValue
+  QMutex InstanceForFileMutex;
+  QCache<QString, QString> InstanceForFileCache;
+
+  /// write the pending tags to the TagCache table in one transaction
+  bool flushPendingTags();
+  /// forget everything cached in memory about files and instances
+  void clearMemoryCaches();
+  /// read the tag from the file and cache its value
+  QString readAndCacheTag(const QString& fileName, const QString& sopInstanceUID,
+                          const unsigned short group, const unsigned short element);
 
   int insertPatient(const ctkDICOMDataset& ctkDataset);
   void insertStudy(const ctkDICOMDataset& ctkDataset, int dbPatientID);
@@ -147,11 +395,17 @@ public:
 // ctkDICOMDatabasePrivate methods
 
 //------------------------------------------------------------------------------
-ctkDICOMDatabasePrivate::ctkDICOMDatabasePrivate(ctkDICOMDatabase& o): q_ptr(&o)
+ctkDICOMDatabasePrivate::ctkDICOMDatabasePrivate(ctkDICOMDatabase& o): q_ptr(&o),
+  TagMemoryCache(200000), InstanceForFileCache(50000)
 {
   this->thumbnailGenerator = NULL;
   this->LoggedExecVerbose = false;
   this->TagCacheVerified = false;
+  this->FullTextSearch = false;
+  this->BatchInsertActive = false;
+  this->BatchSize = 1000;
+  this->BatchPendingInserts = 0;
+  this->PendingTagsBatchSize = 500;
   this->resetLastInsertedValues();
 }
 
@@ -164,6 +418,9 @@ void ctkDICOMDatabasePrivate::resetLastInsertedValues()
   this->LastStudyInstanceUID = QString("");
   this->LastSeriesInstanceUID = QString("");
   this->LastPatientUID = -1;
+  this->BatchPatientUIDs.clear();
+  this->BatchStudyInstanceUIDs.clear();
+  this->BatchSeriesInstanceUIDs.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -229,6 +486,251 @@ bool ctkDICOMDatabasePrivate::loggedExec(QSqlQuery& query, const QString& queryS
   return (success);
 }
 
+//------------------------------------------------------------------------------
+QSqlQuery ctkDICOMDatabasePrivate::preparedQuery(const QString& statement)
+{
+  if (this->BatchInsertActive)
+    {
+    QHash<QString, QSqlQuery>::iterator it = this->BatchStatements.find(statement);
+    if (it != this->BatchStatements.end())
+      {
+      return it.value();
+      }
+    }
+  QSqlQuery query(this->Database);
+  query.prepare(statement);
+  if (this->BatchInsertActive)
+    {
+    this->BatchStatements.insert(statement, query);
+    }
+  return query;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::commitBatch(bool continueBatch)
+{
+  // SQLite refuses to commit while statements are still reading
+  foreach (QSqlQuery query, this->BatchStatements)
+    {
+    query.finish();
+    }
+  if (!this->Database.commit())
+    {
+    logger.error("SQLITE ERROR: could not commit batch: " + this->Database.lastError().text());
+    }
+  logger.debug(QString("Committed batch of %1 inserts").arg(this->BatchPendingInserts));
+  this->BatchPendingInserts = 0;
+  if (continueBatch)
+    {
+    if (this->Database.transaction())
+      {
+      return;
+      }
+    logger.error("SQLITE ERROR: could not continue batch: " + this->Database.lastError().text());
+    }
+  this->BatchStatements.clear();
+  this->BatchPatientUIDs.clear();
+  this->BatchStudyInstanceUIDs.clear();
+  this->BatchSeriesInstanceUIDs.clear();
+  this->BatchInsertActive = false;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::removeBatchedFiles()
+{
+  Q_Q(ctkDICOMDatabase);
+  QSet<QString> removedInstances;
+  {
+    QMutexLocker lock(&this->insertMutex);
+    removedInstances = this->BatchRemovedInstances;
+    this->BatchRemovedInstances.clear();
+  }
+  if (removedInstances.isEmpty())
+    {
+    return;
+    }
+
+  // the files inserted again in the batch keep their new thumbnail
+  QStringList thumbnailsToRemove;
+  QSqlQuery instanceExists(this->Database);
+  instanceExists.prepare("SELECT 1 FROM Images WHERE SOPInstanceUID = ?");
+  foreach (const QString& sopInstanceUID, removedInstances)
+    {
+    instanceExists.bindValue(0, sopInstanceUID);
+    if (this->loggedExec(instanceExists) && !instanceExists.next())
+      {
+      thumbnailsToRemove << sopInstanceUID;
+      }
+    instanceExists.finish();
+    }
+  // a pending thumbnail would be stored again after its removal
+  this->ThumbnailPool.waitForDone();
+  ctkDICOMThumbnailStore* store = this->thumbnailStore(false);
+  if (store && !store->removeThumbnails(thumbnailsToRemove))
+    {
+    logger.warn("Failed to remove thumbnails");
+    }
+
+  q->cleanup();
+  this->resetLastInsertedValues();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::flushPendingTags()
+{
+  if (!this->TagCacheDatabase.isOpen())
+    {
+    return false;
+    }
+  QHash<QString, QPair<QString, QString> > pendingTags;
+  {
+    QMutexLocker lock(&this->PendingTagsMutex);
+    pendingTags = this->PendingTags;
+    this->PendingTags.clear();
+  }
+  if (pendingTags.isEmpty())
+    {
+    return true;
+    }
+
+  bool success = true;
+  this->TagCacheDatabase.transaction();
+  QSqlQuery insertTag( this->TagCacheDatabase );
+  insertTag.prepare( "INSERT OR REPLACE INTO TagCache VALUES(:sopInstanceUID, :tag, :value)" );
+  QHash<QString, QPair<QString, QString> >::const_iterator it;
+  for (it = pendingTags.constBegin(); it != pendingTags.constEnd(); ++it)
+    {
+    insertTag.bindValue(":sopInstanceUID", it.value().first);
+    insertTag.bindValue(":tag", it.key().section('|', 1));
+    insertTag.bindValue(":value", it.value().second);
+    success = this->loggedExec(insertTag) && success;
+    }
+  if (!this->TagCacheDatabase.commit())
+    {
+    logger.error("SQLITE ERROR: could not write tag cache: " + this->TagCacheDatabase.lastError().text());
+    success = false;
+    }
+  return success;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::clearMemoryCaches()
+{
+  this->TagMemoryCache.clear();
+  {
+    QMutexLocker lock(&this->InstanceForFileMutex);
+    this->InstanceForFileCache.clear();
+  }
+  QMutexLocker lock(&this->ThumbnailMutex);
+  this->ThumbnailSeries.clear();
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailTask::ctkDICOMThumbnailTask(ctkDICOMDatabasePrivate* database,
+                                             const QString& studyInstanceUID,
+                                             const QString& seriesInstanceUID,
+                                             const QString& sopInstanceUID,
+                                             const QString& fileName)
+  : Database(database), StudyInstanceUID(studyInstanceUID), SeriesInstanceUID(seriesInstanceUID),
+    SOPInstanceUID(sopInstanceUID), FileName(fileName)
+{
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailTask::run()
+{
+  this->Database->generateThumbnail(this->StudyInstanceUID, this->SeriesInstanceUID,
+                                    this->SOPInstanceUID, this->FileName);
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailStore* ctkDICOMDatabasePrivate::thumbnailStore(bool create)
+{
+  Q_Q(ctkDICOMDatabase);
+  QMutexLocker lock(&this->ThumbnailMutex);
+  if (!this->ThumbnailStore && !q->isInMemory()
+      && (create || QFile::exists(ctkDICOMThumbnailStore::storeFileName(q->databaseDirectory()))))
+    {
+    this->ThumbnailStore.reset(new ctkDICOMThumbnailStore(q->databaseDirectory()));
+    }
+  return this->ThumbnailStore.data();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::queueThumbnail(const QString& studyInstanceUID,
+                                             const QString& seriesInstanceUID,
+                                             const QString& sopInstanceUID,
+                                             const QString& fileName)
+{
+  if (!this->thumbnailStore(true))
+    {
+    return;
+    }
+  int priority = 0;
+  {
+    QMutexLocker lock(&this->ThumbnailMutex);
+    if (this->PendingThumbnails.contains(sopInstanceUID))
+      {
+      return;
+      }
+    this->PendingThumbnails.insert(sopInstanceUID);
+    if (!this->ThumbnailSeries.contains(seriesInstanceUID))
+      {
+      this->ThumbnailSeries.insert(seriesInstanceUID);
+      priority = 1;
+      }
+  }
+  this->ThumbnailPool.start(new ctkDICOMThumbnailTask(
+    this, studyInstanceUID, seriesInstanceUID, sopInstanceUID, fileName), priority);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::generateThumbnail(const QString& studyInstanceUID,
+                                                const QString& seriesInstanceUID,
+                                                const QString& sopInstanceUID,
+                                                const QString& fileName)
+{
+  Q_Q(ctkDICOMDatabase);
+  // created by queueThumbnail(), before the task was started
+  ctkDICOMThumbnailStore* store = this->ThumbnailStore.data();
+  bool generated = true;
+  if (!store->contains(sopInstanceUID, QFileInfo(fileName).lastModified()))
+    {
+    DicomImage dcmImage(QDir::toNativeSeparators(fileName).toAscii());
+    QByteArray imageData;
+    generated = this->thumbnailGenerator
+      && this->thumbnailGenerator->generateThumbnailData(&dcmImage, imageData)
+      && store->storeThumbnail(sopInstanceUID, seriesInstanceUID, imageData);
+    if (!generated)
+      {
+      logger.warn("Failed to generate thumbnail for " + fileName);
+      }
+    }
+  {
+    QMutexLocker lock(&this->ThumbnailMutex);
+    this->PendingThumbnails.remove(sopInstanceUID);
+  }
+  if (generated)
+    {
+    emit q->thumbnailGenerated(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+    }
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMDatabasePrivate::readAndCacheTag(const QString& fileName, const QString& sopInstanceUID,
+                                                 const unsigned short group, const unsigned short element)
+{
+  Q_Q(ctkDICOMDatabase);
+  ctkDICOMDataset dataset;
+  dataset.InitializeFromFileHeader(fileName);
+
+  DcmTagKey tagKey(group, element);
+
+  QString value = dataset.GetAllElementValuesAsString(tagKey);
+  q->cacheTag(sopInstanceUID, q->groupElementToTag(group, element), value);
+  return( value );
+}
+
 //------------------------------------------------------------------------------
 void ctkDICOMDatabasePrivate::createBackupFileList()
 {
@@ -267,6 +769,9 @@ void ctkDICOMDatabase::openDatabase(const QString databaseFile, const QString& c
         }
     }
   d->resetLastInsertedValues();
+  // the text tables are created with the schema or by its update, the
+  // database may be read-only here
+  d->FullTextSearch = d->hasFullTextIndex();
 
   if (!isInMemory())
     {
@@ -283,6 +788,15 @@ void ctkDICOMDatabase::openDatabase(const QString databaseFile, const QString& c
   QFileInfo fileInfo(d->DatabaseFileName);
   d->TagCacheDatabaseFilename = QString( fileInfo.dir().path() + "/ctkDICOMTagCache.sql" );
   d->TagCacheVerified = false;
+
+  // thumbnails are stored next to the database, the store is opened
+  // when it exists and created with the first thumbnail otherwise
+  d->ThumbnailPool.waitForDone();
+  {
+    QMutexLocker lock(&d->ThumbnailMutex);
+    d->ThumbnailStore.reset();
+  }
+  d->thumbnailStore(false);
 }
 
 
@@ -310,6 +824,9 @@ ctkDICOMDatabase::ctkDICOMDatabase(QObject* parent)
 //------------------------------------------------------------------------------
 ctkDICOMDatabase::~ctkDICOMDatabase()
 {
+  Q_D(ctkDICOMDatabase);
+  d->ThumbnailPool.waitForDone();
+  d->flushPendingTags();
 }
 
 //----------------------------------------------------------------------------
@@ -345,6 +862,8 @@ const QSqlDatabase& ctkDICOMDatabase::database() const {
 //------------------------------------------------------------------------------
 void ctkDICOMDatabase::setThumbnailGenerator(ctkDICOMAbstractThumbnailGenerator *generator){
   Q_D(ctkDICOMDatabase);
+  // the pending thumbnails are generated with the previous generator
+  d->ThumbnailPool.waitForDone();
   d->thumbnailGenerator = generator;
 }
 
@@ -373,15 +892,33 @@ bool ctkDICOMDatabasePrivate::executeScript(const QString script) {
 
   QSqlQuery query(Database);
 
+  // the statements of a trigger body are kept together up to its END
+  QString trigger;
   for (QStringList::iterator it = sqlCommandsLines.begin(); it != sqlCommandsLines.end()-1; ++it)
     {
-      if (! (*it).startsWith("--") )
+      QString command = (*it).trimmed();
+      if (!trigger.isEmpty())
+        {
+          trigger += " " + command;
+          if (!command.startsWith("END", Qt::CaseInsensitive))
+            {
+              continue;
+            }
+          command = trigger;
+          trigger.clear();
+        }
+      else if (command.startsWith("CREATE TRIGGER", Qt::CaseInsensitive))
+        {
+          trigger = command;
+          continue;
+        }
+      if (! command.isEmpty() && ! command.startsWith("--") )
         {
-          qDebug() << *it << "\n";
-          query.exec(*it);
+          qDebug() << command << "\n";
+          query.exec(command);
           if (query.lastError().type())
             {
-              qDebug() << "There was an error during execution of the statement: " << (*it);
+              qDebug() << "There was an error during execution of the statement: " << command;
               qDebug() << "Error message: " << query.lastError().text();
               return false;
             }
@@ -390,6 +927,150 @@ bool ctkDICOMDatabasePrivate::executeScript(const QString script) {
   return true;
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::createFullTextIndex()
+{
+  this->FullTextSearch = false;
+  QStringList tables = this->Database.tables();
+  if (!tables.contains("Patients") || !tables.contains("Studies") || !tables.contains("Series"))
+    {
+    return false;
+    }
+  if (this->hasFullTextIndex())
+    {
+    this->FullTextSearch = true;
+    return true;
+    }
+
+  // The text tables use the rowid of the indexed rows as docid. The rowid
+  // of Studies and Series is not stable across a VACUUM, which this class
+  // never runs; dropping the text tables rebuilds them at next opening.
+  QStringList textIndexes;
+  textIndexes << "Patients" << "PatientsText" << "UID" << "PatientsName"
+              << "Studies" << "StudiesText" << "rowid" << "StudyDescription"
+              << "Series" << "SeriesText" << "rowid" << "SeriesDescription";
+
+  QSqlQuery query(this->Database);
+  bool transaction = this->Database.transaction();
+  for (int i = 0; i < textIndexes.count(); i += 4)
+    {
+    QString table = textIndexes[i];
+    QString textTable = textIndexes[i + 1];
+    QString key = textIndexes[i + 2];
+    QString column = textIndexes[i + 3];
+    QStringList statements;
+    statements
+      << QString("DROP TABLE IF EXISTS %1").arg(textTable)
+      << QString("CREATE VIRTUAL TABLE %1 USING fts3(%2)").arg(textTable).arg(column)
+      << QString("INSERT INTO %1(docid, %2) SELECT %3, %2 FROM %4").arg(textTable).arg(column).arg(key).arg(table)
+      << QString("CREATE TRIGGER %1Insert AFTER INSERT ON %2 BEGIN "
+                 "INSERT INTO %1(docid, %3) VALUES (NEW.%4, NEW.%3); END").arg(textTable).arg(table).arg(column).arg(key)
+      << QString("CREATE TRIGGER %1Update AFTER UPDATE OF %3 ON %2 BEGIN "
+                 "UPDATE %1 SET %3 = NEW.%3 WHERE docid = NEW.%4; END").arg(textTable).arg(table).arg(column).arg(key)
+      << QString("CREATE TRIGGER %1Delete AFTER DELETE ON %2 BEGIN "
+                 "DELETE FROM %1 WHERE docid = OLD.%3; END").arg(textTable).arg(table).arg(key);
+    foreach(const QString& statement, statements)
+      {
+      if (!query.exec(statement))
+        {
+        // SQLite may be built without the fts3 module, the searches
+        // then fall back to LIKE on the tables themselves
+        logger.warn("Full text search is not available: " + query.lastError().text());
+        if (transaction)
+          {
+          this->Database.rollback();
+          }
+        return false;
+        }
+      }
+    }
+  if (transaction)
+    {
+    this->Database.commit();
+    }
+  this->FullTextSearch = true;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::dropFullTextIndex()
+{
+  QSqlQuery query(this->Database);
+  QStringList textTables;
+  textTables << "PatientsText" << "StudiesText" << "SeriesText";
+  foreach(const QString& textTable, textTables)
+    {
+    // the triggers are dropped with the tables they are defined on
+    query.exec(QString("DROP TABLE IF EXISTS %1").arg(textTable));
+    }
+  this->FullTextSearch = false;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::hasFullTextIndex()const
+{
+  QStringList tables = this->Database.tables();
+  return tables.contains("PatientsText") && tables.contains("StudiesText") && tables.contains("SeriesText");
+}
+
+//------------------------------------------------------------------------------
+// Updates that do not need the files to be read again, in order
+static const char* SchemaMigrations[][3] = {
+  { "0.5.3", "0.6", ":/dicom/dicom-schema-update-0.6.sql" }
+};
+static const int SchemaMigrationCount = sizeof(SchemaMigrations) / sizeof(SchemaMigrations[0]);
+
+//------------------------------------------------------------------------------
+static int firstSchemaMigration(const QString& version)
+{
+  int first = 0;
+  while (first < SchemaMigrationCount && version != SchemaMigrations[first][0])
+    {
+    ++first;
+    }
+  return first;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::canMigrateSchema(const QString& version)
+{
+  return firstSchemaMigration(version) < SchemaMigrationCount;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::migrateSchema(const QString& version)
+{
+  Q_Q(ctkDICOMDatabase);
+  QString loadedVersion = version;
+  int first = firstSchemaMigration(loadedVersion);
+  if (first == SchemaMigrationCount)
+    {
+    return false;
+    }
+
+  // the update is done in a single transaction
+  if (!this->Database.transaction())
+    {
+    return false;
+    }
+  for (int i = first; i < SchemaMigrationCount && loadedVersion != q->schemaVersion(); ++i)
+    {
+    if (!this->executeScript(SchemaMigrations[i][2]))
+      {
+      this->Database.rollback();
+      return false;
+      }
+    loadedVersion = SchemaMigrations[i][1];
+    }
+  if (loadedVersion != q->schemaVersion())
+    {
+    this->Database.rollback();
+    return false;
+    }
+  this->Database.commit();
+  return true;
+}
+
 //------------------------------------------------------------------------------
 QStringList ctkDICOMDatabasePrivate::filenames(QString table)
 {
@@ -411,12 +1092,19 @@ bool ctkDICOMDatabase::initializeDatabase(const char* sqlFileName)
   Q_D(ctkDICOMDatabase);
 
   d->resetLastInsertedValues();
+  d->clearMemoryCaches();
 
   // remove any existing schema info - this handles the case where an
   // old schema should be loaded for testing.
   QSqlQuery dropSchemaInfo(d->Database);
   d->loggedExec( dropSchemaInfo, QString("DROP TABLE IF EXISTS 'SchemaInfo';") );
-  return d->executeScript(sqlFileName);
+  d->dropFullTextIndex();
+  if (!d->executeScript(sqlFileName))
+    {
+    return false;
+    }
+  d->createFullTextIndex();
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -447,16 +1135,36 @@ QString ctkDICOMDatabase::schemaVersion()
   // * make sure the 'Images' contains a 'Filename' column
   //   so that the ctkDICOMDatabasePrivate::filenames method
   //   still works.
+  // * add the in place update from the previous version to
+  //   SchemaMigrations in ctkDICOMDatabase.cpp if the files do not
+  //   need to be read again
   //
-  return QString("0.5.3");
+  return QString("0.6");
 };
 
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::updateSchemaIfNeeded(const char* schemaFile)
 {
-  if ( schemaVersionLoaded() != schemaVersion() )
+  Q_D(ctkDICOMDatabase);
+  QString loadedVersion = schemaVersionLoaded();
+  if ( loadedVersion != schemaVersion() )
     {
-    return this->updateSchema(schemaFile);
+    // known versions of the default schema are updated in place
+    bool started = false;
+    if ( QString(schemaFile) == QString(":/dicom/dicom-schema.sql")
+         && d->canMigrateSchema(loadedVersion) )
+      {
+      emit schemaUpdateStarted(0);
+      started = true;
+      if ( d->migrateSchema(loadedVersion) )
+        {
+        d->clearMemoryCaches();
+        d->createFullTextIndex();
+        emit schemaUpdated();
+        return true;
+        }
+      }
+    return d->reloadSchema(schemaFile, started);
     }
   else
     {
@@ -468,34 +1176,46 @@ bool ctkDICOMDatabase::updateSchemaIfNeeded(const char* schemaFile)
 
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::updateSchema(const char* schemaFile)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->reloadSchema(schemaFile, false);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::reloadSchema(const char* schemaFile, bool started)
 {
   // backup filelist
   // reinit with the new schema
   // reinsert everything
 
-  Q_D(ctkDICOMDatabase);
-  d->createBackupFileList();
+  Q_Q(ctkDICOMDatabase);
+  this->createBackupFileList();
 
-  d->resetLastInsertedValues();
-  this->initializeDatabase(schemaFile);
+  this->resetLastInsertedValues();
+  q->initializeDatabase(schemaFile);
 
-  QStringList allFiles = d->filenames("Filenames_backup");
-  emit schemaUpdateStarted(allFiles.length());
+  QStringList allFiles = this->filenames("Filenames_backup");
+  if (!started)
+    {
+    emit q->schemaUpdateStarted(allFiles.length());
+    }
 
   int progressValue = 0;
+  q->beginBatchInsert();
   foreach(QString file, allFiles)
   {
-    emit schemaUpdateProgress(progressValue);
-    emit schemaUpdateProgress(file);
+    emit q->schemaUpdateProgress(progressValue);
+    emit q->schemaUpdateProgress(file);
 
     // TODO: use QFuture
-    this->insert(file,false,false,true);
+    q->insert(file,false,false,true);
 
     progressValue++;
   }
+  q->endBatchInsert();
   // TODO: check better that everything is ok
-  d->removeBackupFileList();
-  emit schemaUpdated();
+  this->removeBackupFileList();
+  emit q->schemaUpdated();
   return true;
 
 }
@@ -505,6 +1225,10 @@ bool ctkDICOMDatabase::updateSchema(const char* schemaFile)
 void ctkDICOMDatabase::closeDatabase()
 {
   Q_D(ctkDICOMDatabase);
+  this->endBatchInsert();
+  d->ThumbnailPool.waitForDone();
+  d->flushPendingTags();
+  d->clearMemoryCaches();
   d->Database.close();
   d->TagCacheDatabase.close();
 }
@@ -596,6 +1320,14 @@ QString ctkDICOMDatabase::fileForInstance(QString sopInstanceUID)
 QString ctkDICOMDatabase::instanceForFile(QString fileName)
 {
   Q_D(ctkDICOMDatabase);
+  {
+    QMutexLocker lock(&d->InstanceForFileMutex);
+    QString* cachedInstance = d->InstanceForFileCache.object(fileName);
+    if (cachedInstance)
+      {
+      return *cachedInstance;
+      }
+  }
   QSqlQuery query(d->Database);
   query.prepare ( "SELECT SOPInstanceUID FROM Images WHERE Filename=?");
   query.bindValue ( 0, fileName );
@@ -604,6 +1336,8 @@ QString ctkDICOMDatabase::instanceForFile(QString fileName)
   if (query.next())
     {
     result = query.value(0).toString();
+    QMutexLocker lock(&d->InstanceForFileMutex);
+    d->InstanceForFileCache.insert(fileName, new QString(result));
     }
   return( result );
 }
@@ -624,6 +1358,22 @@ QDateTime ctkDICOMDatabase::insertDateTimeForInstance(QString sopInstanceUID)
   return( result );
 }
 
+//------------------------------------------------------------------------------
+QHash<QString, QDateTime> ctkDICOMDatabase::insertDateTimesForAllFiles()
+{
+  Q_D(ctkDICOMDatabase);
+  QSqlQuery query(d->Database);
+  query.prepare ( "SELECT Filename, InsertTimestamp FROM Images" );
+  query.exec();
+  QHash<QString, QDateTime> result;
+  while (query.next())
+    {
+    result.insert(query.value(0).toString(),
+                  QDateTime::fromString(query.value(1).toString(), Qt::ISODate));
+    }
+  return( result );
+}
+
 
 //
 // instance header methods
@@ -658,7 +1408,9 @@ void ctkDICOMDatabase::loadFileHeader (QString fileName)
   Q_D(ctkDICOMDatabase);
   d->LoadedHeader.clear();
   DcmFileFormat fileFormat;
-  OFCondition status = fileFormat.loadFile(fileName.toLatin1().data());
+  // large values like the pixel data are not loaded and printed as such
+  OFCondition status = fileFormat.loadFile(fileName.toLatin1().data(),
+                                           EXS_Unknown, EGL_noChange, 1024);
   if (status.good())
     {
       DcmDataset *dataset = fileFormat.getDataset();
@@ -694,22 +1446,13 @@ QString ctkDICOMDatabase::headerValue (QString key)
   return (d->LoadedHeader[key]);
 }
 
-//
-// instanceValue and fileValue methods
-//
-
-//------------------------------------------------------------------------------
-QString ctkDICOMDatabase::instanceValue(QString sopInstanceUID, QString tag)
-{
-  QString value = this->cachedTag(sopInstanceUID, tag);
-  if (value == TagNotInInstance)
-    {
-    return "";
-    }
-  if (value != "")
-    {
-    return value;
-    }
+//
+// instanceValue and fileValue methods
+//
+
+//------------------------------------------------------------------------------
+QString ctkDICOMDatabase::instanceValue(QString sopInstanceUID, QString tag)
+{
   unsigned short group, element;
   this->tagToGroupElement(tag, group, element);
   return( this->instanceValue(sopInstanceUID, group, element) );
@@ -731,8 +1474,8 @@ QString ctkDICOMDatabase::instanceValue(const QString sopInstanceUID, const unsi
   QString filePath = this->fileForInstance(sopInstanceUID);
   if (filePath != "" )
     {
-    value = this->fileValue(filePath, group, element);
-    return( value );
+    Q_D(ctkDICOMDatabase);
+    return( d->readAndCacheTag(filePath, sopInstanceUID, group, element) );
     }
   else
     {
@@ -746,16 +1489,6 @@ QString ctkDICOMDatabase::fileValue(const QString fileName, QString tag)
 {
   unsigned short group, element;
   this->tagToGroupElement(tag, group, element);
-  QString sopInstanceUID = this->instanceForFile(fileName);
-  QString value = this->cachedTag(sopInstanceUID, tag);
-  if (value == TagNotInInstance)
-    {
-    return "";
-    }
-  if (value != "")
-    {
-    return value;
-    }
   return( this->fileValue(fileName, group, element) );
 }
 
@@ -764,6 +1497,7 @@ QString ctkDICOMDatabase::fileValue(const QString fileName, const unsigned short
 {
   // here is where the real lookup happens
   // - first we check the tagCache to see if the value exists for this instance tag
+  //   (hot tags are answered from memory, then the TagCache table is checked)
   // If not,
   // - for now we create a ctkDICOMDataset and extract the value from there
   // - then we convert to the appropriate type of string
@@ -787,14 +1521,151 @@ QString ctkDICOMDatabase::fileValue(const QString fileName, const unsigned short
     return value;
     }
 
-  ctkDICOMDataset dataset;
-  dataset.InitializeFromFile(fileName);
+  Q_D(ctkDICOMDatabase);
+  return( d->readAndCacheTag(fileName, sopInstanceUID, group, element) );
+}
 
-  DcmTagKey tagKey(group, element);
+//------------------------------------------------------------------------------
+QList<QStringList> ctkDICOMDatabase::instanceValues(const QStringList& sopInstanceUIDs, const QStringList& tags)
+{
+  Q_D(ctkDICOMDatabase);
 
-  value = dataset.GetAllElementValuesAsString(tagKey);
-  this->cacheTag(sopInstanceUID, tag, value);
-  return( value );
+  // rows of the result, missing values are null strings until resolved
+  QHash<QString, QStringList> values;
+  QSet<QString> unresolvedInstances;
+  foreach (const QString& sopInstanceUID, sopInstanceUIDs)
+    {
+    QStringList row;
+    foreach (const QString& tag, tags)
+      {
+      QString value;
+      if (!d->TagMemoryCache.find(sopInstanceUID, tag, value))
+        {
+        unresolvedInstances.insert(sopInstanceUID);
+        }
+      row << value;
+      }
+    values.insert(sopInstanceUID, row);
+    }
+
+  // SQLite limits the number of bound parameters of a statement
+  const int chunkSize = 500;
+  QStringList unresolved = unresolvedInstances.toList();
+
+  // one query per chunk of instances for everything in the tag cache table
+  this->flushTagCache();
+  if (!unresolved.isEmpty() && (this->tagCacheExists() || this->initializeTagCache()))
+    {
+    QString tagPlaceholders = QString("?,").repeated(tags.count());
+    tagPlaceholders.chop(1);
+    for (int start = 0; start < unresolved.count(); start += chunkSize)
+      {
+      QStringList chunk = unresolved.mid(start, chunkSize);
+      QString uidPlaceholders = QString("?,").repeated(chunk.count());
+      uidPlaceholders.chop(1);
+      QSqlQuery selectValues( d->TagCacheDatabase );
+      selectValues.prepare( QString("SELECT SOPInstanceUID, Tag, Value FROM TagCache WHERE SOPInstanceUID IN (%1) AND Tag IN (%2)")
+                            .arg(uidPlaceholders).arg(tagPlaceholders) );
+      foreach (const QString& sopInstanceUID, chunk)
+        {
+        selectValues.addBindValue(sopInstanceUID);
+        }
+      foreach (const QString& tag, tags)
+        {
+        selectValues.addBindValue(tag);
+        }
+      d->loggedExec(selectValues);
+      while (selectValues.next())
+        {
+        QString sopInstanceUID = selectValues.value(0).toString();
+        QString tag = selectValues.value(1).toString();
+        QString value = selectValues.value(2).toString();
+        values[sopInstanceUID][tags.indexOf(tag)] = value;
+        d->TagMemoryCache.insert(sopInstanceUID, tag, value);
+        }
+      }
+    }
+
+  // find the files of the instances that still miss tags
+  QList<ctkDICOMTagRequest> requests;
+  for (int start = 0; start < unresolved.count(); start += chunkSize)
+    {
+    QStringList chunk = unresolved.mid(start, chunkSize);
+    QString uidPlaceholders = QString("?,").repeated(chunk.count());
+    uidPlaceholders.chop(1);
+    QSqlQuery selectFiles( d->Database );
+    selectFiles.prepare( QString("SELECT SOPInstanceUID, Filename FROM Images WHERE SOPInstanceUID IN (%1)")
+                         .arg(uidPlaceholders) );
+    foreach (const QString& sopInstanceUID, chunk)
+      {
+      selectFiles.addBindValue(sopInstanceUID);
+      }
+    d->loggedExec(selectFiles);
+    while (selectFiles.next())
+      {
+      QString sopInstanceUID = selectFiles.value(0).toString();
+      ctkDICOMTagRequest request;
+      request.SOPInstanceUID = sopInstanceUID;
+      request.FileName = selectFiles.value(1).toString();
+      const QStringList& row = values[sopInstanceUID];
+      for (int i = 0; i < tags.count(); ++i)
+        {
+        unsigned short group = 0, element = 0;
+        if (row[i].isNull() && this->tagToGroupElement(tags[i], group, element))
+          {
+          request.Tags << DcmTagKey(group, element);
+          request.TagIndexes << i;
+          }
+        }
+      if (!request.Tags.isEmpty())
+        {
+        requests << request;
+        }
+      }
+    }
+
+  // each file is parsed once for all of its missing tags, in parallel
+  QList<QStringList> readValues =
+    QtConcurrent::blockingMapped< QList<QStringList> >(requests, ReadTagsFunctor());
+
+  {
+    QMutexLocker lock(&d->PendingTagsMutex);
+    for (int r = 0; r < requests.count(); ++r)
+      {
+      const ctkDICOMTagRequest& request = requests[r];
+      QStringList& row = values[request.SOPInstanceUID];
+      for (int t = 0; t < request.TagIndexes.count(); ++t)
+        {
+        int i = request.TagIndexes[t];
+        QString value = readValues[r][t];
+        if (value.isEmpty())
+          {
+          value = TagNotInInstance;
+          }
+        row[i] = value;
+        d->TagMemoryCache.insert(request.SOPInstanceUID, tags[i], value);
+        d->PendingTags.insert(request.SOPInstanceUID + '|' + tags[i],
+                              qMakePair(request.SOPInstanceUID, value));
+        }
+      }
+  }
+  // everything read is written back in one transaction
+  d->flushPendingTags();
+
+  QList<QStringList> result;
+  foreach (const QString& sopInstanceUID, sopInstanceUIDs)
+    {
+    QStringList row = values.value(sopInstanceUID);
+    for (int i = 0; i < row.count(); ++i)
+      {
+      if (row[i] == TagNotInInstance || row[i].isNull())
+        {
+        row[i] = "";
+        }
+      }
+    result << row;
+    }
+  return( result );
 }
 
 //------------------------------------------------------------------------------
@@ -839,6 +1710,13 @@ void ctkDICOMDatabase::insert( const ctkDICOMDataset& ctkDataset, bool storeFile
   d->insert(ctkDataset, QString(), storeFile, generateThumbnail);
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::insert( const ctkDICOMDataset& ctkDataset, const QString& filePath, bool storeFile, bool generateThumbnail)
+{
+  Q_D(ctkDICOMDatabase);
+  d->insert(ctkDataset, filePath, storeFile, generateThumbnail);
+}
+
 
 //------------------------------------------------------------------------------
 void ctkDICOMDatabase::insert ( const QString& filePath, bool storeFile, bool generateThumbnail, bool createHierarchy, const QString& destinationDirectoryName)
@@ -861,7 +1739,7 @@ void ctkDICOMDatabase::insert ( const QString& filePath, bool storeFile, bool ge
   DcmFileFormat fileformat;
   ctkDICOMDataset ctkDataset;
 
-  ctkDataset.InitializeFromFile(filePath);
+  ctkDataset.InitializeFromFileHeader(filePath);
   if ( ctkDataset.IsInitialized() )
     {
       d->insert( ctkDataset, filePath, storeFile, generateThumbnail );
@@ -872,6 +1750,72 @@ void ctkDICOMDatabase::insert ( const QString& filePath, bool storeFile, bool ge
     }
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::beginBatchInsert(int batchSize)
+{
+  Q_D(ctkDICOMDatabase);
+  QMutexLocker lock(&d->insertMutex);
+  d->BatchSize = qMax(1, batchSize);
+  if (d->BatchInsertActive)
+    {
+    return;
+    }
+  if (!d->Database.transaction())
+    {
+    logger.error("SQLITE ERROR: could not start batch: " + d->Database.lastError().text());
+    return;
+    }
+  d->BatchInsertActive = true;
+  d->BatchPendingInserts = 0;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::endBatchInsert()
+{
+  Q_D(ctkDICOMDatabase);
+  QMutexLocker lock(&d->insertMutex);
+  if (!d->BatchInsertActive)
+    {
+    // the batch ended early if its transaction could not be continued
+    lock.unlock();
+    d->removeBatchedFiles();
+    return;
+    }
+  d->commitBatch(false);
+  lock.unlock();
+  d->flushPendingTags();
+  d->removeBatchedFiles();
+  if (isInMemory())
+    {
+    emit databaseChanged();
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::isBatchInsertActive() const
+{
+  Q_D(const ctkDICOMDatabase);
+  return d->BatchInsertActive;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::insertBatch(const QStringList& filePaths, bool storeFile, bool generateThumbnail, int batchSize)
+{
+  bool ownBatch = !this->isBatchInsertActive();
+  if (ownBatch)
+    {
+    this->beginBatchInsert(batchSize);
+    }
+  foreach (const QString& filePath, filePaths)
+    {
+    this->insert(filePath, storeFile, generateThumbnail);
+    }
+  if (ownBatch)
+    {
+    this->endBatchInsert();
+    }
+}
+
 //------------------------------------------------------------------------------
 int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMDataset& ctkDataset)
 {
@@ -883,8 +1827,13 @@ int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMDataset& ctkDataset)
   QString patientsName(ctkDataset.GetElementAsString(DCM_PatientName) );
   QString patientsBirthDate(ctkDataset.GetElementAsString(DCM_PatientBirthDate) );
 
-  QSqlQuery checkPatientExistsQuery(Database);
-  checkPatientExistsQuery.prepare ( "SELECT * FROM Patients WHERE PatientID = ? AND PatientsName = ?" );
+  QString batchKey = patientID + "\\" + patientsName;
+  if (BatchInsertActive && BatchPatientUIDs.contains(batchKey))
+    {
+    return BatchPatientUIDs.value(batchKey);
+    }
+
+  QSqlQuery checkPatientExistsQuery = preparedQuery( "SELECT * FROM Patients WHERE PatientID = ? AND PatientsName = ?" );
   checkPatientExistsQuery.bindValue ( 0, patientID );
   checkPatientExistsQuery.bindValue ( 1, patientsName );
   loggedExec(checkPatientExistsQuery);
@@ -904,8 +1853,7 @@ int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMDataset& ctkDataset)
       QString patientsAge(ctkDataset.GetElementAsString(DCM_PatientAge) );
       QString patientComments(ctkDataset.GetElementAsString(DCM_PatientComments) );
 
-      QSqlQuery insertPatientStatement ( Database );
-      insertPatientStatement.prepare ( "INSERT INTO Patients ('UID', 'PatientsName', 'PatientID', 'PatientsBirthDate', 'PatientsBirthTime', 'PatientsSex', 'PatientsAge', 'PatientsComments' ) values ( NULL, ?, ?, ?, ?, ?, ?, ? )" );
+      QSqlQuery insertPatientStatement = preparedQuery( "INSERT INTO Patients ('UID', 'PatientsName', 'PatientID', 'PatientsBirthDate', 'PatientsBirthTime', 'PatientsSex', 'PatientsAge', 'PatientsComments' ) values ( NULL, ?, ?, ?, ?, ?, ?, ? )" );
       insertPatientStatement.bindValue ( 0, patientsName );
       insertPatientStatement.bindValue ( 1, patientID );
       insertPatientStatement.bindValue ( 2, QDate::fromString ( patientsBirthDate, "yyyyMMdd" ) );
@@ -920,15 +1868,23 @@ int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMDataset& ctkDataset)
       logger.debug ( "New patient inserted: " + QString().setNum ( dbPatientID ) );
       qDebug() << "New patient inserted as : " << dbPatientID;
     }
-    return dbPatientID;
+  if (BatchInsertActive)
+    {
+    BatchPatientUIDs.insert(batchKey, dbPatientID);
+    }
+  return dbPatientID;
 }
 
 //------------------------------------------------------------------------------
 void ctkDICOMDatabasePrivate::insertStudy(const ctkDICOMDataset& ctkDataset, int dbPatientID)
 {
   QString studyInstanceUID(ctkDataset.GetElementAsString(DCM_StudyInstanceUID) );
-  QSqlQuery checkStudyExistsQuery (Database);
-  checkStudyExistsQuery.prepare ( "SELECT * FROM Studies WHERE StudyInstanceUID = ?" );
+  if (BatchInsertActive && BatchStudyInstanceUIDs.contains(studyInstanceUID))
+    {
+    LastStudyInstanceUID = studyInstanceUID;
+    return;
+    }
+  QSqlQuery checkStudyExistsQuery = preparedQuery( "SELECT * FROM Studies WHERE StudyInstanceUID = ?" );
   checkStudyExistsQuery.bindValue ( 0, studyInstanceUID );
   checkStudyExistsQuery.exec();
   if(!checkStudyExistsQuery.next())
@@ -945,8 +1901,7 @@ void ctkDICOMDatabasePrivate::insertStudy(const ctkDICOMDataset& ctkDataset, int
       QString referringPhysician(ctkDataset.GetElementAsString(DCM_ReferringPhysicianName) );
       QString studyDescription(ctkDataset.GetElementAsString(DCM_StudyDescription) );
 
-      QSqlQuery insertStudyStatement ( Database );
-      insertStudyStatement.prepare ( "INSERT INTO Studies ( 'StudyInstanceUID', 'PatientsUID', 'StudyID', 'StudyDate', 'StudyTime', 'AccessionNumber', 'ModalitiesInStudy', 'InstitutionName', 'ReferringPhysician', 'PerformingPhysiciansName', 'StudyDescription' ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
+      QSqlQuery insertStudyStatement = preparedQuery( "INSERT INTO Studies ( 'StudyInstanceUID', 'PatientsUID', 'StudyID', 'StudyDate', 'StudyTime', 'AccessionNumber', 'ModalitiesInStudy', 'InstitutionName', 'ReferringPhysician', 'PerformingPhysiciansName', 'StudyDescription' ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
       insertStudyStatement.bindValue ( 0, studyInstanceUID );
       insertStudyStatement.bindValue ( 1, dbPatientID );
       insertStudyStatement.bindValue ( 2, studyID );
@@ -965,11 +1920,19 @@ void ctkDICOMDatabasePrivate::insertStudy(const ctkDICOMDataset& ctkDataset, int
       else
         {
           LastStudyInstanceUID = studyInstanceUID;
+          if (BatchInsertActive)
+            {
+            BatchStudyInstanceUIDs.insert(studyInstanceUID);
+            }
         }
     }
   else
     {
     qDebug() << "Used existing study: " << studyInstanceUID;
+    if (BatchInsertActive)
+      {
+      BatchStudyInstanceUIDs.insert(studyInstanceUID);
+      }
     }
 }
 
@@ -977,8 +1940,12 @@ void ctkDICOMDatabasePrivate::insertStudy(const ctkDICOMDataset& ctkDataset, int
 void ctkDICOMDatabasePrivate::insertSeries(const ctkDICOMDataset& ctkDataset, QString studyInstanceUID)
 {
   QString seriesInstanceUID(ctkDataset.GetElementAsString(DCM_SeriesInstanceUID) );
-  QSqlQuery checkSeriesExistsQuery (Database);
-  checkSeriesExistsQuery.prepare ( "SELECT * FROM Series WHERE SeriesInstanceUID = ?" );
+  if (BatchInsertActive && BatchSeriesInstanceUIDs.contains(seriesInstanceUID))
+    {
+    LastSeriesInstanceUID = seriesInstanceUID;
+    return;
+    }
+  QSqlQuery checkSeriesExistsQuery = preparedQuery( "SELECT * FROM Series WHERE SeriesInstanceUID = ?" );
   checkSeriesExistsQuery.bindValue ( 0, seriesInstanceUID );
   logger.warn ( "Statement: " + checkSeriesExistsQuery.lastQuery() );
   loggedExec(checkSeriesExistsQuery);
@@ -999,8 +1966,7 @@ void ctkDICOMDatabasePrivate::insertSeries(const ctkDICOMDataset& ctkDataset, QS
       long echoNumber(ctkDataset.GetElementAsInteger(DCM_EchoNumbers) );
       long temporalPosition(ctkDataset.GetElementAsInteger(DCM_TemporalPositionIdentifier) );
 
-      QSqlQuery insertSeriesStatement ( Database );
-      insertSeriesStatement.prepare ( "INSERT INTO Series ( 'SeriesInstanceUID', 'StudyInstanceUID', 'SeriesNumber', 'SeriesDate', 'SeriesTime', 'SeriesDescription', 'Modality', 'BodyPartExamined', 'FrameOfReferenceUID', 'AcquisitionNumber', 'ContrastAgent', 'ScanningSequence', 'EchoNumber', 'TemporalPosition' ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
+      QSqlQuery insertSeriesStatement = preparedQuery( "INSERT INTO Series ( 'SeriesInstanceUID', 'StudyInstanceUID', 'SeriesNumber', 'SeriesDate', 'SeriesTime', 'SeriesDescription', 'Modality', 'BodyPartExamined', 'FrameOfReferenceUID', 'AcquisitionNumber', 'ContrastAgent', 'ScanningSequence', 'EchoNumber', 'TemporalPosition' ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
       insertSeriesStatement.bindValue ( 0, seriesInstanceUID );
       insertSeriesStatement.bindValue ( 1, studyInstanceUID );
       insertSeriesStatement.bindValue ( 2, static_cast<int>(seriesNumber) );
@@ -1025,11 +1991,19 @@ void ctkDICOMDatabasePrivate::insertSeries(const ctkDICOMDataset& ctkDataset, QS
       else
         {
           LastSeriesInstanceUID = seriesInstanceUID;
+          if (BatchInsertActive)
+            {
+            BatchSeriesInstanceUIDs.insert(seriesInstanceUID);
+            }
         }
     }
   else
     {
     qDebug() << "Used existing series: " << seriesInstanceUID;
+    if (BatchInsertActive)
+      {
+      BatchSeriesInstanceUIDs.insert(seriesInstanceUID);
+      }
     }
 }
 
@@ -1048,14 +2022,12 @@ const QStringList ctkDICOMDatabase::tagsToPrecache()
 }
 
 //------------------------------------------------------------------------------
-void ctkDICOMDatabasePrivate::precacheTags( const QString sopInstanceUID )
+void ctkDICOMDatabasePrivate::precacheTags( const ctkDICOMDataset& dataset, const QString sopInstanceUID )
 {
   Q_Q(ctkDICOMDatabase);
 
-  ctkDICOMDataset dataset;
-  QString fileName = q->fileForInstance(sopInstanceUID);
-  dataset.InitializeFromFile(fileName);
-
+  // the dataset being inserted already holds the header, no need
+  // to read the file again
   foreach (const QString &tag, this->TagsToPrecache)
     {
     unsigned short group, element;
@@ -1084,8 +2056,7 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMDataset& ctkDataset, const Q
 
   QString sopInstanceUID ( ctkDataset.GetElementAsString(DCM_SOPInstanceUID) );
 
-  QSqlQuery fileExists ( Database );
-  fileExists.prepare("SELECT InsertTimestamp,Filename FROM Images WHERE SOPInstanceUID == :sopInstanceUID");
+  QSqlQuery fileExists = preparedQuery("SELECT InsertTimestamp,Filename FROM Images WHERE SOPInstanceUID == :sopInstanceUID");
   fileExists.bindValue(":sopInstanceUID",sopInstanceUID);
   bool success = fileExists.exec();
   if (!success)
@@ -1144,16 +2115,7 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMDataset& ctkDataset, const Q
   QString filename = filePath;
   if ( storeFile && !q->isInMemory() && !seriesInstanceUID.isEmpty() )
     {
-      // QString studySeriesDirectory = studyInstanceUID + "/" + seriesInstanceUID;
-      QString destinationDirectoryName = q->databaseDirectory() + "/dicom/";
-      QDir destinationDir(destinationDirectoryName);
-      filename = destinationDirectoryName +
-          studyInstanceUID + "/" +
-          seriesInstanceUID + "/" +
-          sopInstanceUID;
-
-      destinationDir.mkpath(studyInstanceUID + "/" +
-                            seriesInstanceUID);
+      filename = q->storagePathForInstance(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
 
       if(filePath.isEmpty())
         {
@@ -1221,14 +2183,12 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMDataset& ctkDataset, const Q
       //
       if ( !filename.isEmpty() && !seriesInstanceUID.isEmpty() )
         {
-          QSqlQuery checkImageExistsQuery (Database);
-          checkImageExistsQuery.prepare ( "SELECT * FROM Images WHERE Filename = ?" );
+          QSqlQuery checkImageExistsQuery = preparedQuery( "SELECT * FROM Images WHERE Filename = ?" );
           checkImageExistsQuery.bindValue ( 0, filename );
           checkImageExistsQuery.exec();
           if(!checkImageExistsQuery.next())
             {
-              QSqlQuery insertImageStatement ( Database );
-              insertImageStatement.prepare ( "INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ? )" );
+              QSqlQuery insertImageStatement = preparedQuery( "INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ? )" );
               insertImageStatement.bindValue ( 0, sopInstanceUID );
               insertImageStatement.bindValue ( 1, filename );
               insertImageStatement.bindValue ( 2, seriesInstanceUID );
@@ -1236,28 +2196,22 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMDataset& ctkDataset, const Q
               insertImageStatement.exec();
 
               // insert was needed, so cache any application-requested tags
-              this->precacheTags(sopInstanceUID);
+              this->precacheTags(ctkDataset, sopInstanceUID);
+
+              if (BatchInsertActive && ++BatchPendingInserts >= BatchSize)
+                {
+                this->commitBatch(true);
+                }
             }
         }
 
       if( generateThumbnail && thumbnailGenerator && !seriesInstanceUID.isEmpty() )
         {
-          QString studySeriesDirectory = studyInstanceUID + "/" + seriesInstanceUID;
-          //Create thumbnail here
-          QString thumbnailPath = q->databaseDirectory() +
-              "/thumbs/" + studyInstanceUID + "/" + seriesInstanceUID
-              + "/" + sopInstanceUID + ".png";
-          QFileInfo thumbnailInfo(thumbnailPath);
-          if( !(thumbnailInfo.exists()
-                && (thumbnailInfo.lastModified() > QFileInfo(filename).lastModified())))
-            {
-              QDir(q->databaseDirectory() + "/thumbs/").mkpath(studySeriesDirectory);
-              DicomImage dcmImage(QDir::toNativeSeparators(filename).toAscii());
-              thumbnailGenerator->generateThumbnail(&dcmImage, thumbnailPath);
-            }
+          // rendered in the thumbnail pool, see thumbnailGenerated()
+          this->queueThumbnail(studyInstanceUID, seriesInstanceUID, sopInstanceUID, filename);
         }
 
-      if (q->isInMemory())
+      if (q->isInMemory() && !BatchInsertActive)
         {
           emit q->databaseChanged();
         }
@@ -1268,6 +2222,25 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMDataset& ctkDataset, const Q
     }
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::waitForThumbnails()
+{
+  Q_D(ctkDICOMDatabase);
+  d->ThumbnailPool.waitForDone();
+}
+
+//------------------------------------------------------------------------------
+QByteArray ctkDICOMDatabase::thumbnail(const QString& sopInstanceUID)
+{
+  Q_D(ctkDICOMDatabase);
+  ctkDICOMThumbnailStore* store = d->thumbnailStore(false);
+  if (!store)
+    {
+    return QByteArray();
+    }
+  return store->thumbnail(sopInstanceUID);
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::fileExistsAndUpToDate(const QString& filePath)
 {
@@ -1304,6 +2277,24 @@ bool ctkDICOMDatabase::isInMemory() const
   return d->DatabaseFileName == ":memory:";
 }
 
+//------------------------------------------------------------------------------
+QString ctkDICOMDatabase::storagePathForInstance(const QString& studyInstanceUID,
+                                                 const QString& seriesInstanceUID,
+                                                 const QString& sopInstanceUID) const
+{
+  if (this->isInMemory())
+    {
+    return QString();
+    }
+  QString destinationDirectoryName = this->databaseDirectory() + "/dicom/";
+  QDir destinationDir(destinationDirectoryName);
+  destinationDir.mkpath(studyInstanceUID + "/" + seriesInstanceUID);
+  return destinationDirectoryName +
+      studyInstanceUID + "/" +
+      seriesInstanceUID + "/" +
+      sopInstanceUID;
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID)
 {
@@ -1364,19 +2355,32 @@ bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID)
               logger.warn("Failed to remove file " + dbFilePath );
             }
         }
-      if (QFile( thumbnailToRemove ).remove())
-        {
-          logger.debug("Removed thumbnail " + thumbnailToRemove);
-        }
-      else
+      // thumbnail of a database created before the thumbnail store
+      if (QFile::exists( thumbnailToRemove ))
         {
-          logger.warn("Failed to remove thumbnail " + thumbnailToRemove);
+          if (QFile( thumbnailToRemove ).remove())
+            {
+              logger.debug("Removed thumbnail " + thumbnailToRemove);
+            }
+          else
+            {
+              logger.warn("Failed to remove thumbnail " + thumbnailToRemove);
+            }
         }
     }
 
+  // a pending thumbnail would be stored again after its removal
+  d->ThumbnailPool.waitForDone();
+  ctkDICOMThumbnailStore* store = d->thumbnailStore(false);
+  if (store && !store->removeSeriesThumbnails(seriesInstanceUID))
+    {
+      logger.warn("Failed to remove thumbnails of series " + seriesInstanceUID);
+    }
+
   this->cleanup();
 
   d->resetLastInsertedValues();
+  d->clearMemoryCaches();
 
   return true;
 }
@@ -1386,6 +2390,14 @@ bool ctkDICOMDatabase::cleanup()
 {
   Q_D(ctkDICOMDatabase);
   QSqlQuery seriesCleanup ( d->Database );
+  if (d->Database.record("Series").contains("ImagesCount"))
+    {
+    // the children counts are kept up to date by triggers since schema 0.6
+    seriesCleanup.exec("DELETE FROM Series WHERE ImagesCount <= 0;");
+    seriesCleanup.exec("DELETE FROM Studies WHERE SeriesCount <= 0;");
+    seriesCleanup.exec("DELETE FROM Patients WHERE StudiesCount <= 0;");
+    return true;
+    }
   seriesCleanup.exec("DELETE FROM Series WHERE ( SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID ) = 0;");
   seriesCleanup.exec("DELETE FROM Studies WHERE ( SELECT COUNT(*) FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID ) = 0;");
   seriesCleanup.exec("DELETE FROM Patients WHERE ( SELECT COUNT(*) FROM Studies WHERE Studies.PatientsUID = Patients.UID ) = 0;");
@@ -1446,6 +2458,120 @@ bool ctkDICOMDatabase::removePatient(const QString& patientID)
   return result;
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::removeFiles(const QStringList& fileNames)
+{
+  Q_D(ctkDICOMDatabase);
+
+  if (fileNames.isEmpty())
+    {
+    return true;
+    }
+
+  QStringList removedInstances;
+  QStringList thumbnailsToRemove;
+  bool success = true;
+  bool batched = false;
+  {
+    QMutexLocker lock(&d->insertMutex);
+    batched = d->BatchInsertActive;
+    // one transaction for all files, refreshing a large directory can
+    // remove many thousands of them
+    bool ownTransaction = !d->BatchInsertActive && d->Database.transaction();
+
+    QSqlQuery instanceForFile = d->preparedQuery("SELECT SOPInstanceUID, Images.SeriesInstanceUID, StudyInstanceUID FROM Images,Series WHERE Series.SeriesInstanceUID = Images.SeriesInstanceUID AND Filename = ?");
+    QSqlQuery fileRemove = d->preparedQuery("DELETE FROM Images WHERE Filename = ?");
+    foreach (const QString& fileName, fileNames)
+      {
+      instanceForFile.bindValue(0, fileName);
+      d->loggedExec(instanceForFile);
+      if (instanceForFile.next())
+        {
+        QString sopInstanceUID = instanceForFile.value(0).toString();
+        removedInstances << sopInstanceUID;
+        thumbnailsToRemove << databaseDirectory() + "/thumbs/"
+          + instanceForFile.value(2).toString() + "/"
+          + instanceForFile.value(1).toString() + "/"
+          + sopInstanceUID + ".png";
+        }
+      instanceForFile.finish();
+
+      fileRemove.bindValue(0, fileName);
+      if (!d->loggedExec(fileRemove))
+        {
+        logger.error("SQLITE ERROR: could not remove file " + fileName);
+        success = false;
+        }
+      }
+
+    if (ownTransaction && !d->Database.commit())
+      {
+      logger.error("SQLITE ERROR: " + d->Database.lastError().driverText());
+      success = false;
+      }
+    if (batched)
+      {
+      d->BatchRemovedInstances.unite(removedInstances.toSet());
+      }
+  }
+
+  // thumbnails of a database created before the thumbnail store
+  foreach (const QString& thumbnailToRemove, thumbnailsToRemove)
+    {
+    if (QFile::exists(thumbnailToRemove) && !QFile( thumbnailToRemove ).remove())
+      {
+      logger.warn("Failed to remove thumbnail " + thumbnailToRemove);
+      }
+    }
+  // a pending thumbnail would be stored again after its removal. In a
+  // batch, e.g. while the indexer replaces modified files, the thumbnails
+  // and the emptied series are removed once when the batch ends.
+  if (!batched)
+    {
+    d->ThumbnailPool.waitForDone();
+    ctkDICOMThumbnailStore* store = d->thumbnailStore(false);
+    if (store && !store->removeThumbnails(removedInstances))
+      {
+      logger.warn("Failed to remove thumbnails");
+      }
+    }
+
+  // cached values would be stale if the file is inserted again
+  d->flushPendingTags();
+  foreach (const QString& sopInstanceUID, removedInstances)
+    {
+    d->TagMemoryCache.remove(sopInstanceUID);
+    }
+  {
+    QMutexLocker lock(&d->InstanceForFileMutex);
+    foreach (const QString& fileName, fileNames)
+      {
+      d->InstanceForFileCache.remove(fileName);
+      }
+  }
+  if (this->tagCacheExists())
+    {
+    d->TagCacheDatabase.transaction();
+    QSqlQuery removeTags( d->TagCacheDatabase );
+    removeTags.prepare( "DELETE FROM TagCache WHERE SOPInstanceUID = :sopInstanceUID" );
+    foreach (const QString& sopInstanceUID, removedInstances)
+      {
+      removeTags.bindValue(":sopInstanceUID", sopInstanceUID);
+      d->loggedExec(removeTags);
+      }
+    d->TagCacheDatabase.commit();
+    }
+
+  if (!batched)
+    {
+    this->cleanup();
+    }
+
+  d->resetLastInsertedValues();
+
+  return success;
+}
+
 ///
 /// Code related to the tagCache
 ///
@@ -1499,6 +2625,12 @@ bool ctkDICOMDatabase::initializeTagCache()
 {
   Q_D(ctkDICOMDatabase);
 
+  {
+    QMutexLocker lock(&d->PendingTagsMutex);
+    d->PendingTags.clear();
+  }
+  d->TagMemoryCache.clear();
+
   // First, drop any existing table
   if ( this->tagCacheExists() )
     {
@@ -1526,6 +2658,21 @@ bool ctkDICOMDatabase::initializeTagCache()
 QString ctkDICOMDatabase::cachedTag(const QString sopInstanceUID, const QString tag)
 {
   Q_D(ctkDICOMDatabase);
+  QString result("");
+  if (d->TagMemoryCache.find(sopInstanceUID, tag, result))
+    {
+    return( result );
+    }
+  {
+    // may have been evicted from memory before it was written
+    QMutexLocker lock(&d->PendingTagsMutex);
+    QHash<QString, QPair<QString, QString> >::const_iterator pending =
+      d->PendingTags.find(sopInstanceUID + '|' + tag);
+    if (pending != d->PendingTags.end())
+      {
+      return( pending.value().second );
+      }
+  }
   if ( !this->tagCacheExists() )
     {
     if ( !this->initializeTagCache() )
@@ -1538,10 +2685,10 @@ QString ctkDICOMDatabase::cachedTag(const QString sopInstanceUID, const QString
   selectValue.bindValue(":sopInstanceUID",sopInstanceUID);
   selectValue.bindValue(":tag",tag);
   d->loggedExec(selectValue);
-  QString result("");
   if (selectValue.next())
     {
     result = selectValue.value(0).toString();
+    d->TagMemoryCache.insert(sopInstanceUID, tag, result);
     }
   return( result );
 }
@@ -1562,10 +2709,54 @@ bool ctkDICOMDatabase::cacheTag(const QString sopInstanceUID, const QString tag,
     {
     valueToInsert = TagNotInInstance;
     }
-  QSqlQuery insertTag( d->TagCacheDatabase );
-  insertTag.prepare( "INSERT OR REPLACE INTO TagCache VALUES(:sopInstanceUID, :tag, :value)" );
-  insertTag.bindValue(":sopInstanceUID",sopInstanceUID);
-  insertTag.bindValue(":tag",tag);
-  insertTag.bindValue(":value",valueToInsert);
-  return d->loggedExec(insertTag);
+  d->TagMemoryCache.insert(sopInstanceUID, tag, valueToInsert);
+
+  // the table is written behind, in batches
+  int pendingTags;
+  {
+    QMutexLocker lock(&d->PendingTagsMutex);
+    d->PendingTags.insert(sopInstanceUID + '|' + tag, qMakePair(sopInstanceUID, valueToInsert));
+    pendingTags = d->PendingTags.size();
+  }
+  if (pendingTags >= d->PendingTagsBatchSize)
+    {
+    return d->flushPendingTags();
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::flushTagCache()
+{
+  Q_D(ctkDICOMDatabase);
+  return d->flushPendingTags();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::setTagCacheMemoryLimit(int maxEntries)
+{
+  Q_D(ctkDICOMDatabase);
+  d->TagMemoryCache.setMaxEntries(maxEntries);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabase::tagCacheHits() const
+{
+  Q_D(const ctkDICOMDatabase);
+  return d->TagMemoryCache.Hits;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabase::tagCacheMisses() const
+{
+  Q_D(const ctkDICOMDatabase);
+  return d->TagMemoryCache.Misses;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::resetTagCacheStatistics()
+{
+  Q_D(ctkDICOMDatabase);
+  d->TagMemoryCache.Hits = 0;
+  d->TagMemoryCache.Misses = 0;
 }
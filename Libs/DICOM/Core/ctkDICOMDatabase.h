@@ -22,6 +22,7 @@
 #define __ctkDICOMDatabase_h
 
 // Qt includes
+#include <QHash>
 #include <QObject>
 #include <QStringList>
 #include <QSqlDatabase>
@@ -86,7 +87,16 @@ public:
   bool isInMemory() const;
 
   ///
-  /// set thumbnail generator object
+  /// Returns the file where an instance inserted with storeFile is stored,
+  /// i.e. dicom/<study>/<series>/<sop> in the database directory, and
+  /// creates its directory. Returns an empty string for an in memory database.
+  QString storagePathForInstance(const QString& studyInstanceUID,
+                                 const QString& seriesInstanceUID,
+                                 const QString& sopInstanceUID) const;
+
+  ///
+  /// set thumbnail generator object, waits for the thumbnails being
+  /// generated: set a null generator before deleting the generator
   void setThumbnailGenerator(ctkDICOMAbstractThumbnailGenerator* generator);
   ///
   /// get thumbnail genrator object
@@ -136,6 +146,10 @@ public:
   Q_INVOKABLE QString fileForInstance (const QString sopInstanceUID);
   Q_INVOKABLE QString instanceForFile (const QString fileName);
   Q_INVOKABLE QDateTime insertDateTimeForInstance (const QString fileName);
+  /// Returns the insert timestamp of every file in the database,
+  /// keyed by file name. Uses a single query, so it is cheap to call
+  /// before checking a large list of files for being up-to-date.
+  QHash<QString, QDateTime> insertDateTimesForAllFiles ();
 
   Q_INVOKABLE QStringList allFiles ();
   ///
@@ -185,6 +199,39 @@ public:
                             bool storeFile = true, bool generateThumbnail = true,
                             bool createHierarchy = true,
                             const QString& destinationDirectoryName = QString() );
+  /// Insert a dataset that was already read from @param filePath, e.g. by
+  /// the ctkDICOMIndexer parsing threads, without parsing the file again.
+  void insert ( const ctkDICOMDataset& ctkDataset, const QString& filePath,
+                bool storeFile = true, bool generateThumbnail = true );
+
+  ///
+  /// \brief bulk insert mode
+  /// Between beginBatchInsert() and endBatchInsert() all inserts are
+  /// grouped into transactions of up to @param batchSize instances. The
+  /// prepared statements are reused and the patient/study/series lookups
+  /// are answered from memory for the whole batch, which avoids paying
+  /// the SQLite commit overhead for every single instance.
+  /// The batch is committed when endBatchInsert() is called.
+  Q_INVOKABLE void beginBatchInsert(int batchSize = 1000);
+  Q_INVOKABLE void endBatchInsert();
+  Q_INVOKABLE bool isBatchInsertActive() const;
+
+  /// Insert a list of files using the bulk insert mode.
+  /// If a batch is already active, the files are added to it, otherwise
+  /// a batch of @param batchSize is started and ended around the files.
+  Q_INVOKABLE void insertBatch ( const QStringList& filePaths,
+                                 bool storeFile = true, bool generateThumbnail = true,
+                                 int batchSize = 1000 );
+
+  /// Thumbnails are generated in the background after the insert, by a
+  /// pool of threads. The first instance of a series is generated first.
+  /// thumbnailGenerated() is emitted each time one is available.
+  /// In-memory databases keep no thumbnails.
+  /// Block until all queued thumbnails are generated.
+  Q_INVOKABLE void waitForThumbnails();
+  /// Thumbnail of the instance as encoded image data (PNG), empty if
+  /// it was not generated (yet). See ctkDICOMThumbnailStore.
+  Q_INVOKABLE QByteArray thumbnail(const QString& sopInstanceUID);
 
   /// Check if file is already in database and up-to-date
   bool fileExistsAndUpToDate(const QString& filePath);
@@ -194,6 +241,11 @@ public:
   Q_INVOKABLE bool removeSeries(const QString& seriesInstanceUID);
   Q_INVOKABLE bool removeStudy(const QString& studyInstanceUID);
   Q_INVOKABLE bool removePatient(const QString& patientID);
+  /// remove the given files from the database, including their
+  /// thumbnails and cached tags. The files themselves are not touched.
+  /// While a batch insert is active, the thumbnails and the emptied
+  /// series are only removed by endBatchInsert().
+  Q_INVOKABLE bool removeFiles(const QStringList& fileNames);
   bool cleanup();
 
   ///
@@ -209,6 +261,17 @@ public:
   Q_INVOKABLE QString instanceValue (const QString sopInstanceUID, const unsigned short group, const unsigned short element);
   Q_INVOKABLE QString fileValue (const QString fileName, const QString tag);
   Q_INVOKABLE QString fileValue (const QString fileName, const unsigned short group, const unsigned short element);
+
+  ///
+  /// \brief access many element values of many instances at once
+  /// All values already in the tag cache are resolved together, and each
+  /// file that is still needed is read only once, in parallel, for all of
+  /// the requested tags. The values read are added to the tag cache.
+  /// @param sopInstanceUIDs The instances to look up
+  /// @param tags A list of group,element tags in zero-filled hex
+  /// @Returns one row per instance (in the order of sopInstanceUIDs) with
+  ///          one value per tag (in the order of tags), empty if missing
+  Q_INVOKABLE QList<QStringList> instanceValues (const QStringList& sopInstanceUIDs, const QStringList& tags);
   Q_INVOKABLE bool tagToGroupElement (const QString tag, unsigned short& group, unsigned short& element);
   Q_INVOKABLE QString groupElementToTag (const unsigned short& group, const unsigned short& element);
 
@@ -229,7 +292,25 @@ public:
   /// Return the value of a cached tag
   Q_INVOKABLE QString cachedTag (const QString sopInstanceUID, const QString tag);
   /// Insert an instance tag's value into to the cache
+  /// Values are kept in memory right away and written to the tag cache
+  /// table in batches, see flushTagCache().
   Q_INVOKABLE bool cacheTag (const QString sopInstanceUID, const QString tag, const QString value);
+  /// Write the cached tag values that are still pending to the tag cache table
+  Q_INVOKABLE bool flushTagCache ();
+
+  ///
+  /// \brief in-memory part of the tag cache
+  /// The most recently used tag values (including the ones known to be
+  /// missing from their instance) are kept in memory in front of the
+  /// tag cache table.
+  /// @param maxEntries Maximum number of instance tag values kept in memory
+  Q_INVOKABLE void setTagCacheMemoryLimit (int maxEntries);
+  /// Number of tag lookups of cachedTag() and instanceValues() answered from memory
+  Q_INVOKABLE int tagCacheHits () const;
+  /// Number of tag lookups of cachedTag() and instanceValues() that had to
+  /// go to the tag cache table
+  Q_INVOKABLE int tagCacheMisses () const;
+  Q_INVOKABLE void resetTagCacheStatistics ();
 
 
 Q_SIGNALS:
@@ -241,6 +322,11 @@ Q_SIGNALS:
   void schemaUpdateProgress(QString);
   /// Indicates schema update finished
   void schemaUpdated();
+  /// The thumbnail of the instance is available in the thumbnail store.
+  /// Emitted from the thumbnail threads.
+  void thumbnailGenerated(const QString& studyInstanceUID,
+                          const QString& seriesInstanceUID,
+                          const QString& sopInstanceUID);
 
 protected:
   QScopedPointer<ctkDICOMDatabasePrivate> d_ptr;
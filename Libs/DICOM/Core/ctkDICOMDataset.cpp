@@ -128,6 +128,19 @@ void ctkDICOMDataset::InitializeFromFile(const QString& filename,
   InitializeFromDataset(dataset, true);
 }
 
+void ctkDICOMDataset::InitializeFromFileHeader(const QString& filename, const Uint32 maxElementSize)
+{
+  InitializeFromFile(filename, EXS_Unknown, EGL_noChange, maxElementSize);
+  if (!IsInitialized())
+  {
+    return;
+  }
+
+  // the pixel data was skipped while reading; drop it so that nothing
+  // loads it on demand from the file later on
+  GetDcmDataset().findAndDeleteElement(DCM_PixelData);
+}
+
 void ctkDICOMDataset::Serialize()
 {
   Q_D(ctkDICOMDataset);
@@ -89,6 +89,17 @@ public:
                     const Uint32 maxReadLength = DCM_MaxReadLength,
                     const E_FileReadMode readMode = ERM_autoDetect);
 
+    ///
+    /// \brief For initialization from the header of a file only.
+    ///
+    /// Attribute values larger than maxElementSize bytes are skipped while
+    /// reading (and loaded on demand if they are accessed later on), and the
+    /// PixelData (7FE0,0010) attribute is dropped, so the pixel data of the
+    /// file is never read. Use this when only the meta information of a file
+    /// is needed, e.g. for indexing or tag lookups.
+    virtual void InitializeFromFileHeader(const QString& filename,
+                    const Uint32 maxElementSize = 1024);
+
 
 
     /// \brief Save dataset to file
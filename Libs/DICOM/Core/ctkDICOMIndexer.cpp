@@ -31,7 +31,7 @@
 #include <QFileInfo>
 #include <QDebug>
 #include <QPixmap>
-#include <QtConcurrentRun>
+#include <QtConcurrentMap>
 
 // ctkDICOM includes
 #include "ctkLogger.h"
@@ -51,41 +51,225 @@
 #include <dcmtk/dcmimgle/dcmimage.h>  /* for class DicomImage */
 #include <dcmtk/dcmimage/diregist.h>  /* include support for color images */
 
-class AddFileFunctor
+class ParseFileFunctor
 {
 public:
-     AddFileFunctor(ctkDICOMIndexer* indexer, ctkDICOMDatabase& database,
-                    const QString& destinationDirectoryName = "")
-       : Indexer(indexer), Database(database), DestinationDirectoryName(destinationDirectoryName) { }
+     typedef void result_type;
 
-     bool operator()(const QString &filePath)
+     ParseFileFunctor(ctkDICOMIndexerPrivate* indexerPrivate)
+       : IndexerPrivate(indexerPrivate) { }
+
+     void operator()(const QString &filePath)
      {
-         Indexer->addFile(Database,filePath,DestinationDirectoryName);
-         return false; // make sure it is removed;
+         IndexerPrivate->parseFile(filePath);
      }
 
-     ctkDICOMIndexer* Indexer;
-     ctkDICOMDatabase& Database;
-     QString DestinationDirectoryName;
+     ctkDICOMIndexerPrivate* IndexerPrivate;
 
  };
 
 
+//------------------------------------------------------------------------------
+struct ctkDICOMIndexerScanResult
+{
+  QStringList NewFiles;
+  QStringList ModifiedFiles;
+  QSet<QString> ExistingFiles;
+};
+
+class ScanDirectoryFunctor
+{
+public:
+     typedef ctkDICOMIndexerScanResult result_type;
+
+     ScanDirectoryFunctor(const QHash<QString, QDateTime>& indexedFiles,
+                          const QHash<QString, QDateTime>& nonDicomFiles,
+                          const QString& databaseDirectory, bool recursive)
+       : IndexedFiles(indexedFiles), NonDicomFiles(nonDicomFiles),
+         DatabaseDirectory(databaseDirectory), Recursive(recursive) { }
+
+     ctkDICOMIndexerScanResult operator()(const QString &directoryName) const
+     {
+         ctkDICOMIndexerScanResult result;
+         QDirIterator it(directoryName, QDir::Files,
+                         Recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+         while (it.hasNext())
+           {
+           QString filePath = it.next();
+           QHash<QString, QDateTime>::const_iterator indexed = IndexedFiles.find(filePath);
+           if (indexed == IndexedFiles.end())
+             {
+             // the database files and their journals are not DICOM files
+             if (it.fileInfo().fileName().contains(".sql")
+                 && it.fileInfo().absolutePath() == DatabaseDirectory)
+               {
+               continue;
+               }
+             QHash<QString, QDateTime>::const_iterator nonDicom = NonDicomFiles.find(filePath);
+             if (nonDicom != NonDicomFiles.end()
+                 && !(nonDicom.value() < it.fileInfo().lastModified()))
+               {
+               continue;
+               }
+             result.NewFiles << filePath;
+             continue;
+             }
+           result.ExistingFiles.insert(filePath);
+           // files written after they have been indexed have changed
+           if (!(it.fileInfo().lastModified() < indexed.value()))
+             {
+             result.ModifiedFiles << filePath;
+             }
+           }
+         return result;
+     }
+
+     const QHash<QString, QDateTime>& IndexedFiles;
+     const QHash<QString, QDateTime>& NonDicomFiles;
+     QString DatabaseDirectory;
+     bool Recursive;
+
+ };
+
 //------------------------------------------------------------------------------
 static ctkLogger logger("org.commontk.dicom.DICOMIndexer" );
 //------------------------------------------------------------------------------
 
 
+//------------------------------------------------------------------------------
+// ctkDICOMIndexerQueue methods
+
+//------------------------------------------------------------------------------
+ctkDICOMIndexerQueue::ctkDICOMIndexerQueue(int capacity)
+  : Capacity(capacity), Closed(false)
+{
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMIndexerQueue::~ctkDICOMIndexerQueue()
+{
+  this->abort();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerQueue::reset()
+{
+  QMutexLocker lock(&this->Mutex);
+  this->Closed = false;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMIndexerQueue::push(const ctkDICOMIndexerRecord& record)
+{
+  QMutexLocker lock(&this->Mutex);
+  while (!this->Closed && this->Records.size() >= this->Capacity)
+    {
+    this->NotFull.wait(&this->Mutex);
+    }
+  if (this->Closed)
+    {
+    return false;
+    }
+  this->Records.enqueue(record);
+  this->NotEmpty.wakeOne();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMIndexerQueue::pop(QList<ctkDICOMIndexerRecord>& records, int maxRecords)
+{
+  QMutexLocker lock(&this->Mutex);
+  while (!this->Closed && this->Records.isEmpty())
+    {
+    this->NotEmpty.wait(&this->Mutex);
+    }
+  if (this->Records.isEmpty())
+    {
+    return false;
+    }
+  while (!this->Records.isEmpty() && records.size() < maxRecords)
+    {
+    records << this->Records.dequeue();
+    }
+  this->NotFull.wakeAll();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerQueue::close()
+{
+  QMutexLocker lock(&this->Mutex);
+  this->Closed = true;
+  this->NotEmpty.wakeAll();
+  this->NotFull.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerQueue::abort()
+{
+  QMutexLocker lock(&this->Mutex);
+  this->Closed = true;
+  while (!this->Records.isEmpty())
+    {
+    delete this->Records.dequeue().Dataset;
+    }
+  this->NotEmpty.wakeAll();
+  this->NotFull.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMIndexerWriter methods
+
+//------------------------------------------------------------------------------
+ctkDICOMIndexerWriter::ctkDICOMIndexerWriter(ctkDICOMIndexerQueue& queue)
+  : Database(0), StoreFile(false), GenerateThumbnail(true), BatchSize(1000), Queue(queue)
+{
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerWriter::run()
+{
+  this->Database->beginBatchInsert(this->BatchSize);
+  // the batch removes the thumbnails and the emptied series once it ends
+  this->Database->removeFiles(this->RemovedFiles);
+  this->RemovedFiles.clear();
+  QList<ctkDICOMIndexerRecord> records;
+  while (this->Queue.pop(records, 64))
+    {
+    // the rows of modified files are only replaced once the files have
+    // been parsed again, a file that can no longer be read keeps its row
+    QStringList replacedFiles;
+    foreach (const ctkDICOMIndexerRecord& record, records)
+      {
+      if (record.Replace)
+        {
+        replacedFiles << record.FilePath;
+        }
+      }
+    this->Database->removeFiles(replacedFiles);
+    foreach (const ctkDICOMIndexerRecord& record, records)
+      {
+      this->Database->insert(*record.Dataset, record.FilePath,
+                             this->StoreFile, this->GenerateThumbnail);
+      delete record.Dataset;
+      }
+    records.clear();
+    }
+  this->Database->endBatchInsert();
+}
+
 //------------------------------------------------------------------------------
 // ctkDICOMIndexerPrivate methods
 
 //------------------------------------------------------------------------------
-ctkDICOMIndexerPrivate::ctkDICOMIndexerPrivate(ctkDICOMIndexer& o) : q_ptr(&o), Canceled(false), CurrentPercentageProgress(-1)
+ctkDICOMIndexerPrivate::ctkDICOMIndexerPrivate(ctkDICOMIndexer& o) : q_ptr(&o), Canceled(false), CurrentPercentageProgress(-1),
+  Queue(256), Writer(Queue)
 {
   Q_Q(ctkDICOMIndexer);
   connect(&DirectoryImportWatcher,SIGNAL(progressValueChanged(int)),this,SLOT(OnProgress(int)));
-  connect(&DirectoryImportWatcher,SIGNAL(finished()),q,SIGNAL(indexingComplete()));
-  connect(&DirectoryImportWatcher,SIGNAL(canceled()),q,SIGNAL(indexingComplete()));
+  connect(&DirectoryImportWatcher,SIGNAL(finished()),this,SLOT(OnParsingFinished()));
+  connect(&DirectoryImportWatcher,SIGNAL(canceled()),this,SLOT(OnParsingFinished()));
+  connect(&Writer,SIGNAL(finished()),q,SIGNAL(indexingComplete()));
 }
 
 //------------------------------------------------------------------------------
@@ -93,7 +277,57 @@ ctkDICOMIndexerPrivate::~ctkDICOMIndexerPrivate()
 {
   DirectoryImportWatcher.cancel();
   DirectoryImportWatcher.waitForFinished();
+  Queue.abort();
+  Writer.wait();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerPrivate::parseFile(const QString& filePath)
+{
+  Q_Q(ctkDICOMIndexer);
+
+  QHash<QString, QDateTime>::const_iterator indexed = IndexedFiles.find(filePath);
+  if (indexed != IndexedFiles.end()
+      && QFileInfo(filePath).lastModified() < indexed.value())
+    {
+    logger.debug( "File " + filePath + " already added.");
+    return;
+    }
+
+  emit q->indexingFilePath(filePath);
+
+  ctkDICOMDataset* dataset = new ctkDICOMDataset;
+  dataset->InitializeFromFileHeader(filePath);
+  if (!dataset->IsInitialized())
+    {
+    logger.warn(QString("Could not read DICOM file:") + filePath);
+    delete dataset;
+    QMutexLocker lock(&NonDicomFilesMutex);
+    NonDicomFiles.insert(filePath, QFileInfo(filePath).lastModified());
+    return;
+    }
+
+  ctkDICOMIndexerRecord record;
+  record.FilePath = filePath;
+  record.Dataset = dataset;
+  record.Replace = indexed != IndexedFiles.end();
+  if (!Queue.push(record))
+    {
+    // import was canceled
+    delete dataset;
+    }
+}
 
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerPrivate::OnParsingFinished()
+{
+  // the writer finishes (and signals indexingComplete) once the
+  // queue is drained
+  Queue.close();
+  if (!DirectoryImportFuture.isCanceled())
+    {
+    FilesToIndex.clear();
+    }
 }
 
 void ctkDICOMIndexerPrivate::OnProgress(int)
@@ -180,8 +414,23 @@ void ctkDICOMIndexer::addListOfFiles(ctkDICOMDatabase& ctkDICOMDatabase,
       d->DirectoryImportWatcher.cancel();
       d->DirectoryImportWatcher.waitForFinished();
     }
+    d->Queue.close();
+    d->Writer.wait();
+
+    if (!destinationDirectoryName.isEmpty())
+    {
+      logger.warn("Ignoring destinationDirectoryName parameter, just taking it as indication we should copy!");
+    }
+
+    // header parsing runs on the global thread pool, the database is only
+    // written from the single writer thread
+    d->IndexedFiles = ctkDICOMDatabase.insertDateTimesForAllFiles();
     d->FilesToIndex.append(listOfFiles);
-    d->DirectoryImportFuture = QtConcurrent::filter(d->FilesToIndex,AddFileFunctor(this,ctkDICOMDatabase,destinationDirectoryName));
+    d->Queue.reset();
+    d->Writer.Database = &ctkDICOMDatabase;
+    d->Writer.StoreFile = !destinationDirectoryName.isEmpty();
+    d->Writer.start();
+    d->DirectoryImportFuture = QtConcurrent::map(d->FilesToIndex,ParseFileFunctor(d));
     d->DirectoryImportWatcher.setFuture(d->DirectoryImportFuture);
   }
 }
@@ -258,48 +507,90 @@ void ctkDICOMIndexer::addDicomdir(ctkDICOMDatabase& ctkDICOMDatabase,
 //------------------------------------------------------------------------------
 void ctkDICOMIndexer::refreshDatabase(ctkDICOMDatabase& dicomDatabase, const QString& directoryName)
 {
-  Q_UNUSED(dicomDatabase);
-  Q_UNUSED(directoryName);
-  /*
-   * Probably this should go to the database class as well
-   * Or we have to extend the interface to make possible what we do here
-   * without using SQL directly
-
-  /// get all filenames from the database
-  QSqlQuery allFilesQuery(dicomDatabase.database());
-  QStringList databaseFileNames;
-  QStringList filesToRemove;
-  this->loggedExec(allFilesQuery, "SELECT Filename from Images;");
-
-  while (allFilesQuery.next())
+  Q_D(ctkDICOMIndexer);
+
+  QDir directory(directoryName);
+  if (directoryName.isEmpty() || !directory.exists())
+    {
+    logger.warn("Cannot refresh database from missing directory: " + directoryName);
+    return;
+    }
+  QString directoryPath = directory.absolutePath();
+  QHash<QString, QDateTime> indexedFiles = dicomDatabase.insertDateTimesForAllFiles();
+  QString databaseDirectory = QDir(dicomDatabase.databaseDirectory()).absolutePath();
+  QHash<QString, QDateTime> nonDicomFiles;
+  {
+    QMutexLocker lock(&d->NonDicomFilesMutex);
+    nonDicomFiles = d->NonDicomFiles;
+  }
+
+  // walk the subdirectories in parallel, most of the time is spent
+  // waiting for the file system
+  QStringList subdirectories;
+  foreach (const QString& subdirectory, directory.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+    subdirectories << directory.absoluteFilePath(subdirectory);
+    }
+  QList<ctkDICOMIndexerScanResult> scanResults =
+    QtConcurrent::blockingMapped< QList<ctkDICOMIndexerScanResult> >(subdirectories,
+      ScanDirectoryFunctor(indexedFiles, nonDicomFiles, databaseDirectory, true));
+  scanResults << ScanDirectoryFunctor(indexedFiles, nonDicomFiles, databaseDirectory, false)(directoryPath);
+
+  QStringList newFiles;
+  QStringList modifiedFiles;
+  QSet<QString> existingFiles;
+  foreach (const ctkDICOMIndexerScanResult& scanResult, scanResults)
+    {
+    newFiles << scanResult.NewFiles;
+    modifiedFiles << scanResult.ModifiedFiles;
+    existingFiles.unite(scanResult.ExistingFiles);
+    }
+
+  QStringList removedFiles;
+  foreach (const QString& indexedFile, indexedFiles.keys())
     {
-    QString fileName = allFilesQuery.value(0).toString();
-    databaseFileNames.append(fileName);
-    if (! QFile::exists(fileName) )
+    if (indexedFile.startsWith(directoryPath + "/") && !existingFiles.contains(indexedFile))
       {
-      filesToRemove.append(fileName);
+      removedFiles << indexedFile;
       }
     }
 
-  QSet<QString> filesytemFiles;
-  QDirIterator dirIt(directoryName);
-  while (dirIt.hasNext())
+  logger.debug(QString("Refreshing %1: %2 new, %3 modified, %4 removed files")
+               .arg(directoryPath).arg(newFiles.count())
+               .arg(modifiedFiles.count()).arg(removedFiles.count()));
+  emit foundFilesToRefresh(newFiles.count(), modifiedFiles.count(), removedFiles.count());
+
+  if(d->DirectoryImportWatcher.isRunning())
     {
-    filesytemFiles.insert(dirIt.next());
+    d->DirectoryImportWatcher.cancel();
+    d->DirectoryImportWatcher.waitForFinished();
     }
-  
-  // TODO: it looks like this function was never finished...
-  // 
-  // I guess the next step is to remove all filesToRemove from the database
-  // and also to add filesystemFiles into the database tables
-  */ 
-  }
+  d->Queue.close();
+  d->Writer.wait();
+
+  // the rows of the removed and modified files are removed by the writer
+  // thread, in the batch of the files to index
+  QStringList filesToIndex = newFiles + modifiedFiles;
+  if (!filesToIndex.isEmpty())
+    {
+    d->Writer.RemovedFiles = removedFiles;
+    emit foundFilesToIndex(filesToIndex.count());
+    addListOfFiles(dicomDatabase, filesToIndex);
+    }
+  else
+    {
+    dicomDatabase.removeFiles(removedFiles);
+    emit indexingComplete();
+    }
+}
 
 //----------------------------------------------------------------------------
 void ctkDICOMIndexer::waitForImportFinished()
 {
   Q_D(ctkDICOMIndexer);
   d->DirectoryImportWatcher.waitForFinished();
+  d->Queue.close();
+  d->Writer.wait();
 }
 
 //----------------------------------------------------------------------------
@@ -307,4 +598,5 @@ void ctkDICOMIndexer::cancel()
 {
   Q_D(ctkDICOMIndexer);
   d->DirectoryImportWatcher.cancel();
+  d->Queue.abort();
 }
@@ -80,6 +80,16 @@ public:
   Q_INVOKABLE void addFile(ctkDICOMDatabase& database, const QString filePath,
                     const QString& destinationDirectoryName = "");
 
+  ///
+  /// \brief Resynchronizes the database with the files below directoryName.
+  ///
+  /// Files that are not in the database yet or that were modified after
+  /// they have been indexed are (re-)inserted, files of the database that
+  /// vanished from the directory are removed from it. Unchanged files, the
+  /// database files and the files this indexer could not read as DICOM
+  /// that did not change since are not read at all. The row of a modified
+  /// file is only replaced once the file has been read again.
+  ///
   Q_INVOKABLE void refreshDatabase(ctkDICOMDatabase& database, const QString& directoryName);
 
   ///
@@ -90,6 +100,8 @@ public:
 
 Q_SIGNALS:
   void foundFilesToIndex(int);
+  /// Emitted by refreshDatabase with the number of new, modified and removed files
+  void foundFilesToRefresh(int newFiles, int modifiedFiles, int removedFiles);
   void indexingFileNumber(int);
   void indexingFilePath(QString);
   void progress(int);
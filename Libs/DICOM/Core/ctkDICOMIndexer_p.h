@@ -21,10 +21,81 @@
 #ifndef CTKDICOMINDEXERPRIVATE_H
 #define CTKDICOMINDEXERPRIVATE_H
 
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QQueue>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
 
 #include "ctkDICOMIndexer.h"
 
+//------------------------------------------------------------------------------
+/// A parsed file waiting to be written into the database
+struct ctkDICOMIndexerRecord
+{
+  QString FilePath;
+  ctkDICOMDataset* Dataset;
+  /// the file is already in the database, its row is replaced
+  bool Replace;
+};
+
+//------------------------------------------------------------------------------
+/// Bounded queue between the parsing threads and the database writer thread.
+/// Parsing threads block while the queue is full, so that the memory used
+/// by parsed but not yet written headers stays bounded.
+class ctkDICOMIndexerQueue
+{
+public:
+  ctkDICOMIndexerQueue(int capacity);
+  ~ctkDICOMIndexerQueue();
+
+  /// Reopen the queue for a new import
+  void reset();
+  /// Blocks while the queue is full. Returns false (and does not take the
+  /// record) if the queue has been closed.
+  bool push(const ctkDICOMIndexerRecord& record);
+  /// Blocks while the queue is empty and open, then moves up to maxRecords
+  /// records into records. Returns false once the queue is closed and drained.
+  bool pop(QList<ctkDICOMIndexerRecord>& records, int maxRecords);
+  /// No more records will be pushed, pending ones are still delivered
+  void close();
+  /// Close the queue and drop the pending records
+  void abort();
+
+private:
+  QMutex Mutex;
+  QWaitCondition NotEmpty;
+  QWaitCondition NotFull;
+  QQueue<ctkDICOMIndexerRecord> Records;
+  int Capacity;
+  bool Closed;
+};
+
+//------------------------------------------------------------------------------
+/// Single thread draining the queue into the database in batches, so
+/// that the header parsing is not serialized on the database insert.
+class ctkDICOMIndexerWriter : public QThread
+{
+public:
+  ctkDICOMIndexerWriter(ctkDICOMIndexerQueue& queue);
+
+  ctkDICOMDatabase* Database;
+  bool StoreFile;
+  bool GenerateThumbnail;
+  int BatchSize;
+  /// files removed from the database in the batch of the next run
+  QStringList RemovedFiles;
+
+protected:
+  virtual void run();
+
+  ctkDICOMIndexerQueue& Queue;
+};
+
 //------------------------------------------------------------------------------
 class ctkDICOMIndexerPrivate : public QObject
 {
@@ -39,9 +110,14 @@ public:
   ctkDICOMIndexerPrivate(ctkDICOMIndexer&);
   ~ctkDICOMIndexerPrivate();
 
+  /// Parse the header of filePath and queue it for the writer thread.
+  /// Called concurrently from the parsing threads.
+  void parseFile(const QString& filePath);
+
 public Q_SLOTS:
 
   void OnProgress(int progress);
+  void OnParsingFinished();
 public:
 
   ctkDICOMAbstractThumbnailGenerator* thumbnailGenerator;
@@ -50,6 +126,15 @@ public:
   QFutureWatcher<void> DirectoryImportWatcher;
   QFuture<void> DirectoryImportFuture;
   int CurrentPercentageProgress;
+
+  /// insert timestamps of the indexed files, taken before parsing starts
+  QHash<QString, QDateTime> IndexedFiles;
+  /// modification times of the files that could not be parsed, which
+  /// refreshDatabase() does not read again until they change
+  QHash<QString, QDateTime> NonDicomFiles;
+  QMutex NonDicomFilesMutex;
+  ctkDICOMIndexerQueue Queue;
+  ctkDICOMIndexerWriter Writer;
 };
 
 
@@ -26,53 +26,21 @@
 #include <QSqlRecord>
 #include <QSqlResult>
 
+#include <QDate>
 #include <QTime>
 #include <QDebug>
+#include <QRegExp>
 
 // ctkDICOMCore includes
 #include "ctkDICOMModel.h"
+#include "ctkDICOMModel_p.h"
 #include "ctkLogger.h"
 
 static ctkLogger logger ( "org.commontk.dicom.DICOMModel" );
-struct Node;
 
 Q_DECLARE_METATYPE(Qt::CheckState);
 Q_DECLARE_METATYPE(QStringList);
 
-//------------------------------------------------------------------------------
-class ctkDICOMModelPrivate
-{
-  Q_DECLARE_PUBLIC(ctkDICOMModel);
-protected:
-  ctkDICOMModel* const q_ptr;
-  
-public:
-  ctkDICOMModelPrivate(ctkDICOMModel&);
-  virtual ~ctkDICOMModelPrivate();
-  void init();
-
-  void fetch(const QModelIndex& indexValue, int limit);
-  Node* createNode(int row, const QModelIndex& parentValue)const;
-  Node* nodeFromIndex(const QModelIndex& indexValue)const;
-  //QModelIndexList indexListFromNode(const Node* node)const;
-  //QModelIndexList modelIndexList(Node* node = 0)const;
-  //int childrenCount(Node* node = 0)const;
-  // move it in the Node struct
-  QVariant value(Node* parentValue, int row, int field)const;
-  QVariant value(const QModelIndex& indexValue, int row, int field)const;
-  QString  generateQuery(const QString& fields, const QString& table, const QString& conditions = QString())const;
-  void updateQueries(Node* node)const;
-
-  Node*        RootNode;
-  QSqlDatabase DataBase;
-  QList<QMap<int, QVariant> > Headers;
-  QString      Sort;
-  QMap<QString, QVariant> SearchParameters;
-
-  ctkDICOMModel::IndexType StartLevel;
-  ctkDICOMModel::IndexType EndLevel;
-};
-
 //------------------------------------------------------------------------------
 // 1 node per row
 // TBD: should probably use the QStandardItems instead.
@@ -89,26 +57,132 @@ struct Node
   ctkDICOMModel::IndexType Type;
   Node*                           Parent;
   QVector<Node*>                  Children;
+  /// children already created, by row
+  QHash<int, Node*>               ChildrenByRow;
   int                             Row;
-  QSqlQuery                       Query;
+  /// query of the children, see ctkDICOMModelPrivate::nextPage()
+  QString                         Statement;
+  QVariantList                    BoundValues;
+  QStringList                     Fields;
+  /// rows of the children loaded so far, one value per field
+  QList<QVariantList>             Rows;
+  /// page loaded in the background, not inserted in the model yet
+  ctkDICOMModelPage               Prefetched;
+  bool                            Prefetching;
   QString                         UID;
+  /// number of children given by the parent query, -1 if unknown
+  int                             ChildCount;
   int                             RowCount;
   bool                            AtEnd;
   bool                            Fetching;
   QMap<int, QVariant>             Data;
 };
 
+//------------------------------------------------------------------------------
+// The two last fields of each row are the sort key and the rowid, they
+// are used to start the next page after the last row (keyset pagination)
+// instead of stepping through all the previous rows.
+static const char* SortKeyField = "_SortKey";
+static const char* RowKeyField = "_RowKey";
+static const char* ChildCountField = "_ChildCount";
+
+//------------------------------------------------------------------------------
+// ctkDICOMModelLoader methods
+
+//------------------------------------------------------------------------------
+ctkDICOMModelLoader::ctkDICOMModelLoader(const QSqlDatabase& database)
+{
+  this->ConnectionName = QString("ctkDICOMModelLoader-%1").arg(reinterpret_cast<quintptr>(this));
+  QSqlDatabase::cloneDatabase(database, this->ConnectionName);
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMModelLoader::~ctkDICOMModelLoader()
+{
+  QSqlDatabase::removeDatabase(this->ConnectionName);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMModelLoader::loadPage(QSqlQuery& query, ctkDICOMModelPage& page)
+{
+  for (int i = 0; i < page.BoundValues.count(); ++i)
+    {
+    query.bindValue(i, page.BoundValues[i]);
+    }
+  if (!query.exec())
+    {
+    logger.error("SQLITE ERROR: " + query.lastError().driverText());
+    return false;
+    }
+  QSqlRecord record = query.record();
+  page.Fields.clear();
+  for (int field = 0; field < record.count(); ++field)
+    {
+    page.Fields << record.fieldName(field);
+    }
+  while (query.next())
+    {
+    QVariantList row;
+    for (int field = 0; field < record.count(); ++field)
+      {
+      row << query.value(field);
+      }
+    page.Rows << row;
+    }
+  query.finish();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelLoader::load(ctkDICOMModelPage page)
+{
+  QSqlDatabase database = QSqlDatabase::database(this->ConnectionName);
+  if (!database.isOpen())
+    {
+    logger.error("Could not open background connection: " + database.lastError().text());
+    return;
+    }
+  if (!this->PreparedQueries.contains(page.Statement))
+    {
+    QSqlQuery query(database);
+    query.prepare(page.Statement);
+    this->PreparedQueries.insert(page.Statement, query);
+    }
+  QSqlQuery query = this->PreparedQueries.value(page.Statement);
+  if (loadPage(query, page))
+    {
+    emit loaded(page);
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelLoader::close()
+{
+  this->PreparedQueries.clear();
+  QSqlDatabase::database(this->ConnectionName, false).close();
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMModelPrivate methods
+
 //------------------------------------------------------------------------------
 ctkDICOMModelPrivate::ctkDICOMModelPrivate(ctkDICOMModel& o):q_ptr(&o)
 {
   this->RootNode     = 0;
   this->StartLevel = ctkDICOMModel::RootType;
   this->EndLevel = ctkDICOMModel::ImageType;
+  this->SortOrder = Qt::AscendingOrder;
+  this->Generation = 0;
+  this->PageSize = 256;
+  this->Loader = 0;
+  this->FullTextSearch = false;
+  this->ChildrenCounts = false;
 }
 
 //------------------------------------------------------------------------------
 ctkDICOMModelPrivate::~ctkDICOMModelPrivate()
 {
+  this->stopLoader();
   delete this->RootNode;
   this->RootNode = 0;
 }
@@ -135,89 +209,56 @@ void ctkDICOMModelPrivate::init()
   this->Headers << data;
   data[Qt::DisplayRole] = QString("Performer");
   this->Headers << data;
-}
 
-//------------------------------------------------------------------------------
-Node* ctkDICOMModelPrivate::nodeFromIndex(const QModelIndex& indexValue)const
-{
-  return indexValue.isValid() ? reinterpret_cast<Node*>(indexValue.internalPointer()) : this->RootNode;
+  qRegisterMetaType<ctkDICOMModelPage>("ctkDICOMModelPage");
 }
 
-/*
 //------------------------------------------------------------------------------
-QModelIndexList ctkDICOMModelPrivate::indexListFromNode(const Node* node)const
+void ctkDICOMModelPrivate::startLoader()
 {
-  Q_Q(const ctkDICOMModel);
-  Q_ASSERT(node);
-  QModelIndexList indexList;
-  
-  Node* parentNode = node->Parent;
-  if (parentNode == 0)
-    {
-    return indexList;
-    }
-  int field = parentNode->Query.record().indexOf("UID");
-  int row = -1;
-  for (row = 0; row < parentNode->RowCount; ++row)
-    {
-    QString uid = this->value(parentNode, row, field).toString();
-    if (uid == node->UID)
-      {
-      break;
-      }
-    }
-  if (row >= parentNode->RowCount)
+  this->stopLoader();
+  // an in-memory database can't be shared with another connection
+  if (!this->DataBase.isOpen()
+      || this->DataBase.databaseName().isEmpty()
+      || this->DataBase.databaseName() == ":memory:")
     {
-    return indexList;
-    }
-  for (int column = 0 ; column < this->Headers.size(); ++column)
-    {
-    indexList.append(q->createIndex(row, column, parentNode));
+    return;
     }
-  return indexList;
+  this->Loader = new ctkDICOMModelLoader(this->DataBase);
+  this->Loader->moveToThread(&this->LoaderThread);
+  connect(this, SIGNAL(pageRequested(ctkDICOMModelPage)),
+          this->Loader, SLOT(load(ctkDICOMModelPage)));
+  connect(this->Loader, SIGNAL(loaded(ctkDICOMModelPage)),
+          this, SLOT(onPageLoaded(ctkDICOMModelPage)));
+  this->LoaderThread.start(QThread::LowPriority);
 }
 
 //------------------------------------------------------------------------------
-QModelIndexList ctkDICOMModelPrivate::modelIndexList(Node* node)const
+void ctkDICOMModelPrivate::stopLoader()
 {
-  QModelIndexList list;
-  if (node == 0)
+  if (!this->Loader)
     {
-    node = this->RootNode;
-    }
-  foreach(Node* child, node->Children)
-    {
-    list.append(this->indexListFromNode(child));
-    }
-  foreach(Node* child, node->Children)
-    {
-    list.append(this->modelIndexList(child));
+    return;
     }
-  return list;
+  QMetaObject::invokeMethod(this->Loader, "close", Qt::BlockingQueuedConnection);
+  this->LoaderThread.quit();
+  this->LoaderThread.wait();
+  delete this->Loader;
+  this->Loader = 0;
 }
 
 //------------------------------------------------------------------------------
-int ctkDICOMModelPrivate::childrenCount(Node* node)const
+Node* ctkDICOMModelPrivate::nodeFromIndex(const QModelIndex& indexValue)const
 {
-  int count = 0;
-  if (node == 0)
-    {
-    node = this->RootNode;
-    }
-  count += node->Children.size();
-  foreach(Node* child, node->Children)
-    {
-    count += this->childrenCount(child);
-    }
-  return count;
+  return indexValue.isValid() ? reinterpret_cast<Node*>(indexValue.internalPointer()) : this->RootNode;
 }
-*/
 
 //------------------------------------------------------------------------------
 Node* ctkDICOMModelPrivate::createNode(int row, const QModelIndex& parentValue)const
 {
   Node* node = new Node;
   Node* nodeParent = 0;
+  node->ChildCount = -1;
   if (row == -1)
     {// root node
     node->Type = ctkDICOMModel::RootType;
@@ -232,6 +273,7 @@ Node* ctkDICOMModelPrivate::createNode(int row, const QModelIndex& parentValue)c
     {
     nodeParent = this->nodeFromIndex(parentValue); 
     nodeParent->Children.push_back(node);
+    nodeParent->ChildrenByRow.insert(row, node);
     node->Parent = nodeParent;
     node->Type = ctkDICOMModel::IndexType(nodeParent->Type + 1);
     }
@@ -240,6 +282,11 @@ Node* ctkDICOMModelPrivate::createNode(int row, const QModelIndex& parentValue)c
     {
     int field = 0;//nodeParent->Query.record().indexOf("UID");
     node->UID = this->value(parentValue, row, field).toString();
+    int childCountField = nodeParent->Fields.indexOf(ChildCountField);
+    if (childCountField >= 0)
+      {
+      node->ChildCount = this->value(nodeParent, row, childCountField).toInt();
+      }
 #if CHECKABLE_COLUMNS
     node->Data[Qt::CheckStateRole] = node->Parent->Data[Qt::CheckStateRole];
 #endif
@@ -248,6 +295,7 @@ Node* ctkDICOMModelPrivate::createNode(int row, const QModelIndex& parentValue)c
   node->RowCount = 0;
   node->AtEnd = false;
   node->Fetching = false;
+  node->Prefetching = false;
 
   this->updateQueries(node);
   
@@ -260,7 +308,7 @@ QVariant ctkDICOMModelPrivate::value(const QModelIndex& parentValue, int row, in
   Node* node = this->nodeFromIndex(parentValue);
   if (row >= node->RowCount)
     {      
-    const_cast<ctkDICOMModelPrivate *>(this)->fetch(parentValue, row + 256);
+    const_cast<ctkDICOMModelPrivate *>(this)->fetch(parentValue, row + this->PageSize);
     }
   return this->value(node, row, column);
 }
@@ -268,155 +316,365 @@ QVariant ctkDICOMModelPrivate::value(const QModelIndex& parentValue, int row, in
 //------------------------------------------------------------------------------
 QVariant ctkDICOMModelPrivate::value(Node* parentNode, int row, int column) const
 {
-  if (row < 0 || column < 0 || !parentNode || row >= parentNode->RowCount)
-    {
-    return QVariant();
-    }
-  
-  if (!parentNode->Query.seek(row))
+  if (row < 0 || column < 0 || !parentNode || row >= parentNode->RowCount
+      || column >= parentNode->Rows[row].count())
     {
-    qDebug() << parentNode->Query.lastError();
-    Q_ASSERT(parentNode->Query.seek(row));
     return QVariant();
     }
-  QVariant res = parentNode->Query.value(column);
-  Q_ASSERT(res.isValid());
-  return res;
+  return parentNode->Rows[row][column];
 }
 
 //------------------------------------------------------------------------------
-QString ctkDICOMModelPrivate::generateQuery(const QString& fields, const QString& table, const QString& conditions)const
+void ctkDICOMModelPrivate::searchConditions(ctkDICOMModel::IndexType type,
+                                            QStringList& conditions, QVariantList& values)const
 {
-  QString res = QString("SELECT ") + fields + QString(" FROM ") + table;
-  if (!conditions.isEmpty())
+  switch(type)
     {
-    res += QString(" WHERE ") + conditions;
+    case ctkDICOMModel::PatientType:
+      if(this->SearchParameters["Name"].toString() != "")
+        {
+        this->textCondition("Patients.UID", "PatientsText", "Patients.PatientsName",
+                            this->SearchParameters["Name"].toString(), conditions, values);
+        }
+      break;
+    case ctkDICOMModel::StudyType:
+      if(this->SearchParameters["Study"].toString() != "")
+        {
+        this->textCondition("Studies.rowid", "StudiesText", "Studies.StudyDescription",
+                            this->SearchParameters["Study"].toString(), conditions, values);
+        }
+      if(this->SearchParameters["Modalities"].value<QStringList>().count() > 0)
+        {
+        QStringList modalities = this->SearchParameters["Modalities"].value<QStringList>();
+        QStringList placeholders;
+        foreach(const QString& modality, modalities)
+          {
+          placeholders << "?";
+          values << modality;
+          }
+        conditions << "Studies.ModalitiesInStudy IN (" + placeholders.join(",") + ")";
+        }
+      if(this->SearchParameters["StartDate"].toString() != "" &&
+         this->SearchParameters["EndDate"].toString() != "")
+        {
+        conditions << "Studies.StudyDate BETWEEN ? AND ?";
+        values << QDate::fromString(this->SearchParameters["StartDate"].toString(), "yyyyMMdd").toString("yyyy-MM-dd")
+               << QDate::fromString(this->SearchParameters["EndDate"].toString(), "yyyyMMdd").toString("yyyy-MM-dd");
+        }
+      break;
+    case ctkDICOMModel::SeriesType:
+      if(this->SearchParameters["Series"].toString() != "")
+        {
+        this->textCondition("Series.rowid", "SeriesText", "Series.SeriesDescription",
+                            this->SearchParameters["Series"].toString(), conditions, values);
+        }
+      break;
+    case ctkDICOMModel::ImageType:
+      if(this->SearchParameters["ID"].toString() != "")
+        {
+        conditions << "Images.SOPInstanceUID LIKE ?";
+        values << "%" + this->SearchParameters["ID"].toString() + "%";
+        }
+      break;
+    default:
+      break;
     }
-  if (!this->Sort.isEmpty())
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::textCondition(const QString& key, const QString& textTable,
+                                         const QString& column, const QString& text,
+                                         QStringList& conditions, QVariantList& values)const
+{
+  // the full text index matches words starting with the searched ones
+  QStringList words = text.split(QRegExp("[\\W_]+"), QString::SkipEmptyParts);
+  if (!this->FullTextSearch || words.isEmpty())
     {
-    res += QString(" ORDER BY ") + this->Sort;
+    conditions << column + " LIKE ?";
+    values << "%" + text + "%";
+    return;
     }
-  logger.debug ( "ctkDICOMModelPrivate::generateQuery: query is: " + res );
-  return res;
+  conditions << QString("%1 IN (SELECT docid FROM %2 WHERE %2 MATCH ?)").arg(key).arg(textTable);
+  values << words.join("* ") + "*";
 }
 
 //------------------------------------------------------------------------------
 void ctkDICOMModelPrivate::updateQueries(Node* node)const
 {
-  // are you kidding me, it should be virtualized here :-)
-  QString query;
-  QString condition;
+  // The statement is the same for all the nodes of a level, only the bound
+  // values change: the prepared queries are shared between the nodes.
+  ctkDICOMModel::IndexType childType = ctkDICOMModel::IndexType(node->Type + 1);
+  QString fields;
+  QString table;
+  QString parentCondition;
+  QString childCount("0");
+  QString childCountColumn;
+  QVariantList childCountValues;
   switch(node->Type)
     {
     default:
       Q_ASSERT(node->Type == ctkDICOMModel::RootType);
       break;
     case ctkDICOMModel::RootType:
-      //query = QString("SELECT  FROM ");
-      if(this->SearchParameters["Name"].toString() != ""){
-        condition.append("PatientsName LIKE \"%" + this->SearchParameters["Name"].toString() + "%\"");
-      }
-      query = this->generateQuery("UID as UID, PatientsName as Name, PatientsAge as Age, PatientsBirthDate as Date, PatientID as \"Subject ID\"","Patients", condition);
-      logger.debug ( "ctkDICOMModelPrivate::updateQueries for Root: query is: " + query );
+      fields = "UID as UID, PatientsName as Name, PatientsAge as Age, PatientsBirthDate as Date, PatientID as \"Subject ID\"";
+      table = "Patients";
+      childCount = "SELECT COUNT(*) FROM Studies WHERE Studies.PatientsUID = Patients.UID";
+      childCountColumn = "Patients.StudiesCount";
       break;
     case ctkDICOMModel::PatientType:
-      //query = QString("SELECT  FROM Studies WHERE PatientsUID='%1'").arg(node->UID);
-      if(this->SearchParameters["Study"].toString() != "")
-        {
-        condition.append("StudyDescription LIKE \"%" + this->SearchParameters["Study"].toString() + "%\"" + " AND ");
-        }
-      if(this->SearchParameters["Modalities"].value<QStringList>().count() > 0)
-        {
-        condition.append("ModalitiesInStudy IN (\"" + this->SearchParameters["Modalities"].value<QStringList>().join("\",\"") + "\") AND ");
-        }
-      if(this->SearchParameters["StartDate"].toString() != "" &&
-         this->SearchParameters["EndDate"].toString() != "")
-        {
-          condition.append(" ( StudyDate BETWEEN \'" + QDate::fromString(this->SearchParameters["StartDate"].toString(), "yyyyMMdd").toString("yyyy-MM-dd")
-                           + "\' AND \'" + QDate::fromString(this->SearchParameters["EndDate"].toString(), "yyyyMMdd").toString("yyyy-MM-dd") + "\' ) AND ");
-        }
-      query = this->generateQuery("StudyInstanceUID as UID, StudyDescription as Name, ModalitiesInStudy as Scan, StudyDate as Date, AccessionNumber as Number, InstitutionName as Institution, ReferringPhysician as Referrer, PerformingPhysiciansName as Performer", "Studies", condition + QString("PatientsUID='%1'").arg(node->UID));
-      logger.debug ( "ctkDICOMModelPrivate::updateQueries for Patient: query is: " + query );
+      fields = "StudyInstanceUID as UID, StudyDescription as Name, ModalitiesInStudy as Scan, StudyDate as Date, AccessionNumber as Number, InstitutionName as Institution, ReferringPhysician as Referrer, PerformingPhysiciansName as Performer";
+      table = "Studies";
+      parentCondition = "Studies.PatientsUID = ?";
+      childCount = "SELECT COUNT(*) FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID";
+      childCountColumn = "Studies.SeriesCount";
       break;
     case ctkDICOMModel::StudyType:
-      //query = QString("SELECT SeriesInstanceUID as UID, SeriesDescription as Name, BodyPartExamined as Scan, SeriesDate as Date, AcquisitionNumber as Number FROM Series WHERE StudyInstanceUID='%1'").arg(node->UID);
-      if(this->SearchParameters["Series"].toString() != "")
-        {
-        condition.append("SeriesDescription LIKE \"%" + this->SearchParameters["Series"].toString() + "%\"" + " AND ");
-        }
-      query = this->generateQuery("SeriesInstanceUID as UID, SeriesDescription as Name, Modality as Age, SeriesNumber as Scan, BodyPartExamined as \"Subject ID\", SeriesDate as Date, AcquisitionNumber as Number","Series",condition + QString("StudyInstanceUID='%1'").arg(node->UID));
-      logger.debug ( "ctkDICOMModelPrivate::updateQueries for Study: query is: " + query );
+      fields = "SeriesInstanceUID as UID, SeriesDescription as Name, Modality as Age, SeriesNumber as Scan, BodyPartExamined as \"Subject ID\", SeriesDate as Date, AcquisitionNumber as Number";
+      table = "Series";
+      parentCondition = "Series.StudyInstanceUID = ?";
+      childCount = "SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID";
+      childCountColumn = "Series.ImagesCount";
       break;
     case ctkDICOMModel::SeriesType:
-      if(this->SearchParameters["ID"].toString() != "")
-        {
-        condition.append("SOPInstanceUID LIKE \"%" + this->SearchParameters["ID"].toString() + "%\"" + " AND ");
-        }
-      //query = QString("SELECT Filename as UID, Filename as Name, SeriesInstanceUID as Date FROM Images WHERE SeriesInstanceUID='%1'").arg(node->UID);
-      query = this->generateQuery("SOPInstanceUID as UID, Filename as Name, SeriesInstanceUID as Date", "Images", condition + QString("SeriesInstanceUID='%1'").arg(node->UID));
-      logger.debug ( "ctkDICOMModelPrivate::updateQueries for Series: query is: " + query );
+      fields = "SOPInstanceUID as UID, Filename as Name, SeriesInstanceUID as Date";
+      table = "Images";
+      parentCondition = "Images.SeriesInstanceUID = ?";
       break;
     case ctkDICOMModel::ImageType:
+      node->Statement = QString();
+      node->BoundValues.clear();
+      return;
+    }
+
+  // the children of the rows are counted in the same query, as long as
+  // the rows can have children in the model
+  if (childCount != "0" && childType < this->EndLevel)
+    {
+    QStringList childConditions;
+    this->searchConditions(ctkDICOMModel::IndexType(childType + 1), childConditions, childCountValues);
+    if (childConditions.isEmpty() && this->ChildrenCounts)
+      {
+      // nothing filtered, the count kept by the database is enough
+      childCount = childCountColumn;
+      }
+    foreach(const QString& condition, childConditions)
+      {
+      childCount += " AND " + condition;
+      }
+    }
+  else
+    {
+    childCount = "0";
+    }
+
+  QStringList conditions;
+  QVariantList conditionValues;
+  this->searchConditions(childType, conditions, conditionValues);
+  if (!parentCondition.isEmpty())
+    {
+    conditions << parentCondition;
+    conditionValues << node->UID;
+    }
+  if (conditions.isEmpty())
+    {
+    conditions << "1";
+    }
+
+  // SQLite resolves the select list aliases in ORDER BY only, the sort key
+  // is computed from the column the sorted header is an alias of
+  QString sortKey("''");
+  foreach(const QString& field, fields.split(", "))
+    {
+    QString alias = field.section(" as ", 1);
+    alias.remove('"');
+    if (!this->SortColumn.isEmpty() && alias == this->SortColumn)
+      {
+      sortKey = QString("IFNULL(%1.%2, '')").arg(table).arg(field.section(" as ", 0, 0));
       break;
+      }
     }
-  node->Query = QSqlQuery(query, this->DataBase);
+  node->Statement = QString("SELECT %1, (%2) AS %3, %4 AS %5, %6.rowid AS %7 FROM %6 WHERE %8")
+    .arg(fields).arg(childCount).arg(ChildCountField)
+    .arg(sortKey).arg(SortKeyField)
+    .arg(table).arg(RowKeyField)
+    .arg(conditions.join(" AND "));
+  node->BoundValues = childCountValues + conditionValues;
+  logger.debug ( "ctkDICOMModelPrivate::updateQueries: query is: " + node->Statement );
+
   foreach(Node* child, node->Children)
     {
     this->updateQueries(child);
     }
 }
 
+//------------------------------------------------------------------------------
+ctkDICOMModelPage ctkDICOMModelPrivate::nextPage(Node* node, int limit)const
+{
+  ctkDICOMModelPage page;
+  page.ParentNode = node;
+  page.Generation = this->Generation;
+  page.Statement = node->Statement;
+  page.BoundValues = node->BoundValues;
+  if (!node->Rows.isEmpty())
+    {
+    // start right after the last row loaded, an index seek
+    const QVariantList& lastRow = node->Rows.last();
+    int sortKeyField = node->Fields.indexOf(SortKeyField);
+    int rowKeyField = node->Fields.indexOf(RowKeyField);
+    page.AfterKey = lastRow[rowKeyField].toLongLong();
+    if (this->SortColumn.isEmpty())
+      {
+      page.Statement += QString(" AND %1 > ?").arg(RowKeyField);
+      page.BoundValues << page.AfterKey;
+      }
+    else
+      {
+      page.Statement += QString(" AND (%1 %2 ? OR (%1 = ? AND %3 > ?))")
+        .arg(SortKeyField)
+        .arg(this->SortOrder == Qt::AscendingOrder ? ">" : "<")
+        .arg(RowKeyField);
+      page.BoundValues << lastRow[sortKeyField] << lastRow[sortKeyField] << page.AfterKey;
+      }
+    }
+  page.Statement += QString(" ORDER BY %1 %2, %3 LIMIT ?")
+    .arg(SortKeyField)
+    .arg(this->SortOrder == Qt::AscendingOrder ? "ASC" : "DESC")
+    .arg(RowKeyField);
+  page.BoundValues << limit;
+  return page;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMModelPrivate::loadPage(ctkDICOMModelPage& page)const
+{
+  if (!this->PreparedQueries.contains(page.Statement))
+    {
+    QSqlQuery query(this->DataBase);
+    if (!query.prepare(page.Statement))
+      {
+      logger.error("SQLITE ERROR: " + query.lastError().driverText());
+      return false;
+      }
+    this->PreparedQueries.insert(page.Statement, query);
+    }
+  QSqlQuery query = this->PreparedQueries.value(page.Statement);
+  return ctkDICOMModelLoader::loadPage(query, page);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::prefetch(Node* node)
+{
+  if (!this->Loader || node->AtEnd || node->Prefetching
+      || !node->Prefetched.Rows.isEmpty() || node->Statement.isEmpty())
+    {
+    return;
+    }
+  node->Prefetching = true;
+  emit this->pageRequested(this->nextPage(node, this->PageSize));
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::onPageLoaded(ctkDICOMModelPage page)
+{
+  if (page.Generation != this->Generation)
+    {
+    // the node was deleted by a reset of the model
+    return;
+    }
+  Node* node = page.ParentNode;
+  node->Prefetching = false;
+  qlonglong lastKey = -1;
+  if (!node->Rows.isEmpty())
+    {
+    lastKey = node->Rows.last()[node->Fields.indexOf(RowKeyField)].toLongLong();
+    }
+  if (page.AfterKey != lastKey)
+    {
+    // rows were loaded in the meantime, the page doesn't follow anymore
+    return;
+    }
+  node->Prefetched = page;
+}
+
 //------------------------------------------------------------------------------
 void ctkDICOMModelPrivate::fetch(const QModelIndex& indexValue, int limit)
 {
   Q_Q(ctkDICOMModel);
   Node* node = this->nodeFromIndex(indexValue);
-  if (node->AtEnd || limit <= node->RowCount || node->Fetching/*|| bottom.column() == -1*/)
+  if (!node || node->AtEnd || limit <= node->RowCount || node->Fetching/*|| bottom.column() == -1*/)
     {
     return;
     }
   node->Fetching = true;
 
-  int newRowCount;
-  const int oldRowCount = node->RowCount;
-
-  // try to seek directly
-  if (node->Query.seek(limit - 1)) 
-    {
-    newRowCount = limit;
-    } 
-  else 
+  QList<QVariantList> newRows;
+  int missingRows = limit - node->RowCount;
+  while (missingRows > 0 && !node->AtEnd)
     {
-    newRowCount = qMax(oldRowCount, 1);
-    if (node->Query.seek(newRowCount - 1)) 
+    ctkDICOMModelPage page;
+    if (!node->Prefetched.Rows.isEmpty())
       {
-      while (node->Query.next())
+      // loaded in the background
+      page = node->Prefetched;
+      node->Prefetched = ctkDICOMModelPage();
+      }
+    else
+      {
+      page = this->nextPage(node, qMax(missingRows, this->PageSize));
+      if (!this->loadPage(page))
         {
-        ++newRowCount;
+        node->AtEnd = true;
+        break;
         }
-      } 
-    else 
+      }
+    node->Fields = page.Fields;
+    node->Rows += page.Rows;
+    newRows += page.Rows;
+    missingRows -= page.Rows.count();
+    int requested = page.BoundValues.last().toInt();
+    if (page.Rows.count() < requested
+        || (node->ChildCount >= 0 && node->Rows.count() >= node->ChildCount))
       {
-      // empty or invalid query
-      newRowCount = 0;
+      node->AtEnd = true;
       }
-    node->AtEnd = true; // this is the end.
     }
-  if (newRowCount > 0 && newRowCount > node->RowCount) 
+
+  if (!newRows.isEmpty())
     {
-    q->beginInsertRows(indexValue, node->RowCount, newRowCount - 1);
-    node->RowCount = newRowCount;
+    q->beginInsertRows(indexValue, node->RowCount, node->Rows.count() - 1);
+    node->RowCount = node->Rows.count();
     node->Fetching = false;
     q->endInsertRows();
-    } 
-  else 
+    }
+  else
     {
-    node->RowCount = newRowCount;
+    node->RowCount = node->Rows.count();
     node->Fetching = false;
     }
+  // load the next page while the view shows this one
+  this->prefetch(node);
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::resetRoot()
+{
+  Q_Q(ctkDICOMModel);
+  q->beginResetModel();
+  delete this->RootNode;
+  this->RootNode = 0;
+  ++this->Generation;
+  this->PreparedQueries.clear();
+
+  if (this->DataBase.tables().empty())
+    {
+    //Q_ASSERT(this->DataBase.isOpen());
+    q->endResetModel();
+    return;
+    }
 
+  this->RootNode = this->createNode(-1, QModelIndex());
+  q->endResetModel();
+}
 
 //------------------------------------------------------------------------------
 ctkDICOMModel::ctkDICOMModel(QObject* parentObject)
@@ -486,10 +744,10 @@ QVariant ctkDICOMModel::data ( const QModelIndex & dataIndex, int role ) const
   Node* parentNode = d->nodeFromIndex(parentIndex);
   if (dataIndex.row() >= parentNode->RowCount)
     {      
-    const_cast<ctkDICOMModelPrivate *>(d)->fetch(dataIndex, dataIndex.row());
+    const_cast<ctkDICOMModelPrivate *>(d)->fetch(parentIndex, dataIndex.row() + 1);
     }
   QString columnName = d->Headers[dataIndex.column()][Qt::DisplayRole].toString();
-  int field = parentNode->Query.record().indexOf(columnName);
+  int field = parentNode->Fields.indexOf(columnName);
   if (field < 0)
     {
     // Not all the columns are in the record, it's ok to have no field here.
@@ -514,7 +772,7 @@ void ctkDICOMModel::fetchMore ( const QModelIndex & parentValue )
 {
   Q_D(ctkDICOMModel);
   Node* node = d->nodeFromIndex(parentValue);
-  d->fetch(parentValue, qMax(node->RowCount, 0) + 256);
+  d->fetch(parentValue, qMax(node->RowCount, 0) + d->PageSize);
 }
 
 //------------------------------------------------------------------------------
@@ -561,15 +819,19 @@ bool ctkDICOMModel::hasChildren ( const QModelIndex & parentIndex ) const
   if (node->RowCount == 0 && !node->AtEnd)
     {
     // We don't want to fetch the data because we don't want to add children
-    // to the index yet (it would be a mess to add rows inside a hasChildren)
-    //const_cast<qCTKDCMTKModelPrivate*>(d)->fetch(parentIndex, 1);
-    bool res = node->Query.seek(0);
-    if (!res)
+    // to the index yet (it would be a mess to add rows inside a hasChildren).
+    // The number of children was counted by the query of the parent.
+    if (node->ChildCount < 0)
+      {
+      ctkDICOMModelPage page = d->nextPage(node, 1);
+      node->ChildCount = d->loadPage(page) ? page.Rows.count() : 0;
+      }
+    if (node->ChildCount == 0)
       {
       // now we know there is no children to the node, don't try next time.
       node->AtEnd = true;
       }
-    return res;
+    return node->ChildCount > 0;
     }
   return node->RowCount > 0;
 }
@@ -603,21 +865,17 @@ QModelIndex ctkDICOMModel::index ( int row, int column, const QModelIndex & pare
     return QModelIndex();
     }
   Node* parentNode = d->nodeFromIndex(parentIndex);
-  int field = 0;// always 0//parentNode->Query.record().indexOf("UID");
-  QString uid = d->value(parentIndex, row, field).toString();
-  Node* node = 0;
-  foreach(Node* tmpNode, parentNode->Children)
-    {
-    if (tmpNode->UID == uid)
-      {
-      node = tmpNode;
-      break;
-      }
-    }
+  // rows are only appended until the next reset, a row always refers to
+  // the same node
+  Node* node = parentNode->ChildrenByRow.value(row, 0);
   // TODO: Here it is assumed that ctkDICOMModel::index is called with valid
   // arguments, we should probably be a bit more careful.
   if (node == 0)
     {
+    if (row >= parentNode->RowCount)
+      {
+      const_cast<ctkDICOMModelPrivate *>(d)->fetch(parentIndex, row + d->PageSize);
+      }
     node = d->createNode(row, parentIndex);
     }
   return this->createIndex(row, column, node);
@@ -794,34 +1052,19 @@ void ctkDICOMModel::setDatabase(const QSqlDatabase &db)
 {
   Q_D(ctkDICOMModel);
 
-  this->beginResetModel();
+  d->stopLoader();
   d->DataBase = db;
-  
-  delete d->RootNode;
-  d->RootNode = 0;
-
-  if (d->DataBase.tables().empty())
+  // added by the schema 0.6, the full text tables are optional
+  QStringList tables = db.tables();
+  d->FullTextSearch = tables.contains("PatientsText")
+    && tables.contains("StudiesText") && tables.contains("SeriesText");
+  d->ChildrenCounts = db.record("Series").contains("ImagesCount");
+  d->resetRoot();
+  if (d->RootNode)
     {
-    //Q_ASSERT(d->DataBase.isOpen());
-    this->endResetModel();
-    return;
+    d->startLoader();
+    d->fetch(QModelIndex(), d->PageSize);
     }
-    
-  d->RootNode = d->createNode(-1, QModelIndex());
-  
-  this->endResetModel();
-
-  // TODO, use hasQuerySize everywhere, not only in setDataBase()
-  bool hasQuerySize = d->RootNode->Query.driver()->hasFeature(QSqlDriver::QuerySize);
-  if (hasQuerySize && d->RootNode->Query.size() > 0) 
-    {
-    int newRowCount= d->RootNode->Query.size();
-    beginInsertRows(QModelIndex(), 0, qMax(0, newRowCount - 1));
-    d->RootNode->RowCount = newRowCount;
-    d->RootNode->AtEnd = true;
-    endInsertRows();
-    }
-  d->fetch(QModelIndex(), 256);
 }
 
 //------------------------------------------------------------------------------
@@ -829,35 +1072,8 @@ void ctkDICOMModel::setDatabase(const QSqlDatabase &db,const QMap<QString, QVari
 {
   Q_D(ctkDICOMModel);
 
-  this->beginResetModel();
-  d->DataBase = db;
   d->SearchParameters = parameters;
-
-  delete d->RootNode;
-  d->RootNode = 0;
-
-  if (d->DataBase.tables().empty())
-    {
-    //Q_ASSERT(d->DataBase.isOpen());
-    this->endResetModel();
-    return;
-    }
-
-  d->RootNode = d->createNode(-1, QModelIndex());
-
-  this->endResetModel();
-
-  // TODO, use hasQuerySize everywhere, not only in setDataBase()
-  bool hasQuerySize = d->RootNode->Query.driver()->hasFeature(QSqlDriver::QuerySize);
-  if (hasQuerySize && d->RootNode->Query.size() > 0)
-    {
-    int newRowCount= d->RootNode->Query.size();
-    beginInsertRows(QModelIndex(), 0, qMax(0, newRowCount - 1));
-    d->RootNode->RowCount = newRowCount;
-    d->RootNode->AtEnd = true;
-    endInsertRows();
-    }
-  d->fetch(QModelIndex(), 256);
+  this->setDatabase(db);
 }
 
 //------------------------------------------------------------------------------
@@ -901,15 +1117,9 @@ void ctkDICOMModel::sort(int column, Qt::SortOrder order)
   this->changePersistentIndexList(oldIndexList, newIndexList);
   emit layoutChanged();
   */
-  this->beginResetModel();
-  delete d->RootNode;
-  d->RootNode = 0;
-  d->Sort = QString("\"%1\" %2")
-    .arg(d->Headers[column][Qt::DisplayRole].toString())
-    .arg(order == Qt::AscendingOrder ? "ASC" : "DESC");
-  d->RootNode = d->createNode(-1, QModelIndex());
-  
-  this->endResetModel();
+  d->SortColumn = d->Headers[column][Qt::DisplayRole].toString();
+  d->SortOrder = order;
+  d->resetRoot();
 }
 
 //------------------------------------------------------------------------------
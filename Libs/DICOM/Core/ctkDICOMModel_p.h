@@ -0,0 +1,159 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMModel_p_h
+#define __ctkDICOMModel_p_h
+
+// Qt includes
+#include <QHash>
+#include <QMetaType>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QThread>
+#include <QVariant>
+
+// ctkDICOMCore includes
+#include "ctkDICOMModel.h"
+
+struct Node;
+
+//------------------------------------------------------------------------------
+/// One page of the children of a node, loaded with a keyset query
+struct ctkDICOMModelPage
+{
+  ctkDICOMModelPage() : ParentNode(0), Generation(0), AfterKey(-1) {}
+
+  Node*        ParentNode;
+  /// the page is dropped if the model was reset since it was requested
+  int          Generation;
+  /// key of the last row of the parent when the page was requested
+  qlonglong    AfterKey;
+  QString      Statement;
+  QVariantList BoundValues;
+  QStringList  Fields;
+  QList<QVariantList> Rows;
+};
+
+Q_DECLARE_METATYPE(ctkDICOMModelPage)
+
+//------------------------------------------------------------------------------
+/// Runs the page queries of the model on its own database connection in
+/// a background thread, so that the next page is already loaded when the
+/// view asks for it.
+class ctkDICOMModelLoader : public QObject
+{
+  Q_OBJECT
+public:
+  /// The connection parameters are copied from database, the connection
+  /// itself is opened in the loader thread
+  ctkDICOMModelLoader(const QSqlDatabase& database);
+  virtual ~ctkDICOMModelLoader();
+
+  /// Run the query of the page and fill its rows and fields
+  static bool loadPage(QSqlQuery& query, ctkDICOMModelPage& page);
+
+public Q_SLOTS:
+  void load(ctkDICOMModelPage page);
+  /// Close the connection, must be called in the loader thread
+  void close();
+
+Q_SIGNALS:
+  void loaded(ctkDICOMModelPage page);
+
+private:
+  QString ConnectionName;
+  QHash<QString, QSqlQuery> PreparedQueries;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMModelPrivate : public QObject
+{
+  Q_OBJECT
+  Q_DECLARE_PUBLIC(ctkDICOMModel);
+protected:
+  ctkDICOMModel* const q_ptr;
+
+public:
+  ctkDICOMModelPrivate(ctkDICOMModel&);
+  virtual ~ctkDICOMModelPrivate();
+  void init();
+
+  void fetch(const QModelIndex& indexValue, int limit);
+  Node* createNode(int row, const QModelIndex& parentValue)const;
+  Node* nodeFromIndex(const QModelIndex& indexValue)const;
+  // move it in the Node struct
+  QVariant value(Node* parentValue, int row, int field)const;
+  QVariant value(const QModelIndex& indexValue, int row, int field)const;
+  void updateQueries(Node* node)const;
+
+  /// search conditions on the rows of the given type, with their values
+  void searchConditions(ctkDICOMModel::IndexType type,
+                        QStringList& conditions, QVariantList& values)const;
+  /// condition on the words of a name or description, with the full text
+  /// index if the database has one
+  void textCondition(const QString& key, const QString& textTable,
+                     const QString& column, const QString& text,
+                     QStringList& conditions, QVariantList& values)const;
+  /// statement and values of the page following the last loaded row
+  ctkDICOMModelPage nextPage(Node* node, int limit)const;
+  /// page loaded on the GUI thread connection
+  bool loadPage(ctkDICOMModelPage& page)const;
+  /// ask the loader for the page after the last loaded row
+  void prefetch(Node* node);
+
+  /// (re)create the root node for the current database, sort and search
+  void resetRoot();
+  /// start/stop the background connection
+  void startLoader();
+  void stopLoader();
+
+  Node*        RootNode;
+  QSqlDatabase DataBase;
+  QList<QMap<int, QVariant> > Headers;
+  /// header of the sort column, no sort if empty
+  QString      SortColumn;
+  Qt::SortOrder SortOrder;
+  QMap<QString, QVariant> SearchParameters;
+
+  ctkDICOMModel::IndexType StartLevel;
+  ctkDICOMModel::IndexType EndLevel;
+
+  /// incremented each time the nodes are deleted
+  int Generation;
+  int PageSize;
+  /// schema features of the database, see ctkDICOMDatabase::schemaVersion()
+  bool FullTextSearch;
+  bool ChildrenCounts;
+  /// prepared statements of the GUI thread connection
+  mutable QHash<QString, QSqlQuery> PreparedQueries;
+
+  QThread LoaderThread;
+  ctkDICOMModelLoader* Loader;
+
+public Q_SLOTS:
+  void onPageLoaded(ctkDICOMModelPage page);
+
+Q_SIGNALS:
+  void pageRequested(ctkDICOMModelPage page);
+};
+
+#endif
@@ -25,12 +25,15 @@
 #include <QDate>
 #include <QStringList>
 #include <QSet>
+#include <QRunnable>
 #include <QFile>
 #include <QDirIterator>
 #include <QFileInfo>
 #include <QDebug>
+#include <QAtomicInt>
 
 // ctkDICOMCore includes
+#include "ctkDICOMAssociationPool_p.h"
 #include "ctkDICOMQuery.h"
 #include "ctkLogger.h"
 
@@ -87,6 +90,10 @@ public:
   /// Add a StudyInstanceUID to be queried
   void addStudyInstanceUIDAndDataset(const QString& StudyInstanceUID, DcmDataset* dataset );
 
+  /// Run the series level requests of the pool on a new association,
+  /// called by each ctkDICOMQueryWorker
+  void findSeries();
+
   QString                 CallingAETitle;
   QString                 CalledAETitle;
   QString                 Host;
@@ -97,7 +104,26 @@ public:
   DcmDataset*             Query;
   QStringList             StudyInstanceUIDList;
   QList<DcmDataset*>      StudyDatasetList;
-  bool                    Canceled;
+  /// set by cancel() while the workers are running
+  QAtomicInt              Canceled;
+  /// series level filter, in dicom style
+  QString                 SeriesDescription;
+  /// the series of the studies are queried on several associations
+  ctkDICOMAssociationPool Pool;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMQueryWorker : public QRunnable
+{
+public:
+  ctkDICOMQueryWorker(ctkDICOMQueryPrivate* query) : Query(query) {}
+  virtual void run()
+    {
+    this->Query->findSeries();
+    this->Query->Pool.workerFinished();
+    }
+protected:
+  ctkDICOMQueryPrivate* Query;
 };
 
 //------------------------------------------------------------------------------
@@ -108,7 +134,7 @@ ctkDICOMQueryPrivate::ctkDICOMQueryPrivate()
 {
   this->Query = new DcmDataset();
   this->Port = 0;
-  this->Canceled = false;
+  this->Canceled = 0;
   this->PreferCGET = false;
 }
 
@@ -125,6 +151,75 @@ void ctkDICOMQueryPrivate::addStudyInstanceUIDAndDataset( const QString& s, DcmD
   this->StudyDatasetList.append ( dataset );
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMQueryPrivate::findSeries()
+{
+  ctkDICOMQuerySCUPrivate scu;
+  scu.query = this->SCU.query;
+  scu.setAETitle ( OFString(this->CallingAETitle.toStdString().c_str()) );
+  scu.setPeerAETitle ( OFString(this->CalledAETitle.toStdString().c_str()) );
+  scu.setPeerHostName ( OFString(this->Host.toStdString().c_str()) );
+  scu.setPeerPort ( this->Port );
+
+  OFList<OFString> transferSyntaxes;
+  transferSyntaxes.push_back ( UID_LittleEndianExplicitTransferSyntax );
+  transferSyntaxes.push_back ( UID_BigEndianExplicitTransferSyntax );
+  transferSyntaxes.push_back ( UID_LittleEndianImplicitTransferSyntax );
+  scu.addPresentationContext ( UID_FINDStudyRootQueryRetrieveInformationModel, transferSyntaxes );
+  if ( !scu.initNetwork().good() || !scu.negotiateAssociation().good() )
+    {
+    logger.error ( "Error negotiating a series level association" );
+    this->Pool.associationFailed();
+    return;
+    }
+  Uint16 presentationContext =
+    scu.findPresentationContextID ( UID_FINDStudyRootQueryRetrieveInformationModel, "" );
+
+  // a request is the study uid followed by the patient name and id
+  QStringList request;
+  while ( this->Pool.nextRequest(request) )
+    {
+    DcmDataset query;
+    query.insertEmptyElement ( DCM_SeriesNumber );
+    query.insertEmptyElement ( DCM_SeriesDescription );
+    query.insertEmptyElement ( DCM_SeriesInstanceUID );
+    query.insertEmptyElement ( DCM_SeriesDate );
+    query.insertEmptyElement ( DCM_SeriesTime );
+    query.insertEmptyElement ( DCM_Modality );
+    query.insertEmptyElement ( DCM_NumberOfSeriesRelatedInstances ); // Number of images in the series
+    query.putAndInsertOFStringArray ( DCM_SeriesDescription, this->SeriesDescription.toLatin1().data() );
+    query.putAndInsertString ( DCM_QueryRetrieveLevel, "SERIES" );
+    query.putAndInsertString ( DCM_StudyInstanceUID, request[0].toStdString().c_str() );
+
+    OFList<QRResponse *> responses;
+    OFCondition status = scu.sendFINDRequest ( presentationContext, &query, &responses );
+    for ( OFIterator<QRResponse*> it = responses.begin(); it != responses.end(); it++ )
+      {
+      DcmDataset *dataset = (*it)->m_dataset;
+      if ( status.good() && dataset != NULL )
+        {
+        // add the patient elements not provided for the series level query,
+        // the copy is inserted by the thread that owns the database
+        DcmDataset* seriesDataset = new DcmDataset( *dataset );
+        seriesDataset->putAndInsertString( DCM_PatientName, request[1].toLatin1().data() );
+        seriesDataset->putAndInsertString( DCM_PatientID, request[2].toLatin1().data() );
+        this->Pool.addResult( seriesDataset );
+        }
+      delete *it;
+      }
+    if ( status.good() )
+      {
+      logger.debug ( "Find succeded on Series level for Study: " + request[0] );
+      }
+    else
+      {
+      logger.error ( "Find on Series level failed for Study: " + request[0] );
+      }
+    this->Pool.requestDone( status.good() );
+    }
+  scu.closeAssociation ( DCMSCU_RELEASE_ASSOCIATION );
+}
+
 //------------------------------------------------------------------------------
 // ctkDICOMQuery methods
 
@@ -227,6 +322,20 @@ QMap<QString,QVariant> ctkDICOMQuery::filters()const
   return d->Filters;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMQuery::setMaximumAssociations ( int maximumAssociations )
+{
+  Q_D(ctkDICOMQuery);
+  d->Pool.setMaximumAssociations(maximumAssociations);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMQuery::maximumAssociations()const
+{
+  Q_D(const ctkDICOMQuery);
+  return d->Pool.maximumAssociations();
+}
+
 //------------------------------------------------------------------------------
 QStringList ctkDICOMQuery::studyInstanceUIDQueried()const
 {
@@ -257,7 +366,7 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
     emit progress("DB not open in Query");
     }
   emit progress(0);
-  if (d->Canceled) {return false;}
+  if (d->Canceled.fetchAndAddOrdered(0)) {return false;}
 
   d->StudyInstanceUIDList.clear();
   d->SCU.setAETitle ( OFString(this->callingAETitle().toStdString().c_str()) );
@@ -268,7 +377,7 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
   logger.error ( "Setting Transfer Syntaxes" );
   emit progress("Setting Transfer Syntaxes");
   emit progress(10);
-  if (d->Canceled) {return false;}
+  if (d->Canceled.fetchAndAddOrdered(0)) {return false;}
 
   OFList<OFString> transferSyntaxes;
   transferSyntaxes.push_back ( UID_LittleEndianExplicitTransferSyntax );
@@ -287,7 +396,7 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
   logger.debug ( "Negotiating Association" );
   emit progress("Negotiating Association");
   emit progress(20);
-  if (d->Canceled) {return false;}
+  if (d->Canceled.fetchAndAddOrdered(0)) {return false;}
 
   OFCondition result = d->SCU.negotiateAssociation();
   if (result.bad())
@@ -378,7 +487,7 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
     logger.debug("Query on study date " + dateRange);
     }
   emit progress(30);
-  if (d->Canceled) {return false;}
+  if (d->Canceled.fetchAndAddOrdered(0)) {return false;}
 
   OFList<QRResponse *> responses;
 
@@ -396,7 +505,7 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
     emit progress("Found useful presentation context");
     }
   emit progress(40);
-  if (d->Canceled) {return false;}
+  if (d->Canceled.fetchAndAddOrdered(0)) {return false;}
 
   OFCondition status = d->SCU.sendFINDRequest ( presentationContext, d->Query, &responses );
   if ( !status.good() )
@@ -410,8 +519,9 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
   logger.debug ( "Find succeded");
   emit progress("Find succeded");
   emit progress(50);
-  if (d->Canceled) {return false;}
+  if (d->Canceled.fetchAndAddOrdered(0)) {return false;}
 
+  database.beginBatchInsert();
   for ( OFIterator<QRResponse*> it = responses.begin(); it != responses.end(); it++ )
     {
     DcmDataset *dataset = (*it)->m_dataset;
@@ -423,72 +533,75 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
       d->addStudyInstanceUIDAndDataset ( StudyInstanceUID.c_str(), dataset );
       emit progress(QString("Processing: ") + QString(StudyInstanceUID.c_str()));
       emit progress(50);
-      if (d->Canceled) {return false;}
+      if (d->Canceled.fetchAndAddOrdered(0))
+        {
+        database.endBatchInsert();
+        return false;
+        }
       }
     }
+  // the series are queried on their own associations
+  d->SCU.closeAssociation ( DCMSCU_RELEASE_ASSOCIATION );
 
-  /* Only ask for series attributes now. This requires kicking out the rest of former query. */
-  d->Query->clear();
-  d->Query->insertEmptyElement ( DCM_SeriesNumber );
-  d->Query->insertEmptyElement ( DCM_SeriesDescription );
-  d->Query->insertEmptyElement ( DCM_SeriesInstanceUID );
-  d->Query->insertEmptyElement ( DCM_SeriesDate );
-  d->Query->insertEmptyElement ( DCM_SeriesTime );
-  d->Query->insertEmptyElement ( DCM_Modality );
-  d->Query->insertEmptyElement ( DCM_NumberOfSeriesRelatedInstances ); // Number of images in the series
-
-  /* Add user-defined filters */
-  d->Query->putAndInsertOFStringArray(DCM_SeriesDescription, seriesDescription.toLatin1().data());
-
-  // Now search each within each Study that was identified
-  d->Query->putAndInsertString ( DCM_QueryRetrieveLevel, "SERIES" );
-  float progressRatio = 25. / d->StudyInstanceUIDList.count();
-  int i = 0; 
-
+  /* Now search each within each Study that was identified, the requests are
+   * spread over up to maximumAssociations() associations and the series are
+   * inserted while the next requests are answered.
+   */
+  d->SeriesDescription = seriesDescription;
+  QList<QStringList> requests;
   QListIterator<DcmDataset*> datasetIterator(d->StudyDatasetList);
   foreach ( QString StudyInstanceUID, d->StudyInstanceUIDList )
     {
     DcmDataset *studyDataset = datasetIterator.next();
-    DcmElement *patientName, *patientID;
-    studyDataset->findAndGetElement(DCM_PatientName, patientName);
-    studyDataset->findAndGetElement(DCM_PatientID, patientID);
-
-    logger.debug ( "Starting Series C-FIND for Study: " + StudyInstanceUID );
-    emit progress(QString("Starting Series C-FIND for Study: ") + StudyInstanceUID);
-    emit progress(50 + (progressRatio * i++));
-    if (d->Canceled) {return false;}
-
-    d->Query->putAndInsertString ( DCM_StudyInstanceUID, StudyInstanceUID.toStdString().c_str() );
-    OFList<QRResponse *> responses;
-    status = d->SCU.sendFINDRequest ( presentationContext, d->Query, &responses );
-    if ( status.good() )
+    OFString patientName, patientID;
+    studyDataset->findAndGetOFString(DCM_PatientName, patientName);
+    studyDataset->findAndGetOFString(DCM_PatientID, patientID);
+    requests << ( QStringList() << StudyInstanceUID
+                  << QString::fromLatin1(patientName.c_str())
+                  << QString::fromLatin1(patientID.c_str()) );
+    }
+  d->Pool.setRequests(requests);
+  QList<QRunnable*> workers;
+  for (int i = 0; i < qMin(d->Pool.maximumAssociations(), requests.count()); ++i)
+    {
+    workers << new ctkDICOMQueryWorker(d);
+    }
+  logger.debug ( QString("Starting Series C-FIND for %1 studies on %2 associations")
+                 .arg(requests.count()).arg(workers.count()) );
+  emit progress(QString("Starting Series C-FIND for %1 studies").arg(requests.count()));
+  const int associations = workers.count();
+  d->Pool.start(workers);
+
+  QList<DcmDataset*> seriesDatasets;
+  while ( d->Pool.takeResults(seriesDatasets) )
+    {
+    foreach ( DcmDataset* dataset, seriesDatasets )
       {
-      for ( OFIterator<QRResponse*> it = responses.begin(); it != responses.end(); it++ )
-        {
-        DcmDataset *dataset = (*it)->m_dataset;
-        if ( dataset != NULL )
-          {
-          // add the patient elements not provided for the series level query
-          dataset->insert( patientName, true );
-          dataset->insert( patientID, true );
-          // insert series dataset 
-          database.insert ( dataset, false /* do not store */, false /* no thumbnail */ );
-          }
-        }
-      logger.debug ( "Find succeded on Series level for Study: " + StudyInstanceUID );
-      emit progress(QString("Find succeded on Series level for Study: ") + StudyInstanceUID);
-      emit progress(50 + (progressRatio * i++));
-      if (d->Canceled) {return false;}
+      // insert series dataset
+      database.insert ( dataset, false /* do not store */, false /* no thumbnail */ );
+      delete dataset;
       }
-    else
+    seriesDatasets.clear();
+    if (d->Canceled.fetchAndAddOrdered(0))
       {
-      logger.error ( "Find on Series level failed for Study: " + StudyInstanceUID );
-      emit progress(QString("Find on Series level failed for Study: ") + StudyInstanceUID);
+      // the workers finish their current request
+      d->Pool.cancel();
       }
-    emit progress(50 + (progressRatio * i++));
-    if (d->Canceled) {return false;}
+    emit progress(50 + (50 * d->Pool.completedRequests()) / qMax(1, requests.count()));
+    }
+  database.endBatchInsert();
+  if (d->Canceled.fetchAndAddOrdered(0)) {return false;}
+  if ( associations > 0 && d->Pool.failedAssociations() == associations )
+    {
+    logger.error ( "Could not negotiate any series level association" );
+    emit progress("Could not negotiate any series level association");
+    return false;
+    }
+  if ( d->Pool.completedRequests() != requests.count() || d->Pool.failedRequests() > 0 )
+    {
+    logger.error ( "Find on Series level failed for some studies" );
+    emit progress("Find on Series level failed for some studies");
     }
-  d->SCU.closeAssociation ( DCMSCU_RELEASE_ASSOCIATION );
   emit progress(100);
   return true;
 }
@@ -497,5 +610,5 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
 void ctkDICOMQuery::cancel()
 {
   Q_D(ctkDICOMQuery);
-  d->Canceled = true;
+  d->Canceled.fetchAndStoreOrdered(1);
 }
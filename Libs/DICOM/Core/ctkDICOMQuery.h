@@ -44,6 +44,7 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMQuery : public QObject
   Q_PROPERTY(QString host READ host WRITE setHost);
   Q_PROPERTY(int port READ port WRITE setPort);
   Q_PROPERTY(bool preferCGET READ preferCGET WRITE setPreferCGET);
+  Q_PROPERTY(int maximumAssociations READ maximumAssociations WRITE setMaximumAssociations);
 
 public:
   explicit ctkDICOMQuery(QObject* parent = 0);
@@ -68,6 +69,11 @@ public:
   /// false by default
   void setPreferCGET ( bool preferCGET );
   bool preferCGET()const;
+  /// Number of associations opened at most at the same time to query the
+  /// series of the studies found, each one runs its requests in its own
+  /// thread. 4 by default.
+  void setMaximumAssociations ( int maximumAssociations );
+  int maximumAssociations()const;
 
   /// Query a remote DICOM Image Store SCP
   /// You must at least set the host and port before calling query()
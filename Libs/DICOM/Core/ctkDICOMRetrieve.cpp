@@ -21,8 +21,13 @@
 #include <stdexcept>
 
 // Qt includes
+#include <QAtomicInt>
+#include <QFile>
+#include <QRunnable>
 
 // ctkDICOMCore includes
+#include "ctkDICOMAssociationPool_p.h"
+#include "ctkDICOMDataset.h"
 #include "ctkDICOMRetrieve.h"
 #include "ctkLogger.h"
 
@@ -35,6 +40,8 @@
 #include <dcmtk/dcmdata/dcfilefo.h>
 #include <dcmtk/dcmdata/dcdeftag.h>
 #include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcmetinf.h>
+#include <dcmtk/dcmdata/dcostrmf.h>
 #include <dcmtk/ofstd/ofcond.h>
 #include <dcmtk/ofstd/ofstring.h>
 #include <dcmtk/ofstd/ofstd.h>        /* for class OFStandard */
@@ -56,9 +63,13 @@ class ctkDICOMRetrieveSCUPrivate : public DcmSCU
 {
 public:
   ctkDICOMRetrieve *retrieve;
+  /// if set, the received datasets are handed over to the pool instead
+  /// of being inserted in the database by the receiving thread
+  ctkDICOMAssociationPool *pool;
   ctkDICOMRetrieveSCUPrivate()
     {
     this->retrieve = 0;
+    this->pool = 0;
     };
   ~ctkDICOMRetrieveSCUPrivate() {};
 
@@ -94,9 +105,40 @@ public:
         emit this->retrieve->progress("Got STORE request for " + qInstanceUID);
         emit this->retrieve->progress(0);
         continueCGETSession = !this->retrieve->wasCanceled();
-        if (this->retrieve && this->retrieve->database())
+        QSharedPointer<ctkDICOMDatabase> database = this->retrieve->database();
+        if (database)
           {
-          this->retrieve->database()->insert(incomingObject);
+          // the instance is written once where the database stores it and
+          // only its header is given to the database to be indexed
+          OFString studyInstanceUID, seriesInstanceUID;
+          incomingObject->findAndGetOFString(DCM_StudyInstanceUID, studyInstanceUID);
+          incomingObject->findAndGetOFString(DCM_SeriesInstanceUID, seriesInstanceUID);
+          QString fileName;
+          if (!qInstanceUID.isEmpty() && !seriesInstanceUID.empty())
+            {
+            fileName = database->storagePathForInstance(
+              studyInstanceUID.c_str(), seriesInstanceUID.c_str(), qInstanceUID);
+            }
+          DcmDataset* dataset = 0;
+          if (!fileName.isEmpty() && this->writeInstance(incomingObject, fileName))
+            {
+            dataset = this->copyHeader(incomingObject);
+            }
+          else
+            {
+            // in memory database, nothing to write
+            fileName = QString();
+            dataset = new DcmDataset(*incomingObject);
+            }
+          if (this->pool)
+            {
+            continueCGETSession = this->pool->addResult(dataset, fileName)
+              && continueCGETSession;
+            }
+          else
+            {
+            ctkDICOMRetrieveSCUPrivate::insert(*database, dataset, fileName);
+            }
           return EC_Normal;
           }
         else
@@ -109,6 +151,87 @@ public:
       return EC_IllegalCall;
     };
 
+  // write the dataset as a DICOM file in the transfer syntax it was
+  // received with, without copying it
+  static bool writeInstance(DcmDataset* dataset, const QString& fileName)
+    {
+      E_TransferSyntax xfer = dataset->getOriginalXfer();
+      if (xfer == EXS_Unknown)
+        {
+        xfer = EXS_LittleEndianExplicit;
+        }
+      // the meta header is built from the uids of the instance
+      DcmFileFormat fileFormat;
+      OFString sopClassUID, sopInstanceUID;
+      dataset->findAndGetOFString(DCM_SOPClassUID, sopClassUID);
+      dataset->findAndGetOFString(DCM_SOPInstanceUID, sopInstanceUID);
+      fileFormat.getDataset()->putAndInsertString(DCM_SOPClassUID, sopClassUID.c_str());
+      fileFormat.getDataset()->putAndInsertString(DCM_SOPInstanceUID, sopInstanceUID.c_str());
+      if (fileFormat.validateMetaInfo(xfer).bad())
+        {
+        return false;
+        }
+
+      // written next to its final location and renamed once complete, so
+      // that a canceled retrieve does not leave a truncated file behind
+      QString temporaryFileName = fileName + ".part";
+      OFCondition status = EC_Normal;
+        {
+        DcmOutputFileStream stream(temporaryFileName.toLocal8Bit().data());
+        status = stream.status();
+        if (status.good())
+          {
+          DcmMetaInfo* metaInfo = fileFormat.getMetaInfo();
+          metaInfo->transferInit();
+          status = metaInfo->write(stream, EXS_LittleEndianExplicit, EET_ExplicitLength, NULL);
+          metaInfo->transferEnd();
+          }
+        if (status.good())
+          {
+          dataset->transferInit();
+          status = dataset->write(stream, xfer, EET_ExplicitLength, NULL);
+          dataset->transferEnd();
+          }
+        }
+      QFile::remove(fileName);
+      if (status.bad() || !QFile::rename(temporaryFileName, fileName))
+        {
+        logger.error("Error saving file: " + fileName + " " + QString(status.text()));
+        QFile::remove(temporaryFileName);
+        return false;
+        }
+      return true;
+    };
+
+  // copy of the elements of the dataset but the pixel data
+  static DcmDataset* copyHeader(DcmDataset* dataset)
+    {
+      DcmDataset* header = new DcmDataset;
+      for (unsigned long i = 0; i < dataset->card(); ++i)
+        {
+        DcmElement* element = dataset->getElement(i);
+        if (element->getTag() != DCM_PixelData)
+          {
+          header->insert(OFstatic_cast(DcmElement*, element->clone()));
+          }
+        }
+      return header;
+    };
+
+  // index the dataset, stored in fileName if not empty
+  static void insert(ctkDICOMDatabase& database, DcmDataset* dataset, const QString& fileName)
+    {
+      if (fileName.isEmpty())
+        {
+        database.insert(dataset);
+        delete dataset;
+        return;
+        }
+      ctkDICOMDataset header;
+      header.InitializeFromDataset(dataset, true /* take ownership */);
+      database.insert(header, fileName, false /* already stored */, true);
+    };
+
   // called when status information from remote server
   // comes in from CGET
   virtual OFCondition handleCGETResponse(const T_ASC_PresentationContextID presID,
@@ -139,9 +262,10 @@ protected:
 public:
   ctkDICOMRetrievePrivate(ctkDICOMRetrieve& obj);
   ~ctkDICOMRetrievePrivate();
+  /// read by the workers while they receive instances
+  QAtomicInt    WasCanceled;
   /// Keep the currently negotiated connection to the 
   /// peer host open unless the connection parameters change
-  bool          WasCanceled;
   bool          KeepAssociationOpen;
   bool          ConnectionParamsChanged;
   bool          LastRetrieveType;
@@ -160,6 +284,28 @@ public:
   bool get ( const QString& studyInstanceUID,
                   const QString& seriesInstanceUID,
                   const RetrieveType retrieveType );
+  /// presentation contexts for MOVE and GET, and for the storage
+  /// requests of the peer in response to a GET
+  static void addPresentationContexts(DcmSCU& scu);
+  /// Run the study requests of the pool on a new association,
+  /// called by each ctkDICOMRetrieveWorker
+  void getStudies();
+  /// several studies are retrieved on several associations at once
+  ctkDICOMAssociationPool Pool;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMRetrieveWorker : public QRunnable
+{
+public:
+  ctkDICOMRetrieveWorker(ctkDICOMRetrievePrivate* retrieve) : Retrieve(retrieve) {}
+  virtual void run()
+    {
+    this->Retrieve->getStudies();
+    this->Retrieve->Pool.workerFinished();
+    }
+protected:
+  ctkDICOMRetrievePrivate* Retrieve;
 };
 
 //------------------------------------------------------------------------------
@@ -170,7 +316,7 @@ ctkDICOMRetrievePrivate::ctkDICOMRetrievePrivate(ctkDICOMRetrieve& obj)
   : q_ptr(&obj)
 {
   this->Database = QSharedPointer<ctkDICOMDatabase> (0);
-  this->WasCanceled = false;
+  this->WasCanceled = 0;
   this->KeepAssociationOpen = true;
   this->ConnectionParamsChanged = false;
   this->LastRetrieveType = RetrieveNone;
@@ -187,18 +333,24 @@ ctkDICOMRetrievePrivate::ctkDICOMRetrievePrivate(ctkDICOMRetrieve& obj)
   DcmRLEDecoderRegistration::registerCodecs();
 
   logger.info ( "Setting Transfer Syntaxes" );
+  ctkDICOMRetrievePrivate::addPresentationContexts(this->SCU);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrievePrivate::addPresentationContexts(DcmSCU& scu)
+{
   OFList<OFString> transferSyntaxes;
   transferSyntaxes.push_back ( UID_LittleEndianExplicitTransferSyntax );
   transferSyntaxes.push_back ( UID_BigEndianExplicitTransferSyntax );
   transferSyntaxes.push_back ( UID_LittleEndianImplicitTransferSyntax );
-  this->SCU.addPresentationContext ( 
+  scu.addPresentationContext ( 
       UID_MOVEStudyRootQueryRetrieveInformationModel, transferSyntaxes );
-  this->SCU.addPresentationContext ( 
+  scu.addPresentationContext ( 
       UID_GETStudyRootQueryRetrieveInformationModel, transferSyntaxes );
 
   for (Uint16 i = 0; i < numberOfDcmLongSCUStorageSOPClassUIDs; i++)
     {
-    this->SCU.addPresentationContext(dcmLongSCUStorageSOPClassUIDs[i], 
+    scu.addPresentationContext(dcmLongSCUStorageSOPClassUIDs[i], 
         transferSyntaxes, ASC_SC_ROLE_SCP);
     }
 }
@@ -499,6 +651,64 @@ bool ctkDICOMRetrievePrivate::get ( const QString& studyInstanceUID,
   return true;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMRetrievePrivate::getStudies()
+{
+  ctkDICOMRetrieveSCUPrivate scu;
+  scu.retrieve = this->SCU.retrieve;
+  scu.pool = &this->Pool;
+  scu.setAETitle(this->SCU.getAETitle());
+  scu.setPeerAETitle(this->SCU.getPeerAETitle());
+  scu.setPeerHostName(this->SCU.getPeerHostName());
+  scu.setPeerPort(this->SCU.getPeerPort());
+  ctkDICOMRetrievePrivate::addPresentationContexts(scu);
+  if ( !scu.initNetwork().good() || !scu.negotiateAssociation().good() )
+    {
+    logger.error ( "Error negotiating a retrieve association" );
+    this->Pool.associationFailed();
+    return;
+    }
+  T_ASC_PresentationContextID presID = scu.findPresentationContextID(
+                                          UID_GETStudyRootQueryRetrieveInformationModel, 
+                                          "" /* don't care about transfer syntax */ );
+  if (presID == 0)
+    {
+    logger.error ( "GET Request failed: No valid Study Root GET Presentation Context available" );
+    scu.closeAssociation(DCMSCU_RELEASE_ASSOCIATION);
+    this->Pool.associationFailed();
+    return;
+    }
+
+  QStringList request;
+  while ( this->Pool.nextRequest(request) )
+    {
+    const QString& studyInstanceUID = request[0];
+    DcmDataset retrieveParameters;
+    retrieveParameters.putAndInsertString ( DCM_QueryRetrieveLevel, "STUDY" );
+    retrieveParameters.putAndInsertString ( DCM_StudyInstanceUID, 
+                                               studyInstanceUID.toStdString().c_str() );
+    // the instances are received by handleSTORERequest() while the
+    // request is running
+    OFList<RetrieveResponse*> responses;
+    OFCondition status = scu.sendCGETRequest ( presID, &retrieveParameters, &responses );
+    bool success = status.good() && responses.begin() != responses.end();
+    if ( success )
+      {
+      logger.debug ( "GET succeeded for study: " + studyInstanceUID );
+      }
+    else
+      {
+      logger.error ( "GET failed for study: " + studyInstanceUID );
+      }
+    for ( OFIterator<RetrieveResponse*> it = responses.begin(); it != responses.end(); it++ )
+      {
+      delete *it;
+      }
+    this->Pool.requestDone( success );
+    }
+  scu.closeAssociation(DCMSCU_RELEASE_ASSOCIATION);
+}
+
 //------------------------------------------------------------------------------
 // ctkDICOMRetrieve methods
 
@@ -636,14 +846,14 @@ bool ctkDICOMRetrieve::keepAssociationOpen()
 void ctkDICOMRetrieve::setWasCanceled(const bool wasCanceled)
 {
   Q_D(ctkDICOMRetrieve);
-  d->WasCanceled = wasCanceled;
+  d->WasCanceled.fetchAndStoreOrdered(wasCanceled ? 1 : 0);
 }
 
 //------------------------------------------------------------------------------
 bool ctkDICOMRetrieve::wasCanceled()
 {
-  Q_D(const ctkDICOMRetrieve);
-  return d->WasCanceled;
+  Q_D(ctkDICOMRetrieve);
+  return d->WasCanceled.fetchAndAddOrdered(0) != 0;
 }
 
 //------------------------------------------------------------------------------
@@ -700,10 +910,80 @@ bool ctkDICOMRetrieve::getSeries(const QString& studyInstanceUID,
   return d->get ( studyInstanceUID, seriesInstanceUID, ctkDICOMRetrievePrivate::RetrieveSeries );
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieve::getStudies(const QStringList& studyInstanceUIDs)
+{
+  Q_D(ctkDICOMRetrieve);
+  if (!d->Database)
+    {
+    logger.error("Cannot get studies: no database set.");
+    return false;
+    }
+  logger.info ( "Starting getStudies" );
+
+  QList<QStringList> requests;
+  foreach(const QString& studyInstanceUID, studyInstanceUIDs)
+    {
+    if (!studyInstanceUID.isEmpty())
+      {
+      requests << (QStringList() << studyInstanceUID);
+      }
+    }
+  d->Pool.setRequests(requests);
+  QList<QRunnable*> workers;
+  for (int i = 0; i < qMin(d->Pool.maximumAssociations(), requests.count()); ++i)
+    {
+    workers << new ctkDICOMRetrieveWorker(d);
+    }
+  emit progress(QString("Sending Get Requests for %1 studies").arg(requests.count()));
+  emit progress(0);
+  d->Pool.start(workers);
+
+  // the received instances are inserted while the requests go on
+  d->Database->beginBatchInsert();
+  QList<DcmDataset*> datasets;
+  QStringList fileNames;
+  while ( d->Pool.takeResults(datasets, fileNames) )
+    {
+    for (int i = 0; i < datasets.count(); ++i)
+      {
+      ctkDICOMRetrieveSCUPrivate::insert(*d->Database, datasets[i], fileNames[i]);
+      }
+    datasets.clear();
+    fileNames.clear();
+    if (d->WasCanceled.fetchAndAddOrdered(0))
+      {
+      // the workers finish their current request
+      d->Pool.cancel();
+      }
+    emit progress((100 * d->Pool.completedRequests()) / qMax(1, requests.count()));
+    }
+  d->Database->endBatchInsert();
+
+  emit progress("Finished Get");
+  emit progress(100);
+  return !d->WasCanceled.fetchAndAddOrdered(0) && d->Pool.completedRequests() == requests.count()
+    && d->Pool.failedRequests() == 0;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieve::setMaximumAssociations(int maximumAssociations)
+{
+  Q_D(ctkDICOMRetrieve);
+  d->Pool.setMaximumAssociations(maximumAssociations);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieve::maximumAssociations()const
+{
+  Q_D(const ctkDICOMRetrieve);
+  return d->Pool.maximumAssociations();
+}
+
 //------------------------------------------------------------------------------
 void ctkDICOMRetrieve::cancel()
 {
   Q_D(ctkDICOMRetrieve);
-  d->WasCanceled = true;
+  d->WasCanceled.fetchAndStoreOrdered(1);
 }
 
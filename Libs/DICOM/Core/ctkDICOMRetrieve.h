@@ -45,6 +45,7 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMRetrieve : public QObject
   Q_PROPERTY(QString moveDestinationAETitle READ moveDestinationAETitle WRITE setMoveDestinationAETitle)
   Q_PROPERTY(bool keepAssociationOpen READ keepAssociationOpen WRITE setKeepAssociationOpen)
   Q_PROPERTY(bool wasCanceled READ wasCanceled WRITE setWasCanceled)
+  Q_PROPERTY(int maximumAssociations READ maximumAssociations WRITE setMaximumAssociations)
 
 public:
   explicit ctkDICOMRetrieve();
@@ -78,6 +79,11 @@ public:
   /// (default false)
   void setWasCanceled(const bool wasCanceled);
   bool wasCanceled();
+  /// Number of associations opened at most at the same time by
+  /// getStudies(), each one runs its requests in its own thread.
+  /// 4 by default.
+  void setMaximumAssociations(int maximumAssociations);
+  int maximumAssociations()const;
   /// where to insert new data sets obtained via get (must be set for
   /// get to succeed
   Q_INVOKABLE void setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase);
@@ -94,6 +100,11 @@ public Q_SLOTS:
                        const QString& seriesInstanceUID );
   /// Use CGET to ask peer host to store data to us
   bool getStudy( const QString& studyInstanceUID );
+  /// Use CGET to ask peer host to store the studies to us, the requests
+  /// are spread over up to maximumAssociations() associations and the
+  /// instances are inserted in the database while they are received.
+  /// Returns false if any study could not be retrieved.
+  bool getStudies( const QStringList& studyInstanceUIDs );
   /// Cancel the current operation
   void cancel();
 
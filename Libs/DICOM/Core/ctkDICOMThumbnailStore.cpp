@@ -0,0 +1,194 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDir>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+// ctkDICOMCore includes
+#include "ctkDICOMThumbnailStore.h"
+#include "ctkLogger.h"
+
+static ctkLogger logger ( "org.commontk.dicom.DICOMThumbnailStore" );
+
+//------------------------------------------------------------------------------
+class ctkDICOMThumbnailStorePrivate
+{
+public:
+  ctkDICOMThumbnailStorePrivate();
+
+  bool exec(QSqlQuery& query) const;
+
+  QString ConnectionName;
+  QSqlDatabase Database;
+  /// a connection can't be used by several threads at the same time
+  mutable QMutex Mutex;
+};
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailStorePrivate::ctkDICOMThumbnailStorePrivate()
+  : Mutex(QMutex::Recursive)
+{
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStorePrivate::exec(QSqlQuery& query) const
+{
+  if (!query.exec())
+    {
+    logger.error("SQLITE ERROR: " + query.lastError().driverText());
+    return false;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailStore::ctkDICOMThumbnailStore(const QString& databaseDirectory)
+  : d_ptr(new ctkDICOMThumbnailStorePrivate)
+{
+  Q_D(ctkDICOMThumbnailStore);
+  d->ConnectionName = QString("ctkDICOMThumbnailStore-%1").arg(reinterpret_cast<quintptr>(this));
+  d->Database = QSqlDatabase::addDatabase("QSQLITE", d->ConnectionName);
+  d->Database.setDatabaseName(storeFileName(databaseDirectory));
+  // the thumbnail list widget reads the store through its own connection
+  // while the thumbnail threads write, wait for the lock instead of failing
+  d->Database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+  if (!d->Database.open())
+    {
+    logger.error("Could not open thumbnail store: " + d->Database.lastError().text());
+    return;
+    }
+
+  QSqlQuery query(d->Database);
+  query.exec("PRAGMA synchronous = OFF");
+  query.exec("CREATE TABLE IF NOT EXISTS Thumbnails ("
+             " SOPInstanceUID VARCHAR(64) NOT NULL PRIMARY KEY,"
+             " SeriesInstanceUID VARCHAR(64) NOT NULL,"
+             " InsertTimestamp VARCHAR(20) NOT NULL,"
+             " Thumbnail BLOB NOT NULL)");
+  query.exec("CREATE INDEX IF NOT EXISTS ThumbnailsSeriesIndex ON Thumbnails (SeriesInstanceUID)");
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailStore::~ctkDICOMThumbnailStore()
+{
+  Q_D(ctkDICOMThumbnailStore);
+  d->Database.close();
+  d->Database = QSqlDatabase();
+  QSqlDatabase::removeDatabase(d->ConnectionName);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::isOpen() const
+{
+  Q_D(const ctkDICOMThumbnailStore);
+  return d->Database.isOpen();
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMThumbnailStore::storeFileName(const QString& databaseDirectory)
+{
+  return databaseDirectory + "/ctkDICOMThumbnails.sql";
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::contains(const QString& sopInstanceUID, const QDateTime& newerThan) const
+{
+  Q_D(const ctkDICOMThumbnailStore);
+  QMutexLocker lock(&d->Mutex);
+  QSqlQuery query(d->Database);
+  query.prepare("SELECT InsertTimestamp FROM Thumbnails WHERE SOPInstanceUID = ?");
+  query.addBindValue(sopInstanceUID);
+  if (!d->exec(query) || !query.next())
+    {
+    return false;
+    }
+  return !newerThan.isValid()
+    || QDateTime::fromString(query.value(0).toString(), Qt::ISODate) > newerThan;
+}
+
+//------------------------------------------------------------------------------
+QByteArray ctkDICOMThumbnailStore::thumbnail(const QString& sopInstanceUID) const
+{
+  Q_D(const ctkDICOMThumbnailStore);
+  QMutexLocker lock(&d->Mutex);
+  QSqlQuery query(d->Database);
+  query.prepare("SELECT Thumbnail FROM Thumbnails WHERE SOPInstanceUID = ?");
+  query.addBindValue(sopInstanceUID);
+  if (!d->exec(query) || !query.next())
+    {
+    return QByteArray();
+    }
+  return query.value(0).toByteArray();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::storeThumbnail(const QString& sopInstanceUID,
+                                            const QString& seriesInstanceUID,
+                                            const QByteArray& imageData)
+{
+  Q_D(ctkDICOMThumbnailStore);
+  QMutexLocker lock(&d->Mutex);
+  QSqlQuery query(d->Database);
+  query.prepare("INSERT OR REPLACE INTO Thumbnails VALUES (?, ?, ?, ?)");
+  query.addBindValue(sopInstanceUID);
+  query.addBindValue(seriesInstanceUID);
+  query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+  query.addBindValue(imageData);
+  return d->exec(query);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::removeThumbnails(const QStringList& sopInstanceUIDs)
+{
+  Q_D(ctkDICOMThumbnailStore);
+  if (sopInstanceUIDs.isEmpty())
+    {
+    return true;
+    }
+  QMutexLocker lock(&d->Mutex);
+  bool success = true;
+  d->Database.transaction();
+  QSqlQuery query(d->Database);
+  query.prepare("DELETE FROM Thumbnails WHERE SOPInstanceUID = ?");
+  foreach (const QString& sopInstanceUID, sopInstanceUIDs)
+    {
+    query.bindValue(0, sopInstanceUID);
+    success = d->exec(query) && success;
+    }
+  query.finish();
+  return d->Database.commit() && success;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::removeSeriesThumbnails(const QString& seriesInstanceUID)
+{
+  Q_D(ctkDICOMThumbnailStore);
+  QMutexLocker lock(&d->Mutex);
+  QSqlQuery query(d->Database);
+  query.prepare("DELETE FROM Thumbnails WHERE SeriesInstanceUID = ?");
+  query.addBindValue(seriesInstanceUID);
+  return d->exec(query);
+}
@@ -0,0 +1,83 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMThumbnailStore_h
+#define __ctkDICOMThumbnailStore_h
+
+// Qt includes
+#include <QByteArray>
+#include <QDateTime>
+#include <QScopedPointer>
+#include <QStringList>
+
+#include "ctkDICOMCoreExport.h"
+
+class ctkDICOMThumbnailStorePrivate;
+
+/// \ingroup DICOM_Core
+///
+/// \brief Packed storage of the thumbnails of a DICOM database
+///
+/// All thumbnails of a database are kept in a single file
+/// (ctkDICOMThumbnails.sql in the database directory) instead of one
+/// image file per instance. The thumbnails are stored as encoded image
+/// data (PNG) that can be given to QImage::loadFromData().
+/// All methods can be called from several threads. Several stores can
+/// be opened on the same database, a store waits up to 5 seconds for
+/// the lock held by another one.
+///
+class CTK_DICOM_CORE_EXPORT ctkDICOMThumbnailStore
+{
+public:
+  /// Open (and create if needed) the thumbnail store of the database
+  /// located in databaseDirectory
+  explicit ctkDICOMThumbnailStore(const QString& databaseDirectory);
+  virtual ~ctkDICOMThumbnailStore();
+
+  bool isOpen() const;
+
+  /// Path of the store file for the database located in databaseDirectory
+  static QString storeFileName(const QString& databaseDirectory);
+
+  /// Returns true if a thumbnail of the instance is stored.
+  /// If newerThan is valid, the thumbnail must also have been stored after it.
+  bool contains(const QString& sopInstanceUID, const QDateTime& newerThan = QDateTime()) const;
+
+  /// Encoded image data of the thumbnail, empty if there is none
+  QByteArray thumbnail(const QString& sopInstanceUID) const;
+
+  /// Store (or replace) the thumbnail of an instance
+  bool storeThumbnail(const QString& sopInstanceUID, const QString& seriesInstanceUID,
+                      const QByteArray& imageData);
+
+  /// Remove the thumbnails of the given instances
+  bool removeThumbnails(const QStringList& sopInstanceUIDs);
+  /// Remove the thumbnails of all instances of a series
+  bool removeSeriesThumbnails(const QString& seriesInstanceUID);
+
+protected:
+  QScopedPointer<ctkDICOMThumbnailStorePrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(ctkDICOMThumbnailStore);
+  Q_DISABLE_COPY(ctkDICOMThumbnailStore);
+};
+
+#endif
@@ -56,6 +56,30 @@ int ctkDICOMImageTest1( int argc, char * argv [] )
     return EXIT_FAILURE;
     }
   qtImage.setPixmap(pixmap);
+
+  QImage frame = ctkImage.frame(0);
+  if (frame.format() != QImage::Format_Indexed8
+      || frame.width() != static_cast<int>(dcmtkImage.getWidth())
+      || frame.height() != static_cast<int>(dcmtkImage.getHeight()))
+    {
+    std::cerr << "Monochrome frame should be an 8 bit indexed image of the size of the dicom image";
+    return EXIT_FAILURE;
+    }
+  // rendered frames are cached until the window changes
+  if (ctkImage.frame(0).cacheKey() != frame.cacheKey())
+    {
+    std::cerr << "Frame should be returned from the frame cache";
+    return EXIT_FAILURE;
+    }
+  double center = 0.;
+  double width = 0.;
+  dcmtkImage.getWindow(center, width);
+  dcmtkImage.setWindow(center + 10., width);
+  if (ctkImage.frame(0).cacheKey() == frame.cacheKey())
+    {
+    std::cerr << "Frame should be rendered again after a window change";
+    return EXIT_FAILURE;
+    }
   qtImage.show();
 
   if (argc > 2 && QString(argv[2]) == "-I")
@@ -109,6 +109,9 @@ ctkDICOMAppWidgetPrivate::ctkDICOMAppWidgetPrivate(ctkDICOMAppWidget* parent): q
 
 ctkDICOMAppWidgetPrivate::~ctkDICOMAppWidgetPrivate()
 {
+  // the generator is destroyed before the database, which may still be
+  // generating thumbnails
+  DICOMDatabase->setThumbnailGenerator(0);
   if ( IndexerProgress )
     {
     delete IndexerProgress;
@@ -290,6 +293,8 @@ ctkDICOMAppWidget::ctkDICOMAppWidget(QWidget* _parent):Superclass(_parent),
 
   connect(d->ThumbnailsWidget, SIGNAL(selected(ctkThumbnailLabel)), this, SLOT(onThumbnailSelected(ctkThumbnailLabel)));
   connect(d->ThumbnailsWidget, SIGNAL(doubleClicked(ctkThumbnailLabel)), this, SLOT(onThumbnailDoubleClicked(ctkThumbnailLabel)));
+  connect(d->DICOMDatabase.data(), SIGNAL(thumbnailGenerated(QString,QString,QString)),
+          d->ThumbnailsWidget, SLOT(onThumbnailGenerated(QString,QString,QString)));
   connect(d->ImportDialog, SIGNAL(fileSelected(QString)),this,SLOT(onImportDirectory(QString)));
 
   connect(d->QueryRetrieveWidget, SIGNAL(canceled()), d->QueryRetrieveWidget, SLOT(hide()) );
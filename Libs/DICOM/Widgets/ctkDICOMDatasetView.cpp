@@ -34,8 +34,10 @@
 
 // ctkDICOMWidgets includex
 #include "ctkDICOMDatasetView.h"
+#include "ctkDICOMImage.h"
 
 // Qt includes
+#include <QCache>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -48,6 +50,20 @@
 
 static ctkLogger logger("org.commontk.DICOM.Widgets.ctkDICOMDatasetView");
 
+//--------------------------------------------------------------------------
+/// A decoded DICOM file and the frames rendered from it
+struct ctkDICOMDatasetViewImage
+{
+  ctkDICOMDatasetViewImage(const QString& dicomPath)
+    : DicomImage(QDir::toNativeSeparators(dicomPath).toStdString().c_str()),
+      Image(&this->DicomImage)
+  {
+  }
+
+  ::DicomImage DicomImage;
+  ctkDICOMImage Image;
+};
+
 //--------------------------------------------------------------------------
 class ctkDICOMDatasetViewPrivate 
 {
@@ -65,10 +81,25 @@ public:
   double DicomIntensityWindow;
   bool AutoWindowLevel;
 
+  /// the last decoded files, so that changing the window/level, stepping
+  /// through the frames or going back to an image doesn't decode the file
+  /// again and reuses the frames already rendered
+  QCache<QString, ctkDICOMDatasetViewImage> ImageCache;
+  QString CurrentDicomPath;
+  int CurrentFrame;
+
   void init();
 
   void setImage(const QModelIndex& imageIndex, bool defaultIntensity = true);
 
+  /// select the window of the image according to the intensity settings
+  void applyWindow(DicomImage& dcmImage, bool defaultIntensity);
+  /// show the current frame of the current image
+  void showFrame();
+  /// step to the next/previous frame of a multiframe image,
+  /// returns false if there is no such frame
+  bool stepFrame(int step);
+
   void onPatientModelSelected(const QModelIndex& index);
   void onStudyModelSelected(const QModelIndex& index);
   void onSeriesModelSelected(const QModelIndex& index);
@@ -101,6 +132,9 @@ void ctkDICOMDatasetViewPrivate::init()
 
   this->AutoWindowLevel = true;
 
+  this->ImageCache.setMaxCost(4);
+  this->CurrentFrame = 0;
+
   /*
   this->Window->setParent(q);
   QHBoxLayout* layout = new QHBoxLayout(q);
@@ -126,10 +160,24 @@ void ctkDICOMDatasetViewPrivate::setImage(const QModelIndex &imageIndex, bool de
         dicomPath.append("/").append(model->data(imageIndex ,ctkDICOMModel::UIDRole).toString());
 
         if (QFile(dicomPath).exists()){
-          DicomImage dcmImage(  QDir::toNativeSeparators(dicomPath).toStdString().c_str() );
+            ctkDICOMDatasetViewImage* image = this->ImageCache.object(dicomPath);
+            if (!image){
+                image = new ctkDICOMDatasetViewImage(dicomPath);
+                this->ImageCache.insert(dicomPath, image);
+            }
+            if (dicomPath != this->CurrentDicomPath){
+                this->CurrentDicomPath = dicomPath;
+                this->CurrentFrame = 0;
+            }
 
-            q->clearImages();
-            q->addImage(dcmImage, defaultIntensity);
+            EI_Status result = image->DicomImage.getStatus();
+            if (result != EIS_Normal){
+                logger.error(QString("Rendering of DICOM image failed: ") + DicomImage::getString(result));
+                q->clearImages();
+                return;
+            }
+            this->applyWindow(image->DicomImage, defaultIntensity);
+            this->showFrame();
             this->CurrentImageIndex = imageIndex;
 
             q->emitImageDisplayedSignal(imageIndex.row(), model->rowCount(seriesIndex));
@@ -139,6 +187,58 @@ void ctkDICOMDatasetViewPrivate::setImage(const QModelIndex &imageIndex, bool de
     }
 }
 
+// -------------------------------------------------------------------------
+void ctkDICOMDatasetViewPrivate::applyWindow(DicomImage& dcmImage, bool defaultIntensity){
+    // Select first window defined in image. If none, compute min/max window as best guess.
+    // Only relevant for monochrome
+    if (this->AutoWindowLevel)
+    {
+      if (dcmImage.isMonochrome())
+      {
+          if (defaultIntensity && dcmImage.getWindowCount() > 0)
+          {
+            dcmImage.setWindow(0);
+          }
+          else
+          {
+            dcmImage.setMinMaxWindow(OFTrue /* ignore extreme values */);
+            dcmImage.getWindow(this->DicomIntensityLevel, this->DicomIntensityWindow);
+          }
+      }
+    }
+    else
+    {
+      dcmImage.setWindow(this->DicomIntensityLevel, this->DicomIntensityWindow);
+    }
+}
+
+// -------------------------------------------------------------------------
+void ctkDICOMDatasetViewPrivate::showFrame(){
+    Q_Q(ctkDICOMDatasetView);
+
+    q->clearImages();
+    ctkDICOMDatasetViewImage* image = this->ImageCache.object(this->CurrentDicomPath);
+    if (image){
+        // frames already rendered with the same window come from the cache
+        q->addImage(image->Image.frame(this->CurrentFrame));
+    }
+}
+
+// -------------------------------------------------------------------------
+bool ctkDICOMDatasetViewPrivate::stepFrame(int step){
+    ctkDICOMDatasetViewImage* image = this->ImageCache.object(this->CurrentDicomPath);
+    if (!image){
+        return false;
+    }
+    int frame = this->CurrentFrame + step;
+    if (frame < 0 || frame >= static_cast<int>(image->Image.frameCount())){
+        return false;
+    }
+    this->CurrentFrame = frame;
+    this->showFrame();
+    return true;
+}
+
 // -------------------------------------------------------------------------
 void ctkDICOMDatasetViewPrivate::onPatientModelSelected(const QModelIndex &index){
     Q_Q(ctkDICOMDatasetView);
@@ -266,7 +366,6 @@ void ctkDICOMDatasetView::addImage( const QImage & image )
 void ctkDICOMDatasetView::addImage( DicomImage & dcmImage, bool defaultIntensity )
 {
     Q_D(ctkDICOMDatasetView);
-    QImage image;
     // Check whether we have a valid image
     EI_Status result = dcmImage.getStatus();
     if (result != EIS_Normal)
@@ -274,63 +373,10 @@ void ctkDICOMDatasetView::addImage( DicomImage & dcmImage, bool defaultIntensity
       logger.error(QString("Rendering of DICOM image failed for thumbnail failed: ") + DicomImage::getString(result));
       return;
     }
-    // Select first window defined in image. If none, compute min/max window as best guess.
-    // Only relevant for monochrome
-    if (d->AutoWindowLevel)
-    {
-      if (dcmImage.isMonochrome())
-      {
-          if (defaultIntensity && dcmImage.getWindowCount() > 0)
-          {
-            dcmImage.setWindow(0);
-          }
-          else
-          {
-            dcmImage.setMinMaxWindow(OFTrue /* ignore extreme values */);
-            dcmImage.getWindow(d->DicomIntensityLevel, d->DicomIntensityWindow);
-          }
-      }
-    } 
-    else 
-    {
-      dcmImage.setWindow(d->DicomIntensityLevel, d->DicomIntensityWindow);
-    }
-    /* get image extension and prepare image header */
-    const unsigned long width = dcmImage.getWidth();
-    const unsigned long height = dcmImage.getHeight();
-    unsigned long offset = 0;
-    unsigned long length = 0;
-    QString header;
-
-    if (dcmImage.isMonochrome())
-    {
-      // write PGM header (binary monochrome image format)
-      header = QString("P5 %1 %2 255\n").arg(width).arg(height);
-      offset = header.length();
-      length = width * height + offset;
-    }
-    else
-    {
-      // write PPM header (binary color image format)
-      header = QString("P6 %1 %2 255\n").arg(width).arg(height);
-      offset = header.length();
-      length = width * height * 3 /* RGB */ + offset;
-    }
-    /* create output buffer for DicomImage class */
-    QByteArray buffer;
-    /* copy header to output buffer and resize it for pixel data */
-    buffer.append(header);
-    buffer.resize(length);
-
-    /* render pixel data to buffer */
-    if (dcmImage.getOutputData(static_cast<void *>(buffer.data() + offset), length - offset, 8, 0))
-    {  
-      if (!image.loadFromData( buffer ))
-        {
-            logger.error("QImage couldn't created");
-        }
-    }
-    this->addImage(image);
+    // ctkDICOMImage selects the default window, apply ours afterwards
+    ctkDICOMImage image(&dcmImage);
+    d->applyWindow(dcmImage, defaultIntensity);
+    this->addImage(image.frame(0));
 }
 
 // -------------------------------------------------------------------------
@@ -355,11 +401,16 @@ void ctkDICOMDatasetView::mouseMoveEvent(QMouseEvent* event){
     if(event->buttons() == Qt::RightButton){
         event->accept();
         QPoint nowPos = event->pos();
+        // step through the frames of a multiframe image first
         if(nowPos.y() > d->OldMousePos.y()){
-            emit requestNextImage();
+            if(!d->stepFrame(1)){
+                emit requestNextImage();
+            }
             d->OldMousePos = event->pos();
         }else if(nowPos.y() < d->OldMousePos.y()){
-            emit requestPreviousImage();
+            if(!d->stepFrame(-1)){
+                emit requestPreviousImage();
+            }
             d->OldMousePos = event->pos();
         }
     }else if(event->buttons() == Qt::MidButton){
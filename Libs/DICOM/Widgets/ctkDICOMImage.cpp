@@ -20,8 +20,10 @@
 =========================================================================*/
 
 // Qt includes
+#include <QCache>
 #include <QDebug>
 #include <QString>
+#include <QVector>
 
 // ctkDICOMCore includes
 #include "ctkDICOMImage.h"
@@ -41,8 +43,21 @@ class ctkDICOMImagePrivate
 public:
   ctkDICOMImagePrivate(ctkDICOMImage&);
 
+  /// Render the frame into a new QImage, see ctkDICOMImage::frame()
+  QImage renderFrame(int frame) const;
+  /// Drop the cached frames if the window was changed since they were rendered
+  void checkFrameCache() const;
+
   ::DicomImage* DicomImage;
 
+  /// frames already rendered, the cost is in kilobytes
+  mutable QCache<int, QImage> FrameCache;
+  /// window the cached frames were rendered with
+  mutable double FrameCacheWindowCenter;
+  mutable double FrameCacheWindowWidth;
+
+  QVector<QRgb> GrayColorTable;
+
 protected:
   ctkDICOMImage* const q_ptr;
 
@@ -53,6 +68,76 @@ private:
 //------------------------------------------------------------------------------
 ctkDICOMImagePrivate::ctkDICOMImagePrivate(ctkDICOMImage& o):q_ptr(&o)
 {
+  this->FrameCache.setMaxCost(32 * 1024);
+  this->FrameCacheWindowCenter = 0.;
+  this->FrameCacheWindowWidth = 0.;
+  for (int i = 0; i < 256; ++i)
+    {
+    this->GrayColorTable << qRgb(i, i, i);
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMImagePrivate::checkFrameCache() const
+{
+  if (!this->DicomImage->isMonochrome())
+    {
+    return;
+    }
+  double center = 0.;
+  double width = 0.;
+  this->DicomImage->getWindow(center, width);
+  if (center != this->FrameCacheWindowCenter || width != this->FrameCacheWindowWidth)
+    {
+    this->FrameCache.clear();
+    this->FrameCacheWindowCenter = center;
+    this->FrameCacheWindowWidth = width;
+    }
+}
+
+//------------------------------------------------------------------------------
+QImage ctkDICOMImagePrivate::renderFrame(int frame) const
+{
+  const int width = static_cast<int>(this->DicomImage->getWidth());
+  const int height = static_cast<int>(this->DicomImage->getHeight());
+  const bool monochrome = this->DicomImage->isMonochrome();
+  // DCMTK renders 8 bit gray values or interleaved RGB triplets
+  const int rowLength = monochrome ? width : 3 * width;
+
+  QImage image(width, height, monochrome ? QImage::Format_Indexed8 : QImage::Format_RGB888);
+  if (image.isNull())
+    {
+    logger.error("QImage couldn't created");
+    return image;
+    }
+  if (monochrome)
+    {
+    image.setColorTable(this->GrayColorTable);
+    }
+
+  if (image.bytesPerLine() == rowLength)
+    {
+    // no padding at the end of the rows, render straight into the image
+    if (!this->DicomImage->getOutputData(image.bits(), image.byteCount(), 8, frame))
+      {
+      return QImage();
+      }
+    }
+  else
+    {
+    // QImage rows are 32 bit aligned, copy row by row from the internal
+    // buffer of DicomImage
+    const uchar* pixelData = static_cast<const uchar*>(this->DicomImage->getOutputData(8, frame));
+    if (!pixelData)
+      {
+      return QImage();
+      }
+    for (int y = 0; y < height; ++y)
+      {
+      OFBitmanipTemplate<Uint8>::copyMem(pixelData + y * rowLength, image.scanLine(y), rowLength);
+      }
+    }
+  return image;
 }
 
 //------------------------------------------------------------------------------
@@ -106,32 +191,29 @@ QImage ctkDICOMImage::frame(int frame) const
 {
   Q_D(const ctkDICOMImage);
 
-  // this way of converting the dicom image to a qpixmap was adopted from some code from
-  // the DCMTK forum, posted by Joerg Riesmayer, see http://forum.dcmtk.org/viewtopic.php?t=120
-  QImage image;
-  if ((d->DicomImage != NULL) && (d->DicomImage->getStatus() == EIS_Normal))
+  if ((d->DicomImage == NULL) || (d->DicomImage->getStatus() != EIS_Normal))
     {
-    /* get image extension */
-    const unsigned long width = d->DicomImage->getWidth();
-    const unsigned long height = d->DicomImage->getHeight();
-    QString header = QString("P5 %1 %2 255\n").arg(width).arg(height);
-    const unsigned long offset = header.length();
-    const unsigned long length = width * height + offset;
-    /* create output buffer for DicomImage class */
-    QByteArray buffer;
-    buffer.append(header);
-    buffer.resize(length);
-
-    /* copy PGM header to buffer */
-
-    if (d->DicomImage->getOutputData(static_cast<void *>(buffer.data() + offset), length - offset, 8, frame))
-      {
+    return QImage();
+    }
 
-      if (!image.loadFromData( buffer ))
-        {
-        logger.error("QImage couldn't created");
-        }
-      }
+  d->checkFrameCache();
+  QImage* cachedFrame = d->FrameCache.object(frame);
+  if (cachedFrame)
+    {
+    return *cachedFrame;
+    }
+
+  QImage image = d->renderFrame(frame);
+  if (!image.isNull())
+    {
+    d->FrameCache.insert(frame, new QImage(image), image.byteCount() / 1024 + 1);
     }
   return image;
 }
+
+//------------------------------------------------------------------------------
+void ctkDICOMImage::clearFrameCache()
+{
+  Q_D(ctkDICOMImage);
+  d->FrameCache.clear();
+}
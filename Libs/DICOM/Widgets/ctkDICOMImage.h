@@ -61,8 +61,20 @@ public:
   ///
   /// \brief Returns a specific frame of the dicom image
   ///
+  /// Monochrome frames are returned as QImage::Format_Indexed8 with a gray
+  /// color table, color frames as QImage::Format_RGB888.
+  /// The rendered frames are cached, the cache is dropped when the window
+  /// of the dicom image changes.
+  ///
   QImage frame(int frame = 0) const;
 
+  ///
+  /// \brief Forget the rendered frames.
+  /// To be called when the rendering parameters of the dicom image are
+  /// changed in another way than its window (e.g. VOI LUT, presentation LUT).
+  ///
+  void clearFrameCache();
+
   ///
   /// \brief Returns the number of frames contained in the dicom image.
   /// \sa DicomImage::getFrameCount()
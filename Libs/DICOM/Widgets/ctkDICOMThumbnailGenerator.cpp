@@ -24,7 +24,9 @@
 #include "ctkLogger.h"
 
 // Qt includes
+#include <QBuffer>
 #include <QImage>
+#include <QVector>
 
 // DCMTK includes
 #include "dcmimage.h"
@@ -41,6 +43,13 @@ public:
   ctkDICOMThumbnailGeneratorPrivate(ctkDICOMThumbnailGenerator&);
   virtual ~ctkDICOMThumbnailGeneratorPrivate();
 
+  /// Render dcmImage scaled down to fit in ThumbnailSize x ThumbnailSize.
+  /// Returns a null image on failure.
+  QImage renderThumbnail(DicomImage* dcmImage) const;
+
+  int ThumbnailSize;
+  QVector<QRgb> GrayColorTable;
+
 protected:
   ctkDICOMThumbnailGenerator* const q_ptr;
 
@@ -51,7 +60,11 @@ private:
 //------------------------------------------------------------------------------
 ctkDICOMThumbnailGeneratorPrivate::ctkDICOMThumbnailGeneratorPrivate(ctkDICOMThumbnailGenerator& o):q_ptr(&o)
 {
-
+  this->ThumbnailSize = 128;
+  for (int i = 0; i < 256; ++i)
+    {
+    this->GrayColorTable << qRgb(i, i, i);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -60,6 +73,70 @@ ctkDICOMThumbnailGeneratorPrivate::~ctkDICOMThumbnailGeneratorPrivate()
 
 }
 
+//------------------------------------------------------------------------------
+QImage ctkDICOMThumbnailGeneratorPrivate::renderThumbnail(DicomImage* dcmImage) const
+{
+  // Check whether we have a valid image
+  EI_Status result = dcmImage->getStatus();
+  if (result != EIS_Normal)
+    {
+    logger.error(QString("Rendering of DICOM image failed for thumbnail failed: ") + DicomImage::getString(result));
+    return QImage();
+    }
+
+  // Let DCMTK scale down the image first, so that only the pixels of the
+  // thumbnail go through the VOI transformation and the conversion to QImage.
+  const unsigned long width = dcmImage->getWidth();
+  const unsigned long height = dcmImage->getHeight();
+  const unsigned long size = static_cast<unsigned long>(this->ThumbnailSize);
+  QScopedPointer<DicomImage> scaledImage;
+  if (width > size || height > size)
+    {
+    // the other dimension is computed from the aspect ratio
+    scaledImage.reset(width >= height ?
+      dcmImage->createScaledImage(size, 0UL, 1, 1) :
+      dcmImage->createScaledImage(0UL, size, 1, 1));
+    }
+  DicomImage* thumbnailImage = scaledImage.isNull() ? dcmImage : scaledImage.data();
+
+  // Select first window defined in image. If none, compute min/max window as best guess.
+  // Only relevant for monochrome.
+  if (thumbnailImage->isMonochrome())
+    {
+    if (thumbnailImage->getWindowCount() > 0)
+      {
+      thumbnailImage->setWindow(0);
+      }
+    else
+      {
+      thumbnailImage->setMinMaxWindow(OFTrue /* ignore extreme values */);
+      }
+    }
+
+  // Render into the internal buffer of DicomImage and wrap it into a QImage,
+  // the rows are not padded by DCMTK.
+  const int thumbnailWidth = static_cast<int>(thumbnailImage->getWidth());
+  const int thumbnailHeight = static_cast<int>(thumbnailImage->getHeight());
+  const uchar* pixelData = static_cast<const uchar*>(thumbnailImage->getOutputData(8));
+  if (!pixelData)
+    {
+    logger.error("Rendering of DICOM image failed for thumbnail");
+    return QImage();
+    }
+  QImage image;
+  if (thumbnailImage->isMonochrome())
+    {
+    image = QImage(pixelData, thumbnailWidth, thumbnailHeight, thumbnailWidth, QImage::Format_Indexed8);
+    image.setColorTable(this->GrayColorTable);
+    }
+  else
+    {
+    image = QImage(pixelData, thumbnailWidth, thumbnailHeight, 3 * thumbnailWidth, QImage::Format_RGB888);
+    }
+  // detach from the DCMTK buffer, it is released with the scaled image
+  return image.copy();
+}
+
 
 //------------------------------------------------------------------------------
 ctkDICOMThumbnailGenerator::ctkDICOMThumbnailGenerator(QObject* parentValue)
@@ -75,63 +152,25 @@ ctkDICOMThumbnailGenerator::~ctkDICOMThumbnailGenerator()
 
 //------------------------------------------------------------------------------
 bool ctkDICOMThumbnailGenerator::generateThumbnail(DicomImage *dcmImage, const QString &path){
-    QImage image;
-    // Check whether we have a valid image
-    EI_Status result = dcmImage->getStatus();
-    if (result != EIS_Normal)
-    {
-      logger.error(QString("Rendering of DICOM image failed for thumbnail failed: ") + DicomImage::getString(result));
-      return false;
-    }
-    // Select first window defined in image. If none, compute min/max window as best guess.
-    // Only relevant for monochrome.
-    if (dcmImage->isMonochrome())
+  Q_D(ctkDICOMThumbnailGenerator);
+  QImage image = d->renderThumbnail(dcmImage);
+  if (image.isNull())
     {
-        if (dcmImage->getWindowCount() > 0)
-        {
-          dcmImage->setWindow(0);
-        }
-        else
-        {
-          dcmImage->setMinMaxWindow(OFTrue /* ignore extreme values */);
-        }
+    return false;
     }
-    /* get image extension and prepare image header */
-    const unsigned long width = dcmImage->getWidth();
-    const unsigned long height = dcmImage->getHeight();
-    unsigned long offset = 0;
-    unsigned long length = 0;
-    QString header;
-
-    if (dcmImage->isMonochrome())
-    {
-      // write PGM header (binary monochrome image format)
-      header = QString("P5 %1 %2 255\n").arg(width).arg(height);
-      offset = header.length();
-      length = width * height + offset;
-    }
-    else
+  return image.save(path, "PNG");
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGenerator::generateThumbnailData(DicomImage *dcmImage, QByteArray &imageData)
+{
+  Q_D(ctkDICOMThumbnailGenerator);
+  QImage image = d->renderThumbnail(dcmImage);
+  if (image.isNull())
     {
-      // write PPM header (binary color image format)
-      header = QString("P6 %1 %2 255\n").arg(width).arg(height);
-      offset = header.length();
-      length = width * height * 3 /* RGB */ + offset;
-    }
-    /* create output buffer for DicomImage class */
-    QByteArray buffer;
-    /* copy header to output buffer and resize it for pixel data */
-    buffer.append(header);
-    buffer.resize(length);
-
-    /* render pixel data to buffer */
-    if (dcmImage->getOutputData(static_cast<void *>(buffer.data() + offset), length - offset, 8, 0))
-    {  
-      if (!image.loadFromData( buffer ))
-        {
-            logger.error("QImage couldn't created");
-            return false;
-        }
+    return false;
     }
-    image.scaled(128,128,Qt::KeepAspectRatio).save(path,"PNG");
-    return true;
+  QBuffer buffer(&imageData);
+  buffer.open(QIODevice::WriteOnly);
+  return image.save(&buffer, "PNG");
 }
@@ -44,6 +44,9 @@ public:
 
   virtual bool generateThumbnail(DicomImage* dcmImage, const QString& path );
 
+  /// Render the thumbnail as PNG data without going through a file
+  virtual bool generateThumbnailData(DicomImage* dcmImage, QByteArray& imageData);
+
 protected:
   QScopedPointer<ctkDICOMThumbnailGeneratorPrivate> d_ptr;
 
@@ -29,6 +29,7 @@
 #include <QPixmap>
 #include <QPushButton>
 #include <QResizeEvent>
+#include <QTimer>
 
 // ctk includes
 #include "ctkLogger.h"
@@ -42,6 +43,7 @@
 #include "ctkDICOMDatabase.h"
 #include "ctkDICOMFilterProxyModel.h"
 #include "ctkDICOMModel.h"
+#include "ctkDICOMThumbnailStore.h"
 
 // ctkDICOMWidgets includes
 #include "ctkDICOMThumbnailListWidget.h"
@@ -67,9 +69,22 @@ public:
   ctkDICOMThumbnailListWidgetPrivate(ctkDICOMThumbnailListWidget* parent);
 
   QString DatabaseDirectory;
+  mutable QScopedPointer<ctkDICOMThumbnailStore> ThumbnailStore;
   QModelIndex CurrentSelectedModel;
+  /// coalesces the refreshes requested while thumbnails are generated
+  QTimer RefreshTimer;
 
-  void addThumbnailWidget(const QModelIndex &imageIndex, const QModelIndex& sourceIndex, const QString& text);
+  /// store of the database directory, opened once the database created
+  /// it with its first thumbnail. Null for in-memory databases, which
+  /// have no directory and no store.
+  ctkDICOMThumbnailStore* thumbnailStore() const;
+
+  /// thumbnail of the image from the thumbnail store, or from the
+  /// thumbs directory of older databases. Null if there is none (yet).
+  QPixmap thumbnail(const QModelIndex& imageIndex) const;
+
+  void addThumbnailWidget(const QModelIndex &imageIndex, const QModelIndex& sourceIndex, const QString& text,
+                          const QPixmap& pixmap);
 
   void onPatientModelSelected(const QModelIndex &index);
   void onStudyModelSelected(const QModelIndex &index);
@@ -86,7 +101,53 @@ private:
 ctkDICOMThumbnailListWidgetPrivate::ctkDICOMThumbnailListWidgetPrivate(ctkDICOMThumbnailListWidget* parent):
   Superclass(parent)
 {
+  this->RefreshTimer.setSingleShot(true);
+  this->RefreshTimer.setInterval(200);
+}
 
+//----------------------------------------------------------------------------
+ctkDICOMThumbnailStore* ctkDICOMThumbnailListWidgetPrivate::thumbnailStore() const
+{
+    if(!this->ThumbnailStore && !this->DatabaseDirectory.isEmpty()
+       && QFile::exists(ctkDICOMThumbnailStore::storeFileName(this->DatabaseDirectory)))
+    {
+        this->ThumbnailStore.reset(new ctkDICOMThumbnailStore(this->DatabaseDirectory));
+    }
+    return this->ThumbnailStore.data();
+}
+
+//----------------------------------------------------------------------------
+QPixmap ctkDICOMThumbnailListWidgetPrivate::thumbnail(const QModelIndex& imageIndex) const
+{
+    QPixmap pix;
+    ctkDICOMModel* model = const_cast<ctkDICOMModel*>(qobject_cast<const ctkDICOMModel*>(imageIndex.model()));
+    if(!model)
+    {
+        return pix;
+    }
+    QString sopInstanceUID = model->data(imageIndex, ctkDICOMModel::UIDRole).toString();
+    ctkDICOMThumbnailStore* store = this->thumbnailStore();
+    if(store)
+    {
+        QByteArray imageData = store->thumbnail(sopInstanceUID);
+        if(!imageData.isEmpty() && pix.loadFromData(imageData))
+        {
+            return pix;
+        }
+    }
+
+    QModelIndex seriesIndex = imageIndex.parent();
+    QModelIndex studyIndex = seriesIndex.parent();
+    QString thumbnailPath = this->DatabaseDirectory +
+                            "/thumbs/" + model->data(studyIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
+                            model->data(seriesIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
+                            sopInstanceUID + ".png";
+    if(QFile(thumbnailPath).exists())
+    {
+        logger.debug("Setting pixmap to " + thumbnailPath);
+        pix.load(thumbnailPath);
+    }
+    return pix;
 }
 
 //----------------------------------------------------------------------------
@@ -108,14 +169,10 @@ void ctkDICOMThumbnailListWidgetPrivate::onPatientModelSelected(const QModelInde
             int imageCount = model->rowCount(seriesIndex);
             QModelIndex imageIndex = seriesIndex.child(imageCount/2, 0);
 
-            QString thumbnailPath = this->DatabaseDirectory +
-                                    "/thumbs/" + model->data(studyIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
-                                    model->data(seriesIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
-                                    model->data(imageIndex, ctkDICOMModel::UIDRole).toString() + ".png";
-
-            if(QFile(thumbnailPath).exists())
+            QPixmap pix = this->thumbnail(imageIndex);
+            if(!pix.isNull())
             {
-                this->addThumbnailWidget(imageIndex, studyIndex, model->data(studyIndex, Qt::DisplayRole).toString());
+                this->addThumbnailWidget(imageIndex, studyIndex, model->data(studyIndex, Qt::DisplayRole).toString(), pix);
             }
         }
     }
@@ -138,21 +195,16 @@ void ctkDICOMThumbnailListWidgetPrivate::onStudyModelSelected(const QModelIndex
             int imageCount = model->rowCount(seriesIndex);
             QModelIndex imageIndex = seriesIndex.child(imageCount/2, 0);
 
-            QString thumbnailPath = this->DatabaseDirectory +
-                                    "/thumbs/" + model->data(studyIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
-                                    model->data(seriesIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
-                                    model->data(imageIndex, ctkDICOMModel::UIDRole).toString() + ".png";
-
-            if (QFile(thumbnailPath).exists())
+            QPixmap pix = this->thumbnail(imageIndex);
+            if (!pix.isNull())
             {
-                this->addThumbnailWidget(imageIndex, seriesIndex, model->data(seriesIndex, Qt::DisplayRole).toString());
+                this->addThumbnailWidget(imageIndex, seriesIndex, model->data(seriesIndex, Qt::DisplayRole).toString(), pix);
             }
         }
     }
 }
 
 void ctkDICOMThumbnailListWidgetPrivate::onSeriesModelSelected(const QModelIndex &index){
-    QModelIndex studyIndex = index.parent();
     QModelIndex seriesIndex = index;
 
     ctkDICOMModel* model = const_cast<ctkDICOMModel*>(qobject_cast<const ctkDICOMModel*>(index.model()));
@@ -167,40 +219,27 @@ void ctkDICOMThumbnailListWidgetPrivate::onSeriesModelSelected(const QModelIndex
         {
             QModelIndex imageIndex = seriesIndex.child(i,0);
 
-            QString thumbnailPath = this->DatabaseDirectory +
-                                    "/thumbs/" + model->data(studyIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
-                                    model->data(seriesIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
-                                    model->data(imageIndex, ctkDICOMModel::UIDRole).toString() + ".png";
-
-            if(QFile(thumbnailPath).exists())
+            QPixmap pix = this->thumbnail(imageIndex);
+            if(!pix.isNull())
             {
-                this->addThumbnailWidget(imageIndex, imageIndex, QString("Image %1").arg(i));
+                this->addThumbnailWidget(imageIndex, imageIndex, QString("Image %1").arg(i), pix);
             }
         }
     }
 }
 
-void ctkDICOMThumbnailListWidgetPrivate::addThumbnailWidget(const QModelIndex& imageIndex, const QModelIndex& sourceIndex, const QString &text){
+void ctkDICOMThumbnailListWidgetPrivate::addThumbnailWidget(const QModelIndex& imageIndex, const QModelIndex& sourceIndex, const QString &text,
+                                                            const QPixmap& pix){
     Q_Q(ctkDICOMThumbnailListWidget);
 
     ctkDICOMModel* model = const_cast<ctkDICOMModel*>(qobject_cast<const ctkDICOMModel*>(imageIndex.model()));
 
     if(model)
     {
-        QModelIndex seriesIndex = imageIndex.parent();
-        QModelIndex studyIndex = seriesIndex.parent();
-
-        QString thumbnailPath = this->DatabaseDirectory +
-                                "/thumbs/" + model->data(studyIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
-                                model->data(seriesIndex ,ctkDICOMModel::UIDRole).toString() + "/" +
-                                model->data(imageIndex, ctkDICOMModel::UIDRole).toString() + ".png";
-
         ctkThumbnailLabel* widget = new ctkThumbnailLabel(this->ScrollAreaContentWidget);
 
         QString widgetLabel = text;
         widget->setText( widgetLabel );
-        QPixmap pix(thumbnailPath);
-        logger.debug("Setting pixmap to " + thumbnailPath);
         if(this->ThumbnailSize.isValid()){
           widget->setFixedSize(this->ThumbnailSize);
         }
@@ -225,7 +264,8 @@ void ctkDICOMThumbnailListWidgetPrivate::addThumbnailWidget(const QModelIndex& i
 ctkDICOMThumbnailListWidget::ctkDICOMThumbnailListWidget(QWidget* _parent):
   Superclass(new ctkDICOMThumbnailListWidgetPrivate(this), _parent)
 {
-
+  Q_D(ctkDICOMThumbnailListWidget);
+  connect(&d->RefreshTimer, SIGNAL(timeout()), this, SLOT(refreshThumbnails()));
 }
 
 //----------------------------------------------------------------------------
@@ -239,6 +279,8 @@ void ctkDICOMThumbnailListWidget::setDatabaseDirectory(const QString &directory)
     Q_D(ctkDICOMThumbnailListWidget);
 
     d->DatabaseDirectory = directory;
+    // reopened from the new directory when a thumbnail is shown
+    d->ThumbnailStore.reset();
 }
 
 //----------------------------------------------------------------------------
@@ -305,3 +347,36 @@ void ctkDICOMThumbnailListWidget::onModelSelected(const QModelIndex &index){
 
     this->setCurrentThumbnail(0);
 }
+
+//----------------------------------------------------------------------------
+void ctkDICOMThumbnailListWidget::onThumbnailGenerated(const QString& studyInstanceUID,
+                                                       const QString& seriesInstanceUID,
+                                                       const QString& sopInstanceUID){
+    Q_D(ctkDICOMThumbnailListWidget);
+    Q_UNUSED(sopInstanceUID);
+
+    if(!d->CurrentSelectedModel.isValid())
+    {
+        return;
+    }
+    const QAbstractItemModel* model = d->CurrentSelectedModel.model();
+    int type = model->data(d->CurrentSelectedModel, ctkDICOMModel::TypeRole).toInt();
+    QString uid = model->data(d->CurrentSelectedModel, ctkDICOMModel::UIDRole).toString();
+    // the patient of a study isn't known here, patients are always refreshed
+    if(type == ctkDICOMModel::PatientType
+       || (type == ctkDICOMModel::StudyType && uid == studyInstanceUID)
+       || (type == ctkDICOMModel::SeriesType && uid == seriesInstanceUID))
+    {
+        d->RefreshTimer.start();
+    }
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMThumbnailListWidget::refreshThumbnails(){
+    Q_D(ctkDICOMThumbnailListWidget);
+
+    if(d->CurrentSelectedModel.isValid())
+    {
+        this->onModelSelected(d->CurrentSelectedModel);
+    }
+}
@@ -47,6 +47,13 @@ private:
 
 public Q_SLOTS:
   void onModelSelected(const QModelIndex& index);
+  /// Show the thumbnail if it belongs to the current selection.
+  /// Connect to ctkDICOMDatabase::thumbnailGenerated().
+  void onThumbnailGenerated(const QString& studyInstanceUID,
+                            const QString& seriesInstanceUID,
+                            const QString& sopInstanceUID);
+  /// Reload the thumbnails of the current selection
+  void refreshThumbnails();
 };
 
 #endif
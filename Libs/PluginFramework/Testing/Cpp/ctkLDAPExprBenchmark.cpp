@@ -0,0 +1,168 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTime>
+
+#include "ctkLDAPExpr_p.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+QStringList filters()
+{
+  QStringList filters;
+  filters << "(objectclass=org.commontk.eventadmin.ctkEventHandler)"
+          << "(&(objectclass=org.commontk.eventadmin.ctkEventHandler)(event.topics=org/commontk/*))"
+          << "(|(service.ranking>=10)(service.pid=pid.3))"
+          << "(&(service.id=42)(!(name~=Some Name)))"
+          << "(&(objectclass=*)(|(a=1)(b=2)(c=3)(d=4)(event.topics=*)))"
+          << "(&(count<=5)(count=05)(Name=some*))";
+  return filters;
+}
+
+//----------------------------------------------------------------------------
+QList<ctkDictionary> dictionaries()
+{
+  QList<ctkDictionary> dictionaries;
+  for (int i = 0; i < 16; ++i)
+  {
+    ctkDictionary dictionary;
+    dictionary.insert("objectclass", QString(i % 2 ? "org.commontk.eventadmin.ctkEventHandler" : "ctkLogService"));
+    dictionary.insert("event.topics", QStringList() << "org/commontk/test" << QString("topic/%1").arg(i));
+    dictionary.insert("service.ranking", i);
+    dictionary.insert("service.pid", QString("pid.%1").arg(i));
+    dictionary.insert("service.id", 40 + i);
+    dictionary.insert("name", QString(i % 3 ? "SomeName" : "Other name"));
+    dictionary.insert("count", QString::number(i));
+    dictionary.insert(QString(QChar('a' + i % 5)), i % 4);
+    dictionaries << dictionary;
+  }
+  return dictionaries;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Compare the evaluation of the compiled filters with the evaluation of
+// their expression trees, then report the throughput of both, with the
+// filter parsed for each lookup as the services registry used to do.
+// The number of evaluations can be given on the command line.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  int iterations = argc > 1 ? QString(argv[1]).toInt() : 200000;
+  QStringList filterStrings = filters();
+  QList<ctkDictionary> dicts = dictionaries();
+
+  QList<ctkLDAPExpr> exprs;
+  foreach (QString filter, filterStrings)
+  {
+    exprs << ctkLDAPExpr(filter);
+  }
+
+  int matches = 0;
+  for (int i = 0; i < exprs.size(); ++i)
+  {
+    foreach (ctkDictionary dictionary, dicts)
+    {
+      for (int matchCase = 0; matchCase < 2; ++matchCase)
+      {
+        bool compiled = exprs[i].evaluate(dictionary, matchCase);
+        if (compiled != exprs[i].evaluateTree(dictionary, matchCase))
+        {
+          std::cerr << "Compiled and tree evaluations differ for "
+                    << qPrintable(filterStrings[i]) << std::endl;
+          return EXIT_FAILURE;
+        }
+        matches += compiled;
+      }
+    }
+  }
+  if (matches == 0)
+  {
+    std::cerr << "No filter matched" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // a cached filter is shared, the cache is bypassed when disabled
+  if (ctkLDAPExpr(filterStrings[1]).toString() != exprs[1].toString()
+      || ctkLDAPExpr::cacheCapacity() != 256)
+  {
+    std::cerr << "Unexpected filter cache state" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  QTime timer;
+  int result = 0;
+
+  // evaluation only
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+  {
+    result += exprs[i % exprs.size()].evaluateTree(dicts[i % dicts.size()], false);
+  }
+  int treeTime = timer.elapsed();
+
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+  {
+    result -= exprs[i % exprs.size()].evaluate(dicts[i % dicts.size()], false);
+  }
+  int compiledTime = timer.elapsed();
+
+  // filter string given at each lookup
+  ctkLDAPExpr::setCacheCapacity(0);
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+  {
+    result += ctkLDAPExpr(filterStrings[i % filterStrings.size()])
+        .evaluateTree(dicts[i % dicts.size()], false);
+  }
+  int parseTime = timer.elapsed();
+
+  ctkLDAPExpr::setCacheCapacity(256);
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+  {
+    result -= ctkLDAPExpr(filterStrings[i % filterStrings.size()])
+        .evaluate(dicts[i % dicts.size()], false);
+  }
+  int cachedTime = timer.elapsed();
+
+  if (result != 0)
+  {
+    std::cerr << "Compiled and tree evaluations differ" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << iterations << " evaluations: tree " << treeTime << " ms, compiled "
+            << compiledTime << " ms; parsed each time " << parseTime
+            << " ms, cached " << cachedTime << " ms" << std::endl;
+
+  return EXIT_SUCCESS;
+}
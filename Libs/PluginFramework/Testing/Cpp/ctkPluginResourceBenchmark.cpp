@@ -0,0 +1,233 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QSet>
+#include <QTime>
+#include <QtSql>
+
+#include "ctkPluginResourceArchive_p.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+const int PluginKey = 1;
+
+//----------------------------------------------------------------------------
+// Resources of a UI-heavy plugin: icons, a few forms and translations
+QMap<QByteArray, QByteArray> resources()
+{
+  QMap<QByteArray, QByteArray> resources;
+  resources.insert("/META-INF/MANIFEST.MF", QByteArray("Plugin-SymbolicName: org.commontk.bench\n"));
+  for (int i = 0; i < 400; ++i)
+  {
+    resources.insert(QString("/icons/%1/icon%2.png").arg(i % 4 ? "small" : "large").arg(i).toUtf8(),
+                     QByteArray(512 + (i % 16) * 256, char(i)));
+  }
+  for (int i = 0; i < 40; ++i)
+  {
+    resources.insert(QString("/forms/form%1.ui").arg(i).toUtf8(), QByteArray(8192, 'u'));
+    resources.insert(QString("/translations/bench_%1.qm").arg(i).toUtf8(), QByteArray(32768, 't'));
+  }
+  return resources;
+}
+
+//----------------------------------------------------------------------------
+// Fills a database with the schema and the statements of ctkPluginStorageSQL
+bool createDatabase(QSqlDatabase& database, const QMap<QByteArray, QByteArray>& resources)
+{
+  QSqlQuery query(database);
+  if (!query.exec("CREATE TABLE PluginResources (K INTEGER NOT NULL,"
+                  "ResourcePath TEXT NOT NULL, Resource BLOB NOT NULL)"))
+  {
+    return false;
+  }
+
+  QVariantList keys;
+  QVariantList paths;
+  QVariantList data;
+  for (QMap<QByteArray, QByteArray>::const_iterator it = resources.begin(); it != resources.end(); ++it)
+  {
+    keys << PluginKey;
+    paths << QString::fromUtf8(it.key());
+    data << it.value();
+  }
+  query.prepare("INSERT INTO PluginResources (K,ResourcePath,Resource) VALUES(?,?,?)");
+  query.addBindValue(keys);
+  query.addBindValue(paths);
+  query.addBindValue(data);
+  return query.execBatch();
+}
+
+//----------------------------------------------------------------------------
+QByteArray getDatabaseResource(QSqlDatabase& database, const QString& path)
+{
+  QSqlQuery query(database);
+  query.prepare("SELECT Resource FROM PluginResources WHERE K=? AND ResourcePath=?");
+  query.addBindValue(PluginKey);
+  query.addBindValue(path);
+  query.exec();
+  return query.next() ? query.value(0).toByteArray() : QByteArray();
+}
+
+//----------------------------------------------------------------------------
+QStringList findDatabaseResourcesPath(QSqlDatabase& database, const QString& path)
+{
+  QString resourcePath = path.startsWith('/') ? path : QString("/") + path;
+  if (!resourcePath.endsWith('/'))
+    resourcePath += "/";
+
+  QSqlQuery query(database);
+  query.prepare("SELECT SUBSTR(ResourcePath,?) FROM PluginResources WHERE K=? AND SUBSTR(ResourcePath,1,?)=?");
+  query.addBindValue(resourcePath.size()+1);
+  query.addBindValue(PluginKey);
+  query.addBindValue(resourcePath.size());
+  query.addBindValue(resourcePath);
+  query.exec();
+
+  QSet<QString> paths;
+  while (query.next())
+  {
+    QStringList components = query.value(0).toString().split('/', QString::SkipEmptyParts);
+    if (components.size() == 1)
+    {
+      paths << components.front();
+    }
+    else if (components.size() == 2)
+    {
+      paths << components.front() + "/";
+    }
+  }
+  return paths.toList();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Latency of the plugin resource fetches and listings from the plugin
+// database and from a memory-mapped resource archive. The number of
+// fetches can be given on the command line.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  int iterations = argc > 1 ? QString(argv[1]).toInt() : 20000;
+
+  QDir dir(QDir::temp().filePath("ctkPluginResourceBenchmark"));
+  QDir::root().mkpath(dir.absolutePath());
+  QFile::remove(dir.filePath("plugins.db"));
+
+  QMap<QByteArray, QByteArray> pluginResources = resources();
+  QStringList paths;
+  foreach (QByteArray path, pluginResources.keys())
+  {
+    paths << QString::fromUtf8(path);
+  }
+
+  int result = EXIT_SUCCESS;
+  {
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "ctkPluginResourceBenchmark");
+    database.setDatabaseName(dir.filePath("plugins.db"));
+    if (!database.open() || !createDatabase(database, pluginResources) ||
+        !ctkPluginResourceArchive::write(dir.filePath("1.res"), pluginResources))
+    {
+      std::cerr << "Could not create the resource stores in " << qPrintable(dir.absolutePath()) << std::endl;
+      return EXIT_FAILURE;
+    }
+    ctkPluginResourceArchive archive(dir.filePath("1.res"));
+
+    // both stores return the same resources and listings
+    QStringList listings;
+    listings << "/" << "icons" << "/icons/small/" << "forms" << "META-INF" << "missing";
+    foreach (QString path, listings)
+    {
+      QSet<QString> fromDatabase = findDatabaseResourcesPath(database, path).toSet();
+      if (fromDatabase != archive.findResourcesPath(path).toSet())
+      {
+        std::cerr << "The resource listings of " << qPrintable(path) << " differ" << std::endl;
+        result = EXIT_FAILURE;
+      }
+    }
+    foreach (QString path, paths)
+    {
+      if (getDatabaseResource(database, path) != archive.getResource(path))
+      {
+        std::cerr << "The resources " << qPrintable(path) << " differ" << std::endl;
+        result = EXIT_FAILURE;
+      }
+    }
+    if (!archive.getResource("/icons/none.png").isNull())
+    {
+      std::cerr << "Found a missing resource" << std::endl;
+      result = EXIT_FAILURE;
+    }
+
+    QTime timer;
+    qint64 bytes = 0;
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+    {
+      bytes += getDatabaseResource(database, paths[(i * 7) % paths.size()]).size();
+    }
+    int databaseTime = timer.elapsed();
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+    {
+      bytes -= archive.getResource(paths[(i * 7) % paths.size()]).size();
+    }
+    int archiveTime = timer.elapsed();
+
+    timer.start();
+    for (int i = 0; i < iterations / 10; ++i)
+    {
+      bytes += findDatabaseResourcesPath(database, listings[i % listings.size()]).size();
+    }
+    int databaseListTime = timer.elapsed();
+
+    timer.start();
+    for (int i = 0; i < iterations / 10; ++i)
+    {
+      bytes -= archive.findResourcesPath(listings[i % listings.size()]).size();
+    }
+    int archiveListTime = timer.elapsed();
+
+    if (bytes != 0)
+    {
+      std::cerr << "The resource stores returned different data" << std::endl;
+      result = EXIT_FAILURE;
+    }
+
+    std::cout << iterations << " fetches: database " << databaseTime << " ms, archive "
+              << archiveTime << " ms; " << iterations / 10 << " listings: database "
+              << databaseListTime << " ms, archive " << archiveListTime << " ms" << std::endl;
+
+    database.close();
+  }
+  QSqlDatabase::removeDatabase("ctkPluginResourceBenchmark");
+
+  return result;
+}
@@ -0,0 +1,193 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QMutex>
+#include <QThread>
+#include <QTime>
+#include <QWaitCondition>
+
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <ctkPluginFramework.h>
+#include <ctkPluginFrameworkFactory.h>
+#include <ctkServiceRegistration.h>
+
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+const int StableServices = 64;
+
+//----------------------------------------------------------------------------
+// Resolves the stable services, by class and by pid, until it is stopped.
+class LookupThread : public QThread
+{
+public:
+
+  LookupThread(ctkPluginContext* context, QAtomicInt* stop)
+    : context(context), stop(stop), lookups(0), failures(0)
+  {
+  }
+
+  void run()
+  {
+    int i = 0;
+    while (stop->fetchAndAddOrdered(0) == 0)
+    {
+      QString filter = QString("(service.pid=bench.stable.%1)").arg(i++ % StableServices);
+      if (context->getServiceReferences("QObject", filter).size() != 1)
+      {
+        ++failures;
+      }
+      if (context->getServiceReferences("QObject").size() < StableServices)
+      {
+        ++failures;
+      }
+      lookups += 2;
+    }
+  }
+
+  ctkPluginContext* context;
+  QAtomicInt* stop;
+  int lookups;
+  int failures;
+};
+
+//----------------------------------------------------------------------------
+// Registers, modifies and unregisters services until it is stopped.
+class ChurnThread : public QThread
+{
+public:
+
+  ChurnThread(ctkPluginContext* context, QAtomicInt* stop)
+    : context(context), stop(stop), changes(0)
+  {
+  }
+
+  void run()
+  {
+    QObject service;
+    int i = 0;
+    while (stop->fetchAndAddOrdered(0) == 0)
+    {
+      ctkDictionary props;
+      props.insert(ctkPluginConstants::SERVICE_PID, QString("bench.churn.%1").arg(i++));
+      ctkServiceRegistration registration =
+        context->registerService(QStringList("QObject"), &service, props);
+      props.insert(ctkPluginConstants::SERVICE_RANKING, i);
+      registration.setProperties(props);
+      registration.unregister();
+      changes += 3;
+    }
+  }
+
+  ctkPluginContext* context;
+  QAtomicInt* stop;
+  int changes;
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Number of service lookups per second for 1 to 8 lookup threads, while
+// another thread keeps registering and unregistering services. The
+// duration of each run in ms can be given on the command line.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  int duration = argc > 1 ? QString(argv[1]).toInt() : 1000;
+
+  ctkProperties fwProps;
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE, QDir::temp().filePath("ctkServicesBenchmark"));
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN, ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT);
+  ctkPluginFrameworkFactory fwFactory(fwProps);
+  QSharedPointer<ctkPluginFramework> framework = fwFactory.getFramework();
+  framework->start();
+  ctkPluginContext* context = framework->getPluginContext();
+
+  QList<QObject*> stableServices;
+  for (int i = 0; i < StableServices; ++i)
+  {
+    ctkDictionary props;
+    props.insert(ctkPluginConstants::SERVICE_PID, QString("bench.stable.%1").arg(i));
+    stableServices << new QObject;
+    context->registerService(QStringList("QObject"), stableServices.back(), props);
+  }
+
+  int result = EXIT_SUCCESS;
+  QList<int> threadCounts;
+  threadCounts << 1 << 2 << 4 << 8;
+  foreach (int threadCount, threadCounts)
+  {
+    QAtomicInt stop(0);
+    ChurnThread churn(context, &stop);
+    QList<LookupThread*> lookupThreads;
+    for (int i = 0; i < threadCount; ++i)
+    {
+      lookupThreads << new LookupThread(context, &stop);
+    }
+
+    QTime timer;
+    timer.start();
+    churn.start();
+    foreach (LookupThread* thread, lookupThreads)
+    {
+      thread->start();
+    }
+    QMutex mutex;
+    QWaitCondition running;
+    mutex.lock();
+    running.wait(&mutex, duration);
+    mutex.unlock();
+    stop.fetchAndStoreOrdered(1);
+    churn.wait();
+
+    int lookups = 0;
+    int failures = 0;
+    foreach (LookupThread* thread, lookupThreads)
+    {
+      thread->wait();
+      lookups += thread->lookups;
+      failures += thread->failures;
+    }
+    int elapsed = qMax(1, timer.elapsed());
+    qDeleteAll(lookupThreads);
+
+    std::cout << threadCount << " threads: " << (lookups * 1000LL / elapsed)
+              << " lookups/s, " << (churn.changes * 1000LL / elapsed)
+              << " changes/s" << std::endl;
+    if (failures > 0)
+    {
+      std::cerr << failures << " lookups did not find the stable services" << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+
+  framework->stop();
+  framework->waitForStop(5000);
+  qDeleteAll(stableServices);
+  return result;
+}
@@ -0,0 +1,270 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEABatchTestSuite_p.h"
+
+#include <ctkPluginContext.h>
+#include <ctkServiceRegistration.h>
+
+#include <service/event/ctkEventAdmin.h>
+#include <service/event/ctkEventConstants.h>
+
+#include <QMutex>
+#include <QTest>
+#include <QTime>
+#include <QWaitCondition>
+#include <QDebug>
+
+namespace
+{
+
+const int BatchSize = 100;
+
+//----------------------------------------------------------------------------
+ctkDictionary handlerProperties(const QString& topic, bool batch)
+{
+  ctkDictionary props;
+  props.insert(ctkEventConstants::EVENT_TOPIC, topic);
+  if (batch)
+  {
+    props.insert(ctkEventConstants::EVENT_DELIVERY, ctkEventConstants::DELIVERY_ASYNC_BATCH);
+  }
+  return props;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+ctkEABatchTestHelper::ctkEABatchTestHelper(int delay)
+  : events(0), calls(0), outOfOrder(0), lastValue(-1), delay(delay)
+{
+
+}
+
+//----------------------------------------------------------------------------
+void ctkEABatchTestHelper::handleEvent(const ctkEvent& event)
+{
+  received(QList<ctkEvent>() << event);
+}
+
+//----------------------------------------------------------------------------
+void ctkEABatchTestHelper::handleEvents(const QList<ctkEvent>& batch)
+{
+  received(batch);
+}
+
+//----------------------------------------------------------------------------
+void ctkEABatchTestHelper::received(const QList<ctkEvent>& batch)
+{
+  // the events of a handler are delivered by one thread at a time
+  int last = lastValue.fetchAndAddOrdered(0);
+  foreach (const ctkEvent& event, batch)
+  {
+    int value = event.getProperty("value").toInt();
+    if (value <= last)
+    {
+      outOfOrder.ref();
+    }
+    last = value;
+  }
+  lastValue.fetchAndStoreOrdered(last);
+  events.fetchAndAddOrdered(batch.size());
+  calls.ref();
+
+  if (delay > 0)
+  {
+    QMutex mutex;
+    QWaitCondition sleep;
+    QMutexLocker l(&mutex);
+    sleep.wait(&mutex, delay);
+  }
+}
+
+//----------------------------------------------------------------------------
+ctkEABatchTestSuite::ctkEABatchTestSuite(ctkPluginContext* pc, long eventPluginId)
+  : context(pc), eventPluginId(eventPluginId), eventAdmin(0)
+{
+
+}
+
+//----------------------------------------------------------------------------
+void ctkEABatchTestSuite::init()
+{
+  context->getPlugin(eventPluginId)->start();
+  reference = context->getServiceReference<ctkEventAdmin>();
+  eventAdmin = context->getService<ctkEventAdmin>(reference);
+}
+
+//----------------------------------------------------------------------------
+void ctkEABatchTestSuite::cleanup()
+{
+  context->ungetService(reference);
+  context->getPlugin(eventPluginId)->stop();
+}
+
+//----------------------------------------------------------------------------
+bool ctkEABatchTestSuite::waitForEvents(const QList<ctkEABatchTestHelper*>& handlers,
+                                        int events, int msecs)
+{
+  QTime timer;
+  timer.start();
+  bool delivered = false;
+  while (!delivered && timer.elapsed() < msecs)
+  {
+    delivered = true;
+    foreach (ctkEABatchTestHelper* handler, handlers)
+    {
+      delivered = delivered && handler->events >= events;
+    }
+    if (!delivered) QTest::qWait(10);
+  }
+  return delivered;
+}
+
+//----------------------------------------------------------------------------
+int ctkEABatchTestSuite::postEvents(const QString& topic, int events, bool batched)
+{
+  QTime timer;
+  timer.start();
+  QList<ctkEvent> batch;
+  for (int i = 0; i < events; ++i)
+  {
+    ctkDictionary props;
+    props.insert("value", i);
+    ctkEvent event(topic, props);
+    if (!batched)
+    {
+      eventAdmin->postEvent(event);
+      continue;
+    }
+    batch.push_back(event);
+    if (batch.size() == BatchSize || i == events - 1)
+    {
+      eventAdmin->postEvents(batch);
+      batch.clear();
+    }
+  }
+  return timer.elapsed();
+}
+
+//----------------------------------------------------------------------------
+void ctkEABatchTestSuite::testPostEventsDelivery()
+{
+  const int events = 10 * BatchSize;
+  ctkEABatchTestHelper handler;
+  ctkEABatchTestHelper batchHandler;
+  ctkServiceRegistration handlerRegistration = context->registerService<ctkEventHandler>(
+        &handler, handlerProperties("org/commontk/batch/delivery", false));
+  ctkServiceRegistration batchHandlerRegistration = context->registerService<ctkEventHandler>(
+        &batchHandler, handlerProperties("org/commontk/batch/delivery", true));
+
+  postEvents("org/commontk/batch/delivery", events, true);
+  bool delivered = waitForEvents(QList<ctkEABatchTestHelper*>() << &handler << &batchHandler, events, 10000);
+  handlerRegistration.unregister();
+  batchHandlerRegistration.unregister();
+
+  QVERIFY2(delivered, "Not all posted events were delivered");
+  QCOMPARE(int(handler.events), events);
+  QCOMPARE(int(handler.calls), events);
+  QCOMPARE(int(handler.outOfOrder), 0);
+  QCOMPARE(int(batchHandler.events), events);
+  QCOMPARE(int(batchHandler.outOfOrder), 0);
+  QVERIFY2(batchHandler.calls <= events / BatchSize, "A posted batch was split for a batch handler");
+}
+
+//----------------------------------------------------------------------------
+void ctkEABatchTestSuite::testPostEventsThroughput()
+{
+  const int events = 20000;
+  const int handlerCount = 8;
+  QList<int> posted;
+  QList<int> delivered;
+  for (int batched = 0; batched < 2; ++batched)
+  {
+    // half of the handlers receive the events in batches
+    QList<ctkEABatchTestHelper*> handlers;
+    QList<ctkServiceRegistration> registrations;
+    for (int i = 0; i < handlerCount; ++i)
+    {
+      handlers << new ctkEABatchTestHelper;
+      registrations << context->registerService<ctkEventHandler>(
+                         handlers.back(), handlerProperties("org/commontk/batch/throughput", i % 2 == 1));
+    }
+
+    QTime timer;
+    timer.start();
+    posted << qMax(1, postEvents("org/commontk/batch/throughput", events, batched));
+    bool allDelivered = waitForEvents(handlers, events, 60000);
+    delivered << qMax(1, timer.elapsed());
+
+    foreach (ctkServiceRegistration registration, registrations)
+    {
+      registration.unregister();
+    }
+    int outOfOrder = 0;
+    foreach (ctkEABatchTestHelper* handler, handlers)
+    {
+      outOfOrder += handler->outOfOrder;
+    }
+    qDeleteAll(handlers);
+
+    QVERIFY2(allDelivered, "Not all posted events were delivered");
+    QCOMPARE(outOfOrder, 0);
+
+    qDebug() << (batched ? "postEvents:" : "postEvent:") << events * 1000LL / posted.back()
+             << "posts/s," << events * 1000LL / delivered.back() << "events/s delivered to"
+             << handlerCount << "handlers";
+  }
+
+  qDebug() << "postEvents delivers" << double(delivered.front()) / delivered.back()
+           << "times as many events per second as postEvent";
+}
+
+//----------------------------------------------------------------------------
+void ctkEABatchTestSuite::testCoalesceEvents()
+{
+  const int events = 200;
+  ctkEABatchTestHelper handler(20);
+  ctkServiceRegistration handlerRegistration = context->registerService<ctkEventHandler>(
+        &handler, handlerProperties("org/commontk/batch/coalesce", false));
+
+  for (int i = 0; i < events; ++i)
+  {
+    ctkDictionary props;
+    props.insert("value", i);
+    props.insert(ctkEventConstants::EVENT_COALESCE, 1000);
+    eventAdmin->postEvent(ctkEvent("org/commontk/batch/coalesce", props));
+  }
+
+  QTime timer;
+  timer.start();
+  while (handler.lastValue != events - 1 && timer.elapsed() < 10000)
+  {
+    QTest::qWait(10);
+  }
+  handlerRegistration.unregister();
+
+  QCOMPARE(int(handler.lastValue), events - 1);
+  QCOMPARE(int(handler.outOfOrder), 0);
+  QVERIFY2(handler.events < events, "The waiting events were not coalesced");
+  qDebug() << handler.events << "of" << events << "coalescing events delivered to a slow handler";
+}
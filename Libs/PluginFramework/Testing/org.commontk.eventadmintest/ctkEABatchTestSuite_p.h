@@ -0,0 +1,115 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEABATCHTESTSUITE_P_H
+#define CTKEABATCHTESTSUITE_P_H
+
+#include <QObject>
+
+#include <ctkServiceReference.h>
+#include <ctkTestSuiteInterface.h>
+
+#include <service/event/ctkEventHandler.h>
+
+class ctkPluginContext;
+struct ctkEventAdmin;
+
+class ctkEABatchTestHelper : public QObject, public ctkEventHandler
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkEventHandler)
+
+public:
+
+  ctkEABatchTestHelper(int delay = 0);
+
+  void handleEvent(const ctkEvent& event);
+
+  void handleEvents(const QList<ctkEvent>& batch);
+
+  QAtomicInt events;
+  QAtomicInt calls;
+  QAtomicInt outOfOrder;
+  QAtomicInt lastValue;
+
+private:
+
+  void received(const QList<ctkEvent>& batch);
+
+  const int delay;
+};
+
+
+class ctkEABatchTestSuite : public QObject,
+    public ctkTestSuiteInterface
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkTestSuiteInterface)
+
+public:
+
+  ctkEABatchTestSuite(ctkPluginContext* pc, long eventPluginId);
+
+private Q_SLOTS:
+
+  void init();
+  void cleanup();
+
+  /*
+   * Ensures ctkEventAdmin delivers the events given to postEvents() in order,
+   * one by one to an ordinary ctkEventHandler and in a single call per
+   * batch to a ctkEventHandler registered for the "async.batch" delivery.
+   */
+  void testPostEventsDelivery();
+
+  /*
+   * Measures the events posted and delivered per second with postEvent()
+   * and with postEvents(), and ensures both deliver all events.
+   */
+  void testPostEventsThroughput();
+
+  /*
+   * Ensures ctkEventAdmin replaces the coalescing events waiting for a
+   * slow ctkEventHandler, the last posted event being delivered.
+   */
+  void testCoalesceEvents();
+
+private:
+
+  /*
+   * Waits until each of the handlers received the given number of events,
+   * at most for the given time.
+   */
+  bool waitForEvents(const QList<ctkEABatchTestHelper*>& handlers, int events, int msecs);
+
+  /*
+   * Posts the events one by one or in batches and returns the time it took.
+   */
+  int postEvents(const QString& topic, int events, bool batched);
+
+  ctkPluginContext* context;
+  long eventPluginId;
+  ctkEventAdmin* eventAdmin;
+  ctkServiceReference reference;
+};
+
+#endif // CTKEABATCHTESTSUITE_P_H
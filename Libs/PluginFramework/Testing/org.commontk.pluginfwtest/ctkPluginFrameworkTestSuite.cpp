@@ -25,6 +25,7 @@
 #include <ctkPluginContext.h>
 #include <ctkPluginConstants.h>
 #include <ctkPluginException.h>
+#include <ctkPluginFrameworkLauncher.h>
 #include <ctkServiceException.h>
 
 #include <QDir>
@@ -455,6 +456,49 @@ void ctkPluginFrameworkTestSuite::frame045a()
   }
 }
 
+//----------------------------------------------------------------------------
+// Service lookups with filters on indexed properties: exact and wildcard
+// values, combined with other conditions, after modification and after
+// unregistration.
+void ctkPluginFrameworkTestSuite::frame046a()
+{
+  QObject handlerA, handlerB, handlerC;
+  ctkDictionary props;
+  props.insert(ctkPluginConstants::SERVICE_PID, "frame046a.A");
+  props.insert("event.topics", QStringList() << "org/commontk/frame046a/*");
+  ctkServiceRegistration regA = pc->registerService(QStringList("QObject"), &handlerA, props);
+  props.clear();
+  props.insert(ctkPluginConstants::SERVICE_PID, "frame046a.B");
+  props.insert("event.topics", QString("org/commontk/frame046a/B"));
+  props.insert("frame046a", "B");
+  ctkServiceRegistration regB = pc->registerService(QStringList("QObject"), &handlerB, props);
+  props.clear();
+  props.insert(ctkPluginConstants::SERVICE_PID, "frame046a.C");
+  props.insert("event.topics", QString("org/commontk/frame046a/C"));
+  ctkServiceRegistration regC = pc->registerService(QStringList("QObject"), &handlerC, props);
+
+  QCOMPARE(pc->getServiceReferences("QObject", "(service.pid=frame046a.A)").size(), 1);
+  QCOMPARE(pc->getServiceReferences("", "(service.pid=frame046a.B)").size(), 1);
+  QCOMPARE(pc->getServiceReferences("QObject", "(service.pid=frame046a.*)").size(), 3);
+  QCOMPARE(pc->getServiceReferences("QObject", "(&(service.pid=frame046a.*)(frame046a=B))").size(), 1);
+  QCOMPARE(pc->getServiceReferences("QObject", "(|(event.topics=org/commontk/frame046a/\\*)"
+                                    "(event.topics=org/commontk/frame046a/C))").size(), 2);
+  QCOMPARE(pc->getServiceReferences("ctkPluginFrameworkTestSuite", "(service.pid=frame046a.A)").size(), 0);
+
+  props.clear();
+  props.insert(ctkPluginConstants::SERVICE_PID, "frame046a.D");
+  regC.setProperties(props);
+  QCOMPARE(pc->getServiceReferences("QObject", "(service.pid=frame046a.C)").size(), 0);
+  QCOMPARE(pc->getServiceReferences("QObject", "(service.pid=frame046a.D)").size(), 1);
+
+  regA.unregister();
+  regB.unregister();
+  regC.unregister();
+  QCOMPARE(pc->getServiceReferences("QObject", "(service.pid=frame046a.*)").size(), 0);
+
+  clearEvents();
+}
+
 //----------------------------------------------------------------------------
 // Reinstalls and the updates testbundle_A.
 // The version is checked to see if an update has been made.
@@ -539,6 +583,84 @@ void ctkPluginFrameworkTestSuite::frame070a()
   QVERIFY2(versionA1 != versionA, "framework test plug-in, update of plug-in failed, version info unchanged :FRAME070A:Fail");
 }
 
+//----------------------------------------------------------------------------
+// Start pluginSL3_test and pluginSL1_test with the launcher, which loads
+// them in parallel, and check that pluginSL1_test, required by
+// pluginSL3_test, is started first.
+void ctkPluginFrameworkTestSuite::frame080a()
+{
+  clearEvents();
+
+  ctkPluginFrameworkLauncher::addSearchPath(pc->getProperty("pluginfw.testDir").toString(), false);
+  QStringList symbolicNames;
+  symbolicNames << "pluginSL3.test" << "pluginSL1.test";
+  QVERIFY2(ctkPluginFrameworkLauncher::startPlugins(symbolicNames, ctkPlugin::START_ACTIVATION_POLICY, pc),
+           "framework test plugin, starting the plugins failed :FRAME080A:FAIL");
+
+  QSharedPointer<ctkPlugin> pSL1;
+  QSharedPointer<ctkPlugin> pSL3;
+  foreach(QSharedPointer<ctkPlugin> plugin, pc->getPlugins())
+  {
+    if (plugin->getSymbolicName() == "pluginSL1.test") pSL1 = plugin;
+    else if (plugin->getSymbolicName() == "pluginSL3.test") pSL3 = plugin;
+  }
+  QVERIFY2(pSL1 && pSL1->getState() == ctkPlugin::ACTIVE, "pluginSL1_test should be ACTIVE");
+  QVERIFY2(pSL3 && pSL3->getState() == ctkPlugin::ACTIVE, "pluginSL3_test should be ACTIVE");
+
+  QList<ctkPluginEvent> syncPEvts;
+  syncPEvts << ctkPluginEvent(ctkPluginEvent::STARTING, pSL1);
+  syncPEvts << ctkPluginEvent(ctkPluginEvent::STARTING, pSL3);
+  QVERIFY2(checkSyncListenerEvents(syncPEvts), "Unexpected start order :FRAME080A:FAIL");
+
+  QHash<QString, ctkPluginFrameworkLauncher::PluginTiming> timings = ctkPluginFrameworkLauncher::getPluginTimings();
+  QCOMPARE(timings.size(), 2);
+  QVERIFY(timings.contains("pluginSL1.test"));
+  QVERIFY(timings.contains("pluginSL3.test"));
+
+  // the service listener test suite installs these plugins again
+  pSL3->uninstall();
+  pSL1->uninstall();
+  clearEvents();
+}
+
+//----------------------------------------------------------------------------
+// Install pluginA2_test, whose resources other than the manifest are
+// cached on first access, and check its resources, also after
+// reinstalling it.
+void ctkPluginFrameworkTestSuite::frame085a()
+{
+  const QString resourcePath("CTK-INF/resources/pluginA2_test.txt");
+
+  QVERIFY2(pc->getProperty(ctkPluginConstants::FRAMEWORK_PLUGIN_LAZY_RESOURCES).toBool(),
+           "framework test plugin, the resources are not cached lazily :FRAME085A:FAIL");
+
+  for (int i = 0; i < 2; ++i)
+  {
+    QSharedPointer<ctkPlugin> pA2;
+    try
+    {
+      pA2 = ctkPluginFrameworkTestUtil::installPlugin(pc, "pluginA2_test");
+    }
+    catch (const ctkPluginException& pexcA2)
+    {
+      qDebug() << "framework test plugin" << pexcA2 << ":FRAME085A:FAIL";
+      QFAIL("Failed to install pluginA2_test");
+    }
+
+    QCOMPARE(pA2->getHeaders().value("Plugin-Name"), QString("pluginA2_test"));
+
+    QByteArray resource = pA2->getResource(resourcePath);
+    QCOMPARE(resource.trimmed(), QByteArray("pluginA2_test resource"));
+    QCOMPARE(pA2->getResource(resourcePath), resource);
+    QVERIFY(pA2->getResource("CTK-INF/resources/none.txt").isNull());
+
+    // the reinstalled plugin may reuse the storage key of the uninstalled one
+    pA2->uninstall();
+  }
+
+  clearEvents();
+}
+
 //----------------------------------------------------------------------------
 void ctkPluginFrameworkTestSuite::frameworkListener(const ctkPluginFrameworkEvent& fwEvent)
 {
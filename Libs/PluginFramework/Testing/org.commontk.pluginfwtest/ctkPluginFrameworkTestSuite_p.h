@@ -66,7 +66,10 @@ private Q_SLOTS:
   void frame040a();
   void frame042a();
   void frame045a();
+  void frame046a();
   void frame070a();
+  void frame080a();
+  void frame085a();
 
 private:
 
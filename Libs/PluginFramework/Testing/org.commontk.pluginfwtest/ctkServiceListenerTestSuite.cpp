@@ -28,6 +28,7 @@
 #include <ctkPluginConstants.h>
 #include <ctkServiceEvent.h>
 #include <ctkServiceException.h>
+#include <ctkServiceRegistration.h>
 
 #include <ctkPluginFrameworkTestUtil.h>
 
@@ -316,6 +317,55 @@ void ctkServiceListenerTestSuite::frameSL25a()
   }
 }
 
+//----------------------------------------------------------------------------
+void ctkServiceListenerTestSuite::frameSL30a()
+{
+  ctkServiceListener classAndName(pc, false);
+  ctkServiceListener pidAndRanking(pc, false);
+  ctkServiceListener otherClasses(pc, false);
+  try
+  {
+    pc->connectServiceListener(&classAndName, "serviceChanged",
+                               "(&(objectclass=QObject)(name=frameSL30a))");
+    pc->connectServiceListener(&pidAndRanking, "serviceChanged",
+                               "(&(service.pid=frameSL30a.pid)(service.ranking>=5))");
+    pc->connectServiceListener(&otherClasses, "serviceChanged",
+                               "(|(&(objectclass=QObject)(name=other))(&(objectclass=ctkFooService)(name=frameSL30a)))");
+  }
+  catch (const ctkInvalidArgumentException& iae)
+  {
+    qDebug() << "service listener registration failed " << iae.what();
+    QFAIL("service listener registration failed");
+  }
+
+  QObject service;
+  ctkDictionary props;
+  props.insert("name", "frameSL30a");
+  props.insert(ctkPluginConstants::SERVICE_PID, "frameSL30a.pid");
+  props.insert(ctkPluginConstants::SERVICE_RANKING, 1);
+  ctkServiceRegistration registration = pc->registerService(QStringList("QObject"), &service, props);
+  props.insert(ctkPluginConstants::SERVICE_RANKING, 10);
+  registration.setProperties(props);
+  registration.unregister();
+
+  pc->disconnectServiceListener(&classAndName, "serviceChanged");
+  pc->disconnectServiceListener(&pidAndRanking, "serviceChanged");
+  pc->disconnectServiceListener(&otherClasses, "serviceChanged");
+
+  QList<ctkServiceEvent::Type> events;
+  events << ctkServiceEvent::REGISTERED << ctkServiceEvent::MODIFIED << ctkServiceEvent::UNREGISTERING;
+  QVERIFY(classAndName.checkEvents(events));
+  QVERIFY(classAndName.teststatus);
+
+  // the service only matches once its ranking has been raised
+  events.clear();
+  events << ctkServiceEvent::MODIFIED << ctkServiceEvent::UNREGISTERING;
+  QVERIFY(pidAndRanking.checkEvents(events));
+  QVERIFY(pidAndRanking.teststatus);
+
+  QVERIFY(otherClasses.checkEvents(QList<ctkServiceEvent::Type>()));
+}
+
 //----------------------------------------------------------------------------
 bool ctkServiceListenerTestSuite::runStartStopTest(
   const QString& tcName, int cnt, QSharedPointer<ctkPlugin> targetPlugin,
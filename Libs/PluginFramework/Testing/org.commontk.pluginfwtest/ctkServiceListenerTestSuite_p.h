@@ -63,6 +63,11 @@ private Q_SLOTS:
 //    void frameSL20a();
     void frameSL25a();
 
+    // Checks that service listeners with compound filters,
+    // which are cached by one of their terms, receive the
+    // events of the matching services only.
+    void frameSL30a();
+
 private:
 
     ctkPluginContext* pc;
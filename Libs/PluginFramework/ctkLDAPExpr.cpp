@@ -23,6 +23,9 @@ limitations under the License.
 
 #include <ctkException.h>
 
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QSet>
 #include <QVariant>
 #include <QStringList>
@@ -88,6 +91,40 @@ public:
 
 };
 
+/**
+ * One node of the expression tree in the compiled form of a filter.
+ * The nodes are stored in prefix order, the operands of a complex node
+ * follow it and a whole sub-expression can be skipped with its size.
+ * The operand of a simple node is prepared once when the filter is
+ * compiled instead of at each evaluation.
+ */
+struct ctkLDAPExpr::Instruction
+{
+  Instruction()
+    : op(0), size(1), wildcard(false), matchAll(false), isInteger(false), integer(0)
+  {
+  }
+
+  //! operator of the node
+  int op;
+  //! number of instructions of the sub-expression, this one included
+  int size;
+  //! attribute name, as written and lower case
+  ctkCaseInsensitiveString name;
+  ctkCaseInsensitiveString lowerName;
+  //! attribute value, with WILDCARD characters
+  QString value;
+  //! value as compared by APPROX
+  QString approxValue;
+  //! the value contains a WILDCARD
+  bool wildcard;
+  //! the value is a single WILDCARD
+  bool matchAll;
+  //! the value is the decimal string of integer
+  bool isInteger;
+  qlonglong integer;
+};
+
 /**
 \brief LDAP Expression Data
 \date 19 May 2010
@@ -111,7 +148,7 @@ public:
   ctkLDAPExprData( const ctkLDAPExprData& other )
     : QSharedData(other), m_operator(other.m_operator),
     m_args(other.m_args), m_attrName(other.m_attrName),
-    m_attrValue(other.m_attrValue)
+    m_attrValue(other.m_attrValue), m_program(other.m_program)
   {
   }
 
@@ -123,8 +160,27 @@ public:
   QString m_attrName;
   //!
   QString m_attrValue;
+  //! compiled form of the expression, only for a parsed filter
+  QVector<ctkLDAPExpr::Instruction> m_program;
 };
 
+/**
+ * Filters parsed by the ctkLDAPExpr(const QString&) constructor, most of
+ * the filters are used many times, e.g. by the service lookups.
+ */
+struct ctkLDAPExprCache
+{
+  ctkLDAPExprCache()
+  {
+    exprs.setMaxCost(256);
+  }
+
+  QMutex mutex;
+  QCache<QString, ctkLDAPExpr> exprs;
+};
+
+Q_GLOBAL_STATIC(ctkLDAPExprCache, ldapExprCache)
+
 //----------------------------------------------------------------------------
 ctkLDAPExpr::ctkLDAPExpr()
 {
@@ -134,6 +190,16 @@ ctkLDAPExpr::ctkLDAPExpr()
 //----------------------------------------------------------------------------
 ctkLDAPExpr::ctkLDAPExpr( const QString &filter )
 {
+  ctkLDAPExprCache* cache = ldapExprCache();
+  {
+    QMutexLocker lock(&cache->mutex);
+    if (ctkLDAPExpr* cached = cache->exprs.object(filter))
+    {
+      d = cached->d;
+      return;
+    }
+  }
+
   ParseState ps(filter);
 
   ctkLDAPExpr expr;
@@ -151,7 +217,13 @@ ctkLDAPExpr::ctkLDAPExpr( const QString &filter )
     ps.error(GARBAGE + " '" + ps.rest() + "'");
   }
 
+  QVector<Instruction> program;
+  compile(expr, program);
+  expr.d->m_program = program;
   d = expr.d;
+
+  QMutexLocker lock(&cache->mutex);
+  cache->exprs.insert(filter, new ctkLDAPExpr(*this));
 }
 
 //----------------------------------------------------------------------------
@@ -189,7 +261,7 @@ bool ctkLDAPExpr::getMatchedObjectClasses(QSet<QString>& objClasses) const
 {
   if (d->m_operator == EQ)
   {
-    if (d->m_attrName.compare(ctkPluginConstants::OBJECTCLASS, Qt::CaseInsensitive) &&
+    if (d->m_attrName.compare(ctkPluginConstants::OBJECTCLASS, Qt::CaseInsensitive) == 0 &&
       d->m_attrValue.indexOf(WILDCARD) < 0) 
     {
       objClasses.insert( d->m_attrValue );
@@ -240,6 +312,55 @@ bool ctkLDAPExpr::getMatchedObjectClasses(QSet<QString>& objClasses) const
   return false;
 }
 
+//----------------------------------------------------------------------------
+bool ctkLDAPExpr::getMatchedValues(const QString& key, QStringList& values) const
+{
+  if (d->m_operator == EQ)
+  {
+    if (d->m_attrName.compare(key, Qt::CaseInsensitive) == 0)
+    {
+      values.append(d->m_attrValue);
+      return true;
+    }
+    return false;
+  }
+  else if (d->m_operator == AND)
+  {
+    // all the operands must be true, the values required by one of them
+    // are enough
+    for (int i = 0; i < d->m_args.size(); i++)
+    {
+      QStringList r;
+      if (d->m_args[i].getMatchedValues(key, r))
+      {
+        values += r;
+        return true;
+      }
+    }
+    return false;
+  }
+  else if (d->m_operator == OR)
+  {
+    QStringList r;
+    for (int i = 0; i < d->m_args.size(); i++)
+    {
+      if (!d->m_args[i].getMatchedValues(key, r))
+      {
+        return false;
+      }
+    }
+    values += r;
+    return true;
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+QChar ctkLDAPExpr::wildcard()
+{
+  return WILDCARD;
+}
+
 //----------------------------------------------------------------------------
 bool ctkLDAPExpr::isSimple( 
   const QStringList& keywords,
@@ -280,8 +401,91 @@ bool ctkLDAPExpr::query( const QString &filter, const ctkDictionary &pd )
   return ctkLDAPExpr(filter).evaluate(pd, false);
 }
 
+//----------------------------------------------------------------------------
+void ctkLDAPExpr::setCacheCapacity(int capacity)
+{
+  ctkLDAPExprCache* cache = ldapExprCache();
+  QMutexLocker lock(&cache->mutex);
+  cache->exprs.setMaxCost(qMax(0, capacity));
+}
+
+//----------------------------------------------------------------------------
+int ctkLDAPExpr::cacheCapacity()
+{
+  ctkLDAPExprCache* cache = ldapExprCache();
+  QMutexLocker lock(&cache->mutex);
+  return cache->exprs.maxCost();
+}
+
 //----------------------------------------------------------------------------
 bool ctkLDAPExpr::evaluate( const ctkDictionary &p, bool matchCase ) const
+{
+  if (d->m_program.isEmpty())
+  {
+    return evaluateTree(p, matchCase);
+  }
+  return evaluate(d->m_program.constData(), 0, p, matchCase);
+}
+
+//----------------------------------------------------------------------------
+bool ctkLDAPExpr::evaluate( const Instruction *program, int index,
+                            const ctkDictionary &p, bool matchCase ) const
+{
+  const Instruction& instruction = program[index];
+  int end = index + instruction.size;
+  switch (instruction.op) {
+  case AND:
+    for (int i = index + 1; i < end; i += program[i].size) {
+      if (!evaluate(program, i, p, matchCase))
+        return false;
+    }
+    return true;
+  case OR:
+    for (int i = index + 1; i < end; i += program[i].size) {
+      if (evaluate(program, i, p, matchCase))
+        return true;
+    }
+    return false;
+  case NOT:
+    return !evaluate(program, index + 1, p, matchCase);
+  default:
+    {
+    ctkDictionary::const_iterator it =
+      p.constFind(matchCase ? instruction.name : instruction.lowerName);
+    return it != p.constEnd() && compare(it.value(), instruction);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkLDAPExpr::compile( const ctkLDAPExpr &expr, QVector<Instruction> &program )
+{
+  // the instructions are referred to by index, program grows below
+  int index = program.size();
+  program.append(Instruction());
+  program[index].op = expr.d->m_operator;
+  if ((expr.d->m_operator & SIMPLE) != 0) {
+    Instruction& instruction = program[index];
+    instruction.name = expr.d->m_attrName;
+    instruction.lowerName = expr.d->m_attrName.toLower();
+    instruction.value = expr.d->m_attrValue;
+    instruction.wildcard = instruction.value.indexOf(WILDCARD) >= 0;
+    instruction.matchAll = instruction.value == WILDCARD_QString;
+    if (instruction.op == APPROX)
+      instruction.approxValue = fixupString(instruction.value);
+    bool ok = false;
+    instruction.integer = instruction.value.toLongLong(&ok);
+    instruction.isInteger = ok && QString::number(instruction.integer) == instruction.value;
+  } else {
+    for (int i = 0; i < expr.d->m_args.size(); i++) {
+      compile(expr.d->m_args[i], program);
+    }
+  }
+  program[index].size = program.size() - index;
+}
+
+//----------------------------------------------------------------------------
+bool ctkLDAPExpr::evaluateTree( const ctkDictionary &p, bool matchCase ) const
 {
   if ((d->m_operator & SIMPLE) != 0) {
     return compare(p[ matchCase ? d->m_attrName : d->m_attrName.toLower() ],
@@ -290,24 +494,57 @@ bool ctkLDAPExpr::evaluate( const ctkDictionary &p, bool matchCase ) const
     switch (d->m_operator) {
     case AND:
       for (int i = 0; i < d->m_args.length( ); i++) {
-        if (!d->m_args[i].evaluate(p, matchCase))
+        if (!d->m_args[i].evaluateTree(p, matchCase))
           return false;
       }
       return true;
     case OR:
       for (int i = 0; i < d->m_args.length( ); i++) {
-        if (d->m_args[i].evaluate(p, matchCase))
+        if (d->m_args[i].evaluateTree(p, matchCase))
           return true;
       }
       return false;
     case NOT:
-      return !d->m_args[0].evaluate(p, matchCase);
+      return !d->m_args[0].evaluateTree(p, matchCase);
     default:
       return false; // Cannot happen
     }
   }
 }
 
+//----------------------------------------------------------------------------
+bool ctkLDAPExpr::compare( const QVariant &obj, const Instruction &instruction ) const
+{
+  if (obj.isNull())
+    return false;
+  if (instruction.op == EQ && instruction.matchAll)
+    return true;
+  switch (obj.type()) {
+  case QVariant::String:
+    {
+    const QString s = obj.toString();
+    switch (instruction.op) {
+    case EQ:
+      return instruction.wildcard ? patSubstr(s, instruction.value) : s == instruction.value;
+    case APPROX:
+      return fixupString(s) == instruction.approxValue;
+    default:
+      return compareString(s, instruction.op, instruction.value);
+    }
+    }
+  case QVariant::Int:
+  case QVariant::UInt:
+  case QVariant::LongLong:
+    // the decimal strings are equal if and only if the numbers are
+    if (instruction.op == EQ && instruction.isInteger)
+      return obj.toLongLong() == instruction.integer;
+    break;
+  default:
+    break;
+  }
+  return compare(obj, instruction.op, instruction.value);
+}
+
 //----------------------------------------------------------------------------
 bool ctkLDAPExpr::compare( const QVariant &obj, int op, const QString &s ) const
 {
@@ -40,7 +40,7 @@ class ctkLDAPExprData;
 \author Xavi Planes
 \ingroup ctkPluginFramework
 */
-class ctkLDAPExpr {
+class CTK_PLUGINFW_EXPORT ctkLDAPExpr {
 
 public:
 
@@ -84,6 +84,22 @@ public:
    */
   bool getMatchedObjectClasses(QSet<QString>& objClasses) const;
 
+  /**
+   * Get the values of the attribute <code>key</code> one of which must be
+   * matched for this LDAP expression to be true. The values may contain
+   * WILDCARD characters, see wildcard(). This will not work with NOT
+   * expressions and other comparisons than equality.
+   *
+   * \param key The attribute name, matched case-insensitively.
+   * \param values The values will be added to values.
+   * \return If the values cannot be determined, <code>false</code> is returned,
+   *         <code>true</code> otherwise.
+   */
+  bool getMatchedValues(const QString& key, QStringList& values) const;
+
+  //! The character standing for <code>*</code> in the values of getMatchedValues()
+  static QChar wildcard();
+
   /**
    * Checks if this LDAP expression is "simple". The definition of
    * a simple filter is:
@@ -126,6 +142,19 @@ public:
   //! Evaluate this LDAP filter.
   bool evaluate(const ctkDictionary &p, bool matchCase) const;
 
+  /**
+   * Evaluate this LDAP filter by walking its expression tree, without the
+   * compiled form used by evaluate(). Both always give the same result.
+   */
+  bool evaluateTree(const ctkDictionary &p, bool matchCase) const;
+
+  /**
+   * Number of parsed filters kept in the cache shared by the ctkLDAPExpr(const QString&)
+   * constructor, 256 by default. A capacity of 0 disables the cache.
+   */
+  static void setCacheCapacity(int capacity);
+  static int cacheCapacity();
+
   //! 
   const QString toString() const;
 
@@ -133,6 +162,7 @@ public:
 private:
 
   class ParseState;
+  struct Instruction;
 
   //!
   ctkLDAPExpr(int op, const QList<ctkLDAPExpr> &args);
@@ -146,6 +176,16 @@ private:
   //!
   static ctkLDAPExpr parseSimple(ParseState &ps);
 
+  //! Flatten the expression tree into program, in prefix order
+  static void compile(const ctkLDAPExpr &expr, QVector<Instruction> &program);
+
+  //! Evaluate the sub-expression of the program starting at index
+  bool evaluate(const Instruction *program, int index,
+                const ctkDictionary &p, bool matchCase) const;
+
+  //! Same as compare(obj, op, s) with the operand prepared by compile()
+  bool compare(const QVariant &obj, const Instruction &instruction) const;
+
   //!
   bool compare(const QVariant &obj, int op, const QString &s) const;
 
@@ -174,6 +214,8 @@ private:
   //! Shared pointer
   QSharedDataPointer<ctkLDAPExprData> d;
 
+  friend class ctkLDAPExprData;
+
 };
 
 
@@ -375,7 +375,10 @@ QStringList ctkPlugin::findResources(const QString& path,
 QByteArray ctkPlugin::getResource(const QString& path) const
 {
   Q_D(const ctkPlugin);
-  return d->archive->getPluginResource(path);
+  // a resource from a resource archive references the mapped file,
+  // which does not outlive the framework storage
+  QByteArray resource = d->archive->getPluginResource(path);
+  return resource.isNull() ? resource : QByteArray(resource.constData(), resource.size());
 }
 
 //----------------------------------------------------------------------------
@@ -31,6 +31,11 @@ const QString ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN = "org.commontk.plugin
 const QString ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT = "onFirstInit";
 const QString ctkPluginConstants::FRAMEWORK_PLUGIN_LOAD_HINTS = "org.commontk.pluginfw.loadhints";
 const QString ctkPluginConstants::FRAMEWORK_PRELOAD_LIBRARIES = "org.commontk.pluginfw.preloadlibs";
+const QString ctkPluginConstants::FRAMEWORK_PLUGIN_LAZY_RESOURCES = "org.commontk.pluginfw.lazyresources";
+const QString ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES = "org.commontk.pluginfw.storage.resources";
+const QString ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_DATABASE = "database";
+const QString ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_ARCHIVE = "archive";
+const QString ctkPluginConstants::FRAMEWORK_SERVICE_INDEXED_KEYS = "org.commontk.pluginfw.services.indexedkeys";
 
 const QString ctkPluginConstants::PLUGIN_SYMBOLICNAME = "Plugin-SymbolicName";
 const QString ctkPluginConstants::PLUGIN_COPYRIGHT = "Plugin-Copyright";
@@ -122,6 +122,49 @@ struct CTK_PLUGINFW_EXPORT ctkPluginConstants {
    */
   static const QString FRAMEWORK_PRELOAD_LIBRARIES; // = "org.commontk.pluginfw.preloadlibs"
 
+  /**
+   * Specifies if the Qt resources of a plug-in are cached in the framework
+   * storage when the plug-in is installed (the default) or when one of
+   * them is first accessed. The value of this property must be of type
+   * bool. The plug-in manifest is always cached when the plug-in is installed.
+   *
+   * Setting this property to <code>true</code> reduces the initial framework
+   * start-up time if a lot of plug-ins with large resources are installed.
+   */
+  static const QString FRAMEWORK_PLUGIN_LAZY_RESOURCES; // = "org.commontk.pluginfw.lazyresources"
+
+  /**
+   * Specifies where the Qt resources of the plug-ins are cached in the
+   * framework storage. The value of this property must be of type QString,
+   * either FRAMEWORK_STORAGE_RESOURCES_DATABASE (the default) or
+   * FRAMEWORK_STORAGE_RESOURCES_ARCHIVE.
+   */
+  static const QString FRAMEWORK_STORAGE_RESOURCES; // = "org.commontk.pluginfw.storage.resources"
+
+  /**
+   * Specifies that the plug-in resources are cached in the plug-in database.
+   */
+  static const QString FRAMEWORK_STORAGE_RESOURCES_DATABASE; // = "database"
+
+  /**
+   * Specifies that the plug-in resources are cached in an indexed archive
+   * file per plug-in, which is memory-mapped when a resource is first
+   * accessed. The plug-in database then only holds the plug-in meta-data.
+   */
+  static const QString FRAMEWORK_STORAGE_RESOURCES_ARCHIVE; // = "archive"
+
+  /**
+   * Specifies the service properties the framework keeps an index of, in
+   * addition to SERVICE_PID. The value of this property must be either of
+   * type QString or QStringList, it defaults to the <code>event.topics</code>
+   * property of the event handlers.
+   *
+   * Service lookups whose filter requires one of the values of an indexed
+   * property only evaluate the filter for the services having that value,
+   * instead of all the services registered under the requested class.
+   */
+  static const QString FRAMEWORK_SERVICE_INDEXED_KEYS; // = "org.commontk.pluginfw.services.indexedkeys"
+
   /**
    * Manifest header identifying the plugin's symbolic name.
    *
@@ -64,6 +64,11 @@ void ctkPluginFrameworkContext::initProperties()
 {
   props[ctkPluginConstants::FRAMEWORK_VERSION] = "0.9";
   props[ctkPluginConstants::FRAMEWORK_VENDOR] = "CommonTK";
+  if (!props.contains(ctkPluginConstants::FRAMEWORK_SERVICE_INDEXED_KEYS))
+  {
+    // the topics of the event handlers, looked up for each event
+    props[ctkPluginConstants::FRAMEWORK_SERVICE_INDEXED_KEYS] = QStringList("event.topics");
+  }
 }
 
 //----------------------------------------------------------------------------
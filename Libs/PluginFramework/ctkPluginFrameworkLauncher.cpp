@@ -23,12 +23,21 @@
 #include <QDirIterator>
 #include <QFileInfo>
 #include <QDebug>
+#include <QFile>
+#include <QPluginLoader>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QTime>
 
 #include "ctkPluginFrameworkLauncher.h"
 #include "ctkPluginFrameworkFactory.h"
 #include "ctkPluginFramework.h"
 #include "ctkPluginContext.h"
 #include "ctkPluginException.h"
+#include "ctkPluginFrameworkDebug_p.h"
+#include "ctkPluginFrameworkUtil_p.h"
+#include "ctkPluginManifest_p.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -61,6 +70,67 @@ public:
   ctkProperties fwProps;
 
   ctkPluginFrameworkFactory* fwFactory;
+
+  QHash<QString, ctkPluginFrameworkLauncher::PluginTiming> timings;
+};
+
+//----------------------------------------------------------------------------
+// Loads a plugin library and reads the plugins it requires from its
+// manifest. The library stays loaded until the loader is deleted, so
+// that installing and starting the plugin does not load it again.
+class ctkPluginLibraryLoader : public QRunnable
+{
+public:
+
+  ctkPluginLibraryLoader(const QString& symbolicName, const QString& pluginPath,
+                         QLibrary::LoadHints loadHints)
+    : symbolicName(symbolicName), pluginPath(pluginPath), elapsed(0)
+  {
+    setAutoDelete(false);
+    pluginLoader.setLoadHints(loadHints);
+    pluginLoader.setFileName(pluginPath);
+  }
+
+  ~ctkPluginLibraryLoader()
+  {
+    if (pluginLoader.isLoaded()) pluginLoader.unload();
+  }
+
+  void run()
+  {
+    QTime timer;
+    timer.start();
+    if (pluginLoader.load())
+    {
+      QFile manifestResource(QString(":/") + symbolicName + "/META-INF/MANIFEST.MF");
+      if (manifestResource.open(QIODevice::ReadOnly))
+      {
+        ctkPluginManifest manifest(manifestResource.readAll());
+        try
+        {
+          QList<QMap<QString, QStringList> > requireList =
+              ctkPluginFrameworkUtil::parseEntries(ctkPluginConstants::REQUIRE_PLUGIN,
+                                                   manifest.getAttribute(ctkPluginConstants::REQUIRE_PLUGIN),
+                                                   true, true, false);
+          foreach (const QMap<QString, QStringList>& e, requireList)
+          {
+            requiredPlugins << e.value("$key").front();
+          }
+        }
+        catch (const ctkInvalidArgumentException&)
+        {
+          // reported when the plugin is installed
+        }
+      }
+    }
+    elapsed = timer.elapsed();
+  }
+
+  const QString symbolicName;
+  const QString pluginPath;
+  QPluginLoader pluginLoader;
+  QStringList requiredPlugins;
+  int elapsed;
 };
 
 const QScopedPointer<ctkPluginFrameworkLauncherPrivate> ctkPluginFrameworkLauncher::d(
@@ -162,6 +232,125 @@ bool ctkPluginFrameworkLauncher::start(const QString& symbolicName, ctkPlugin::S
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool ctkPluginFrameworkLauncher::startPlugins(const QStringList& symbolicNames,
+                                              ctkPlugin::StartOptions options,
+                                              ctkPluginContext* context)
+{
+  if (!start(QString(), options, context)) return false;
+
+  ctkPluginContext* pc = context ? context : getPluginContext();
+  bool result = true;
+  d->timings.clear();
+
+  // load the plugin libraries and read their manifests in parallel
+  QLibrary::LoadHints loadHints =
+      d->fwProps.value(ctkPluginConstants::FRAMEWORK_PLUGIN_LOAD_HINTS).value<QLibrary::LoadHints>();
+  QList<ctkPluginLibraryLoader*> loaders;
+  QThreadPool threadPool;
+  foreach(QString symbolicName, symbolicNames)
+  {
+    QString pluginPath = getPluginPath(symbolicName);
+    if (pluginPath.isEmpty())
+    {
+      qWarning() << "Plug-in" << symbolicName << "not found";
+      result = false;
+      continue;
+    }
+    loaders << new ctkPluginLibraryLoader(symbolicName, pluginPath, loadHints);
+    threadPool.start(loaders.back());
+  }
+  threadPool.waitForDone();
+
+  // install the plugins, which does not load their libraries again
+  QHash<QString, QSharedPointer<ctkPlugin> > plugins;
+  QTime timer;
+  foreach(ctkPluginLibraryLoader* loader, loaders)
+  {
+    PluginTiming& timing = d->timings[loader->symbolicName];
+    timing.load = loader->elapsed;
+    timer.start();
+    try
+    {
+      plugins.insert(loader->symbolicName, pc->installPlugin(QUrl::fromLocalFile(loader->pluginPath)));
+    }
+    catch (const ctkPluginException& exc)
+    {
+      qWarning() << "Failed to install plugin:" << exc;
+      result = false;
+    }
+    timing.install = timer.elapsed();
+    timing.start = 0;
+  }
+
+  // start the plugins level by level, each level only requiring
+  // plugins of the previous levels
+  QList<ctkPluginLibraryLoader*> pending = loaders;
+  QSet<QString> done;
+  while (!pending.isEmpty())
+  {
+    QList<ctkPluginLibraryLoader*> level;
+    foreach(ctkPluginLibraryLoader* loader, pending)
+    {
+      bool ready = true;
+      foreach(QString requiredPlugin, loader->requiredPlugins)
+      {
+        if (d->timings.contains(requiredPlugin) && !done.contains(requiredPlugin))
+        {
+          ready = false;
+          break;
+        }
+      }
+      if (ready) level << loader;
+    }
+    if (level.isEmpty())
+    {
+      // dependency cycle
+      level = pending;
+    }
+
+    foreach(ctkPluginLibraryLoader* loader, level)
+    {
+      pending.removeOne(loader);
+      done << loader->symbolicName;
+
+      QSharedPointer<ctkPlugin> plugin = plugins.value(loader->symbolicName);
+      if (!plugin) continue;
+      timer.start();
+      try
+      {
+        plugin->start(options);
+      }
+      catch (const ctkPluginException& exc)
+      {
+        qWarning() << "Failed to start plugin:" << exc;
+        result = false;
+      }
+      d->timings[loader->symbolicName].start = timer.elapsed();
+    }
+  }
+  qDeleteAll(loaders);
+
+  if (d->fwProps.value(ctkPluginFrameworkDebug::FRAMEWORK_PROP).toBool())
+  {
+    foreach(QString symbolicName, symbolicNames)
+    {
+      if (!d->timings.contains(symbolicName)) continue;
+      const PluginTiming& timing = d->timings[symbolicName];
+      qDebug() << "Plug-in" << symbolicName << "loaded in" << timing.load << "ms, installed in"
+               << timing.install << "ms, started in" << timing.start << "ms";
+    }
+  }
+
+  return result;
+}
+
+//----------------------------------------------------------------------------
+QHash<QString, ctkPluginFrameworkLauncher::PluginTiming> ctkPluginFrameworkLauncher::getPluginTimings()
+{
+  return d->timings;
+}
+
 //----------------------------------------------------------------------------
 bool ctkPluginFrameworkLauncher::stop(const QString& symbolicName,
                                       ctkPlugin::StopOptions options, ctkPluginContext* context)
@@ -22,7 +22,9 @@
 #ifndef CTKPLUGINFRAMEWORKLAUNCHER_H
 #define CTKPLUGINFRAMEWORKLAUNCHER_H
 
+#include <QHash>
 #include <QString>
+#include <QStringList>
 #include <QScopedPointer>
 
 #include <ctkPluginFrameworkExport.h>
@@ -44,6 +46,20 @@ class CTK_PLUGINFW_EXPORT ctkPluginFrameworkLauncher
 {
 public:
 
+  /**
+   * The time in milliseconds spent on the start-up of a plugin by
+   * #startPlugins.
+   */
+  struct PluginTiming
+  {
+    /** Loading the plugin library and reading its manifest */
+    int load;
+    /** Installing the plugin */
+    int install;
+    /** Resolving and starting the plugin */
+    int start;
+  };
+
   /**
    * Specify the set of framework properties to be used when
    * initializing the Plugin Framework.
@@ -106,6 +122,43 @@ public:
                     ctkPlugin::StartOptions options = ctkPlugin::START_ACTIVATION_POLICY,
                     ctkPluginContext* context = 0);
 
+  /**
+   * This method instantiates and starts the Plugin Framework like #start and
+   * then installs and starts the plugins with the given symbolic names.
+   *
+   * <p>
+   * The plugin libraries are loaded and their manifests are read in parallel.
+   * The plugins are then installed, and started in the order given by their
+   * <code>Require-Plugin</code> manifest headers, so that the plugins a
+   * plugin requires are started before it. Plugins depending on each other
+   * in a cycle are started in the given order.
+   *
+   * <p>
+   * Setting the ctkPluginConstants::FRAMEWORK_PLUGIN_LAZY_RESOURCES
+   * framework property further reduces the time spent installing the plugins.
+   *
+   * \param symbolicNames The symbolic names of the plugins to start.
+   * \param options The options used to start the plugins.
+   * \param context The plugin context to use for installing the plugins.
+   * \return <code>true</code> if all the plugins were found and successfully
+   *         installed and started, <code>false</code> otherwise.
+   *
+   * \see getPluginTimings()
+   */
+  static bool startPlugins(const QStringList& symbolicNames,
+                           ctkPlugin::StartOptions options = ctkPlugin::START_ACTIVATION_POLICY,
+                           ctkPluginContext* context = 0);
+
+  /**
+   * Get the time spent on the start-up of each plugin by the last call
+   * to #startPlugins. The timings are also printed if the
+   * <code>org.commontk.pluginfw.debug.pluginfw</code> framework
+   * property is set.
+   *
+   * \return The timings, indexed by plugin symbolic name.
+   */
+  static QHash<QString, PluginTiming> getPluginTimings();
+
   /**
    * This method either stops the plug-in with the given <code>symbolicName</code> using
    * the supplied stop options <code>options</code>
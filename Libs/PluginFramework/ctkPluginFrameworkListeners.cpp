@@ -45,6 +45,7 @@ ctkPluginFrameworkListeners::ctkPluginFrameworkListeners(ctkPluginFrameworkConte
   for (int i = 0; i < hashedServiceKeys.size(); ++i)
   {
     cache.push_back(QHash<QString, QList<ctkServiceSlotEntry> >());
+    conjunctionCache.push_back(QHash<QString, QList<ctkServiceSlotEntry> >());
   }
 }
 
@@ -130,11 +131,21 @@ QSet<ctkServiceSlotEntry> ctkPluginFrameworkListeners::getMatchingServiceSlots(
       << "listeners with complicated filters";
   }
 
-  // Check the cache
+  // Check the cache, and evaluate the filters of the conjunction
+  // cache entries only for the service's values of the hashed keys
+  ctkDictionary props;
+  if (!conjunctionCache[OBJECTCLASS_IX].isEmpty() || !conjunctionCache[SERVICE_ID_IX].isEmpty() ||
+      !conjunctionCache[SERVICE_PID_IX].isEmpty())
+  {
+    props = sr.d_func()->getProperties();
+  }
+  QSet<ctkServiceSlotEntry> evaluated;
+
   QStringList c = sr.d_func()->getProperty(ctkPluginConstants::OBJECTCLASS, lockProps).toStringList();
   foreach (QString objClass, c)
   {
     addToSet(set, OBJECTCLASS_IX, objClass);
+    addMatchingToSet(set, evaluated, OBJECTCLASS_IX, objClass, props);
   }
 
   bool ok = false;
@@ -142,12 +153,14 @@ QSet<ctkServiceSlotEntry> ctkPluginFrameworkListeners::getMatchingServiceSlots(
   if (ok)
   {
     addToSet(set, SERVICE_ID_IX, QString::number(service_id));
+    addMatchingToSet(set, evaluated, SERVICE_ID_IX, QString::number(service_id), props);
   }
 
   QStringList service_pids = sr.d_func()->getProperty(ctkPluginConstants::SERVICE_PID, lockProps).toStringList();
   foreach (QString service_pid, service_pids)
   {
     addToSet(set, SERVICE_PID_IX, service_pid);
+    addMatchingToSet(set, evaluated, SERVICE_PID_IX, service_pid, props);
   }
 
   return set;
@@ -240,21 +253,11 @@ void ctkPluginFrameworkListeners::removeFromCache(const ctkServiceSlotEntry& sse
 {
   if (!sse.getLocalCache().isEmpty())
   {
+    // the entry is either in the cache or in the conjunction cache
     for (int i = 0; i < hashedServiceKeys.size(); ++i)
     {
-      QHash<QString, QList<ctkServiceSlotEntry> >& keymap = cache[i];
-      QStringList& l = sse.getLocalCache()[i];
-      QStringListIterator it(l);
-      while (it.hasNext())
-      {
-        QString value = it.next();
-        QList<ctkServiceSlotEntry>& sses = keymap[value];
-        sses.removeAll(sse);
-        if (sses.isEmpty())
-        {
-          keymap.remove(value);
-        }
-      }
+      removeFromCache(cache[i], sse.getLocalCache()[i], sse);
+      removeFromCache(conjunctionCache[i], sse.getLocalCache()[i], sse);
     }
   }
   else
@@ -263,6 +266,25 @@ void ctkPluginFrameworkListeners::removeFromCache(const ctkServiceSlotEntry& sse
   }
 }
 
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkListeners::removeFromCache(QHash<QString, QList<ctkServiceSlotEntry> >& keymap,
+                                                  const QStringList& values, const ctkServiceSlotEntry& sse)
+{
+  QStringListIterator it(values);
+  while (it.hasNext())
+  {
+    QHash<QString, QList<ctkServiceSlotEntry> >::iterator sses = keymap.find(it.next());
+    if (sses != keymap.end())
+    {
+      sses.value().removeAll(sse);
+      if (sses.value().isEmpty())
+      {
+        keymap.erase(sses);
+      }
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 void ctkPluginFrameworkListeners::checkSimple(const ctkServiceSlotEntry& sse)
 {
@@ -287,7 +309,7 @@ void ctkPluginFrameworkListeners::checkSimple(const ctkServiceSlotEntry& sse)
         }
       }
     }
-    else
+    else if (!checkConjunction(sse))
     {
       if (pluginFw->debug.ldap)
       {
@@ -298,6 +320,47 @@ void ctkPluginFrameworkListeners::checkSimple(const ctkServiceSlotEntry& sse)
   }
 }
 
+//----------------------------------------------------------------------------
+bool ctkPluginFrameworkListeners::checkConjunction(const ctkServiceSlotEntry& sse)
+{
+  // a service id matches a single service, a pid usually does too
+  static const int selectivity[] = { SERVICE_ID_IX, SERVICE_PID_IX, OBJECTCLASS_IX };
+
+  for (int i = 0; i < 3; ++i)
+  {
+    const int cache_ix = selectivity[i];
+    QStringList values;
+    if (!sse.getLDAPExpr().getMatchedValues(hashedServiceKeys[cache_ix], values)) continue;
+
+    bool hasWildcard = false;
+    foreach (QString value, values)
+    {
+      if (value.contains(ctkLDAPExpr::wildcard()))
+      {
+        hasWildcard = true;
+        break;
+      }
+    }
+    if (hasWildcard) continue;
+
+    values.removeDuplicates();
+    ctkLDAPExpr::LocalCache local_cache(hashedServiceKeys.size());
+    local_cache[cache_ix] = values;
+    sse.getLocalCache() = local_cache;
+    foreach (QString value, values)
+    {
+      conjunctionCache[cache_ix][value].push_back(sse);
+    }
+
+    if (pluginFw->debug.ldap)
+    {
+      qDebug() << "Cached filter" << sse.getFilter() << "by" << hashedServiceKeys[cache_ix];
+    }
+    return true;
+  }
+  return false;
+}
+
 //----------------------------------------------------------------------------
 void ctkPluginFrameworkListeners::addToSet(QSet<ctkServiceSlotEntry>& set,
                                            int cache_ix, const QString& val)
@@ -322,3 +385,30 @@ void ctkPluginFrameworkListeners::addToSet(QSet<ctkServiceSlotEntry>& set,
     }
   }
 }
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkListeners::addMatchingToSet(QSet<ctkServiceSlotEntry>& set,
+                                                   QSet<ctkServiceSlotEntry>& evaluated,
+                                                   int cache_ix, const QString& val,
+                                                   const ctkDictionary& props)
+{
+  QHash<QString, QList<ctkServiceSlotEntry> >::const_iterator l = conjunctionCache[cache_ix].find(val);
+  if (l == conjunctionCache[cache_ix].end()) return;
+
+  int n = 0;
+  foreach (ctkServiceSlotEntry entry, l.value())
+  {
+    if (evaluated.contains(entry)) continue;
+    evaluated.insert(entry);
+    if (entry.getLDAPExpr().evaluate(props, false))
+    {
+      set.insert(entry);
+      ++n;
+    }
+  }
+
+  if (pluginFw->debug.ldap)
+  {
+    qDebug() << hashedServiceKeys[cache_ix] << "conjunctions matched" << n << "out of" << l.value().size();
+  }
+}
@@ -124,6 +124,11 @@ private:
   // Service listeners with "simple" filters are cached
   QList<QHash<QString, QList<ctkServiceSlotEntry> > > cache;
 
+  // Service listeners with filters requiring one of the values of a
+  // hashed key are cached by these values, and their filters are only
+  // evaluated for the services having one of them
+  QList<QHash<QString, QList<ctkServiceSlotEntry> > > conjunctionCache;
+
   QSet<ctkServiceSlotEntry> serviceSet;
 
   ctkPluginFrameworkContext* pluginFw;
@@ -140,11 +145,32 @@ private:
    */
   void checkSimple(const ctkServiceSlotEntry& sse);
 
+  /**
+   * Checks if the specified service slot's filter requires one of
+   * the values of a hashed key, and caches it by the values of the
+   * most selective such key.
+   */
+  bool checkConjunction(const ctkServiceSlotEntry& sse);
+
+  /**
+   * Remove the service slot from the lists of the cache \a keymap
+   * for the given values.
+   */
+  void removeFromCache(QHash<QString, QList<ctkServiceSlotEntry> >& keymap,
+                       const QStringList& values, const ctkServiceSlotEntry& sse);
+
   /**
    * Add all members of the specified list to the specified set.
    */
   void addToSet(QSet<ctkServiceSlotEntry>& set, int cache_ix, const QString& val);
 
+  /**
+   * Add the members of the specified conjunction cache list whose
+   * filter matches the service properties to the specified set.
+   */
+  void addMatchingToSet(QSet<ctkServiceSlotEntry>& set, QSet<ctkServiceSlotEntry>& evaluated,
+                        int cache_ix, const QString& val, const ctkDictionary& props);
+
   /**
    * The unsynchronized version of removeServiceSlot().
    */
@@ -0,0 +1,229 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "ctkPluginResourceArchive_p.h"
+
+#include <QSet>
+#include <QVector>
+
+#include <cstring>
+
+static const char ARCHIVE_MAGIC[8] = {'C', 'T', 'K', 'R', 'E', 'S', '0', '1'};
+
+//----------------------------------------------------------------------------
+struct ctkPluginResourceArchive::Header
+{
+  char magic[8];
+  quint32 count;
+  quint32 reserved;
+};
+
+//----------------------------------------------------------------------------
+struct ctkPluginResourceArchive::Entry
+{
+  quint32 pathOffset;
+  quint32 pathSize;
+  quint32 dataOffset;
+  quint32 dataSize;
+};
+
+//----------------------------------------------------------------------------
+static int comparePaths(const QByteArray& p1, const QByteArray& p2)
+{
+  int result = std::memcmp(p1.constData(), p2.constData(), qMin(p1.size(), p2.size()));
+  return result != 0 ? result : p1.size() - p2.size();
+}
+
+//----------------------------------------------------------------------------
+ctkPluginResourceArchive::ctkPluginResourceArchive(const QString& fileName)
+  : file(fileName), data(0), size(0), entries(0), count(0)
+{
+  if (!file.open(QIODevice::ReadOnly)) return;
+
+  size = file.size();
+  if (size < static_cast<qint64>(sizeof(Header))) return;
+
+  const uchar* mapped = file.map(0, size);
+  if (mapped == 0) return;
+
+  // check the whole index once, so that lookups do not need to
+  const Header* header = reinterpret_cast<const Header*>(mapped);
+  const qint64 indexEnd = sizeof(Header) + static_cast<qint64>(header->count) * sizeof(Entry);
+  if (std::memcmp(header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || indexEnd > size)
+  {
+    file.unmap(const_cast<uchar*>(mapped));
+    return;
+  }
+
+  const Entry* index = reinterpret_cast<const Entry*>(mapped + sizeof(Header));
+  for (quint32 i = 0; i < header->count; ++i)
+  {
+    if (static_cast<qint64>(index[i].pathOffset) + index[i].pathSize > size ||
+        static_cast<qint64>(index[i].dataOffset) + index[i].dataSize > size)
+    {
+      file.unmap(const_cast<uchar*>(mapped));
+      return;
+    }
+  }
+
+  data = mapped;
+  entries = index;
+  count = header->count;
+}
+
+//----------------------------------------------------------------------------
+bool ctkPluginResourceArchive::isValid() const
+{
+  return data != 0;
+}
+
+//----------------------------------------------------------------------------
+QByteArray ctkPluginResourceArchive::entryPath(int index) const
+{
+  return QByteArray::fromRawData(reinterpret_cast<const char*>(data + entries[index].pathOffset),
+                                 entries[index].pathSize);
+}
+
+//----------------------------------------------------------------------------
+int ctkPluginResourceArchive::lowerBound(const QByteArray& path) const
+{
+  int first = 0;
+  int length = count;
+  while (length > 0)
+  {
+    int half = length / 2;
+    if (comparePaths(entryPath(first + half), path) < 0)
+    {
+      first += half + 1;
+      length -= half + 1;
+    }
+    else
+    {
+      length = half;
+    }
+  }
+  return first;
+}
+
+//----------------------------------------------------------------------------
+QByteArray ctkPluginResourceArchive::getResource(const QString& path) const
+{
+  if (!isValid()) return QByteArray();
+
+  const QByteArray utf8Path = path.toUtf8();
+  int index = lowerBound(utf8Path);
+  if (index == count || comparePaths(entryPath(index), utf8Path) != 0)
+  {
+    return QByteArray();
+  }
+
+  // an empty resource must not be mistaken for a missing one
+  if (entries[index].dataSize == 0) return QByteArray("");
+  return QByteArray::fromRawData(reinterpret_cast<const char*>(data + entries[index].dataOffset),
+                                 entries[index].dataSize);
+}
+
+//----------------------------------------------------------------------------
+QStringList ctkPluginResourceArchive::findResourcesPath(const QString& path) const
+{
+  if (!isValid()) return QStringList();
+
+  QString resourcePath = path.startsWith('/') ? path : QString("/") + path;
+  if (!resourcePath.endsWith('/'))
+    resourcePath += "/";
+  const QByteArray prefix = resourcePath.toUtf8();
+
+  QSet<QString> paths;
+  for (int index = lowerBound(prefix); index < count; ++index)
+  {
+    QByteArray currPath = entryPath(index);
+    if (!currPath.startsWith(prefix)) break;
+
+    QStringList components = QString::fromUtf8(currPath.constData() + prefix.size(),
+                                                currPath.size() - prefix.size())
+                             .split('/', QString::SkipEmptyParts);
+    if (components.size() == 1)
+    {
+      paths << components.front();
+    }
+    else if (components.size() == 2)
+    {
+      paths << components.front() + "/";
+    }
+  }
+
+  return paths.toList();
+}
+
+//----------------------------------------------------------------------------
+bool ctkPluginResourceArchive::write(const QString& fileName, const QMap<QByteArray, QByteArray>& resources)
+{
+  Header header;
+  std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+  header.count = resources.size();
+  header.reserved = 0;
+
+  // QMap orders the paths by their bytes, as the lookups expect
+  QVector<Entry> index;
+  index.reserve(resources.size());
+  quint32 offset = sizeof(Header) + resources.size() * sizeof(Entry);
+  for (QMap<QByteArray, QByteArray>::const_iterator it = resources.begin(); it != resources.end(); ++it)
+  {
+    Entry entry;
+    entry.pathOffset = offset;
+    entry.pathSize = it.key().size();
+    offset += entry.pathSize;
+    index << entry;
+  }
+  int i = 0;
+  for (QMap<QByteArray, QByteArray>::const_iterator it = resources.begin(); it != resources.end(); ++it, ++i)
+  {
+    index[i].dataOffset = offset;
+    index[i].dataSize = it.value().size();
+    offset += index[i].dataSize;
+  }
+
+  QFile tmpFile(fileName + ".tmp");
+  if (!tmpFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+  bool success = tmpFile.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header);
+  if (!index.isEmpty())
+  {
+    const qint64 indexSize = index.size() * sizeof(Entry);
+    success = success && tmpFile.write(reinterpret_cast<const char*>(index.constData()), indexSize) == indexSize;
+  }
+  for (QMap<QByteArray, QByteArray>::const_iterator it = resources.begin(); success && it != resources.end(); ++it)
+  {
+    success = tmpFile.write(it.key()) == it.key().size();
+  }
+  for (QMap<QByteArray, QByteArray>::const_iterator it = resources.begin(); success && it != resources.end(); ++it)
+  {
+    success = tmpFile.write(it.value()) == it.value().size();
+  }
+  tmpFile.close();
+
+  if (!success || (QFile::exists(fileName) && !QFile::remove(fileName)) || !tmpFile.rename(fileName))
+  {
+    tmpFile.remove();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,108 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CTKPLUGINRESOURCEARCHIVE_P_H
+#define CTKPLUGINRESOURCEARCHIVE_P_H
+
+#include "ctkPluginFrameworkExport.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QStringList>
+
+/**
+ * \ingroup PluginFramework
+ *
+ * A file holding the cached Qt resources of a plugin, indexed by their
+ * path and memory-mapped when opened.
+ *
+ * The file starts with a header and an index of the resources, sorted
+ * by the UTF-8 encoding of their paths, followed by the paths and the
+ * resource data. The integers are stored in host byte order, the file
+ * being a cache local to the framework storage.
+ */
+class CTK_PLUGINFW_EXPORT ctkPluginResourceArchive
+{
+
+public:
+
+  /**
+   * Opens and maps the archive file \a fileName. Check isValid() to
+   * know if the file exists and is a valid archive.
+   */
+  ctkPluginResourceArchive(const QString& fileName);
+
+  bool isValid() const;
+
+  /**
+   * Get the data of the resource with the given path, which must start
+   * with a '/'.
+   *
+   * The returned byte array references the mapped file and must not be
+   * used once this archive is deleted. ctkPlugin::getResource() returns
+   * a copy of it.
+   *
+   * @param path The path of the resource.
+   * @return The resource data, or a null byte array if there is no such
+   *         resource.
+   */
+  QByteArray getResource(const QString& path) const;
+
+  /**
+   * Get the resource entries under the given path, the sub-directories
+   * ending with a '/'.
+   *
+   * @param path A resource path.
+   * @return The resource entries.
+   */
+  QStringList findResourcesPath(const QString& path) const;
+
+  /**
+   * Writes an archive of the given resources, indexed by their UTF-8
+   * encoded path, to the file \a fileName, replacing an existing file.
+   *
+   * @return <code>true</code> on success, <code>false</code> otherwise.
+   */
+  static bool write(const QString& fileName, const QMap<QByteArray, QByteArray>& resources);
+
+private:
+
+  struct Header;
+  struct Entry;
+
+  /**
+   * Index of the first entry whose path is not less than \a path.
+   */
+  int lowerBound(const QByteArray& path) const;
+
+  QByteArray entryPath(int index) const;
+
+  QFile file;
+  const uchar* data;
+  qint64 size;
+  const Entry* entries;
+  int count;
+
+  Q_DISABLE_COPY(ctkPluginResourceArchive)
+};
+
+#endif // CTKPLUGINRESOURCEARCHIVE_P_H
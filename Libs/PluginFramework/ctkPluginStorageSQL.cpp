@@ -28,6 +28,7 @@
 #include "ctkPluginStorage_p.h"
 #include "ctkPluginFrameworkUtil_p.h"
 #include "ctkPluginFrameworkContext_p.h"
+#include "ctkPluginResourceArchive_p.h"
 #include "ctkServiceException.h"
 
 #include <QApplication>
@@ -37,6 +38,9 @@
 //database table names
 #define PLUGINS_TABLE "Plugins"
 #define PLUGIN_RESOURCES_TABLE "PluginResources"
+#define PLUGIN_RESOURCES_PENDING_TABLE "PluginResourcesPending"
+
+#define MANIFEST_RESOURCE_PATH "/META-INF/MANIFEST.MF"
 
 //----------------------------------------------------------------------------
 enum TBindIndexes
@@ -55,11 +59,22 @@ enum TBindIndexes
 ctkPluginStorageSQL::ctkPluginStorageSQL(ctkPluginFrameworkContext *framework)
   : m_isDatabaseOpen(false)
   , m_inTransaction(false)
+  , m_resourceArchivesEnabled(framework->props.value(ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES).toString()
+                              == ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_ARCHIVE)
+  , m_nextResourceArchive(0)
   , m_framework(framework)
   , m_nextFreeId(-1)
 {
   // See if we have a storage database
   m_databasePath = ctkPluginFrameworkUtil::getFileStorage(framework, "").absoluteFilePath("plugins.db");
+  if (m_resourceArchivesEnabled)
+  {
+    m_resourceArchivesDir = ctkPluginFrameworkUtil::getFileStorage(framework, "resources");
+  }
+  else
+  {
+    m_resourceArchivesDir = QDir(ctkPluginFrameworkUtil::getFrameworkDir(framework) + "/resources");
+  }
 
   this->open();
   restorePluginArchives();
@@ -171,12 +186,33 @@ void ctkPluginStorageSQL::open()
     }
   }
 
+  // The table of plug-ins with deferred resources was added later on,
+  // databases without it do not contain any such plug-in
+  if (!query.exec("CREATE TABLE IF NOT EXISTS " PLUGIN_RESOURCES_PENDING_TABLE " ("
+                  "K INTEGER PRIMARY KEY,"
+                  "FOREIGN KEY(K) REFERENCES " PLUGINS_TABLE "(K) ON DELETE CASCADE)"))
+  {
+    close();
+    throw ctkPluginDatabaseException(QString("Creating the table " PLUGIN_RESOURCES_PENDING_TABLE " failed: ")
+                                     + query.lastError().text(), ctkPluginDatabaseException::DB_SQL_ERROR);
+  }
+  query.finish();
+
+  executeQuery(&query, "SELECT K FROM " PLUGIN_RESOURCES_PENDING_TABLE);
+  while (query.next())
+  {
+    m_pendingResources.insert(query.value(EBindIndex).toInt());
+  }
+  query.finish();
+
   // silently remove any plugin marked as uninstalled
   cleanupDB();
 
   //Update database based on the recorded timestamps
   updateDB();
 
+  cleanupResourceArchives();
+
   initNextFreeIds();
 }
 
@@ -358,6 +394,24 @@ QLibrary::LoadHints ctkPluginStorageSQL::getPluginLoadHints() const
   return QLibrary::LoadHints(0);
 }
 
+//----------------------------------------------------------------------------
+bool ctkPluginStorageSQL::getLazyResources() const
+{
+  return m_framework->props.value(ctkPluginConstants::FRAMEWORK_PLUGIN_LAZY_RESOURCES).toBool();
+}
+
+//----------------------------------------------------------------------------
+QString ctkPluginStorageSQL::getResourcePrefix(const QString& libLocation)
+{
+  QString resourcePrefix = QFileInfo(libLocation).baseName();
+  if (resourcePrefix.startsWith("lib"))
+  {
+    resourcePrefix = resourcePrefix.mid(3);
+  }
+  resourcePrefix.replace("_", ".");
+  return QString(":/") + resourcePrefix + "/";
+}
+
 //----------------------------------------------------------------------------
 QSharedPointer<ctkPluginArchive> ctkPluginStorageSQL::insertPlugin(const QUrl& location, const QString& localPath)
 {
@@ -416,13 +470,7 @@ void ctkPluginStorageSQL::insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa,
   QFileInfo fileInfo(pa->getLibLocation());
   QString libTimestamp = getStringFromQDateTime(fileInfo.lastModified());
 
-  QString resourcePrefix = fileInfo.baseName();
-  if (resourcePrefix.startsWith("lib"))
-  {
-    resourcePrefix = resourcePrefix.mid(3);
-  }
-  resourcePrefix.replace("_", ".");
-  resourcePrefix = QString(":/") + resourcePrefix + "/";
+  QString resourcePrefix = getResourcePrefix(pa->getLibLocation());
 
   // Load the plugin and cache the resources
 
@@ -468,28 +516,317 @@ void ctkPluginStorageSQL::insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa,
 
   pa->key = query->lastInsertId().toInt();
 
-  // Write the plug-in resource data into the database
+  // Write the plug-in resource data into the database, or only the
+  // manifest if the other resources are cached on first access or
+  // in a resource archive
+  QString skipPath;
+  if (getLazyResources() || m_resourceArchivesEnabled)
+  {
+    statement = "INSERT INTO " PLUGIN_RESOURCES_TABLE " (K,ResourcePath,Resource) VALUES(?,?,?)";
+    bindValues.clear();
+    bindValues << pa->key;
+    bindValues << MANIFEST_RESOURCE_PATH;
+    bindValues << manifest;
+    executeQuery(query, statement, bindValues);
+    skipPath = MANIFEST_RESOURCE_PATH;
+  }
+
+  if (getLazyResources())
+  {
+    statement = "INSERT INTO " PLUGIN_RESOURCES_PENDING_TABLE " (K) VALUES(?)";
+    bindValues.clear();
+    bindValues << pa->key;
+    executeQuery(query, statement, bindValues);
+
+    QMutexLocker lock(&m_resourcesLock);
+    m_pendingResources.insert(pa->key);
+  }
+  else
+  {
+    insertResources(pa->key, resourcePrefix, skipPath, query);
+  }
+
+  pluginLoader.unload();
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStorageSQL::insertResources(int key, const QString& resourcePrefix,
+                                          const QString& skipPath, QSqlQuery* query)
+{
+  if (m_resourceArchivesEnabled)
+  {
+    // the archive also holds the manifest, so that it can be listed
+    QMap<QByteArray, QByteArray> resources;
+    QDirIterator dirIter(resourcePrefix, QDirIterator::Subdirectories);
+    while (dirIter.hasNext())
+    {
+      QString resourcePath = dirIter.next();
+      if (QFileInfo(resourcePath).isDir()) continue;
+
+      QFile resourceFile(resourcePath);
+      resourceFile.open(QIODevice::ReadOnly);
+      resources.insert(resourcePath.mid(resourcePrefix.size()-1).toUtf8(), resourceFile.readAll());
+      resourceFile.close();
+    }
+
+    // a new file is written, the previous archive of the key may still
+    // be mapped and could not be replaced
+    QMutexLocker lock(&m_resourceArchivesLock);
+    const QString fileName = QString("%1-%2.res").arg(key).arg(m_nextResourceArchive++);
+    if (!ctkPluginResourceArchive::write(m_resourceArchivesDir.absoluteFilePath(fileName), resources))
+    {
+      throw ctkPluginDatabaseException(QString("Could not write the resource archive %1")
+                                       .arg(m_resourceArchivesDir.absoluteFilePath(fileName)),
+                                       ctkPluginDatabaseException::DB_WRITE_ERROR);
+    }
+    if (m_resourceArchives.contains(key))
+    {
+      m_replacedResourceArchives << m_resourceArchives.take(key);
+    }
+    // a file which cannot be removed while it is mapped is removed at the next start
+    const QString oldPath = getResourceArchivePath(key);
+    if (!oldPath.isNull()) QFile::remove(oldPath);
+    m_resourceArchiveFiles.insert(key, fileName);
+    return;
+  }
+
+  QVariantList keys;
+  QVariantList resourcePaths;
+  QVariantList resources;
+
   QDirIterator dirIter(resourcePrefix, QDirIterator::Subdirectories);
   while (dirIter.hasNext())
   {
     QString resourcePath = dirIter.next();
     if (QFileInfo(resourcePath).isDir()) continue;
 
-    QFile resourceFile(resourcePath);
+    resourcePath = resourcePath.mid(resourcePrefix.size()-1);
+    if (resourcePath == skipPath) continue;
+
+    QFile resourceFile(dirIter.filePath());
     resourceFile.open(QIODevice::ReadOnly);
-    QByteArray resourceData = resourceFile.readAll();
+    keys << key;
+    resourcePaths << resourcePath;
+    resources << resourceFile.readAll();
     resourceFile.close();
+  }
 
-    statement = "INSERT INTO " PLUGIN_RESOURCES_TABLE " (K,ResourcePath,Resource) VALUES(?,?,?)";
-    bindValues.clear();
-    bindValues << pa->key;
-    bindValues << resourcePath.mid(resourcePrefix.size()-1);
-    bindValues << resourceData;
+  if (keys.isEmpty()) return;
 
-    executeQuery(query, statement, bindValues);
+  QString statement = "INSERT INTO " PLUGIN_RESOURCES_TABLE " (K,ResourcePath,Resource) VALUES(?,?,?)";
+  if (!query->prepare(statement))
+  {
+    throw ctkPluginDatabaseException(QString("Problem: Could not prepare statement: %1\nReason: %2")
+                                     .arg(statement).arg(query->lastError().text()),
+                                     ctkPluginDatabaseException::DB_SQL_ERROR);
+  }
+  query->addBindValue(keys);
+  query->addBindValue(resourcePaths);
+  query->addBindValue(resources);
+  if (!query->execBatch())
+  {
+    QString errorText = QString("Problem: Could not execute statement: %1\nReason: %2")
+        .arg(statement).arg(query->lastError().text());
+    query->finish();
+    query->clear();
+    throw ctkPluginDatabaseException(errorText, ctkPluginDatabaseException::DB_SQL_ERROR);
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStorageSQL::insertPendingResources(int key)
+{
+  QMutexLocker lock(&m_resourcesLock);
+  if (!m_pendingResources.contains(key)) return;
+
+  checkConnection();
+
+  QSqlDatabase database = QSqlDatabase::database(m_connectionName);
+  QSqlQuery query(database);
+
+  QList<QVariant> bindValues;
+  bindValues.append(key);
+  executeQuery(&query, "SELECT LocalPath FROM " PLUGINS_TABLE " WHERE K=?", bindValues);
+  if (!query.next())
+  {
+    // the plug-in has been removed in the meantime
+    m_pendingResources.remove(key);
+    return;
+  }
+  QString libLocation = query.value(EBindIndex).toString();
+  query.finish();
+
+  QPluginLoader pluginLoader;
+  pluginLoader.setLoadHints(getPluginLoadHints());
+  pluginLoader.setFileName(libLocation);
+  if (!pluginLoader.load())
+  {
+    throw ctkPluginDatabaseException(QString("The plugin \"%1\" could not be loaded to cache its resources: %2")
+                                     .arg(libLocation).arg(pluginLoader.errorString()),
+                                     ctkPluginDatabaseException::DB_SQL_ERROR);
   }
 
+  beginTransaction(&query, Write);
+
+  try
+  {
+    insertResources(key, getResourcePrefix(libLocation), MANIFEST_RESOURCE_PATH, &query);
+    executeQuery(&query, "DELETE FROM " PLUGIN_RESOURCES_PENDING_TABLE " WHERE K=?", bindValues);
+  }
+  catch (...)
+  {
+    rollbackTransaction(&query);
+    pluginLoader.unload();
+    throw;
+  }
+
+  commitTransaction(&query);
   pluginLoader.unload();
+
+  m_pendingResources.remove(key);
+}
+
+//----------------------------------------------------------------------------
+QString ctkPluginStorageSQL::getResourceArchivePath(int key) const
+{
+  QHash<int, QString>::const_iterator it = m_resourceArchiveFiles.find(key);
+  if (it == m_resourceArchiveFiles.end()) return QString();
+  return m_resourceArchivesDir.absoluteFilePath(it.value());
+}
+
+//----------------------------------------------------------------------------
+QSharedPointer<ctkPluginResourceArchive> ctkPluginStorageSQL::getResourceArchive(int key)
+{
+  {
+    QMutexLocker lock(&m_resourceArchivesLock);
+    QSharedPointer<ctkPluginResourceArchive> archive = m_resourceArchives.value(key);
+    if (archive) return archive;
+
+    const QString path = getResourceArchivePath(key);
+    archive = QSharedPointer<ctkPluginResourceArchive>(new ctkPluginResourceArchive(path));
+    if (!path.isNull() && archive->isValid())
+    {
+      m_resourceArchives.insert(key, archive);
+      return archive;
+    }
+  }
+
+  // the archive file is missing or corrupt, write it again
+  {
+    QMutexLocker lock(&m_resourcesLock);
+    m_pendingResources.insert(key);
+  }
+  try
+  {
+    insertPendingResources(key);
+  }
+  catch (const ctkPluginDatabaseException& exc)
+  {
+    qWarning() << "Writing the resource archive failed:" << exc;
+    return QSharedPointer<ctkPluginResourceArchive>();
+  }
+
+  QMutexLocker lock(&m_resourceArchivesLock);
+  QSharedPointer<ctkPluginResourceArchive> archive(new ctkPluginResourceArchive(getResourceArchivePath(key)));
+  if (!archive->isValid()) return QSharedPointer<ctkPluginResourceArchive>();
+  m_resourceArchives.insert(key, archive);
+  return archive;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStorageSQL::removeResourceArchive(int key)
+{
+  if (!m_resourceArchivesEnabled) return;
+
+  QMutexLocker lock(&m_resourceArchivesLock);
+  if (m_resourceArchives.contains(key))
+  {
+    m_replacedResourceArchives << m_resourceArchives.take(key);
+  }
+  // a file which cannot be removed while it is mapped is removed at the next start
+  const QString path = getResourceArchivePath(key);
+  if (!path.isNull()) QFile::remove(path);
+  m_resourceArchiveFiles.remove(key);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStorageSQL::cleanupResourceArchives()
+{
+  if (!m_resourceArchivesDir.exists()) return;
+
+  QSqlDatabase database = QSqlDatabase::database(m_connectionName);
+  QSqlQuery query(database);
+
+  if (!m_resourceArchivesEnabled)
+  {
+    // The resources of the plug-ins inserted while the archives were
+    // enabled are cached in the database again, on first access
+    foreach(QString fileName, m_resourceArchivesDir.entryList(QDir::Files))
+    {
+      bool ok = false;
+      int key = QFileInfo(fileName).completeBaseName().section('-', 0, 0).toInt(&ok);
+      if (ok)
+      {
+        QList<QVariant> bindValues;
+        bindValues.append(key);
+        executeQuery(&query, "INSERT OR IGNORE INTO " PLUGIN_RESOURCES_PENDING_TABLE " (K) "
+                     "SELECT K FROM " PLUGINS_TABLE " WHERE K=?", bindValues);
+        if (query.numRowsAffected() > 0)
+        {
+          m_pendingResources.insert(key);
+        }
+      }
+      m_resourceArchivesDir.remove(fileName);
+    }
+    m_resourceArchivesDir.rmdir(m_resourceArchivesDir.absolutePath());
+    return;
+  }
+
+  executeQuery(&query, "SELECT K FROM " PLUGINS_TABLE);
+  QSet<int> keys;
+  while (query.next())
+  {
+    keys << query.value(EBindIndex).toInt();
+  }
+
+  // archive files are named <key>-<number>.res, the most recent archive
+  // of a key having the highest number
+  QHash<int, int> archiveNumbers;
+  QStringList obsoleteFiles;
+  foreach(QString fileName, m_resourceArchivesDir.entryList(QDir::Files))
+  {
+    const QString baseName = QFileInfo(fileName).completeBaseName();
+    bool keyOk = false;
+    bool numberOk = false;
+    int key = baseName.section('-', 0, 0).toInt(&keyOk);
+    int number = baseName.section('-', 1).toInt(&numberOk);
+    if (!keyOk || !numberOk || !fileName.endsWith(".res"))
+    {
+      obsoleteFiles << fileName;
+      continue;
+    }
+    m_nextResourceArchive = qMax(m_nextResourceArchive, number + 1);
+
+    if (!keys.contains(key))
+    {
+      obsoleteFiles << fileName;
+    }
+    else if (!archiveNumbers.contains(key) || archiveNumbers[key] < number)
+    {
+      if (archiveNumbers.contains(key)) obsoleteFiles << m_resourceArchiveFiles[key];
+      archiveNumbers[key] = number;
+      m_resourceArchiveFiles[key] = fileName;
+    }
+    else
+    {
+      obsoleteFiles << fileName;
+    }
+  }
+
+  foreach(QString fileName, obsoleteFiles)
+  {
+    m_resourceArchivesDir.remove(fileName);
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -526,11 +863,16 @@ void ctkPluginStorageSQL::replacePluginArchive(QSharedPointer<ctkPluginArchive>
 
   try
   {
+    int oldKey = static_cast<ctkPluginArchiveSQL*>(oldPA.data())->key;
     removeArchiveFromDB(static_cast<ctkPluginArchiveSQL*>(oldPA.data()), &query);
     insertArchive(qSharedPointerCast<ctkPluginArchiveSQL>(newPA), &query);
 
     commitTransaction(&query);
     m_archives[pos] = newPA;
+    if (oldKey != qSharedPointerCast<ctkPluginArchiveSQL>(newPA)->key)
+    {
+      removeResourceArchive(oldKey);
+    }
   }
   catch (const ctkRuntimeException& re)
   {
@@ -559,6 +901,7 @@ bool ctkPluginStorageSQL::removeArchive(ctkPluginArchiveSQL* pa)
   {
     removeArchiveFromDB(pa, &query);
     commitTransaction(&query);
+    removeResourceArchive(pa->key);
 
     QMutexLocker lock(&m_archivesLock);
     int idx = find(pa);
@@ -596,6 +939,10 @@ void ctkPluginStorageSQL::removeArchiveFromDB(ctkPluginArchiveSQL* pa, QSqlQuery
   bindValues.append(pa->key);
 
   executeQuery(query, statement, bindValues);
+
+  // the key may be reused by a plug-in inserted later
+  QMutexLocker lock(&m_resourcesLock);
+  m_pendingResources.remove(pa->key);
 }
 
 QList<QSharedPointer<ctkPluginArchive> > ctkPluginStorageSQL::getAllPluginArchives() const
@@ -667,6 +1014,14 @@ void ctkPluginStorageSQL::setAutostartSetting(int key, int autostart)
 //----------------------------------------------------------------------------
 QStringList ctkPluginStorageSQL::findResourcesPath(int archiveKey, const QString& path) const
 {
+  ctkPluginStorageSQL* self = const_cast<ctkPluginStorageSQL*>(this);
+  self->insertPendingResources(archiveKey);
+  if (m_resourceArchivesEnabled)
+  {
+    QSharedPointer<ctkPluginResourceArchive> archive = self->getResourceArchive(archiveKey);
+    return archive ? archive->findResourcesPath(path) : QStringList();
+  }
+
   checkConnection();
 
   QString statement = "SELECT SUBSTR(ResourcePath,?) FROM PluginResources WHERE K=? AND SUBSTR(ResourcePath,1,?)=?";
@@ -810,6 +1165,19 @@ QString ctkPluginStorageSQL::getDatabasePath() const
 //----------------------------------------------------------------------------
 QByteArray ctkPluginStorageSQL::getPluginResource(int key, const QString& res) const
 {
+  // the manifest is always read from the database
+  QString resourcePath = res.startsWith('/') ? res : QString("/") + res;
+  if (resourcePath != MANIFEST_RESOURCE_PATH)
+  {
+    ctkPluginStorageSQL* self = const_cast<ctkPluginStorageSQL*>(this);
+    self->insertPendingResources(key);
+    if (m_resourceArchivesEnabled)
+    {
+      QSharedPointer<ctkPluginResourceArchive> archive = self->getResourceArchive(key);
+      return archive ? archive->getResource(resourcePath) : QByteArray();
+    }
+  }
+
   checkConnection();
 
   QSqlDatabase database = QSqlDatabase::database(m_connectionName);
@@ -817,7 +1185,6 @@ QByteArray ctkPluginStorageSQL::getPluginResource(int key, const QString& res) c
 
   QString statement = "SELECT Resource FROM PluginResources WHERE K=? AND ResourcePath=?";
 
-  QString resourcePath = res.startsWith('/') ? res : QString("/") + res;
   QList<QVariant> bindValues;
   bindValues.append(key);
   bindValues.append(resourcePath);
@@ -910,7 +1277,7 @@ bool ctkPluginStorageSQL::dropTables()
   QSqlDatabase database = QSqlDatabase::database(m_connectionName);
   QSqlQuery query(database);
   QStringList expectedTables;
-  expectedTables << PLUGINS_TABLE << PLUGIN_RESOURCES_TABLE;
+  expectedTables << PLUGINS_TABLE << PLUGIN_RESOURCES_TABLE << PLUGIN_RESOURCES_PENDING_TABLE;
 
   if (database.tables().count() > 0)
   {
@@ -29,6 +29,7 @@
 // CTK class forward declarations
 class ctkPluginFrameworkContext;
 class ctkPluginArchiveSQL;
+class ctkPluginResourceArchive;
 
 /**
  * \ingroup PluginFramework
@@ -132,6 +133,10 @@ public:
    * must be relative to the plugin specific resource prefix, but may
    * start with a '/'.
    *
+   * If the resources are stored in archive files, the returned byte
+   * array references the mapped archive and is valid until this
+   * storage is deleted.
+   *
    * @param pluginId The id of the plugin from which to get the resource
    * @param res The path to the resource in the plugin
    * @return The byte array of the cached resource
@@ -235,6 +240,43 @@ private:
    */
   QLibrary::LoadHints getPluginLoadHints() const;
 
+  /**
+   * Checks if the framework defers caching the plug-in resources until
+   * they are first accessed.
+   */
+  bool getLazyResources() const;
+
+  /**
+   * Get the Qt resource prefix of the plug-in library at \a libLocation.
+   */
+  static QString getResourcePrefix(const QString& libLocation);
+
+  /**
+   * Get the path of the resource archive file of the plug-in with the given key,
+   * or a null string if it has none. The resource archives lock must be held.
+   */
+  QString getResourceArchivePath(int key) const;
+
+  /**
+   * Get the mapped resource archive of the plug-in with the given key.
+   * A missing or invalid archive file is written again from the plug-in
+   * library.
+   *
+   * @return The archive, or a null pointer if it could not be written.
+   */
+  QSharedPointer<ctkPluginResourceArchive> getResourceArchive(int key);
+
+  /**
+   * Removes the resource archive file of the plug-in with the given key.
+   */
+  void removeResourceArchive(int key);
+
+  /**
+   * Removes the resource archive files of plug-ins which are no
+   * longer in the database.
+   */
+  void cleanupResourceArchives();
+
   /**
    *  Helper method that creates the database tables:
    *
@@ -276,6 +318,25 @@ private:
 
   void insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa, QSqlQuery* query);
 
+  /**
+   * Writes the Qt resources under \a resourcePrefix, except for
+   * \a skipPath, into the database using a single prepared statement.
+   * If the resources are stored in archive files, all of them are written
+   * into the archive file of the plug-in instead.
+   *
+   * @throws ctkPluginDatabaseException
+   */
+  void insertResources(int key, const QString& resourcePrefix,
+                       const QString& skipPath, QSqlQuery* query);
+
+  /**
+   * Caches the resources of the plug-in with the given key, if they
+   * were deferred when the plug-in was inserted.
+   *
+   * @throws ctkPluginDatabaseException
+   */
+  void insertPendingResources(int key);
+
   void removeArchiveFromDB(ctkPluginArchiveSQL *pa, QSqlQuery *query);
 
   /**
@@ -330,6 +391,37 @@ private:
 
   QMutex m_archivesLock;
 
+  /**
+   * Keys of the plug-ins whose resources, except for the manifest,
+   * are not cached yet.
+   */
+  QSet<int> m_pendingResources;
+  QMutex m_resourcesLock;
+
+  /**
+   * If the resources, except for the manifests, are stored in
+   * memory-mapped archive files instead of the database.
+   */
+  bool m_resourceArchivesEnabled;
+  QDir m_resourceArchivesDir;
+  QMutex m_resourceArchivesLock;
+
+  /**
+   * Mapped resource archives, by plug-in key. Replaced archives stay
+   * mapped until the storage is deleted, the resources returned by
+   * getPluginResource() referencing them.
+   */
+  QHash<int, QSharedPointer<ctkPluginResourceArchive> > m_resourceArchives;
+  QList<QSharedPointer<ctkPluginResourceArchive> > m_replacedResourceArchives;
+
+  /**
+   * Resource archive file names, by plug-in key. The name of a written
+   * archive is never reused, plug-in keys are: a mapped file cannot be
+   * replaced on every platform.
+   */
+  QHash<int, QString> m_resourceArchiveFiles;
+  int m_nextResourceArchive;
+
   /**
    * Plugin id sorted list of all active plugin archives.
    */
@@ -120,7 +120,8 @@ void ctkServiceRegistration::setProperties(const ctkDictionary& props)
       before = d->plugin->fwCtx->listeners.getMatchingServiceSlots(d->reference, false);
       QStringList classes = d->properties.value(ctkPluginConstants::OBJECTCLASS).toStringList();
       qlonglong sid = d->properties.value(ctkPluginConstants::SERVICE_ID).toLongLong();
-      d->properties = ctkServices::createServiceProperties(props, classes, sid);
+      d->plugin->fwCtx->services->updateServiceProperties(
+            *this, ctkServices::createServiceProperties(props, classes, sid));
       int new_rank = d->properties.value(ctkPluginConstants::SERVICE_RANKING).toInt();
       if (old_rank != new_rank)
       {
@@ -24,6 +24,7 @@
 #include <QStringListIterator>
 #include <QMutexLocker>
 #include <QBuffer>
+#include <QThread>
 
 #include <algorithm>
 
@@ -43,6 +44,69 @@ struct ServiceRegistrationComparator
   }
 };
 
+//----------------------------------------------------------------------------
+class ctkServices::ReadLock
+{
+public:
+
+  ReadLock(const ctkServices* services)
+    : services(services)
+  {
+    parity = services->readersEpoch.fetchAndAddOrdered(0) & 1;
+    services->readers[parity].ref();
+    current = services->snapshot.fetchAndAddOrdered(0);
+  }
+
+  ~ReadLock()
+  {
+    services->readers[parity].deref();
+  }
+
+  const ctkServicesSnapshot* operator->() const
+  {
+    return current;
+  }
+
+  const ctkServicesSnapshot& operator*() const
+  {
+    return *current;
+  }
+
+private:
+
+  const ctkServices* services;
+  const ctkServicesSnapshot* current;
+  int parity;
+};
+
+//----------------------------------------------------------------------------
+// Get the strings a filter can match in the given property value, returns
+// false if the value can be matched otherwise.
+static bool getIndexValues(const QVariant& value, QStringList& values)
+{
+  if (value.type() == QVariant::List || value.type() == QVariant::StringList)
+  {
+    if (value.canConvert<QString>())
+    {
+      values.append(value.toString());
+    }
+    foreach (QVariant element, value.toList())
+    {
+      if (!getIndexValues(element, values))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (value.canConvert<QString>())
+  {
+    values.append(value.toString());
+    return true;
+  }
+  return value.isNull();
+}
+
 //----------------------------------------------------------------------------
 ctkDictionary ctkServices::createServiceProperties(const ctkDictionary& in,
                                                        const QStringList& classes,
@@ -63,25 +127,61 @@ ctkDictionary ctkServices::createServiceProperties(const ctkDictionary& in,
 
 //----------------------------------------------------------------------------
 ctkServices::ctkServices(ctkPluginFrameworkContext* fwCtx)
-  : mutex(), framework(fwCtx)
+  : mutex(), framework(fwCtx), snapshot(new ctkServicesSnapshot)
 {
-
+  indexedKeys << ctkPluginConstants::SERVICE_PID;
+  indexedKeys << fwCtx->props.value(ctkPluginConstants::FRAMEWORK_SERVICE_INDEXED_KEYS).toStringList();
+  for (int i = 0; i < indexedKeys.size(); ++i)
+  {
+    indexedKeys[i] = indexedKeys[i].toLower();
+  }
+  indexedKeys.removeDuplicates();
+  indexedKeys.removeAll(QString());
 }
 
 //----------------------------------------------------------------------------
 ctkServices::~ctkServices()
 {
   clear();
+  delete snapshot.fetchAndStoreOrdered(0);
 }
 
 //----------------------------------------------------------------------------
 void ctkServices::clear()
 {
-  services.clear();
-  classServices.clear();
+  {
+    QMutexLocker lock(&mutex);
+    publishSnapshot_unlocked(new ctkServicesSnapshot);
+  }
   framework = 0;
 }
 
+//----------------------------------------------------------------------------
+ctkServicesSnapshot* ctkServices::copySnapshot_unlocked() const
+{
+  // the containers are implicitly shared, only the changed ones are copied
+  return new ctkServicesSnapshot(*snapshot.fetchAndAddOrdered(0));
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::publishSnapshot_unlocked(ctkServicesSnapshot* next)
+{
+  ctkServicesSnapshot* previous = snapshot.fetchAndStoreOrdered(next);
+
+  // A lookup may have read the previous snapshot while counting itself in
+  // either half of readers. The new lookups count themselves in the other
+  // half than the one waited for, so that each half gets empty.
+  for (int i = 0; i < 2; ++i)
+  {
+    int parity = readersEpoch.fetchAndAddOrdered(1) & 1;
+    while (readers[parity].fetchAndAddOrdered(0) != 0)
+    {
+      QThread::yieldCurrentThread();
+    }
+  }
+  delete previous;
+}
+
 //----------------------------------------------------------------------------
 ctkServiceRegistration ctkServices::registerService(ctkPluginPrivate* plugin,
                              const QStringList& classes,
@@ -117,15 +217,18 @@ ctkServiceRegistration ctkServices::registerService(ctkPluginPrivate* plugin,
                              createServiceProperties(properties, classes));
   {
     QMutexLocker lock(&mutex);
-    services.insert(res, classes);
+    ctkServicesSnapshot* next = copySnapshot_unlocked();
+    next->services.insert(res, classes);
     for (QStringListIterator i(classes); i.hasNext(); )
     {
       QString currClass = i.next();
-      QList<ctkServiceRegistration>& s = classServices[currClass];
+      QList<ctkServiceRegistration>& s = next->classServices[currClass];
       QList<ctkServiceRegistration>::iterator ip =
           std::lower_bound(s.begin(), s.end(), res, ServiceRegistrationComparator());
       s.insert(ip, res);
     }
+    addToIndexes_unlocked(*next, res, res.d_func()->properties);
+    publishSnapshot_unlocked(next);
   }
 
   ctkServiceReference r = res.getReference();
@@ -140,12 +243,149 @@ void ctkServices::updateServiceRegistrationOrder(const ctkServiceRegistration& s
                                               const QStringList& classes)
 {
   QMutexLocker lock(&mutex);
+  ctkServicesSnapshot* next = copySnapshot_unlocked();
   for (QStringListIterator i(classes); i.hasNext(); )
   {
-    QList<ctkServiceRegistration>& s = classServices[i.next()];
+    QList<ctkServiceRegistration>& s = next->classServices[i.next()];
     s.removeAll(sr);
     s.insert(std::lower_bound(s.begin(), s.end(), sr, ServiceRegistrationComparator()), sr);
   }
+  publishSnapshot_unlocked(next);
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::updateServiceProperties(ctkServiceRegistration& sr,
+                                          const ctkDictionary& properties)
+{
+  QMutexLocker lock(&mutex);
+  ctkServicesSnapshot* next = copySnapshot_unlocked();
+  ctkDictionary& current = sr.d_func()->properties;
+  removeFromIndexes_unlocked(*next, sr, current);
+  current = properties;
+  addToIndexes_unlocked(*next, sr, current);
+  publishSnapshot_unlocked(next);
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::addToIndexes_unlocked(ctkServicesSnapshot& next,
+                                        const ctkServiceRegistration& sr,
+                                        const ctkDictionary& properties)
+{
+  foreach (QString key, indexedKeys)
+  {
+    QVariant value = properties.value(key);
+    if (!value.isValid())
+    {
+      continue;
+    }
+    QStringList values;
+    if (getIndexValues(value, values))
+    {
+      values.removeDuplicates();
+      QMap<QString, QList<ctkServiceRegistration> >& index = next.propertyServices[key];
+      foreach (QString v, values)
+      {
+        index[v].append(sr);
+      }
+    }
+    else
+    {
+      next.unindexedServices[key].append(sr);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::removeFromIndexes_unlocked(ctkServicesSnapshot& next,
+                                             const ctkServiceRegistration& sr,
+                                             const ctkDictionary& properties)
+{
+  foreach (QString key, indexedKeys)
+  {
+    QVariant value = properties.value(key);
+    if (!value.isValid())
+    {
+      continue;
+    }
+    QStringList values;
+    if (getIndexValues(value, values))
+    {
+      QMap<QString, QList<ctkServiceRegistration> >& index = next.propertyServices[key];
+      foreach (QString v, values)
+      {
+        QMap<QString, QList<ctkServiceRegistration> >::iterator it = index.find(v);
+        if (it != index.end())
+        {
+          it.value().removeAll(sr);
+          if (it.value().isEmpty())
+          {
+            index.erase(it);
+          }
+        }
+      }
+    }
+    else
+    {
+      QList<ctkServiceRegistration>& s = next.unindexedServices[key];
+      s.removeAll(sr);
+      if (s.isEmpty())
+      {
+        next.unindexedServices.remove(key);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+bool ctkServices::getIndexedCandidates_unlocked(const ctkServicesSnapshot& current,
+                                                const ctkLDAPExpr& ldap,
+                                                QSet<ctkServiceRegistration>& candidates) const
+{
+  bool found = false;
+  foreach (QString key, indexedKeys)
+  {
+    QStringList patterns;
+    if (!ldap.getMatchedValues(key, patterns))
+    {
+      continue;
+    }
+
+    QSet<ctkServiceRegistration> keyCandidates = current.unindexedServices.value(key).toSet();
+    const QMap<QString, QList<ctkServiceRegistration> > index = current.propertyServices.value(key);
+    foreach (QString pattern, patterns)
+    {
+      int wildcard = pattern.indexOf(ctkLDAPExpr::wildcard());
+      if (wildcard < 0)
+      {
+        QMap<QString, QList<ctkServiceRegistration> >::const_iterator it = index.constFind(pattern);
+        if (it != index.constEnd())
+        {
+          keyCandidates += it.value().toSet();
+        }
+      }
+      else
+      {
+        // the values matching the pattern start with its literal prefix
+        QString prefix = pattern.left(wildcard);
+        for (QMap<QString, QList<ctkServiceRegistration> >::const_iterator it = index.lowerBound(prefix);
+             it != index.constEnd() && it.key().startsWith(prefix); ++it)
+        {
+          keyCandidates += it.value().toSet();
+        }
+      }
+    }
+
+    if (found)
+    {
+      candidates.intersect(keyCandidates);
+    }
+    else
+    {
+      candidates = keyCandidates;
+      found = true;
+    }
+  }
+  return found;
 }
 
 //----------------------------------------------------------------------------
@@ -157,16 +397,19 @@ bool ctkServices::checkServiceClass(QObject* service, const QString& cls) const
 //----------------------------------------------------------------------------
 QList<ctkServiceRegistration> ctkServices::get(const QString& clazz) const
 {
-  QMutexLocker lock(&mutex);
-  return classServices.value(clazz);
+  ReadLock current(this);
+  return current->classServices.value(clazz);
 }
 
 //----------------------------------------------------------------------------
 ctkServiceReference ctkServices::get(ctkPluginPrivate* plugin, const QString& clazz) const
 {
-  QMutexLocker lock(&mutex);
   try {
-    QList<ctkServiceReference> srs = get_unlocked(clazz, QString(), plugin);
+    QList<ctkServiceReference> srs;
+    {
+      ReadLock current(this);
+      srs = get_unlocked(*current, clazz, ctkLDAPExpr(), plugin);
+    }
     if (framework->debug.service_reference)
     {
       qDebug() << "get service ref" << clazz << "for plugin"
@@ -186,31 +429,61 @@ ctkServiceReference ctkServices::get(ctkPluginPrivate* plugin, const QString& cl
 QList<ctkServiceReference> ctkServices::get(const QString& clazz, const QString& filter,
                                             ctkPluginPrivate* plugin) const
 {
-  QMutexLocker lock(&mutex);
-  return get_unlocked(clazz, filter, plugin);
+  ctkLDAPExpr ldap;
+  if (!filter.isEmpty())
+  {
+    // parsed before the snapshot is read, a broken filter throws here
+    ldap = ctkLDAPExpr(filter);
+  }
+  ReadLock current(this);
+  return get_unlocked(*current, clazz, ldap, plugin);
 }
 
 //----------------------------------------------------------------------------
-QList<ctkServiceReference> ctkServices::get_unlocked(const QString& clazz, const QString& filter,
+QList<ctkServiceReference> ctkServices::get_unlocked(const ctkServicesSnapshot& current,
+                                                     const QString& clazz, const ctkLDAPExpr& ldap,
                                                      ctkPluginPrivate* plugin) const
 {
   Q_UNUSED(plugin)
 
   QListIterator<ctkServiceRegistration>* s = 0;
   QList<ctkServiceRegistration> v;
-  ctkLDAPExpr ldap;
-  if (clazz.isEmpty())
+
+  QSet<ctkServiceRegistration> candidates;
+  if (!ldap.isNull() && getIndexedCandidates_unlocked(current, ldap, candidates))
   {
-    if (!filter.isEmpty())
+    // only the services with the property values required by the filter
+    QSet<ctkServiceRegistration>::iterator it = candidates.begin();
+    while (it != candidates.end())
+    {
+      if (!clazz.isEmpty() && !current.services.value(*it).contains(clazz))
+      {
+        it = candidates.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+    if (candidates.isEmpty())
+    {
+      return QList<ctkServiceReference>();
+    }
+    v = candidates.toList();
+    std::sort(v.begin(), v.end(), ServiceRegistrationComparator());
+    s = new QListIterator<ctkServiceRegistration>(v);
+  }
+  else if (clazz.isEmpty())
+  {
+    if (!ldap.isNull())
     {
-      ldap = ctkLDAPExpr(filter);
       QSet<QString> matched;
       if (ldap.getMatchedObjectClasses(matched))
       {
         v.clear();
         foreach (QString className, matched)
         {
-          const QList<ctkServiceRegistration>& cl = classServices[className];
+          const QList<ctkServiceRegistration> cl = current.classServices.value(className);
           v += cl;
         }
         if (!v.isEmpty())
@@ -224,17 +497,17 @@ QList<ctkServiceReference> ctkServices::get_unlocked(const QString& clazz, const
       }
       else
       {
-        s = new QListIterator<ctkServiceRegistration>(services.keys());
+        s = new QListIterator<ctkServiceRegistration>(current.services.keys());
       }
     }
     else
     {
-      s = new QListIterator<ctkServiceRegistration>(services.keys());
+      s = new QListIterator<ctkServiceRegistration>(current.services.keys());
     }
   }
   else
   {
-    QList<ctkServiceRegistration> v = classServices.value(clazz);
+    QList<ctkServiceRegistration> v = current.classServices.value(clazz);
     if (!v.isEmpty())
     {
       s = new QListIterator<ctkServiceRegistration>(v);
@@ -243,10 +516,6 @@ QList<ctkServiceReference> ctkServices::get_unlocked(const QString& clazz, const
     {
       return QList<ctkServiceReference>();
     }
-    if (!filter.isEmpty())
-    {
-      ldap = ctkLDAPExpr(filter);
-    }
   }
 
   QList<ctkServiceReference> res;
@@ -255,7 +524,7 @@ QList<ctkServiceReference> ctkServices::get_unlocked(const QString& clazz, const
     ctkServiceRegistration sr = s->next();
     ctkServiceReference sri = sr.getReference();
 
-    if (filter.isEmpty() || ldap.evaluate(sr.d_func()->properties, false))
+    if (ldap.isNull() || ldap.evaluate(sr.d_func()->properties, false))
     {
       res.push_back(sri);
     }
@@ -272,29 +541,32 @@ void ctkServices::removeServiceRegistration(const ctkServiceRegistration& sr)
   QMutexLocker lock(&mutex);
 
   QStringList classes = sr.d_func()->properties.value(ctkPluginConstants::OBJECTCLASS).toStringList();
-  services.remove(sr);
+  ctkServicesSnapshot* next = copySnapshot_unlocked();
+  removeFromIndexes_unlocked(*next, sr, sr.d_func()->properties);
+  next->services.remove(sr);
   for (QStringListIterator i(classes); i.hasNext(); )
   {
     QString currClass = i.next();
-    QList<ctkServiceRegistration>& s = classServices[currClass];
+    QList<ctkServiceRegistration>& s = next->classServices[currClass];
     if (s.size() > 1)
     {
       s.removeAll(sr);
     }
     else
     {
-      classServices.remove(currClass);
+      next->classServices.remove(currClass);
     }
   }
+  publishSnapshot_unlocked(next);
 }
 
 //----------------------------------------------------------------------------
 QList<ctkServiceRegistration> ctkServices::getRegisteredByPlugin(ctkPluginPrivate* p) const
 {
-  QMutexLocker lock(&mutex);
+  ReadLock current(this);
 
   QList<ctkServiceRegistration> res;
-  for (QHashIterator<ctkServiceRegistration, QStringList> i(services); i.hasNext(); )
+  for (QHashIterator<ctkServiceRegistration, QStringList> i(current->services); i.hasNext(); )
   {
     ctkServiceRegistration sr = i.next().key();
     if (sr.d_func()->plugin == p)
@@ -308,10 +580,10 @@ QList<ctkServiceRegistration> ctkServices::getRegisteredByPlugin(ctkPluginPrivat
 //----------------------------------------------------------------------------
 QList<ctkServiceRegistration> ctkServices::getUsedByPlugin(QSharedPointer<ctkPlugin> p) const
 {
-  QMutexLocker lock(&mutex);
+  ReadLock current(this);
 
   QList<ctkServiceRegistration> res;
-  for (QHashIterator<ctkServiceRegistration, QStringList> i(services); i.hasNext(); )
+  for (QHashIterator<ctkServiceRegistration, QStringList> i(current->services); i.hasNext(); )
   {
     ctkServiceRegistration sr = i.next().key();
     if (sr.d_func()->isUsedByPlugin(p))
@@ -23,24 +23,74 @@
 #ifndef CTKSERVICES_P_H
 #define CTKSERVICES_P_H
 
+#include <QAtomicInt>
+#include <QAtomicPointer>
 #include <QHash>
+#include <QMap>
 #include <QObject>
 #include <QMutex>
+#include <QSet>
 #include <QStringList>
 
 #include "ctkPlugin_p.h"
 #include "ctkServiceRegistration.h"
 
+class ctkLDAPExpr;
+
+/**
+ * \ingroup PluginFramework
+ *
+ * The registered services as seen by the service lookups. A snapshot is
+ * never modified once it is published by ctkServices, the changes are
+ * made to a copy which then replaces it.
+ */
+struct ctkServicesSnapshot
+{
+  /**
+   * All registered services in the current framework.
+   * Mapping of registered service to class names under which
+   * the service is registerd.
+   */
+  QHash<ctkServiceRegistration, QStringList> services;
+
+  /**
+   * Mapping of classname to registered service.
+   * The List of registered services are ordered with the highest
+   * ranked service first.
+   */
+  QHash<QString, QList<ctkServiceRegistration> > classServices;
+
+  /**
+   * Mapping of an indexed property name to the string values of the
+   * property, and of each value to the registered services having it.
+   * The values are sorted so that the values starting with a given
+   * prefix are next to each other.
+   */
+  QHash<QString, QMap<QString, QList<ctkServiceRegistration> > > propertyServices;
+
+  /**
+   * Mapping of an indexed property name to the registered services whose
+   * value of the property cannot be indexed. They are candidates for
+   * any value of the property.
+   */
+  QHash<QString, QList<ctkServiceRegistration> > unindexedServices;
+};
 
 /**
  * \ingroup PluginFramework
  *
  * Here we handle all the services that are registered in the framework.
+ *
+ * The lookups do not lock: they read the current ctkServicesSnapshot,
+ * which the changes replace. The changes are serialized by mutex and
+ * delete the replaced snapshot once the lookups which may still read it
+ * are done.
  */
 class ctkServices {
 
 public:
 
+  //! Serializes the changes of the registered services
   mutable QMutex mutex;
 
   /**
@@ -57,19 +107,10 @@ public:
                                  long sid = -1);
 
   /**
-   * All registered services in the current framework.
-   * Mapping of registered service to class names under which
-   * the service is registerd.
-   */
-  QHash<ctkServiceRegistration, QStringList> services;
-
-  /**
-   * Mapping of classname to registered service.
-   * The List of registered services are ordered with the highest
-   * ranked service first.
+   * Lower case names of the service properties which are indexed in
+   * ctkServicesSnapshot::propertyServices.
    */
-  QHash<QString, QList<ctkServiceRegistration> > classServices;
-
+  QStringList indexedKeys;
 
   ctkPluginFrameworkContext* framework;
 
@@ -111,6 +152,17 @@ public:
                                       const QStringList& classes);
 
 
+  /**
+   * Change the properties of a service and update the property indexes,
+   * both under the same lock.
+   *
+   * @param sr The ctkServiceRegistration object.
+   * @param properties The new properties of the service.
+   */
+  void updateServiceProperties(ctkServiceRegistration& sr,
+                               const ctkDictionary& properties);
+
+
   /**
    * Checks that a given service object is an instance of the given
    * class name.
@@ -181,9 +233,47 @@ public:
 
 private:
 
-  QList<ctkServiceReference> get_unlocked(const QString& clazz, const QString& filter,
+  //! Access to the current snapshot for the duration of a lookup
+  class ReadLock;
+  friend class ReadLock;
+
+  //! The published snapshot
+  mutable QAtomicPointer<ctkServicesSnapshot> snapshot;
+  //! Parity of readers the new lookups count themselves in
+  mutable QAtomicInt readersEpoch;
+  //! Number of lookups in progress, in two halves
+  mutable QAtomicInt readers[2];
+
+  //! Copy of the current snapshot, to be changed and published
+  ctkServicesSnapshot* copySnapshot_unlocked() const;
+
+  //! Replace the current snapshot and delete it when it is no longer read
+  void publishSnapshot_unlocked(ctkServicesSnapshot* next);
+
+  QList<ctkServiceReference> get_unlocked(const ctkServicesSnapshot& current,
+                                          const QString& clazz, const ctkLDAPExpr& ldap,
                                           ctkPluginPrivate* plugin) const;
 
+  /**
+   * Add or remove the service to/from the indexes of its properties.
+   */
+  void addToIndexes_unlocked(ctkServicesSnapshot& next, const ctkServiceRegistration& sr,
+                             const ctkDictionary& properties);
+  void removeFromIndexes_unlocked(ctkServicesSnapshot& next, const ctkServiceRegistration& sr,
+                                  const ctkDictionary& properties);
+
+  /**
+   * Get the services whose indexed properties can match the filter.
+   *
+   * @param current The snapshot to search.
+   * @param ldap The filter.
+   * @param candidates The services the filter has to be evaluated for.
+   * @return <code>false</code> if the filter does not require a value of
+   *         an indexed property, <code>true</code> otherwise.
+   */
+  bool getIndexedCandidates_unlocked(const ctkServicesSnapshot& current, const ctkLDAPExpr& ldap,
+                                     QSet<ctkServiceRegistration>& candidates) const;
+
 };
 
 
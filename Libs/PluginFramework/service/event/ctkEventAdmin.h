@@ -173,6 +173,20 @@ struct ctkEventAdmin
    */
   virtual bool updateProperties(qlonglong subscriptionId, const ctkDictionary& properties) = 0;
 
+  /**
+   * Initiate asynchronous, ordered delivery of several events. This is
+   * equivalent to calling postEvent() for each of the events, but the
+   * handlers are determined once for all events of the same topic.
+   * Handlers registered with the {@link ctkEventConstants#DELIVERY_ASYNC_BATCH}
+   * delivery quality receive the events in a single call.
+   *
+   * @param events The events to send to all listeners which subscribe to the
+   *        topics of the events.
+   *
+   * @see ctkEventConstants#EVENT_COALESCE
+   */
+  virtual void postEvents(const QList<ctkEvent>& events) = 0;
+
 };
 
 
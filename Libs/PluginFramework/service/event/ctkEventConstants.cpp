@@ -28,6 +28,9 @@ const QString ctkEventConstants::EVENT_FILTER = "event.filter";
 const QString ctkEventConstants::EVENT_DELIVERY = "event.delivery";
 const QString ctkEventConstants::DELIVERY_ASYNC_ORDERED = "async.ordered";
 const QString ctkEventConstants::DELIVERY_ASYNC_UNORDERED = "async.unordered";
+const QString ctkEventConstants::DELIVERY_ASYNC_BATCH = "async.batch";
+
+const QString ctkEventConstants::EVENT_COALESCE = "event.coalesce";
 
 const QString ctkEventConstants::PLUGIN_SYMBOLICNAME = "plugin.symbolicName";
 const QString ctkEventConstants::PLUGIN_ID = "plugin.id";
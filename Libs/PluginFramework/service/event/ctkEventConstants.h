@@ -91,6 +91,7 @@ struct CTK_PLUGINFW_EXPORT ctkEventConstants {
    *
    * @see #DELIVERY_ASYNC_ORDERED
    * @see #DELIVERY_ASYNC_UNORDERED
+   * @see #DELIVERY_ASYNC_BATCH
    */
   static const QString EVENT_DELIVERY; // = "event.delivery"
 
@@ -125,6 +126,36 @@ struct CTK_PLUGINFW_EXPORT ctkEventConstants {
    */
   static const QString DELIVERY_ASYNC_UNORDERED; // = "async.unordered"
 
+  /**
+   * Event Handler delivery quality value specifying the Event Handler
+   * receives events through <code>ctkEventHandler::handleEvents()</code>.
+   * Events posted by a thread which are waiting for their delivery to the
+   * handler are then handed to it in a single call, in the order they were
+   * posted.
+   *
+   * <p>
+   * This delivery quality value is specific to CTK.
+   *
+   * @see #EVENT_DELIVERY
+   * @see ctkEventAdmin#postEvents(const QList<ctkEvent>&)
+   */
+  static const QString DELIVERY_ASYNC_BATCH; // = "async.batch"
+
+  /**
+   * Event property (named <code>event.coalesce</code>) allowing a posted
+   * event to replace an event of the same topic posted by the same thread
+   * which is still waiting for its delivery to an Event Handler.
+   * <p>
+   * The value of this property is the time window in milliseconds: the
+   * waiting event is replaced if it was posted at most that long before. This
+   * suits events of which only the latest one is of interest, like progress
+   * notifications. Events without this property are never replaced.
+   *
+   * <p>
+   * This event property is specific to CTK.
+   */
+  static const QString EVENT_COALESCE; // = "event.coalesce"
+
   /**
    * The Plugin Symbolic Name of the plugin relevant to the event. The type of
    * the value for this event property is <code>QString</code>.
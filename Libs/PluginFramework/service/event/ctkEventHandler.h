@@ -79,6 +79,22 @@ struct ctkEventHandler
    * @param event The event that occurred.
    */
   virtual void handleEvent(const ctkEvent& event) = 0;
+
+  /**
+   * Called by the {@link ctkEventAdmin} service instead of handleEvent() for
+   * handlers registered with the {@link ctkEventConstants#DELIVERY_ASYNC_BATCH}
+   * delivery quality, to notify the listener of events in the order they
+   * occurred. The default implementation calls handleEvent() for each event.
+   *
+   * @param events The events that occurred.
+   */
+  virtual void handleEvents(const QList<ctkEvent>& events)
+  {
+    foreach (const ctkEvent& event, events)
+    {
+      handleEvent(event);
+    }
+  }
 };
 
 Q_DECLARE_INTERFACE(ctkEventHandler, "org.commontk.service.event.EventHandler")
@@ -0,0 +1,158 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QTcpSocket>
+#include <QTime>
+
+// CTK includes
+#include <ctkSimpleSoapClient.h>
+#include <ctkSimpleSoapServer.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+class ctkSimpleSoapServerTestHandler : public QObject
+{
+  Q_OBJECT
+
+public Q_SLOTS:
+
+  // Answers the Echo message with its value argument
+  void incomingSoapMessage(const QtSoapMessage& message, QtSoapMessage* reply)
+  {
+    reply->setMethod("EchoResponse");
+    reply->addMethodArgument("return", "", message.method()["value"].value().toInt());
+  }
+};
+
+//----------------------------------------------------------------------------
+class ctkSimpleSoapCountingServer : public ctkSimpleSoapServer
+{
+public:
+
+  ctkSimpleSoapCountingServer() : Connections(0) {}
+
+  int Connections;
+
+protected:
+
+  void incomingConnection(int socketDescriptor)
+  {
+    ++Connections;
+    ctkSimpleSoapServer::incomingConnection(socketDescriptor);
+  }
+};
+
+//----------------------------------------------------------------------------
+QByteArray echoRequest(int value)
+{
+  QtSoapMessage request;
+  request.setMethod("Echo");
+  request.addMethodArgument("value", "", value);
+  QByteArray body = request.toXmlString().toUtf8();
+
+  QByteArray block;
+  block.append("POST /Echo HTTP/1.1\r\n");
+  block.append("Content-Type: text/xml;charset=utf-8\r\n");
+  block.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+  block.append("\r\n");
+  block.append(body);
+  return block;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int ctkSimpleSoapServerTest1(int argc, char* argv[])
+{
+  QApplication app(argc, argv);
+
+  ctkSimpleSoapServerTestHandler handler;
+  ctkSimpleSoapCountingServer server;
+  QObject::connect(&server, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)),
+                   &handler, SLOT(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)));
+  if (!server.listen(QHostAddress::LocalHost, 0))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with listen() method" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //----------------------------------------------------------------------------
+  // Successive calls of a client share its connection
+  const int calls = 200;
+  ctkSimpleSoapClient client(server.serverPort(), "/Echo");
+  QTime timer;
+  timer.start();
+  for (int i = 0; i < calls; ++i)
+    {
+    const QtSoapType& result = client.submitSoapRequest("Echo",
+                                                        new QtSoapSimpleType(QtSoapQName("value"), i));
+    if (result.value().toInt() != i)
+      {
+      std::cerr << "Line " << __LINE__ << " - Problem with submitSoapRequest() method"
+                << " - " << qPrintable(result.value().toString()) << " != " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::cout << (timer.elapsed() * 1000.0 / calls) << " us per call" << std::endl;
+
+  if (server.Connections != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with keep-alive - "
+              << server.Connections << " connections for " << calls << " calls" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //----------------------------------------------------------------------------
+  // Pipelined requests are answered in order
+  QTcpSocket socket;
+  socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+  socket.write(echoRequest(101) + echoRequest(102) + echoRequest(103));
+
+  QByteArray responses;
+  timer.restart();
+  while (responses.count("HTTP/1.1 200 OK") < 3 && timer.elapsed() < 5000)
+    {
+    QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+    responses.append(socket.readAll());
+    }
+
+  const int first = responses.indexOf(">101<");
+  const int second = responses.indexOf(">102<");
+  const int third = responses.indexOf(">103<");
+  if (first < 0 || second < first || third < second)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with pipelined requests - "
+              << responses.constData() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+#include "moc_ctkSimpleSoapServerTest1.cpp"
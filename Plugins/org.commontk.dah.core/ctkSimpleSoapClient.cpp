@@ -21,25 +21,81 @@
 
 #include "ctkSimpleSoapClient.h"
 #include "ctkDicomAppHostingTypes.h"
+#include "ctkSoapHttpMessage_p.h"
 #include "ctkSoapLog.h"
 
 #include <QApplication>
 #include <QCursor>
-#include <QNetworkReply>
-#include <QtSoapHttpTransport>
+#include <QEventLoop>
+#include <QHash>
+#include <QTcpSocket>
+
+#include <qtsoap.h>
 
 //----------------------------------------------------------------------------
 class ctkSimpleSoapClientPrivate
 {
 public:
 
-  QEventLoop BlockingLoop;
-  QtSoapHttpTransport Http;
+  ctkSimpleSoapClientPrivate()
+    : NextRequest(0), NextResponse(0)
+  {}
+
+  /**
+   * Answer the requests left without a response by a fault and wake up
+   * the waiting calls.
+   */
+  void failPending(const QString& reason);
+
+  /**
+   * Wake up the waiting calls to check for their response.
+   */
+  void wakeUp();
+
+  QTcpSocket Socket;
 
   int Port;
   QString Path;
+
+  // The received bytes of the responses not read yet
+  QByteArray Buffer;
+
+  // The tickets of the next request written and of the next response read,
+  // the responses arriving in the order of the requests
+  int NextRequest;
+  int NextResponse;
+  QHash<int, QtSoapMessage> Responses;
+
+  // The event loops of the calls waiting for their response, nested if a
+  // call is made while a message is handled during another call
+  QList<QEventLoop*> WaitingLoops;
+
+  QtSoapMessage Response;
 };
 
+//----------------------------------------------------------------------------
+void ctkSimpleSoapClientPrivate::failPending(const QString& reason)
+{
+  for (; NextResponse < NextRequest; ++NextResponse)
+    {
+    QtSoapMessage fault;
+    fault.setFaultCode(QtSoapMessage::Server);
+    fault.setFaultString(reason);
+    Responses.insert(NextResponse, fault);
+    }
+  Buffer.clear();
+  wakeUp();
+}
+
+//----------------------------------------------------------------------------
+void ctkSimpleSoapClientPrivate::wakeUp()
+{
+  foreach (QEventLoop* loop, WaitingLoops)
+    {
+    loop->exit();
+    }
+}
+
 //----------------------------------------------------------------------------
 ctkSimpleSoapClient::ctkSimpleSoapClient(int port, QString path)
   : d_ptr(new ctkSimpleSoapClientPrivate())
@@ -49,22 +105,85 @@ ctkSimpleSoapClient::ctkSimpleSoapClient(int port, QString path)
   d->Port = port;
   d->Path = path;
 
-  connect(&d->Http, SIGNAL(responseReady()), this, SLOT(responseReady()));
-
-  d->Http.setHost("127.0.0.1", false, port);
+  connect(&d->Socket, SIGNAL(readyRead()), this, SLOT(readResponses()));
+  connect(&d->Socket, SIGNAL(connected()), this, SLOT(connectionOpened()));
+  connect(&d->Socket, SIGNAL(disconnected()), this, SLOT(connectionClosed()));
+  connect(&d->Socket, SIGNAL(error(QAbstractSocket::SocketError)),
+          this, SLOT(connectionFailed(QAbstractSocket::SocketError)));
 }
 
 //----------------------------------------------------------------------------
 ctkSimpleSoapClient::~ctkSimpleSoapClient()
 {
+  Q_D(ctkSimpleSoapClient);
+  d->Socket.disconnect(this);
+}
+
+//----------------------------------------------------------------------------
+void ctkSimpleSoapClient::readResponses()
+{
+  Q_D(ctkSimpleSoapClient);
+
+  d->Buffer.append(d->Socket.readAll());
+  forever
+    {
+    ctkSoapHttpMessage message;
+    ctkSoapHttpMessage::ParseResult result = ctkSoapHttpMessage::take(d->Buffer, &message);
+    if (result == ctkSoapHttpMessage::Incomplete)
+      {
+      break;
+      }
+    if (result == ctkSoapHttpMessage::Malformed)
+      {
+      qCritical() << "ctkSimpleSoapClient: malformed HTTP response";
+      d->Socket.abort();
+      d->failPending("Malformed HTTP response");
+      return;
+      }
+
+    QtSoapMessage response;
+    if (!response.setContent(message.body()))
+      {
+      const QString error = response.errorString();
+      response.clear();
+      response.setFaultCode(QtSoapMessage::Server);
+      response.setFaultString(QString("%1 (%2)").arg(QString(message.startLine())).arg(error));
+      }
+    d->Responses.insert(d->NextResponse++, response);
+
+    if (!message.keepAlive())
+      {
+      d->Socket.disconnectFromHost();
+      }
+    }
+  d->wakeUp();
+}
+
+//----------------------------------------------------------------------------
+void ctkSimpleSoapClient::connectionOpened()
+{
+  Q_D(ctkSimpleSoapClient);
+  // the option only applies to a connected socket
+  d->Socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+}
 
+//----------------------------------------------------------------------------
+void ctkSimpleSoapClient::connectionClosed()
+{
+  Q_D(ctkSimpleSoapClient);
+  d->failPending("The connection to the server was closed");
 }
 
 //----------------------------------------------------------------------------
-void ctkSimpleSoapClient::responseReady()
+void ctkSimpleSoapClient::connectionFailed(QAbstractSocket::SocketError error)
 {
   Q_D(ctkSimpleSoapClient);
-  d->BlockingLoop.exit();
+  Q_UNUSED(error)
+  // a closed connection is handled by connectionClosed()
+  if (d->Socket.state() == QAbstractSocket::UnconnectedState)
+    {
+    d->failPending(d->Socket.errorString());
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -88,8 +207,6 @@ const QtSoapType & ctkSimpleSoapClient::submitSoapRequest(const QString& methodN
   d->Http.setAction(action);*/
   QString action = "http://dicom.nema.org/PS3.19/IHostService/" + methodName;
 
-  d->Http.setAction(action);
-
   CTK_SOAP_LOG( << "Submitting action " << action
                 << " method " << methodName
                 << " to path " << d->Path );
@@ -110,19 +227,51 @@ const QtSoapType & ctkSimpleSoapClient::submitSoapRequest(const QString& methodN
   CTK_SOAP_LOG_LOWLEVEL( << "Submitting request " << methodName);
   CTK_SOAP_LOG_LOWLEVEL( << request.toXmlString());
 
-  d->Http.submitRequest(request, d->Path);;
+  const QByteArray body = request.toXmlString().toUtf8();
+  QByteArray block;
+  block.append("POST ").append(d->Path.toUtf8()).append(" HTTP/1.1\r\n");
+  block.append("Host: 127.0.0.1:").append(QByteArray::number(d->Port)).append("\r\n");
+  block.append("Content-Type: text/xml;charset=utf-8\r\n");
+  block.append("SOAPAction: ").append(action.toUtf8()).append("\r\n");
+  block.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+  block.append("\r\n");
+  block.append(body);
+
+  // The connection is kept open between the requests. A connection the
+  // server asked to close is finished first, the requests still pending on
+  // it are failed before this one gets its ticket.
+  if (d->Socket.state() == QAbstractSocket::ClosingState
+      && !d->Socket.waitForDisconnected())
+    {
+    d->Socket.abort();
+    }
+  const int ticket = d->NextRequest++;
+  if (d->Socket.state() == QAbstractSocket::UnconnectedState)
+    {
+    d->Buffer.clear();
+    d->Socket.connectToHost("127.0.0.1", d->Port);
+    }
+  if (!d->Responses.contains(ticket))
+    {
+    d->Socket.write(block);
+    }
 
   CTK_SOAP_LOG_LOWLEVEL( << "Submitted request " << methodName);
 
   QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-  d->BlockingLoop.exec(QEventLoop::ExcludeUserInputEvents | QEventLoop::WaitForMoreEvents);
+  QEventLoop blockingLoop;
+  d->WaitingLoops.push_back(&blockingLoop);
+  while (!d->Responses.contains(ticket))
+    {
+    blockingLoop.exec(QEventLoop::ExcludeUserInputEvents | QEventLoop::WaitForMoreEvents);
+    }
+  d->WaitingLoops.removeOne(&blockingLoop);
 
   QApplication::restoreOverrideCursor();
 
-  //qDebug() << "Reply error: " << reply->errorString();
-  //qDebug() << reply->readAll();
-  const QtSoapMessage& response = d->Http.getResponse();
+  d->Response = d->Responses.take(ticket);
+  const QtSoapMessage& response = d->Response;
 
   CTK_SOAP_LOG( << "Got Response." );
 
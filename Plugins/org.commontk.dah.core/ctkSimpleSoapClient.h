@@ -22,6 +22,7 @@
 #ifndef CTKSIMPLESOAPCLIENT_H
 #define CTKSIMPLESOAPCLIENT_H
 
+#include <QAbstractSocket>
 #include <QObject>
 #include <QScopedPointer>
 
@@ -31,6 +32,11 @@
 
 class ctkSimpleSoapClientPrivate;
 
+/**
+ * A blocking client for SOAP calls to a local ctkSimpleSoapServer. The HTTP
+ * connection is kept open between the calls and reopened when the server
+ * closed it.
+ */
 class org_commontk_dah_core_EXPORT ctkSimpleSoapClient : public QObject
 {
   Q_OBJECT
@@ -44,7 +50,10 @@ public:
 
 private Q_SLOTS:
 
-  void responseReady();
+  void readResponses();
+  void connectionOpened();
+  void connectionClosed();
+  void connectionFailed(QAbstractSocket::SocketError error);
 
 private:
 
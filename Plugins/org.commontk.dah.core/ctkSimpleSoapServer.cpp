@@ -22,7 +22,7 @@
 
 #include "ctkSimpleSoapServer.h"
 
-#include "ctkSoapConnectionRunnable_p.h"
+#include "ctkSoapConnection_p.h"
 
 //----------------------------------------------------------------------------
 ctkSimpleSoapServer::ctkSimpleSoapServer(QObject *parent) :
@@ -35,15 +35,21 @@ ctkSimpleSoapServer::ctkSimpleSoapServer(QObject *parent) :
 void ctkSimpleSoapServer::incomingConnection(int socketDescriptor)
 {
   qDebug() << "New incoming connection";
-  ctkSoapConnectionRunnable* runnable = new ctkSoapConnectionRunnable(socketDescriptor);
-
-  connect(runnable, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)),
-          this, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)),
-          Qt::BlockingQueuedConnection);
-
-  connect(runnable, SIGNAL(incomingWSDLMessage(QString,QString*)),
-          this, SIGNAL(incomingWSDLMessage(QString,QString*)),
-          Qt::BlockingQueuedConnection);
-
-  QThreadPool::globalInstance()->start(runnable);
+  QTcpSocket* socket = new QTcpSocket;
+  if (!socket->setSocketDescriptor(socketDescriptor))
+    {
+    qCritical() << "Accepting the connection failed:" << socket->errorString();
+    delete socket;
+    return;
+    }
+
+  // The connection is served by the event loop of the server thread, the
+  // thread in which the messages were always handled.
+  ctkSoapConnection* connection = new ctkSoapConnection(socket, this);
+
+  connect(connection, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)),
+          this, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)));
+
+  connect(connection, SIGNAL(incomingWSDLMessage(QString,QString*)),
+          this, SIGNAL(incomingWSDLMessage(QString,QString*)));
 }
@@ -33,6 +33,12 @@
 #include <org_commontk_dah_core_Export.h>
 #include <ctkDicomAppHostingTypes.h>
 
+/**
+ * An HTTP/1.1 server for SOAP messages. Connections are kept alive and
+ * served by the event loop of the thread of the server, which is also the
+ * thread the signals are emitted in. The receivers answer the messages by
+ * setting the reply.
+ */
 class org_commontk_dah_core_EXPORT ctkSimpleSoapServer : public QTcpServer
 {
   Q_OBJECT
@@ -0,0 +1,169 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+// CTK includes
+#include "ctkSoapConnection_p.h"
+#include "ctkSoapHttpMessage_p.h"
+#include "ctkSoapLog.h"
+
+//----------------------------------------------------------------------------
+ctkSoapConnection::ctkSoapConnection(QTcpSocket* socket, QObject* parent)
+  : QObject(parent), Socket(socket), Processing(false), Closed(false)
+{
+  Socket->setParent(this);
+  // the messages are small, do not delay them to coalesce segments
+  Socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+  connect(Socket, SIGNAL(readyRead()), this, SLOT(readRequests()));
+  connect(Socket, SIGNAL(disconnected()), this, SLOT(closed()));
+}
+
+//----------------------------------------------------------------------------
+void ctkSoapConnection::readRequests()
+{
+  if (Processing)
+    {
+    // read by the call below when the handler returns
+    return;
+    }
+
+  Processing = true;
+  bool keepAlive = true;
+  while (keepAlive && !Closed)
+    {
+    Buffer.append(Socket->readAll());
+
+    ctkSoapHttpMessage request;
+    ctkSoapHttpMessage::ParseResult result = ctkSoapHttpMessage::take(Buffer, &request);
+    if (result == ctkSoapHttpMessage::Incomplete)
+      {
+      break;
+      }
+    if (result == ctkSoapHttpMessage::Malformed)
+      {
+      qCritical() << "Malformed HTTP request, closing the connection";
+      writeResponse("400 Bad Request", QByteArray(), true);
+      break;
+      }
+
+    CTK_SOAP_LOG_LOWLEVEL( << request.startLine() );
+    keepAlive = processRequest(request);
+    }
+  Processing = false;
+
+  if (Closed)
+    {
+    deleteLater();
+    }
+}
+
+//----------------------------------------------------------------------------
+bool ctkSoapConnection::processRequest(const ctkSoapHttpMessage& request)
+{
+  const bool keepAlive = request.keepAlive();
+
+  QString requestType;
+  if (request.target().contains("?wsdl"))
+    {
+    requestType = "?wsdl";
+    }
+  else if (request.target().contains("?xsd=1"))
+    {
+    requestType = "?xsd=1";
+    }
+
+  QByteArray status("200 OK");
+  QString content;
+  if (!requestType.isEmpty())
+    {
+    emit incomingWSDLMessage(requestType, &content);
+    }
+  else if (!request.body().trimmed().isEmpty())
+    {
+    // The http body contains the soap message
+    CTK_SOAP_LOG_LOWLEVEL( << request.body() );
+    QtSoapMessage msg;
+    if (!msg.setContent(request.body()))
+      {
+      qCritical() << "QtSoap import failed:" << msg.errorString();
+      writeResponse("400 Bad Request", QByteArray(), !keepAlive);
+      return keepAlive;
+      }
+
+    QtSoapMessage reply;
+    CTK_SOAP_LOG(<< "###################" << msg.toXmlString());
+    emit incomingSoapMessage(msg, &reply);
+
+    if (reply.isFault())
+      {
+      qCritical() << "QtSoap reply faulty";
+      status = "500 Internal Server Error";
+      }
+
+    CTK_SOAP_LOG_LOWLEVEL( << "SOAP reply:" );
+
+    content = reply.toXmlString();
+    }
+
+  writeResponse(status, content.toUtf8(), !keepAlive);
+  return keepAlive;
+}
+
+//----------------------------------------------------------------------------
+void ctkSoapConnection::writeResponse(const QByteArray& status, const QByteArray& content, bool close)
+{
+  if (Closed)
+    {
+    return;
+    }
+
+  QByteArray block;
+  block.append("HTTP/1.1 ").append(status).append("\r\n");
+  block.append("Content-Type: text/xml;charset=utf-8\r\n");
+  block.append("Content-Length: ").append(QByteArray::number(content.size())).append("\r\n");
+  if (close)
+    {
+    block.append("Connection: close\r\n");
+    }
+  block.append("\r\n");
+
+  block.append(content);
+
+  CTK_SOAP_LOG_LOWLEVEL( << block );
+
+  Socket->write(block);
+  if (close)
+    {
+    // closes the connection once the response is written
+    Socket->disconnectFromHost();
+    }
+}
+
+//----------------------------------------------------------------------------
+void ctkSoapConnection::closed()
+{
+  Closed = true;
+  if (!Processing)
+    {
+    deleteLater();
+    }
+}
@@ -0,0 +1,80 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+
+#ifndef CTKSOAPCONNECTION_P_H
+#define CTKSOAPCONNECTION_P_H
+
+#include <QObject>
+#include <QTcpSocket>
+
+#include <qtsoap.h>
+
+class ctkSoapHttpMessage;
+
+/**
+ * A connection accepted by the ctkSimpleSoapServer. The requests are read
+ * when the socket signals new data, in the thread of the server, so no
+ * thread is blocked by an idle connection. The connection stays open for
+ * further requests unless the client asks to close it, and pipelined
+ * requests are answered in the order they were received.
+ */
+class ctkSoapConnection : public QObject
+{
+  Q_OBJECT
+
+public:
+
+  ctkSoapConnection(QTcpSocket* socket, QObject* parent = 0);
+
+Q_SIGNALS:
+
+  void incomingSoapMessage(const QtSoapMessage& message, QtSoapMessage* reply);
+  void incomingWSDLMessage(const QString& message, QString* reply);
+
+private Q_SLOTS:
+
+  void readRequests();
+  void closed();
+
+private:
+
+  /**
+   * Answer a request, returning false if the connection is to be closed.
+   */
+  bool processRequest(const ctkSoapHttpMessage& request);
+
+  void writeResponse(const QByteArray& status, const QByteArray& content, bool close);
+
+  QTcpSocket* Socket;
+
+  // The received bytes of the requests not processed yet
+  QByteArray Buffer;
+
+  // A handler may run a nested event loop, in which the socket signals
+  // are ignored until it returns
+  bool Processing;
+  bool Closed;
+
+};
+
+#endif // CTKSOAPCONNECTION_P_H
@@ -0,0 +1,134 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkSoapHttpMessage_p.h"
+
+//----------------------------------------------------------------------------
+ctkSoapHttpMessage::ParseResult ctkSoapHttpMessage::take(QByteArray& buffer, ctkSoapHttpMessage* message)
+{
+  int headerEnd = buffer.indexOf("\r\n\r\n");
+  int separatorSize = 4;
+  const int bareEnd = buffer.indexOf("\n\n");
+  if (bareEnd >= 0 && (headerEnd < 0 || bareEnd < headerEnd))
+    {
+    headerEnd = bareEnd;
+    separatorSize = 2;
+    }
+  if (headerEnd < 0)
+    {
+    return buffer.size() > MAX_HEADER_SIZE ? Malformed : Incomplete;
+    }
+
+  QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+  QList<QByteArray> startLine = lines.takeFirst().trimmed().split(' ');
+  startLine.removeAll(QByteArray());
+  if (startLine.size() < 2)
+    {
+    return Malformed;
+    }
+
+  QHash<QByteArray, QByteArray> headers;
+  foreach (QByteArray line, lines)
+    {
+    const int colon = line.indexOf(':');
+    if (colon > 0)
+      {
+      headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+      }
+    }
+
+  if (headers.value("transfer-encoding").toLower() == "chunked")
+    {
+    return Malformed;
+    }
+  bool ok = true;
+  const QByteArray contentLengthValue = headers.value("content-length", "0");
+  const int contentLength = contentLengthValue.toInt(&ok);
+  if (!ok || contentLength < 0)
+    {
+    return Malformed;
+    }
+
+  const int bodyStart = headerEnd + separatorSize;
+  if (buffer.size() - bodyStart < contentLength)
+    {
+    return Incomplete;
+    }
+
+  message->StartLine = startLine;
+  message->Headers = headers;
+  message->Body = buffer.mid(bodyStart, contentLength);
+  buffer.remove(0, bodyStart + contentLength);
+  return Complete;
+}
+
+//----------------------------------------------------------------------------
+QByteArray ctkSoapHttpMessage::startLine() const
+{
+  QByteArray line;
+  foreach (QByteArray token, StartLine)
+    {
+    if (!line.isEmpty()) line.append(' ');
+    line.append(token);
+    }
+  return line;
+}
+
+//----------------------------------------------------------------------------
+QByteArray ctkSoapHttpMessage::target() const
+{
+  return StartLine.value(1);
+}
+
+//----------------------------------------------------------------------------
+int ctkSoapHttpMessage::statusCode() const
+{
+  return StartLine.value(1).toInt();
+}
+
+//----------------------------------------------------------------------------
+QByteArray ctkSoapHttpMessage::header(const QByteArray& name) const
+{
+  return Headers.value(name.toLower());
+}
+
+//----------------------------------------------------------------------------
+bool ctkSoapHttpMessage::keepAlive() const
+{
+  const QByteArray connection = header("connection").toLower();
+  if (connection == "close")
+    {
+    return false;
+    }
+  if (connection == "keep-alive")
+    {
+    return true;
+    }
+  // the version is the last token of a request line, the first of a status line
+  return StartLine.first() == "HTTP/1.1" || StartLine.last() == "HTTP/1.1";
+}
+
+//----------------------------------------------------------------------------
+QByteArray ctkSoapHttpMessage::body() const
+{
+  return Body;
+}
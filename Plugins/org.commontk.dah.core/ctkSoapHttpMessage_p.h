@@ -0,0 +1,93 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+
+#ifndef CTKSOAPHTTPMESSAGE_P_H
+#define CTKSOAPHTTPMESSAGE_P_H
+
+#include <QByteArray>
+#include <QHash>
+
+/**
+ * An HTTP/1.1 request or response carrying a SOAP message, as read by the
+ * ctkSimpleSoapServer and the ctkSimpleSoapClient from their connections.
+ * Only messages with a <code>Content-Length</code> are supported, which
+ * is what both sides send.
+ */
+class ctkSoapHttpMessage
+{
+
+public:
+
+  enum ParseResult
+  {
+    Incomplete,
+    Complete,
+    Malformed
+  };
+
+  /**
+   * Remove the first message from the buffer if it has been received
+   * completely. Bare line feeds are accepted as line ends.
+   */
+  static ParseResult take(QByteArray& buffer, ctkSoapHttpMessage* message);
+
+  /**
+   * The request line or the status line.
+   */
+  QByteArray startLine() const;
+
+  /**
+   * The request target, the second token of a request line.
+   */
+  QByteArray target() const;
+
+  /**
+   * The status code of a response.
+   */
+  int statusCode() const;
+
+  /**
+   * The value of a header, the name being case insensitive.
+   */
+  QByteArray header(const QByteArray& name) const;
+
+  /**
+   * Whether the connection stays open after this message: HTTP/1.1
+   * connections do unless <code>Connection: close</code> is sent.
+   */
+  bool keepAlive() const;
+
+  QByteArray body() const;
+
+private:
+
+  /** The largest header accepted, protecting against garbage. */
+  static const int MAX_HEADER_SIZE = 64 * 1024;
+
+  QList<QByteArray> StartLine;
+  QHash<QByteArray, QByteArray> Headers;
+  QByteArray Body;
+
+};
+
+#endif // CTKSOAPHTTPMESSAGE_P_H
@@ -0,0 +1,314 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include <QCoreApplication>
+#include <QList>
+#include <QStringList>
+#include <QThread>
+#include <QTime>
+
+#include "util/ctkEALeastRecentlyUsedCacheMap_p.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+typedef ctkEALeastRecentlyUsedCacheMap<int, int> IntCache;
+typedef ctkEALeastRecentlyUsedCacheMap<QString, QString> StringCache;
+
+int failures = 0;
+
+//----------------------------------------------------------------------------
+void check(bool condition, const char* message)
+{
+  if (!condition)
+  {
+    std::cerr << "Failed: " << message << std::endl;
+    ++failures;
+  }
+}
+
+//----------------------------------------------------------------------------
+void testEvictionOrder()
+{
+  IntCache cache(3);
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+  cache.insert(3, 30);
+  // a hit makes 1 the most recently used entry: 2, 3, 1
+  check(cache.value(1) == 10, "hit");
+  // 2 is dropped: 3, 1, 4
+  cache.insert(4, 40);
+  // updating a value makes the key the most recently used entry: 1, 4, 3
+  cache.insert(3, 31);
+  // 1 is dropped: 4, 3, 5
+  cache.insert(5, 50);
+
+  check(cache.size() == 3, "size after evictions");
+  check(cache.value(1, -1) == -1, "1 evicted");
+  check(cache.value(2, -1) == -1, "2 evicted");
+  check(cache.value(4) == 40, "4 kept");
+  check(cache.value(3) == 31, "3 updated");
+  check(cache.value(5) == 50, "5 kept");
+
+  check(cache.remove(4) == 40, "remove returns the value");
+  check(cache.remove(4) == 0, "remove of a missing key");
+  check(cache.size() == 2, "size after remove");
+
+  // the removed entry is not dropped again: 3, 5, 6, 7 drops 3 only
+  cache.insert(6, 60);
+  cache.insert(7, 70);
+  check(cache.size() == 3, "size after remove and inserts");
+  check(cache.value(3, -1) == -1, "3 evicted after remove");
+
+  cache.clear();
+  check(cache.size() == 0, "size after clear");
+  check(cache.value(5, -1) == -1, "value after clear");
+  cache.insert(8, 80);
+  check(cache.value(8) == 80, "insert after clear");
+}
+
+//----------------------------------------------------------------------------
+// Compare the cache with the list based implementation it replaces
+void testAgainstHistoryList()
+{
+  const int maxSize = 16;
+  IntCache cache(maxSize);
+  QHash<int, int> values;
+  QList<int> history;
+
+  qsrand(42);
+  for (int i = 0; i < 100000; ++i)
+  {
+    int key = qrand() % 64;
+    switch (qrand() % 3)
+    {
+    case 0:
+    {
+      int expected = values.value(key, -1);
+      if (values.contains(key))
+      {
+        history.removeAll(key);
+        history.push_back(key);
+      }
+      if (cache.value(key, -1) != expected)
+      {
+        check(false, "value differs from the history list");
+        return;
+      }
+      break;
+    }
+    case 1:
+      history.removeAll(key);
+      values.insert(key, i);
+      history.push_back(key);
+      if (maxSize < values.size())
+      {
+        values.remove(history.takeFirst());
+      }
+      cache.insert(key, i);
+      break;
+    default:
+      history.removeAll(key);
+      if (cache.remove(key) != values.take(key))
+      {
+        check(false, "remove differs from the history list");
+        return;
+      }
+      break;
+    }
+    if (cache.size() != values.size())
+    {
+      check(false, "size differs from the history list");
+      return;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void testShards()
+{
+  // integers hash to themselves, key % 4 is the shard of 16 entries
+  IntCache cache(64, 4);
+  for (int key = 0; key < 1000; ++key)
+  {
+    cache.insert(key, key);
+  }
+  check(cache.size() == 64, "sharded size");
+  check(cache.value(935, -1) == -1, "sharded eviction");
+  bool kept = true;
+  for (int key = 936; key < 1000; ++key)
+  {
+    kept = kept && cache.value(key, -1) == key;
+  }
+  check(kept, "sharded entries kept");
+
+  // the shards share the remainder of the size
+  IntCache unevenCache(10, 4);
+  for (int key = 0; key < 100; ++key)
+  {
+    unevenCache.insert(key, key);
+  }
+  check(unevenCache.size() == 10, "uneven sharded size");
+
+  int exceptions = 0;
+  try { IntCache invalid(0); } catch (const ctkInvalidArgumentException&) { ++exceptions; }
+  try { IntCache invalid(4, 0); } catch (const ctkInvalidArgumentException&) { ++exceptions; }
+  try { IntCache invalid(4, 5); } catch (const ctkInvalidArgumentException&) { ++exceptions; }
+  check(exceptions == 3, "invalid sizes");
+}
+
+//----------------------------------------------------------------------------
+// Looks up filter strings in a shared cache, like concurrent publishers.
+class LookupThread : public QThread
+{
+public:
+
+  LookupThread(StringCache* cache, const QStringList& keys, int lookups)
+    : cache(cache), keys(keys), lookups(lookups), misses(0)
+  {
+  }
+
+  void run()
+  {
+    for (int i = 0; i < lookups; ++i)
+    {
+      const QString& key = keys.at((i * 7) % keys.size());
+      if (cache->value(key).isNull())
+      {
+        cache->insert(key, key);
+        ++misses;
+      }
+    }
+  }
+
+  StringCache* cache;
+  QStringList keys;
+  int lookups;
+  int misses;
+};
+
+//----------------------------------------------------------------------------
+QStringList filterKeys(int count)
+{
+  QStringList keys;
+  for (int i = 0; i < count; ++i)
+  {
+    keys << QString("(&(event.topics=org/commontk/topic%1/*)(index<%2))").arg(i).arg(i % 10);
+  }
+  return keys;
+}
+
+//----------------------------------------------------------------------------
+int runThreads(int maxSize, int shards, int threadCount, int lookups)
+{
+  StringCache cache(maxSize, shards);
+  QStringList keys = filterKeys(maxSize / 2);
+  QList<LookupThread*> threads;
+  for (int i = 0; i < threadCount; ++i)
+  {
+    threads << new LookupThread(&cache, keys, lookups);
+  }
+
+  QTime timer;
+  timer.start();
+  foreach (LookupThread* thread, threads)
+  {
+    thread->start();
+  }
+  foreach (LookupThread* thread, threads)
+  {
+    thread->wait();
+  }
+  int elapsed = timer.elapsed();
+  qDeleteAll(threads);
+  return elapsed;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Checks the eviction order of the cache, then reports the time of cache
+// hits and of inserts evicting entries for growing cache sizes, which
+// should not depend on the size, and the time of concurrent lookups
+// with and without shards. The number of operations can be given on
+// the command line.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  int iterations = argc > 1 ? QString(argv[1]).toInt() : 200000;
+
+  testEvictionOrder();
+  testAgainstHistoryList();
+  testShards();
+  if (failures > 0)
+  {
+    return EXIT_FAILURE;
+  }
+
+  QList<int> sizes;
+  sizes << 30 << 1000 << 30000;
+  foreach (int size, sizes)
+  {
+    StringCache cache(size);
+    QStringList keys = filterKeys(2 * size);
+    for (int i = 0; i < size; ++i)
+    {
+      cache.insert(keys.at(i), keys.at(i));
+    }
+
+    QTime timer;
+    int hits = 0;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+    {
+      hits += !cache.value(keys.at(i % size)).isNull();
+    }
+    int hitTime = timer.elapsed();
+
+    // cycling through twice as many keys, each insert evicts the least
+    // recently used entry
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+    {
+      const QString& key = keys.at((size + i) % keys.size());
+      cache.insert(key, key);
+    }
+    int insertTime = timer.elapsed();
+
+    check(hits == iterations, "hits");
+    check(cache.size() == size, "size after inserts");
+    std::cout << "size " << size << ": " << iterations << " hits " << hitTime
+              << " ms, " << iterations << " inserts " << insertTime << " ms" << std::endl;
+  }
+
+  int threadCount = qMax(2, QThread::idealThreadCount());
+  int lockedTime = runThreads(256, 1, threadCount, iterations);
+  int shardedTime = runThreads(256, 16, threadCount, iterations);
+  std::cout << threadCount << " threads, " << iterations << " lookups each: 1 shard "
+            << lockedTime << " ms, 16 shards " << shardedTime << " ms" << std::endl;
+
+  return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include <QCoreApplication>
+#include <QTime>
+
+#include <ctkPluginContext.h>
+#include <ctkServiceRegistration.h>
+#include <service/event/ctkEventAdmin.h>
+#include <service/event/ctkEventConstants.h>
+
+#include "ctkEventAdminBenchmarkFramework_p.h"
+#include "ctkEventAdminBenchmarkHandler_p.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+const int Topics = 100;
+
+//----------------------------------------------------------------------------
+// Subscriptions: a fourth of the handlers for a single topic, a fourth
+// for all bench topics, a fourth for topics which are never sent and
+// a fourth for all topics with an event filter.
+ctkDictionary handlerProperties(int handler)
+{
+  ctkDictionary props;
+  switch (handler % 4)
+  {
+  case 0:
+    props.insert(ctkEventConstants::EVENT_TOPIC, QString("org/commontk/bench/topic%1").arg(handler % Topics));
+    break;
+  case 1:
+    props.insert(ctkEventConstants::EVENT_TOPIC, QString("org/commontk/bench/*"));
+    break;
+  case 2:
+    props.insert(ctkEventConstants::EVENT_TOPIC, QString("org/commontk/other/topic%1").arg(handler));
+    break;
+  default:
+    props.insert(ctkEventConstants::EVENT_TOPIC, QString("org/commontk/*"));
+    props.insert(ctkEventConstants::EVENT_FILTER, QString("(index<5)"));
+    break;
+  }
+  return props;
+}
+
+//----------------------------------------------------------------------------
+ctkEvent createEvent(int event)
+{
+  ctkDictionary props;
+  props.insert("index", event % 10);
+  return ctkEvent(QString("org/commontk/bench/topic%1").arg(event % Topics), props);
+}
+
+//----------------------------------------------------------------------------
+bool receives(int handler, int event)
+{
+  switch (handler % 4)
+  {
+  case 0: return handler % Topics == event % Topics;
+  case 1: return true;
+  case 2: return false;
+  default: return event % 10 < 5;
+  }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Number of events per second sent to 10, 100 and 1000 event handlers
+// subscribed to various topics, the handlers being called without a
+// timeout. The duration of each run in ms can be given on the command line.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  int duration = argc > 1 ? QString(argv[1]).toInt() : 1000;
+
+  ctkEventAdminBenchmarkFramework framework("ctkEventAdminBenchmark");
+  ctkPluginContext* context = framework.getPluginContext();
+  ctkEventAdmin* admin = framework.getEventAdmin();
+  if (admin == 0) return EXIT_FAILURE;
+
+  int result = EXIT_SUCCESS;
+  QList<int> handlerCounts;
+  handlerCounts << 10 << 100 << 1000;
+  foreach (int handlerCount, handlerCounts)
+  {
+    QList<ctkEventAdminBenchmarkHandler*> handlers;
+    QList<ctkServiceRegistration> registrations;
+    for (int i = 0; i < handlerCount; ++i)
+    {
+      handlers << new ctkEventAdminBenchmarkHandler;
+      registrations << context->registerService<ctkEventHandler>(handlers.back(), handlerProperties(i));
+    }
+
+    QTime timer;
+    timer.start();
+    int events = 0;
+    while (timer.elapsed() < duration)
+    {
+      for (int i = 0; i < 10; ++i, ++events)
+      {
+        admin->sendEvent(createEvent(events));
+      }
+    }
+    int elapsed = qMax(1, timer.elapsed());
+
+    // every handler received the events it subscribed to, and no
+    // unregistered handler receives events
+    int failures = 0;
+    qint64 deliveries = 0;
+    foreach (ctkServiceRegistration registration, registrations)
+    {
+      registration.unregister();
+    }
+    admin->sendEvent(createEvent(0));
+    for (int i = 0; i < handlerCount; ++i)
+    {
+      int expected = 0;
+      for (int event = 0; event < events; ++event)
+      {
+        expected += receives(i, event);
+      }
+      if (handlers[i]->events != expected)
+      {
+        ++failures;
+      }
+      deliveries += expected;
+    }
+    qDeleteAll(handlers);
+
+    std::cout << handlerCount << " handlers: " << (events * 1000LL / elapsed)
+              << " events/s, " << (deliveries * 1000LL / elapsed)
+              << " deliveries/s" << std::endl;
+    if (failures > 0)
+    {
+      std::cerr << failures << " handlers did not receive the expected events" << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,119 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEventAdminBenchmarkFramework_p.h"
+
+#include <QDir>
+#include <QUrl>
+
+#include <ctkConfig.h>
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <ctkPluginException.h>
+#include <ctkPluginFramework.h>
+#include <ctkPluginFrameworkFactory.h>
+#include <ctkPluginFrameworkLauncher.h>
+#include <service/event/ctkEventAdmin.h>
+
+#include <iostream>
+
+//----------------------------------------------------------------------------
+ctkEventAdminBenchmarkFramework::ctkEventAdminBenchmarkFramework(const QString& name,
+                                                                 const ctkProperties& properties)
+  : context(0), admin(0)
+{
+  QString pluginDir;
+#ifdef CMAKE_INTDIR
+  pluginDir = CTK_PLUGIN_DIR CMAKE_INTDIR "/";
+#else
+  pluginDir = CTK_PLUGIN_DIR;
+#endif
+  ctkPluginFrameworkLauncher::addSearchPath(pluginDir);
+
+  ctkProperties fwProps;
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE, QDir::temp().filePath(name));
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN, ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT);
+  fwProps.insert("org.commontk.eventadmin.Timeout", 0);
+  for (ctkProperties::const_iterator it = properties.begin(); it != properties.end(); ++it)
+  {
+    fwProps.insert(it.key(), it.value());
+  }
+  factory.reset(new ctkPluginFrameworkFactory(fwProps));
+  framework = factory->getFramework();
+
+  try
+  {
+    framework->init();
+    framework->start();
+    context = framework->getPluginContext();
+
+    QString pluginPath = ctkPluginFrameworkLauncher::getPluginPath("org.commontk.eventadmin");
+    if (pluginPath.isEmpty())
+    {
+      std::cerr << "Could not find the event admin plugin in " << qPrintable(pluginDir) << std::endl;
+      return;
+    }
+    context->installPlugin(QUrl::fromLocalFile(pluginPath))->start();
+  }
+  catch (const ctkPluginException& e)
+  {
+    std::cerr << qPrintable(e.message()) << std::endl;
+    return;
+  }
+
+  adminRef = context->getServiceReference<ctkEventAdmin>();
+  admin = adminRef ? context->getService<ctkEventAdmin>(adminRef) : 0;
+  if (admin == 0)
+  {
+    std::cerr << "No event admin service" << std::endl;
+  }
+}
+
+//----------------------------------------------------------------------------
+ctkEventAdminBenchmarkFramework::~ctkEventAdminBenchmarkFramework()
+{
+  if (admin)
+  {
+    context->ungetService(adminRef);
+  }
+  try
+  {
+    framework->stop();
+    framework->waitForStop(5000);
+  }
+  catch (const ctkPluginException& e)
+  {
+    std::cerr << qPrintable(e.message()) << std::endl;
+  }
+}
+
+//----------------------------------------------------------------------------
+ctkEventAdmin* ctkEventAdminBenchmarkFramework::getEventAdmin() const
+{
+  return admin;
+}
+
+//----------------------------------------------------------------------------
+ctkPluginContext* ctkEventAdminBenchmarkFramework::getPluginContext() const
+{
+  return context;
+}
@@ -0,0 +1,80 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEVENTADMINBENCHMARKFRAMEWORK_P_H
+#define CTKEVENTADMINBENCHMARKFRAMEWORK_P_H
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+#include <ctkPluginFramework_global.h>
+#include <ctkServiceReference.h>
+
+class ctkPluginContext;
+class ctkPluginFramework;
+class ctkPluginFrameworkFactory;
+struct ctkEventAdmin;
+
+/**
+ * A plugin framework running the event admin plugin of the build tree
+ * for a benchmark, its storage being in the temporary directory.
+ */
+class ctkEventAdminBenchmarkFramework
+{
+
+public:
+
+  /**
+   * Starts the framework and the event admin plugin. The handlers are
+   * called without a timeout, unless \a properties sets one.
+   *
+   * @param name The name of the framework storage directory.
+   * @param properties Additional framework properties.
+   */
+  ctkEventAdminBenchmarkFramework(const QString& name,
+                                  const ctkProperties& properties = ctkProperties());
+
+  /**
+   * Releases the event admin service and stops the framework.
+   */
+  ~ctkEventAdminBenchmarkFramework();
+
+  /**
+   * The event admin service, or 0 if the event admin plugin could not
+   * be started. The reason was then printed.
+   */
+  ctkEventAdmin* getEventAdmin() const;
+
+  ctkPluginContext* getPluginContext() const;
+
+private:
+
+  QScopedPointer<ctkPluginFrameworkFactory> factory;
+  QSharedPointer<ctkPluginFramework> framework;
+  ctkPluginContext* context;
+  ctkServiceReference adminRef;
+  ctkEventAdmin* admin;
+
+  Q_DISABLE_COPY(ctkEventAdminBenchmarkFramework)
+};
+
+#endif // CTKEVENTADMINBENCHMARKFRAMEWORK_P_H
@@ -0,0 +1,107 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEVENTADMINBENCHMARKHANDLER_P_H
+#define CTKEVENTADMINBENCHMARKHANDLER_P_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+
+#include <service/event/ctkEventHandler.h>
+
+/**
+ * An event handler counting the events it receives, optionally taking
+ * some time to handle each of them.
+ */
+class ctkEventAdminBenchmarkHandler : public QObject, public ctkEventHandler
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkEventHandler)
+
+public:
+
+  ctkEventAdminBenchmarkHandler(int delay = 0)
+    : events(0), delay(delay)
+  {
+  }
+
+  void handleEvent(const ctkEvent& /*event*/)
+  {
+    events.fetchAndAddOrdered(1);
+    if (delay > 0)
+    {
+      QMutex mutex;
+      QWaitCondition sleep;
+      QMutexLocker l(&mutex);
+      sleep.wait(&mutex, delay);
+    }
+  }
+
+  QAtomicInt events;
+
+  const int delay;
+};
+
+/**
+ * An event handler checking that the events of each publisher are
+ * received in the order they were posted, the events carrying the
+ * "publisher" and "sequence" properties.
+ */
+class ctkEventAdminOrderingHandler : public QObject, public ctkEventHandler
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkEventHandler)
+
+public:
+
+  ctkEventAdminOrderingHandler()
+    : events(0), outOfOrder(0)
+  {
+  }
+
+  void handleEvent(const ctkEvent& event)
+  {
+    const int publisher = event.getProperty("publisher").toInt();
+    const int sequence = event.getProperty("sequence").toInt();
+    {
+      QMutexLocker l(&mutex);
+      if (sequence != lastSequence.value(publisher, -1) + 1)
+      {
+        outOfOrder.ref();
+      }
+      lastSequence.insert(publisher, sequence);
+    }
+    events.ref();
+  }
+
+  QAtomicInt events;
+  QAtomicInt outOfOrder;
+
+private:
+
+  QMutex mutex;
+  QHash<int, int> lastSequence;
+};
+
+#endif // CTKEVENTADMINBENCHMARKHANDLER_P_H
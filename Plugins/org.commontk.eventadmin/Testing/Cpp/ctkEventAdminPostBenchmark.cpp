@@ -0,0 +1,171 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QThread>
+#include <QTime>
+#include <QWaitCondition>
+
+#include <ctkPluginContext.h>
+#include <ctkServiceRegistration.h>
+#include <service/event/ctkEventAdmin.h>
+#include <service/event/ctkEventConstants.h>
+
+#include "ctkEventAdminBenchmarkFramework_p.h"
+#include "ctkEventAdminBenchmarkHandler_p.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+const int Publishers = 16;
+const int Handlers = 4;
+
+//----------------------------------------------------------------------------
+class Publisher : public QThread
+{
+public:
+
+  Publisher(ctkEventAdmin* admin, int publisher, int events)
+    : admin(admin), publisher(publisher), events(events)
+  {
+  }
+
+  void run()
+  {
+    for (int i = 0; i < events; ++i)
+    {
+      ctkDictionary props;
+      props.insert("publisher", publisher);
+      props.insert("sequence", i);
+      admin->postEvent(ctkEvent("org/commontk/bench/post", props));
+    }
+  }
+
+private:
+
+  ctkEventAdmin* admin;
+  const int publisher;
+  const int events;
+};
+
+//----------------------------------------------------------------------------
+void sleep(int msecs)
+{
+  QMutex mutex;
+  QWaitCondition condition;
+  QMutexLocker l(&mutex);
+  condition.wait(&mutex, msecs);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Bursts of events posted by many threads at once, checking that every
+// handler receives the events of each publisher in the order they were
+// posted. The number of events per publisher can be given on the command line.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  int events = argc > 1 ? QString(argv[1]).toInt() : 5000;
+
+  ctkEventAdminBenchmarkFramework framework("ctkEventAdminPostBenchmark");
+  ctkPluginContext* context = framework.getPluginContext();
+  ctkEventAdmin* admin = framework.getEventAdmin();
+  if (admin == 0) return EXIT_FAILURE;
+
+  ctkDictionary props;
+  props.insert(ctkEventConstants::EVENT_TOPIC, QString("org/commontk/bench/post"));
+  QList<ctkEventAdminOrderingHandler*> handlers;
+  QList<ctkServiceRegistration> registrations;
+  for (int i = 0; i < Handlers; ++i)
+  {
+    handlers << new ctkEventAdminOrderingHandler;
+    registrations << context->registerService<ctkEventHandler>(handlers.back(), props);
+  }
+
+  QList<Publisher*> publishers;
+  for (int i = 0; i < Publishers; ++i)
+  {
+    publishers << new Publisher(admin, i, events);
+  }
+
+  QTime timer;
+  timer.start();
+  foreach (Publisher* publisher, publishers)
+  {
+    publisher->start();
+  }
+  foreach (Publisher* publisher, publishers)
+  {
+    publisher->wait();
+  }
+  int posted = qMax(1, timer.elapsed());
+
+  // wait for the delivery of all events, for at most a minute
+  const int expected = Publishers * events;
+  bool delivered = false;
+  while (!delivered && timer.elapsed() < posted + 60000)
+  {
+    delivered = true;
+    foreach (ctkEventAdminOrderingHandler* handler, handlers)
+    {
+      delivered = delivered && handler->events >= expected;
+    }
+    if (!delivered) sleep(10);
+  }
+  int elapsed = qMax(1, timer.elapsed());
+
+  int result = EXIT_SUCCESS;
+  foreach (ctkEventAdminOrderingHandler* handler, handlers)
+  {
+    if (handler->events != expected)
+    {
+      std::cerr << "A handler received " << int(handler->events) << " instead of "
+                << expected << " events" << std::endl;
+      result = EXIT_FAILURE;
+    }
+    if (handler->outOfOrder > 0)
+    {
+      std::cerr << "A handler received " << int(handler->outOfOrder)
+                << " events out of order" << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+
+  std::cout << Publishers << " publishers: " << (expected * 1000LL / posted)
+            << " posts/s, " << (expected * 1000LL / elapsed) << " events/s delivered to "
+            << Handlers << " handlers" << std::endl;
+
+  foreach (ctkServiceRegistration registration, registrations)
+  {
+    registration.unregister();
+  }
+  qDeleteAll(publishers);
+  qDeleteAll(handlers);
+
+  return result;
+}
@@ -0,0 +1,142 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include <QCoreApplication>
+#include <QTime>
+
+#include <ctkPluginContext.h>
+#include <ctkServiceRegistration.h>
+#include <service/event/ctkEventAdmin.h>
+#include <service/event/ctkEventConstants.h>
+
+#include "ctkEventAdminBenchmarkFramework_p.h"
+#include "ctkEventAdminBenchmarkHandler_p.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+const int Handlers = 20;
+const int Timeout = 200;
+const int SlowHandlerDelay = 2 * Timeout;
+
+//----------------------------------------------------------------------------
+ctkDictionary topicProperties()
+{
+  ctkDictionary props;
+  props.insert(ctkEventConstants::EVENT_TOPIC, QString("org/commontk/bench/send"));
+  return props;
+}
+
+//----------------------------------------------------------------------------
+// Measures the sendEvent round-trip latency to Handlers handlers using the
+// timeout, and checks that a handler exceeding the timeout is blacklisted.
+bool benchmark(bool inlineDelivery, int duration)
+{
+  ctkEventAdminBenchmarkHandler slowHandler(SlowHandlerDelay);
+  QList<ctkEventAdminBenchmarkHandler*> handlers;
+
+  ctkProperties fwProps;
+  fwProps.insert("org.commontk.eventadmin.Timeout", Timeout);
+  fwProps.insert("org.commontk.eventadmin.InlineDelivery", inlineDelivery);
+  ctkEventAdminBenchmarkFramework framework("ctkEventAdminSendBenchmark", fwProps);
+  ctkPluginContext* context = framework.getPluginContext();
+  ctkEventAdmin* admin = framework.getEventAdmin();
+  if (admin == 0) return false;
+
+  bool result = true;
+  QList<ctkServiceRegistration> registrations;
+  for (int i = 0; i < Handlers; ++i)
+  {
+    handlers << new ctkEventAdminBenchmarkHandler;
+    registrations << context->registerService<ctkEventHandler>(handlers.back(), topicProperties());
+  }
+
+  ctkEvent event("org/commontk/bench/send");
+  QTime timer;
+  timer.start();
+  int events = 0;
+  while (timer.elapsed() < duration)
+  {
+    for (int i = 0; i < 100; ++i, ++events)
+    {
+      admin->sendEvent(event);
+    }
+  }
+  int elapsed = qMax(1, timer.elapsed());
+
+  foreach (ctkEventAdminBenchmarkHandler* handler, handlers)
+  {
+    if (handler->events != events)
+    {
+      std::cerr << "A handler received " << int(handler->events) << " instead of "
+                << events << " events" << std::endl;
+      result = false;
+    }
+  }
+
+  // The first event waits for the slow handler, at most for the timeout
+  // when the handlers are called from the pool. It is blacklisted and does
+  // not receive the second event anymore.
+  registrations << context->registerService<ctkEventHandler>(&slowHandler, topicProperties());
+  timer.restart();
+  admin->sendEvent(event);
+  int slowElapsed = timer.elapsed();
+  admin->sendEvent(event);
+  if (slowHandler.events != 1)
+  {
+    std::cerr << "The slow handler received " << int(slowHandler.events)
+              << " events instead of being blacklisted" << std::endl;
+    result = false;
+  }
+
+  std::cout << (inlineDelivery ? "inline delivery: " : "pooled delivery: ")
+            << (elapsed * 1000.0 / events) << " us per sendEvent to " << Handlers
+            << " handlers, " << slowElapsed << " ms for a handler taking "
+            << SlowHandlerDelay << " ms" << std::endl;
+
+  foreach (ctkServiceRegistration registration, registrations)
+  {
+    registration.unregister();
+  }
+  qDeleteAll(handlers);
+  return result;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Round-trip latency of sendEvent with the handlers being called from the
+// thread pool and with inline delivery. The duration of each run in ms can
+// be given on the command line.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  int duration = argc > 1 ? QString(argv[1]).toInt() : 1000;
+
+  bool pooled = benchmark(false, duration);
+  bool inlined = benchmark(true, duration);
+  return pooled && inlined ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -41,6 +41,7 @@ const QString ctkEAConfiguration::PROP_THREAD_POOL_SIZE = "org.commontk.eventadm
 const QString ctkEAConfiguration::PROP_TIMEOUT = "org.commontk.eventadmin.Timeout";
 const QString ctkEAConfiguration::PROP_REQUIRE_TOPIC = "org.commontk.eventadmin.RequireTopic";
 const QString ctkEAConfiguration::PROP_IGNORE_TIMEOUT = "org.commontk.eventadmin.IgnoreTimeout";
+const QString ctkEAConfiguration::PROP_INLINE_DELIVERY = "org.commontk.eventadmin.InlineDelivery";
 const QString ctkEAConfiguration::PROP_LOG_LEVEL = "org.commontk.eventadmin.LogLevel";
 
 
@@ -133,6 +134,11 @@ void ctkEAConfiguration::configure(const ctkDictionary& config )
     {
       ignoreTimeout.clear();
     }
+    // Are the EventHandler of synchronous events called in the sending thread? -
+    // The default is false. Setting this value to true avoids handing-off each
+    // event to the synchronous event dispatching thread and each EventHandler
+    // to the thread pool; the timeout is then enforced by a watchdog thread.
+    inlineDelivery = getBoolProperty(pluginContext->getProperty(PROP_INLINE_DELIVERY), false);
     logLevel = getIntProperty(PROP_LOG_LEVEL,
                               pluginContext->getProperty(PROP_LOG_LEVEL),
                               ctkLogService::LOG_WARNING, // default log level is WARNING
@@ -155,6 +161,7 @@ void ctkEAConfiguration::configure(const ctkDictionary& config )
       CTK_WARN(ctkEventAdminActivator::getLogService())
           << "Value for property:" << PROP_IGNORE_TIMEOUT << " cannot be converted to QStringList - Using default";
     }
+    inlineDelivery = getBoolProperty(config.value(PROP_INLINE_DELIVERY), false);
     logLevel = getIntProperty(PROP_LOG_LEVEL,
                               config.value(PROP_LOG_LEVEL),
                               ctkLogService::LOG_WARNING, // default log level is WARNING
@@ -222,15 +229,20 @@ void ctkEAConfiguration::startOrUpdate()
       << PROP_TIMEOUT << "=" << timeout;
   CTK_DEBUG(ctkEventAdminActivator::getLogService())
       << PROP_REQUIRE_TOPIC << "=" << requireTopic;
-
-  ctkEventAdminService::TopicHandlerFiltersInterface* topicHandlerFilters =
-      new ctkEventAdminService::TopicHandlerFilters(
-        new ctkEventAdminService::TopicCacheMap(cacheSize), requireTopic);
+  CTK_DEBUG(ctkEventAdminActivator::getLogService())
+      << PROP_INLINE_DELIVERY << "=" << inlineDelivery;
 
   ctkEventAdminService::FiltersInterface* filters =
       new ctkEventAdminService::Filters(
         new ctkEventAdminService::LDAPCacheMap(cacheSize), pluginContext);
 
+  // The index keeps track of the ctkEventHandler services by their topics while
+  // they come and go, such that the handlers of an event are found without
+  // querying the framework
+  ctkEventAdminService::TopicHandlerIndex* handlerIndex =
+      new ctkEventAdminService::TopicHandlerIndex(pluginContext, filters, requireTopic);
+  handlerIndex->open();
+
   // Note that this uses a lazy thread pool that will create new threads on
   // demand - in case none of its cached threads is free - until threadPoolSize
   // is reached. Subsequently, a threadPoolSize of 2 effectively disables
@@ -260,12 +272,12 @@ void ctkEAConfiguration::startOrUpdate()
   // below (and not in this HandlerTasks object!)
   ctkEventAdminService::HandlerTasksInterface* handlerTasks =
       new ctkEventAdminService::BlacklistingHandlerTasks(
-        pluginContext, new ctkEventAdminService::BlackList(), topicHandlerFilters, filters);
+        pluginContext, new ctkEventAdminService::BlackList(), handlerIndex);
 
   if (admin == 0)
   {
     admin = new ctkEventAdminService(pluginContext, handlerTasks, sync_pool, async_pool,
-                                     timeout, ignoreTimeout);
+                                     timeout, ignoreTimeout, inlineDelivery);
 
     // Finally, adapt the outside events to our kind of events as per spec
     adaptEvents(admin);
@@ -280,7 +292,7 @@ void ctkEAConfiguration::startOrUpdate()
   }
   else
   {
-    admin->update(handlerTasks, timeout, ignoreTimeout);
+    admin->update(handlerTasks, timeout, ignoreTimeout, inlineDelivery);
   }
 
 }
@@ -298,7 +310,8 @@ QObject* ctkEAConfiguration::tryToCreateMetaTypeProvider(ctkManagedService* mana
   try
   {
     return new ctkEAMetaTypeProvider(managedService, cacheSize, threadPoolSize,
-                                     timeout, requireTopic, ignoreTimeout);
+                                     timeout, requireTopic, ignoreTimeout,
+                                     inlineDelivery);
   }
   catch (...)
   {
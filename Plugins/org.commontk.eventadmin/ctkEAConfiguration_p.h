@@ -89,6 +89,17 @@ class ctkEAAbstractAdapter;
  * pure optimization!
  * The value is a list of strings (separated by comma) which is assumed to define
  * exact class names.
+ * </p>
+ * <p>
+ * <p>
+ *      <tt>org.commontk.eventadmin.InlineDelivery</tt> - Call the
+ *          <tt>ctkEventHandler</tt>s of synchronous events in the sending thread.
+ * </p>
+ * The default is <tt>false</tt>. By default, synchronous events are delivered by
+ * a dedicated thread and each handler subject to the timeout is called by a thread
+ * from the pool. Setting this value to <tt>true</tt> avoids these thread hand-offs:
+ * a single watchdog thread blacklists the handlers exceeding the timeout. The
+ * sending thread is then only released once the handler returns.
  *
  * These properties are read at startup and serve as a default configuration.
  * If a configuration admin is configured, the event admin can be configured
@@ -109,6 +120,7 @@ public:
   static const QString PROP_TIMEOUT; // = "org.commontk.eventadmin.Timeout"
   static const QString PROP_REQUIRE_TOPIC; // = "org.commontk.eventadmin.RequireTopic"
   static const QString PROP_IGNORE_TIMEOUT; // = "org.commontk.eventadmin.IgnoreTimeout"
+  static const QString PROP_INLINE_DELIVERY; // = "org.commontk.eventadmin.InlineDelivery"
   static const QString PROP_LOG_LEVEL; // = "org.commontk.eventadmin.LogLevel"
 
 private:
@@ -128,6 +140,8 @@ private:
 
   QStringList ignoreTimeout;
 
+  bool inlineDelivery;
+
   int logLevel;
 
   // The thread pool used - this is a member because we need to close it on stop
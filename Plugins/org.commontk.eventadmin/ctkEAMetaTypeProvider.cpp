@@ -147,9 +147,10 @@ public:
 
 ctkEAMetaTypeProvider::ctkEAMetaTypeProvider(ctkManagedService* delegatee, int cacheSize,
                                              int threadPoolSize, int timeout, bool requireTopic,
-                                             const QStringList& ignoreTimeout)
+                                             const QStringList& ignoreTimeout, bool inlineDelivery)
   : m_cacheSize(cacheSize), m_threadPoolSize(threadPoolSize), m_timeout(timeout),
-    m_requireTopic(requireTopic), m_ignoreTimeout(ignoreTimeout), m_delegatee(delegatee)
+    m_requireTopic(requireTopic), m_ignoreTimeout(ignoreTimeout), m_inlineDelivery(inlineDelivery),
+    m_delegatee(delegatee)
 {
 }
 
@@ -218,6 +219,15 @@ ctkObjectClassDefinitionPtr ctkEAMetaTypeProvider::getObjectClassDefinition(cons
                                                    QVariant::String, m_ignoreTimeout, 0,
                                                    QStringList(QString::number(std::numeric_limits<int>::max())))));
 
+    adList.push_back(ctkAttributeDefinitionPtr(
+                       new AttributeDefinitionImpl(ctkEAConfiguration::PROP_INLINE_DELIVERY, "Inline Delivery",
+                                                   "Call the event handlers of synchronous events in the sending thread. This is disabled "
+                                                   "by default, in which case synchronous events are handed-off to a dedicated thread and "
+                                                   "each event handler using the timeout is called by a thread from the pool. Enabling this "
+                                                   "setting avoids these thread hand-offs; a single watchdog thread blacklists the event "
+                                                   "handlers exceeding the timeout, but the sending thread only returns once they are done.",
+                                                   QVariant::Bool, m_inlineDelivery ? QStringList("true") : QStringList("false"))));
+
     ocd = ctkObjectClassDefinitionPtr(new ObjectClassDefinitionImpl(adList));
   }
 
@@ -42,6 +42,7 @@ private:
   const int m_timeout;
   const bool m_requireTopic;
   const QStringList m_ignoreTimeout;
+  const bool m_inlineDelivery;
 
   ctkManagedService* const m_delegatee;
 
@@ -54,7 +55,7 @@ public:
 
   ctkEAMetaTypeProvider(ctkManagedService* delegatee, int cacheSize,
                         int threadPoolSize, int timeout, bool requireTopic,
-                        const QStringList& ignoreTimeout);
+                        const QStringList& ignoreTimeout, bool inlineDelivery);
 
 
   /**
@@ -27,16 +27,16 @@ template<class HandlerTasks, class SyncDeliverTasks, class AsyncDeliverTasks>
 ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::ctkEventAdminImpl(
   HandlerTasksInterface* managers, ctkEADefaultThreadPool* syncPool,
   ctkEADefaultThreadPool* asyncPool, int timeout,
-  const QStringList& ignoreTimeout)
+  const QStringList& ignoreTimeout, bool inlineDelivery)
   : managers(managers)
 {
   checkNull(managers, "Managers");
   checkNull(syncPool, "syncPool");
   checkNull(asyncPool, "asyncPool");
 
-  sendManager = new SyncDeliverTasks(syncPool, &syncMasterThread,
+  sendManager = new SyncDeliverTasks(syncPool, &syncMasterThread, &syncWatchdog,
                                      (timeout > 100 ? timeout : 0),
-                                     ignoreTimeout);
+                                     ignoreTimeout, inlineDelivery);
 
   postManager = new AsyncDeliverTasks(asyncPool, sendManager);
 }
@@ -54,6 +54,12 @@ void ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::postEve
   handleEvent(managers.fetchAndAddOrdered(0)->createHandlerTasks(event), postManager);
 }
 
+template<class HandlerTasks, class SyncDeliverTasks, class AsyncDeliverTasks>
+void ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::postEvents(const QList<ctkEvent>& events)
+{
+  handleEvent(managers.fetchAndAddOrdered(0)->createHandlerTasks(events), postManager);
+}
+
 template<class HandlerTasks, class SyncDeliverTasks, class AsyncDeliverTasks>
 void ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::sendEvent(const ctkEvent& event)
 {
@@ -87,15 +93,16 @@ void ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::stop()
       this->managers.fetchAndStoreOrdered(&stoppedHandlerTasks);
   delete oldManagers;
   syncMasterThread.stop();
+  syncWatchdog.stop();
 }
 
 template<class HandlerTasks, class SyncDeliverTasks, class AsyncDeliverTasks>
 void ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::update(HandlerTasksInterface* managers, int timeout,
-                               const QStringList& ignoreTimeout)
+                               const QStringList& ignoreTimeout, bool inlineDelivery)
 {
   HandlerTasksInterface* oldManagers = this->managers.fetchAndStoreOrdered(managers);
   delete oldManagers;
-  this->sendManager->update(timeout, ignoreTimeout);
+  this->sendManager->update(timeout, ignoreTimeout, inlineDelivery);
 }
 
 template<class HandlerTasks, class SyncDeliverTasks, class AsyncDeliverTasks>
@@ -26,6 +26,7 @@
 #include "handler/ctkEAHandlerTasks_p.h"
 #include "tasks/ctkEADeliverTask_p.h"
 #include "dispatch/ctkEASyncMasterThread_p.h"
+#include "dispatch/ctkEASyncWatchdog_p.h"
 
 class ctkEADefaultThreadPool;
 
@@ -63,6 +64,9 @@ private:
   // The (interruptible) thread where sync events are handled
   ctkEASyncMasterThread syncMasterThread;
 
+  // The thread enforcing the timeouts of sync events handled inline
+  ctkEASyncWatchdog syncWatchdog;
+
   // The synchronous event dispatcher
   SyncDeliverTasks* sendManager;
 
@@ -83,6 +87,18 @@ private:
     {
       throw ctkIllegalStateException("The EventAdmin is stopped");
     }
+
+    /**
+     * This is a null object and this method will throw an
+     * ctkIllegalStateException due to the plugin being stopped.
+     *
+     * @throws ctkIllegalStateException - This is a null object and this method
+     *          will always throw an ctkIllegalStateException
+     */
+    QList<ctkEAHandlerTask<HandlerTasks> > createHandlerTasks(const QList<ctkEvent>&)
+    {
+      throw ctkIllegalStateException("The EventAdmin is stopped");
+    }
   };
 
   StoppedHandlerTasks stoppedHandlerTasks;
@@ -98,12 +114,14 @@ public:
    * @param managers The factory used to determine applicable <tt>ctkEventHandler</tt>
    * @param syncPool The synchronous thread pool
    * @param asyncPool The asynchronous thread pool
+   * @param inlineDelivery Whether sync events are handled by the sending thread
    */
   ctkEventAdminImpl(HandlerTasksInterface* managers,
                     ctkEADefaultThreadPool* syncPool,
                     ctkEADefaultThreadPool* asyncPool,
                     int timeout,
-                    const QStringList& ignoreTimeout);
+                    const QStringList& ignoreTimeout,
+                    bool inlineDelivery);
 
   ~ctkEventAdminImpl();
 
@@ -118,6 +136,17 @@ public:
    */
   void postEvent(const ctkEvent& event);
 
+  /**
+   * Post a batch of asynchronous events.
+   *
+   * @param events The events to be posted by this service
+   *
+   * @throws ctkIllegalStateException - In case we are stopped
+   *
+   * @see ctkEventAdmin#postEvents(const QList<ctkEvent>&)
+   */
+  void postEvents(const QList<ctkEvent>& events);
+
   /**
    * Send a synchronous event.
    *
@@ -144,7 +173,7 @@ public:
    * Update the event admin with new configuration.
    */
   void update(HandlerTasksInterface* managers, int timeout,
-              const QStringList& ignoreTimeout);
+              const QStringList& ignoreTimeout, bool inlineDelivery);
 
 private:
 
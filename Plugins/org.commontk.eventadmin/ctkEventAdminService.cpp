@@ -31,8 +31,9 @@ ctkEventAdminService::ctkEventAdminService(ctkPluginContext* context,
                                            ctkEADefaultThreadPool* syncPool,
                                            ctkEADefaultThreadPool* asyncPool,
                                            int timeout,
-                                           const QStringList& ignoreTimeout)
-  : impl(managers, syncPool, asyncPool, timeout, ignoreTimeout),
+                                           const QStringList& ignoreTimeout,
+                                           bool inlineDelivery)
+  : impl(managers, syncPool, asyncPool, timeout, ignoreTimeout, inlineDelivery),
     context(context)
 {
 
@@ -52,6 +53,11 @@ void ctkEventAdminService::postEvent(const ctkEvent& event)
   impl.postEvent(event);
 }
 
+void ctkEventAdminService::postEvents(const QList<ctkEvent>& events)
+{
+  impl.postEvents(events);
+}
+
 void ctkEventAdminService::sendEvent(const ctkEvent& event)
 {
   impl.sendEvent(event);
@@ -197,8 +203,9 @@ void ctkEventAdminService::stop()
 }
 
 void ctkEventAdminService::update(HandlerTasksInterface* managers, int timeout,
-                                  const QStringList& ignoreTimeout)
+                                  const QStringList& ignoreTimeout,
+                                  bool inlineDelivery)
 {
-  impl.update(managers, timeout, ignoreTimeout);
+  impl.update(managers, timeout, ignoreTimeout, inlineDelivery);
 }
 
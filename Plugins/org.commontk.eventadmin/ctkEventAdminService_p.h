@@ -31,8 +31,8 @@
 
 #include "handler/ctkEACleanBlackList_p.h"
 #include "util/ctkEALeastRecentlyUsedCacheMap_p.h"
-#include "handler/ctkEACacheTopicHandlerFilters_p.h"
 #include "handler/ctkEACacheFilters_p.h"
+#include "handler/ctkEATopicHandlerIndex_p.h"
 #include "tasks/ctkEASyncDeliverTasks_p.h"
 #include "tasks/ctkEAAsyncDeliverTasks_p.h"
 #include "dispatch/ctkEASignalPublisher_p.h"
@@ -49,14 +49,12 @@ public:
   typedef ctkEACleanBlackList BlackList;
   typedef ctkEABlackList<BlackList> BlackListInterface;
 
-  typedef ctkEALeastRecentlyUsedCacheMap<QString, QString> TopicCacheMap;
-  typedef ctkEACacheTopicHandlerFilters<TopicCacheMap> TopicHandlerFilters;
-  typedef ctkEATopicHandlerFilters<TopicHandlerFilters> TopicHandlerFiltersInterface;
   typedef ctkEALeastRecentlyUsedCacheMap<QString, ctkLDAPSearchFilter> LDAPCacheMap;
   typedef ctkEACacheFilters<LDAPCacheMap> Filters;
   typedef ctkEAFilters<Filters> FiltersInterface;
+  typedef ctkEATopicHandlerIndex<Filters> TopicHandlerIndex;
 
-  typedef ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> BlacklistingHandlerTasks;
+  typedef ctkEABlacklistingHandlerTasks<BlackList, Filters> BlacklistingHandlerTasks;
   typedef ctkEAHandlerTasks<BlacklistingHandlerTasks> HandlerTasksInterface;
 
   typedef ctkEAHandlerTask<BlacklistingHandlerTasks> HandlerTask;
@@ -80,12 +78,15 @@ public:
                        ctkEADefaultThreadPool* syncPool,
                        ctkEADefaultThreadPool* asyncPool,
                        int timeout,
-                       const QStringList& ignoreTimeout);
+                       const QStringList& ignoreTimeout,
+                       bool inlineDelivery);
 
   ~ctkEventAdminService();
 
   void postEvent(const ctkEvent& event);
 
+  void postEvents(const QList<ctkEvent>& events);
+
   void sendEvent(const ctkEvent& event);
 
   void publishSignal(const QObject* publisher, const char* signal,
@@ -113,7 +114,7 @@ public:
    * Update the event admin with new configuration.
    */
   void update(HandlerTasksInterface* managers, int timeout,
-              const QStringList& ignoreTimeout);
+              const QStringList& ignoreTimeout, bool inlineDelivery);
 
 };
 
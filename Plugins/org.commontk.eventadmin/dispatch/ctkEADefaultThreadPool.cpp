@@ -22,12 +22,11 @@
 
 #include "ctkEADefaultThreadPool_p.h"
 
-#include "ctkEALinkedQueue_p.h"
-#include "ctkEAInterruptedException_p.h"
-
 #include <ctkEventAdminActivator_p.h>
 #include <tasks/ctkEASyncThread_p.h>
 
+#include <QStringList>
+
 struct _SyncThreadFactory : public ctkEAThreadFactory
 {
   ctkEAInterruptibleThread* newThread(ctkEARunnable* command)
@@ -52,8 +51,10 @@ struct _AsyncThreadFactory : public ctkEAThreadFactory
   }
 };
 
+const int ctkEADefaultThreadPool::ASYNC_QUEUE_CAPACITY = 1000;
+
 ctkEADefaultThreadPool::ctkEADefaultThreadPool(int poolSize, bool syncThreads)
-  : ctkEAPooledExecutor(new ctkEALinkedQueue())
+  : ctkEAWorkStealingExecutor(syncThreads ? 0 : ASYNC_QUEUE_CAPACITY)
 {
   if (syncThreads)
   {
@@ -77,16 +78,20 @@ void ctkEADefaultThreadPool::configure(int poolSize)
 
 void ctkEADefaultThreadPool::close()
 {
-  shutdownNow();
-
-  try
+  Statistics statistics = getStatistics();
+  QStringList latency;
+  foreach (int count, statistics.latency)
   {
-    awaitTerminationAfterShutdown();
-  }
-  catch (const ctkEAInterruptedException& )
-  {
-    // ignore this
+    latency << QString::number(count);
   }
+  CTK_DEBUG(ctkEventAdminActivator::getLogService())
+      << "Thread pool statistics: executed" << statistics.executed
+      << "stolen" << statistics.stolen << "blocked" << statistics.blocked
+      << "max queued" << statistics.maxQueued
+      << "latency histogram (ms, powers of two)" << latency.join(" ");
+
+  shutdownNow();
+  awaitTerminationAfterShutdown();
 }
 
 void ctkEADefaultThreadPool::executeTask(ctkEARunnable* task)
@@ -23,17 +23,25 @@
 #ifndef CTKEADEFAULTTHREADPOOL_P_H
 #define CTKEADEFAULTTHREADPOOL_P_H
 
-#include "ctkEAPooledExecutor_p.h"
+#include "ctkEAWorkStealingExecutor_p.h"
 
 /**
  * A thread pool that allows to execute tasks using pooled threads in order
  * to ease the thread creation overhead.
+ *
+ * The queues of the synchronous pool are unbounded, as the event sending
+ * threads wait for their tasks to start anyway. The queues of the asynchronous
+ * pool are bounded; once they are full, the threads posting events deliver
+ * them themselves.
  */
-class ctkEADefaultThreadPool : public ctkEAPooledExecutor
+class ctkEADefaultThreadPool : public ctkEAWorkStealingExecutor
 {
 
 public:
 
+  /** The number of tasks queued per thread of the asynchronous pool */
+  static const int ASYNC_QUEUE_CAPACITY; // = 1000
+
   /**
    * Create a new pool.
    */
@@ -46,7 +54,8 @@ public:
 
   /**
    * Close the pool i.e, stop pooling threads. Note that subsequently, task will
-   * still be executed but no pooling is taking place anymore.
+   * still be executed but no pooling is taking place anymore. The statistics
+   * of the pool are logged on debug level.
    */
   void close();
 
@@ -39,7 +39,7 @@ void ctkEAInterruptibleThread::run()
   {
     const bool autoDelete = command->autoDelete();
     command->run();
-    if (autoDelete && !--command->ref) delete command;
+    if (autoDelete && !command->ref.deref()) delete command;
   }
   else
   {
@@ -30,14 +30,15 @@
 #include <QRunnable>
 
 /**
- * A QRunnable subclass with simple reference counting.
+ * A QRunnable subclass with simple reference counting. The reference
+ * count is atomic, as the references may be released by several threads.
  */
 class ctkEARunnable : public QRunnable
 {
 
 public:
 
-  int ref;
+  QAtomicInt ref;
 
   ctkEARunnable() : ref(0) {}
   bool autoDelete() const { return ref != -1; }
@@ -52,12 +53,12 @@ public:
   ctkEAScopedRunnableReference(ctkEARunnable* runnable)
     : runnable(runnable)
   {
-    ++runnable->ref;
+    runnable->ref.ref();
   }
 
   ~ctkEAScopedRunnableReference()
   {
-    if (!--runnable->ref) delete runnable;
+    if (!runnable->ref.deref()) delete runnable;
   }
 
 private:
@@ -0,0 +1,178 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEASyncWatchdog_p.h"
+
+const int ctkEASyncWatchdog::RESOLUTION = 10;
+
+ctkEASyncWatchdog::Delivery::Delivery(int timeout)
+  : timeout(timeout), watchdog(0), task(-1), start(0), outer(0),
+    pausedTask(-1), pausedAt(0), expiredTask(-1)
+{
+}
+
+void ctkEASyncWatchdog::Delivery::startTask(int task)
+{
+  start.fetchAndStoreOrdered(watchdog->now.fetchAndAddOrdered(0));
+  this->task.fetchAndStoreOrdered(task);
+}
+
+void ctkEASyncWatchdog::Delivery::finishTask()
+{
+  task.fetchAndStoreOrdered(-1);
+}
+
+ctkEASyncWatchdog::ctkEASyncWatchdog()
+  : stopped(false), now(0), clockBase(0)
+{
+  setObjectName("ctkEASyncWatchdog");
+  clock.start();
+}
+
+ctkEASyncWatchdog::~ctkEASyncWatchdog()
+{
+  stop();
+}
+
+void ctkEASyncWatchdog::add(Delivery* delivery)
+{
+  QMutexLocker l(&mutex);
+
+  delivery->watchdog = this;
+
+  CurrentDelivery* current = currentDelivery.localData();
+  if (current == 0)
+  {
+    current = new CurrentDelivery;
+    current->delivery = 0;
+    currentDelivery.setLocalData(current);
+  }
+  delivery->outer = current->delivery;
+  current->delivery = delivery;
+
+  const int time = tick();
+  if (delivery->outer)
+  {
+    // the handler sending this event is not timed while it is delivered
+    delivery->outer->pausedTask = delivery->outer->task.fetchAndStoreOrdered(-1);
+    delivery->outer->pausedAt = time;
+  }
+
+  if (stopped)
+  {
+    return;
+  }
+
+  deliveries.push_back(delivery);
+  if (!isRunning())
+  {
+    start();
+  }
+  else if (deliveries.size() == 1)
+  {
+    condition.wakeAll();
+  }
+}
+
+void ctkEASyncWatchdog::remove(Delivery* delivery)
+{
+  QMutexLocker l(&mutex);
+
+  deliveries.removeOne(delivery);
+  currentDelivery.localData()->delivery = delivery->outer;
+
+  if (Delivery* outer = delivery->outer)
+  {
+    const int time = tick();
+    outer->start.fetchAndStoreOrdered(outer->start.fetchAndAddOrdered(0) + elapsed(outer->pausedAt, time));
+    outer->task.fetchAndStoreOrdered(outer->pausedTask);
+  }
+}
+
+void ctkEASyncWatchdog::stop()
+{
+  {
+    QMutexLocker l(&mutex);
+    stopped = true;
+    deliveries.clear();
+    condition.wakeAll();
+  }
+  QThread::wait();
+}
+
+void ctkEASyncWatchdog::run()
+{
+  QMutexLocker l(&mutex);
+  while (!stopped)
+  {
+    if (deliveries.isEmpty())
+    {
+      condition.wait(&mutex);
+    }
+    else
+    {
+      condition.wait(&mutex, RESOLUTION);
+      tick();
+      check();
+    }
+  }
+}
+
+int ctkEASyncWatchdog::tick()
+{
+  // QTime wraps after a day, hence only the time between two ticks is used
+  clockBase = static_cast<int>(static_cast<uint>(clockBase) + static_cast<uint>(clock.restart()));
+  now.fetchAndStoreOrdered(clockBase);
+  return clockBase;
+}
+
+void ctkEASyncWatchdog::check()
+{
+  const int time = now.fetchAndAddOrdered(0);
+  foreach (Delivery* delivery, deliveries)
+  {
+    const int task = delivery->task.fetchAndAddOrdered(0);
+    if (task < 0 || task == delivery->expiredTask)
+    {
+      continue;
+    }
+
+    // the start stamp belongs to the task if the task did not change meanwhile
+    const int start = delivery->start.fetchAndAddOrdered(0);
+    if (delivery->task.fetchAndAddOrdered(0) != task)
+    {
+      continue;
+    }
+
+    // the stamps lag behind by up to RESOLUTION
+    if (elapsed(start, time) > delivery->timeout + RESOLUTION)
+    {
+      delivery->expiredTask = task;
+      delivery->expired(task);
+    }
+  }
+}
+
+int ctkEASyncWatchdog::elapsed(int from, int to)
+{
+  return static_cast<int>(static_cast<uint>(to) - static_cast<uint>(from));
+}
@@ -0,0 +1,169 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEASYNCWATCHDOG_P_H
+#define CTKEASYNCWATCHDOG_P_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QThreadStorage>
+#include <QTime>
+#include <QWaitCondition>
+
+/**
+ * This thread enforces the timeout of event handlers which are called on the
+ * thread sending a synchronous event. Instead of handing each handler call over
+ * to another thread, the sending thread stamps the time at which it calls a
+ * handler into its registered delivery, and the watchdog periodically checks
+ * the stamps of all deliveries and reports the handlers which exceeded their
+ * timeout. A handler call cannot be aborted, hence the sending thread is only
+ * released once the handler returns.
+ *
+ * If a handler sends an event, the timeout of the handler is stopped for the
+ * delivery time of the inner event.
+ */
+class ctkEASyncWatchdog : public QThread
+{
+
+public:
+
+  /**
+   * The handler calls of a synchronous event delivery.
+   */
+  class Delivery
+  {
+
+  public:
+
+    /**
+     * @param timeout The time in milliseconds granted to each handler
+     */
+    Delivery(int timeout);
+
+    virtual ~Delivery() {}
+
+    /**
+     * Called by the sending thread before it calls a handler.
+     *
+     * @param task The index of the handler in the delivery
+     */
+    void startTask(int task);
+
+    /**
+     * Called by the sending thread after a handler returned.
+     */
+    void finishTask();
+
+  protected:
+
+    /**
+     * Called from the watchdog thread once for a handler which exceeded the
+     * timeout, while the sending thread may still be calling it.
+     *
+     * @param task The index of the handler in the delivery
+     */
+    virtual void expired(int task) = 0;
+
+  private:
+
+    friend class ctkEASyncWatchdog;
+
+    const int timeout;
+
+    ctkEASyncWatchdog* watchdog;
+
+    // The index of the handler being called, -1 if none. It is set after the
+    // start stamp, so that the watchdog can check that both belong together
+    QAtomicInt task;
+    QAtomicInt start;
+
+    // The delivery on the same thread which sent the event of this one
+    Delivery* outer;
+    int pausedTask;
+    int pausedAt;
+
+    // Only used by the watchdog thread
+    int expiredTask;
+  };
+
+  ctkEASyncWatchdog();
+
+  ~ctkEASyncWatchdog();
+
+  /**
+   * Register a delivery of the calling thread. The timeout of the delivery
+   * on the same thread the new one is nested in is stopped. The watchdog
+   * thread is started if needed.
+   */
+  void add(Delivery* delivery);
+
+  /**
+   * Unregister a delivery once all its handlers returned and resume the
+   * timeout of the delivery it was nested in. The watchdog does not access
+   * the delivery after this method returned.
+   */
+  void remove(Delivery* delivery);
+
+  /**
+   * Stop checking the deliveries and wait for the watchdog thread to finish.
+   */
+  void stop();
+
+protected:
+
+  void run();
+
+private:
+
+  struct CurrentDelivery
+  {
+    Delivery* delivery;
+  };
+
+  // The check interval in milliseconds
+  static const int RESOLUTION;
+
+  QMutex mutex;
+  QWaitCondition condition;
+  bool stopped;
+
+  QList<Delivery*> deliveries;
+
+  // The milliseconds since the watchdog was created, updated by the watchdog
+  // while there are deliveries. A stamp may hence be up to RESOLUTION too old.
+  QAtomicInt now;
+  QTime clock;
+  int clockBase;
+
+  QThreadStorage<CurrentDelivery*> currentDelivery;
+
+  // Update now from the clock, with the mutex locked
+  int tick();
+
+  void check();
+
+  static int elapsed(int from, int to);
+};
+
+#endif // CTKEASYNCWATCHDOG_P_H
@@ -32,7 +32,7 @@ void ctkEAThreadFactoryUser::DefaultThread::run()
 {
   const bool autoDelete = command->autoDelete();
   command->run();
-  if (autoDelete && !--command->ref) delete command;
+  if (autoDelete && !command->ref.deref()) delete command;
 }
 
 
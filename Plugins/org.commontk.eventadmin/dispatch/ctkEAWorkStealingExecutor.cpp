@@ -0,0 +1,549 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEAWorkStealingExecutor_p.h"
+
+#include <dispatch/ctkEAInterruptibleThread_p.h>
+#include <dispatch/ctkEAInterruptedException_p.h>
+
+#include <ctkException.h>
+
+#include <limits>
+
+const int ctkEAWorkStealingExecutor::DEFAULT_MAXIMUMPOOLSIZE = std::numeric_limits<int>::max();
+const int ctkEAWorkStealingExecutor::DEFAULT_MINIMUMPOOLSIZE = 1;
+const long ctkEAWorkStealingExecutor::DEFAULT_KEEPALIVETIME = 60 * 1000;
+
+// QTime wraps at midnight
+static const int MSECS_PER_DAY = 24 * 60 * 60 * 1000;
+
+ctkEAWorkStealingExecutor::Statistics::Statistics()
+  : poolSize(0), queued(0), maxQueued(0), executed(0), stolen(0), blocked(0),
+    latency(LATENCY_BUCKETS, 0)
+{
+}
+
+ctkEAWorkStealingExecutor::ctkEAWorkStealingExecutor(int capacity)
+  : capacity(capacity), maximumPoolSize(DEFAULT_MAXIMUMPOOLSIZE),
+    minimumPoolSize(DEFAULT_MINIMUMPOOLSIZE), keepAliveTime(DEFAULT_KEEPALIVETIME),
+    blockedPolicy(RUN_WHEN_BLOCKED), shutdown(false), queues(0)
+{
+  if (capacity < 0) throw ctkInvalidArgumentException("capacity must be >= 0");
+  clock.start();
+}
+
+ctkEAWorkStealingExecutor::~ctkEAWorkStealingExecutor()
+{
+  shutdownNow();
+  awaitTerminationAfterShutdown();
+
+  qDeleteAll(stoppedThreads);
+  qDeleteAll(threads);
+
+  QVector<Queue*>* qs = queues.fetchAndStoreOrdered(0);
+  if (qs)
+  {
+    // commands queued concurrently to the shutdown
+    foreach (Queue* queue, *qs)
+    {
+      foreach (const Entry& entry, queue->entries)
+      {
+        release(entry.command);
+      }
+      delete queue;
+    }
+    delete qs;
+  }
+  qDeleteAll(retiredQueues);
+}
+
+int ctkEAWorkStealingExecutor::getMaximumPoolSize() const
+{
+  QMutexLocker lock(&workerMutex);
+  return maximumPoolSize;
+}
+
+void ctkEAWorkStealingExecutor::setMaximumPoolSize(int newMaximum)
+{
+  QMutexLocker lock(&workerMutex);
+  if (newMaximum <= 0) throw ctkInvalidArgumentException("maximum must be > 0");
+  maximumPoolSize = newMaximum;
+}
+
+int ctkEAWorkStealingExecutor::getMinimumPoolSize() const
+{
+  QMutexLocker lock(&workerMutex);
+  return minimumPoolSize;
+}
+
+void ctkEAWorkStealingExecutor::setMinimumPoolSize(int newMinimum)
+{
+  QMutexLocker lock(&workerMutex);
+  if (newMinimum < 0) throw ctkInvalidArgumentException("minimum must be >= 0");
+  minimumPoolSize = newMinimum;
+}
+
+int ctkEAWorkStealingExecutor::getPoolSize() const
+{
+  return poolSize.fetchAndAddOrdered(0);
+}
+
+long ctkEAWorkStealingExecutor::getKeepAliveTime() const
+{
+  QMutexLocker lock(&workerMutex);
+  return keepAliveTime;
+}
+
+void ctkEAWorkStealingExecutor::setKeepAliveTime(long msecs)
+{
+  QMutexLocker lock(&workerMutex);
+  keepAliveTime = msecs;
+}
+
+int ctkEAWorkStealingExecutor::getCapacity() const
+{
+  return capacity;
+}
+
+void ctkEAWorkStealingExecutor::runWhenBlocked()
+{
+  QMutexLocker lock(&workerMutex);
+  blockedPolicy = RUN_WHEN_BLOCKED;
+}
+
+void ctkEAWorkStealingExecutor::waitWhenBlocked()
+{
+  QMutexLocker lock(&workerMutex);
+  blockedPolicy = WAIT_WHEN_BLOCKED;
+}
+
+void ctkEAWorkStealingExecutor::discardWhenBlocked()
+{
+  QMutexLocker lock(&workerMutex);
+  blockedPolicy = DISCARD_WHEN_BLOCKED;
+}
+
+void ctkEAWorkStealingExecutor::abortWhenBlocked()
+{
+  QMutexLocker lock(&workerMutex);
+  blockedPolicy = ABORT_WHEN_BLOCKED;
+}
+
+void ctkEAWorkStealingExecutor::discardOldestWhenBlocked()
+{
+  QMutexLocker lock(&workerMutex);
+  blockedPolicy = DISCARD_OLDEST_WHEN_BLOCKED;
+}
+
+void ctkEAWorkStealingExecutor::execute(ctkEARunnable* command)
+{
+  BlockedPolicy policy;
+  {
+    QMutexLocker lock(&workerMutex);
+    if (shutdown) return;
+    // the command is referenced until it is executed or discarded
+    if (command->autoDelete()) command->ref.ref();
+
+    // Ensure minimum number of threads
+    if (poolSize.fetchAndAddOrdered(0) < minimumPoolSize)
+    {
+      addWorker(command);
+      return;
+    }
+  }
+
+  // Try to queue it without contending with other threads
+  if (offer(command))
+  {
+    signalWork();
+    return;
+  }
+
+  {
+    // If all queues are full and still under maximum, create new thread
+    QMutexLocker lock(&workerMutex);
+    if (shutdown)
+    {
+      release(command);
+      return;
+    }
+    if (poolSize.fetchAndAddOrdered(0) < maximumPoolSize)
+    {
+      addWorker(command);
+      return;
+    }
+    policy = blockedPolicy;
+  }
+
+  // Cannot queue and cannot create -- apply back-pressure
+  blocked.ref();
+  switch (policy)
+  {
+  case WAIT_WHEN_BLOCKED:
+  {
+    QMutexLocker lock(&workerMutex);
+    waitingForRoom.ref();
+    bool queuedCommand = offer(command);
+    while (!queuedCommand && !shutdown)
+    {
+      roomAvailable.wait(&workerMutex);
+      queuedCommand = offer(command);
+    }
+    waitingForRoom.deref();
+    if (queuedCommand)
+    {
+      workAvailable.wakeOne();
+    }
+    else
+    {
+      release(command);
+    }
+    break;
+  }
+  case DISCARD_WHEN_BLOCKED:
+    release(command);
+    break;
+  case ABORT_WHEN_BLOCKED:
+    release(command);
+    throw ctkRuntimeException("Pool is blocked");
+  case DISCARD_OLDEST_WHEN_BLOCKED:
+    if (discardOldest() && offer(command))
+    {
+      signalWork();
+      break;
+    }
+    // fall back to running the command
+  case RUN_WHEN_BLOCKED:
+  default:
+    runTask(command);
+  }
+}
+
+void ctkEAWorkStealingExecutor::shutdownNow()
+{
+  QMutexLocker lock(&workerMutex);
+  shutdown = true; // don't allow new tasks
+  minimumPoolSize = maximumPoolSize = 0; // don't make new threads
+
+  // discard the queued commands
+  if (QVector<Queue*>* qs = queues.fetchAndAddOrdered(0))
+  {
+    foreach (Queue* queue, *qs)
+    {
+      QList<Entry> entries;
+      {
+        QMutexLocker queueLock(&queue->mutex);
+        entries = queue->entries;
+        queue->entries.clear();
+      }
+      queued.fetchAndAddOrdered(-entries.size());
+      foreach (const Entry& entry, entries)
+      {
+        release(entry.command);
+      }
+    }
+  }
+
+  // interrupt all existing threads
+  foreach (ctkEAInterruptibleThread* t, threads)
+  {
+    t->interrupt();
+  }
+  workAvailable.wakeAll();
+  roomAvailable.wakeAll();
+}
+
+void ctkEAWorkStealingExecutor::awaitTerminationAfterShutdown()
+{
+  QList<ctkEAInterruptibleThread*> allThreads;
+  {
+    QMutexLocker lock(&workerMutex);
+    if (!shutdown)
+      throw ctkIllegalStateException("not in shutdown state");
+    allThreads = threads.values() + stoppedThreads;
+  }
+  foreach (ctkEAInterruptibleThread* t, allThreads)
+  {
+    if (t != ctkEAInterruptibleThread::currentThread())
+    {
+      t->join();
+    }
+  }
+}
+
+ctkEAWorkStealingExecutor::Statistics ctkEAWorkStealingExecutor::getStatistics() const
+{
+  Statistics statistics;
+  statistics.poolSize = poolSize.fetchAndAddOrdered(0);
+  statistics.queued = queued.fetchAndAddOrdered(0);
+  statistics.maxQueued = maxQueued.fetchAndAddOrdered(0);
+  statistics.executed = executed.fetchAndAddOrdered(0);
+  statistics.stolen = stolen.fetchAndAddOrdered(0);
+  statistics.blocked = blocked.fetchAndAddOrdered(0);
+  for (int i = 0; i < LATENCY_BUCKETS; ++i)
+  {
+    statistics.latency[i] = latency[i].fetchAndAddOrdered(0);
+  }
+  return statistics;
+}
+
+bool ctkEAWorkStealingExecutor::offer(ctkEARunnable* command)
+{
+  QVector<Queue*>* qs = queues.fetchAndAddOrdered(0);
+  if (qs == 0) return false;
+
+  const int n = qs->size();
+  const uint first = currentQueue.hasLocalData()
+      ? currentQueue.localData()->queue
+      : static_cast<uint>(nextQueue.fetchAndAddOrdered(1));
+  for (int i = 0; i < n; ++i)
+  {
+    Queue* queue = qs->at((first + i) % n);
+    QMutexLocker lock(&queue->mutex);
+    if (capacity == 0 || queue->entries.size() < capacity)
+    {
+      Entry entry = { command, now() };
+      queue->entries.push_back(entry);
+      lock.unlock();
+
+      const int size = queued.fetchAndAddOrdered(1) + 1;
+      int max = maxQueued.fetchAndAddOrdered(0);
+      while (size > max && !maxQueued.testAndSetOrdered(max, size))
+      {
+        max = maxQueued.fetchAndAddOrdered(0);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ctkEAWorkStealingExecutor::discardOldest()
+{
+  QVector<Queue*>* qs = queues.fetchAndAddOrdered(0);
+  if (qs == 0) return false;
+
+  const uint first = static_cast<uint>(nextQueue.fetchAndAddOrdered(1));
+  for (int i = 0; i < qs->size(); ++i)
+  {
+    Queue* queue = qs->at((first + i) % qs->size());
+    QMutexLocker lock(&queue->mutex);
+    if (!queue->entries.isEmpty())
+    {
+      ctkEARunnable* oldest = queue->entries.takeFirst().command;
+      lock.unlock();
+      queued.deref();
+      release(oldest);
+      return true;
+    }
+  }
+  return false;
+}
+
+ctkEARunnable* ctkEAWorkStealingExecutor::take(int queue)
+{
+  if (queued.fetchAndAddOrdered(0) <= 0) return 0;
+
+  QVector<Queue*>* qs = queues.fetchAndAddOrdered(0);
+  const int n = qs->size();
+  Entry entry = { 0, 0 };
+  for (int i = 0; i < n && entry.command == 0; ++i)
+  {
+    Queue* q = qs->at((queue + i) % n);
+    QMutexLocker lock(&q->mutex);
+    if (!q->entries.isEmpty())
+    {
+      // the oldest of the own queue, the newest of the others
+      entry = i == 0 ? q->entries.takeFirst() : q->entries.takeLast();
+      if (i > 0) stolen.ref();
+    }
+  }
+  if (entry.command == 0) return 0;
+
+  queued.deref();
+  if (waitingForRoom.fetchAndAddOrdered(0) > 0)
+  {
+    QMutexLocker lock(&workerMutex);
+    roomAvailable.wakeAll();
+  }
+
+  int waited = now() - entry.queuedAt;
+  if (waited < 0) waited += MSECS_PER_DAY;
+  int bucket = 0;
+  while (waited > 0 && bucket < LATENCY_BUCKETS - 1)
+  {
+    waited >>= 1;
+    ++bucket;
+  }
+  latency[bucket].ref();
+
+  return entry.command;
+}
+
+void ctkEAWorkStealingExecutor::addWorker(ctkEARunnable* firstTask)
+{
+  // reuse the queue of a terminated worker, the commands left in it
+  // have been stolen or will be taken by the new worker
+  QVector<Queue*>* qs = queues.fetchAndAddOrdered(0);
+  int queue = -1;
+  for (int i = 0; qs && i < qs->size(); ++i)
+  {
+    if (!qs->at(i)->owned)
+    {
+      queue = i;
+      break;
+    }
+  }
+  if (queue < 0)
+  {
+    QVector<Queue*>* grown = qs ? new QVector<Queue*>(*qs) : new QVector<Queue*>();
+    grown->push_back(new Queue());
+    queue = grown->size() - 1;
+    queues.fetchAndStoreOrdered(grown);
+    if (qs) retiredQueues.push_back(qs);
+    qs = grown;
+  }
+  qs->at(queue)->owned = true;
+
+  Worker* worker = new Worker(this, queue, firstTask);
+  worker->ref.ref();
+  ctkEAInterruptibleThread* thread = getThreadFactory()->newThread(worker);
+  threads.insert(worker, thread);
+  poolSize.ref();
+
+  // do some garbage collection
+  foreach (ctkEAInterruptibleThread* t, stoppedThreads)
+  {
+    if (t != ctkEAInterruptibleThread::currentThread() && t->isFinished())
+    {
+      delete t;
+      stoppedThreads.removeAll(t);
+    }
+  }
+
+  thread->start();
+}
+
+bool ctkEAWorkStealingExecutor::waitForWork(Worker* worker, int queue)
+{
+  QMutexLocker lock(&workerMutex);
+  if (shutdown || poolSize.fetchAndAddOrdered(0) > maximumPoolSize)
+  {
+    workerDone(worker, queue);
+    return false;
+  }
+
+  // the idle count is raised before checking for queued commands, and
+  // the queued count before checking for idle workers in execute()
+  idleWorkers.ref();
+  bool timedOut = false;
+  if (queued.fetchAndAddOrdered(0) <= 0)
+  {
+    timedOut = !workAvailable.wait(&workerMutex, keepAliveTime < 0 ? ULONG_MAX : keepAliveTime);
+  }
+  idleWorkers.deref();
+
+  if (shutdown || (timedOut && queued.fetchAndAddOrdered(0) <= 0 &&
+                   poolSize.fetchAndAddOrdered(0) > minimumPoolSize))
+  {
+    workerDone(worker, queue);
+    return false;
+  }
+  return true;
+}
+
+void ctkEAWorkStealingExecutor::workerDone(Worker* worker, int queue)
+{
+  poolSize.deref();
+  queues.fetchAndAddOrdered(0)->at(queue)->owned = false;
+  stoppedThreads << threads.take(worker);
+}
+
+void ctkEAWorkStealingExecutor::signalWork()
+{
+  if (idleWorkers.fetchAndAddOrdered(0) > 0)
+  {
+    QMutexLocker lock(&workerMutex);
+    workAvailable.wakeOne();
+  }
+}
+
+void ctkEAWorkStealingExecutor::runTask(ctkEARunnable* command)
+{
+  const bool autoDelete = command->autoDelete();
+  command->run();
+  if (autoDelete && !command->ref.deref()) delete command;
+}
+
+int ctkEAWorkStealingExecutor::now() const
+{
+  return clock.elapsed() % MSECS_PER_DAY;
+}
+
+void ctkEAWorkStealingExecutor::release(ctkEARunnable* command)
+{
+  if (command->autoDelete() && !command->ref.deref()) delete command;
+}
+
+ctkEAWorkStealingExecutor::Worker::Worker(ctkEAWorkStealingExecutor* executor, int queue,
+                                          ctkEARunnable* firstTask)
+  : executor(executor), queue(queue), firstTask(firstTask)
+{
+}
+
+void ctkEAWorkStealingExecutor::Worker::run()
+{
+  CurrentQueue* current = new CurrentQueue;
+  current->queue = queue;
+  executor->currentQueue.setLocalData(current);
+
+  ctkEARunnable* task = firstTask;
+  firstTask = 0;
+  if (task != 0)
+  {
+    executor->latency[0].ref();
+  }
+
+  forever
+  {
+    if (task == 0)
+    {
+      task = executor->take(queue);
+    }
+    if (task == 0)
+    {
+      if (!executor->waitForWork(this, queue)) break;
+      continue;
+    }
+
+    executor->executed.ref();
+    try
+    {
+      executor->runTask(task);
+    }
+    catch (const ctkEAInterruptedException&)
+    {
+      // interrupted on shutdown, waitForWork() will tell
+    }
+    task = 0;
+  }
+}
@@ -0,0 +1,381 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEAWORKSTEALINGEXECUTOR_P_H
+#define CTKEAWORKSTEALINGEXECUTOR_P_H
+
+#include "ctkEAThreadFactoryUser_p.h"
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QHash>
+#include <QList>
+#include <QThreadStorage>
+#include <QTime>
+#include <QVector>
+#include <QWaitCondition>
+
+/**
+ * A thread pool where each worker thread owns a task queue. The main
+ * supported public method is <code>execute(ctkEARunnable* command)</code>.
+ *
+ * <p>
+ * Commands executed from a worker thread are put into the queue of that
+ * worker, other commands are distributed round-robin across the queues.
+ * A worker takes the oldest command of its own queue and, if its queue is
+ * empty, steals the newest command of the queue of another worker. Hence
+ * threads executing commands concurrently do not contend for a single
+ * queue, while an idle worker still takes over the work of a busy one.
+ *
+ * <p>
+ * A new worker is created for a command if there are fewer than the
+ * minimum pool size workers, or if all queues are full and there are
+ * fewer than the maximum pool size workers. Workers above the minimum
+ * pool size terminate after being idle for the keep alive time.
+ *
+ * <p>
+ * Each queue holds at most <code>capacity</code> commands, a capacity of 0
+ * making the queues unbounded. If all queues are full and no worker can be
+ * added, the blocked execution policy applies back-pressure to the thread
+ * executing the command: it runs the command itself (the default), waits
+ * for room in a queue, discards the command or the oldest queued command,
+ * or throws a ctkRuntimeException.
+ *
+ * <p>
+ * The executor does not order the commands. Callers needing commands to be
+ * executed in order have to submit them as a single command, as the
+ * <code>TaskExecuter</code> of the <code>ctkEAAsyncDeliverTasks</code>
+ * does for the events posted by a thread.
+ */
+class ctkEAWorkStealingExecutor : public ctkEAThreadFactoryUser
+{
+
+public:
+
+  /** The number of buckets of the latency histogram */
+  static const int LATENCY_BUCKETS = 12;
+
+  /**
+   * The counters of the executor.
+   */
+  struct Statistics
+  {
+    Statistics();
+
+    /** The number of worker threads */
+    int poolSize;
+
+    /** The number of commands currently queued */
+    int queued;
+
+    /** The maximum number of commands queued at the same time */
+    int maxQueued;
+
+    /** The number of commands executed by the workers */
+    int executed;
+
+    /** The number of commands a worker took from the queue of another worker */
+    int stolen;
+
+    /** The number of commands subject to the blocked execution policy */
+    int blocked;
+
+    /**
+     * The number of commands by the time they waited before being executed
+     * by a worker: <code>latency[0]</code> counts the commands which did not
+     * wait for a millisecond, <code>latency[i]</code> the commands which
+     * waited from 2^(i-1) to 2^i - 1 milliseconds and the last bucket all
+     * the longer waits.
+     */
+    QVector<int> latency;
+  };
+
+  /**
+   * The default maximum pool size; used if not otherwise specified.
+   * Default value is essentially infinite (std::numeric_limits<int>::max())
+   */
+  static const int DEFAULT_MAXIMUMPOOLSIZE;
+
+  /**
+   * The default minimum pool size; used if not otherwise specified.
+   * Default value is 1.
+   */
+  static const int DEFAULT_MINIMUMPOOLSIZE;
+
+  /**
+   * The default keep alive time for idle workers above the minimum
+   * pool size. Default value is one minute.
+   */
+  static const long DEFAULT_KEEPALIVETIME;
+
+  /**
+   * Create a new pool with queues holding at most <code>capacity</code>
+   * commands per worker, 0 meaning unbounded queues.
+   */
+  ctkEAWorkStealingExecutor(int capacity = 0);
+
+  ~ctkEAWorkStealingExecutor();
+
+  /**
+   * Return the maximum number of threads to simultaneously execute.
+   */
+  int getMaximumPoolSize() const;
+
+  /**
+   * Set the maximum number of threads to use. Decreasing the pool size
+   * will not immediately kill existing threads, but they may later die
+   * when idle.
+   *
+   * @throws ctkInvalidArgumentException if less or equal to zero.
+   */
+  void setMaximumPoolSize(int newMaximum);
+
+  /**
+   * Return the minimum number of threads to simultaneously execute.
+   */
+  int getMinimumPoolSize() const;
+
+  /**
+   * Set the minimum number of threads to use.
+   *
+   * @throws ctkInvalidArgumentException if less than zero.
+   */
+  void setMinimumPoolSize(int newMinimum);
+
+  /**
+   * Return the current number of active threads in the pool.
+   */
+  int getPoolSize() const;
+
+  /**
+   * Return the number of milliseconds to keep threads above the minimum
+   * pool size alive when there is no work.
+   */
+  long getKeepAliveTime() const;
+
+  /**
+   * Set the number of milliseconds to keep threads above the minimum
+   * pool size alive when there is no work.
+   */
+  void setKeepAliveTime(long msecs);
+
+  /**
+   * Return the maximum number of commands queued per worker, 0 if unbounded.
+   */
+  int getCapacity() const;
+
+  /**
+   * Set the policy for blocked execution to be that the current
+   * thread executes the command if all queues are full.
+   */
+  void runWhenBlocked();
+
+  /**
+   * Set the policy for blocked execution to be to wait until a queue
+   * has room, unless the pool has been shut down, in which case
+   * the command is discarded.
+   */
+  void waitWhenBlocked();
+
+  /**
+   * Set the policy for blocked execution to be to return without
+   * executing the command.
+   */
+  void discardWhenBlocked();
+
+  /**
+   * Set the policy for blocked execution to be to throw a
+   * ctkRuntimeException.
+   */
+  void abortWhenBlocked();
+
+  /**
+   * Set the policy for blocked execution to be to discard the oldest
+   * command of a full queue and to queue the new command instead.
+   */
+  void discardOldestWhenBlocked();
+
+  /**
+   * Arrange for the given command to be executed by a thread in this
+   * pool. The method normally returns when the command has been
+   * queued for (possibly later) execution.
+   */
+  void execute(ctkEARunnable* command);
+
+  /**
+   * Interrupt all threads and disable construction of new threads. Queued
+   * commands are discarded, as are commands executed subsequently.
+   */
+  void shutdownNow();
+
+  /**
+   * Wait for a shutdown pool to fully terminate.
+   *
+   * @throws ctkIllegalStateException if shutdown has not been requested
+   */
+  void awaitTerminationAfterShutdown();
+
+  /**
+   * Return the current counters of the executor.
+   */
+  Statistics getStatistics() const;
+
+private:
+
+  enum BlockedPolicy
+  {
+    RUN_WHEN_BLOCKED,
+    WAIT_WHEN_BLOCKED,
+    DISCARD_WHEN_BLOCKED,
+    ABORT_WHEN_BLOCKED,
+    DISCARD_OLDEST_WHEN_BLOCKED
+  };
+
+  struct Entry
+  {
+    ctkEARunnable* command;
+    int queuedAt;
+  };
+
+  /**
+   * The queue of a worker. Queues are reused by new workers but only
+   * deleted with the executor, so that they can be accessed without
+   * holding the lock of the executor.
+   */
+  struct Queue
+  {
+    Queue() : owned(false) {}
+
+    QMutex mutex;
+    QList<Entry> entries;
+    bool owned;
+  };
+
+  /**
+   * Class defining the basic run loop for pooled threads.
+   */
+  class Worker : public ctkEARunnable
+  {
+  public:
+
+    Worker(ctkEAWorkStealingExecutor* executor, int queue, ctkEARunnable* firstTask);
+
+    void run();
+
+  private:
+
+    ctkEAWorkStealingExecutor* executor;
+    const int queue;
+    ctkEARunnable* firstTask;
+  };
+
+  struct CurrentQueue
+  {
+    int queue;
+  };
+
+  const int capacity;
+
+  // Guards the pool configuration, the workers and the wait conditions
+  mutable QMutex workerMutex;
+  QWaitCondition workAvailable;
+  QWaitCondition roomAvailable;
+
+  int maximumPoolSize;
+  int minimumPoolSize;
+  long keepAliveTime;
+  BlockedPolicy blockedPolicy;
+  bool shutdown;
+
+  QHash<Worker*, ctkEAInterruptibleThread*> threads;
+  QList<ctkEAInterruptibleThread*> stoppedThreads;
+
+  // The queues only grow, a new vector being published for each new queue.
+  // The previous vectors are kept until the executor is deleted.
+  QAtomicPointer<QVector<Queue*> > queues;
+  QList<QVector<Queue*>*> retiredQueues;
+
+  QThreadStorage<CurrentQueue*> currentQueue;
+
+  QAtomicInt poolSize;
+  QAtomicInt idleWorkers;
+  QAtomicInt waitingForRoom;
+  QAtomicInt nextQueue;
+  QAtomicInt queued;
+
+  // The milliseconds of the queuedAt stamps
+  QTime clock;
+
+  QAtomicInt maxQueued;
+  QAtomicInt executed;
+  QAtomicInt stolen;
+  QAtomicInt blocked;
+  QAtomicInt latency[LATENCY_BUCKETS];
+
+  /**
+   * Try to queue the command, first into the queue of the current worker
+   * if the command is executed by a worker.
+   */
+  bool offer(ctkEARunnable* command);
+
+  /**
+   * Remove the oldest command of a queue, releasing it.
+   */
+  bool discardOldest();
+
+  /**
+   * Take a command from the given queue or steal one from another queue.
+   */
+  ctkEARunnable* take(int queue);
+
+  /**
+   * Create and start a worker for a new command, which may be null.
+   * Call only when holding the workerMutex.
+   */
+  void addWorker(ctkEARunnable* firstTask);
+
+  /**
+   * Wait for a command to be queued, and return false if the worker
+   * should terminate.
+   */
+  bool waitForWork(Worker* worker, int queue);
+
+  /**
+   * Cleanup method called upon termination of worker thread.
+   * Call only when holding the workerMutex.
+   */
+  void workerDone(Worker* worker, int queue);
+
+  /**
+   * Wake an idle worker after a command was queued.
+   */
+  void signalWork();
+
+  void runTask(ctkEARunnable* command);
+
+  int now() const;
+
+  static void release(ctkEARunnable* command);
+
+};
+
+#endif // CTKEAWORKSTEALINGEXECUTOR_P_H
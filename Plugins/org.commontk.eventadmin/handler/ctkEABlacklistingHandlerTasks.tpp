@@ -20,73 +20,90 @@
 =============================================================================*/
 
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+template<class BlackList, class Filters>
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 ctkEABlacklistingHandlerTasks(ctkPluginContext* context,
                               ctkEABlackList<BlackList>* blackList,
-                              ctkEATopicHandlerFilters<TopicHandlerFilters>* topicHandlerFilters,
-                              ctkEAFilters<Filters>* filters)
-  : blackList(blackList), context(context),
-    topicHandlerFilters(topicHandlerFilters), filters(filters)
+                              ctkEATopicHandlerIndex<Filters>* handlerIndex)
+  : blackList(blackList), context(context), handlerIndex(handlerIndex)
 {
   checkNull(context, "Context");
   checkNull(blackList, "BlackList");
-  checkNull(topicHandlerFilters, "TopicHandlerFilters");
-  checkNull(filters, "Filters");
+  checkNull(handlerIndex, "HandlerIndex");
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+template<class BlackList, class Filters>
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 ~ctkEABlacklistingHandlerTasks()
 {
-  delete filters;
-  delete topicHandlerFilters;
+  delete handlerIndex;
   delete blackList;
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
-QList<ctkEAHandlerTask<ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> > >
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+template<class BlackList, class Filters>
+QList<ctkEAHandlerTask<ctkEABlacklistingHandlerTasks<BlackList, Filters> > >
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 createHandlerTasks(const ctkEvent& event)
 {
   QList<ctkEAHandlerTask<Self> > result;
-  QList<ctkServiceReference> handlerRefs;
+  const QList<ctkEATopicHandler> handlers = handlerIndex->getHandlers(event.getTopic());
 
-  try
+  for (int i = 0; i < handlers.size(); ++i)
   {
-    handlerRefs = context->getServiceReferences<ctkEventHandler>(
-          topicHandlerFilters->createFilterForTopic(event.getTopic()));
-  }
-  catch (const ctkInvalidArgumentException& e)
-  {
-    CTK_WARN_EXC(ctkEventAdminActivator::getLogService(), &e)
-        << "Invalid EVENT_TOPIC [" << event.getTopic() << "]";
+    const ctkEATopicHandler& handler = handlers.at(i);
+    if (accepts(handler, event))
+    {
+      result.push_back(ctkEAHandlerTask<Self>(handler.ref, event, this, handler.batch));
+    }
   }
 
-  for (int i = 0; i < handlerRefs.size(); ++i)
+  return result;
+}
+
+template<class BlackList, class Filters>
+QList<ctkEAHandlerTask<ctkEABlacklistingHandlerTasks<BlackList, Filters> > >
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
+createHandlerTasks(const QList<ctkEvent>& events)
+{
+  QList<ctkEAHandlerTask<Self> > result;
+
+  // The handlers of the topics of the batch
+  QHash<QString, QList<ctkEATopicHandler> > topicHandlers;
+
+  // The position of the task of each batch handler in the result
+  QHash<ctkServiceReference, int> batchTasks;
+
+  foreach (const ctkEvent& event, events)
   {
-    const ctkServiceReference& ref = handlerRefs.at(i);
-    if (!blackList->contains(ref)
-        //TODO security
-        //&& ref.getPlugin()->hasPermission(
-        //  PermissionsUtil.createSubscribePermission(event.getTopic()))
-        )
+    const QString topic = event.getTopic();
+    typename QHash<QString, QList<ctkEATopicHandler> >::iterator it = topicHandlers.find(topic);
+    if (it == topicHandlers.end())
+    {
+      it = topicHandlers.insert(topic, handlerIndex->getHandlers(topic));
+    }
+    const QList<ctkEATopicHandler>& handlers = it.value();
+
+    for (int i = 0; i < handlers.size(); ++i)
     {
-      try
+      const ctkEATopicHandler& handler = handlers.at(i);
+      if (!accepts(handler, event))
       {
-        if (event.matches(filters->createFilter(
-                            ref.getProperty(ctkEventConstants::EVENT_FILTER).toString())))
+        continue;
+      }
+
+      const ctkEAHandlerTask<Self> task(handler.ref, event, this, handler.batch);
+      const int pos = handler.batch ? batchTasks.value(handler.ref, -1) : -1;
+      if (pos < 0)
+      {
+        if (handler.batch)
         {
-          result.push_back(ctkEAHandlerTask<Self>(ref, event, this));
+          batchTasks.insert(handler.ref, result.size());
         }
+        result.push_back(task);
       }
-      catch (const ctkInvalidArgumentException& e)
+      else
       {
-        CTK_WARN_SR_EXC(ctkEventAdminActivator::getLogService(), ref, &e)
-            << "Invalid EVENT_FILTER - Blacklisting ServiceReference ["
-            << ref << " | Plugin(" << ref.getPlugin() << ")]";
-
-        blackList->add(ref);
+        result[pos].append(task);
       }
     }
   }
@@ -94,9 +111,38 @@ createHandlerTasks(const ctkEvent& event)
   return result;
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
+bool
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
+accepts(const ctkEATopicHandler& handler, const ctkEvent& event)
+{
+  const ctkServiceReference& ref = handler.ref;
+  if (blackList->contains(ref)
+      //TODO security
+      //|| !ref.getPlugin()->hasPermission(
+      //  PermissionsUtil.createSubscribePermission(event.getTopic()))
+      )
+  {
+    return false;
+  }
+
+  if (!handler.filterError.isEmpty())
+  {
+    CTK_WARN_SR(ctkEventAdminActivator::getLogService(), ref)
+        << "Invalid EVENT_FILTER (" << handler.filterError
+        << ") - Blacklisting ServiceReference ["
+        << ref << " | Plugin(" << ref.getPlugin() << ")]";
+
+    blackList->add(ref);
+    return false;
+  }
+
+  return event.matches(handler.filter);
+}
+
+template<class BlackList, class Filters>
 void
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 blackListRef(const ctkServiceReference& handlerRef)
 {
   blackList->add(handlerRef);
@@ -106,9 +152,9 @@ blackListRef(const ctkServiceReference& handlerRef)
       << handlerRef.getPlugin() << ")] due to timeout!";
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 ctkEventHandler*
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 getEventHandler(const ctkServiceReference& handlerRef)
 {
   ctkEventHandler* result = (blackList->contains(handlerRef)) ? 0
@@ -117,9 +163,9 @@ getEventHandler(const ctkServiceReference& handlerRef)
   return (result ? result : &nullEventHandler);
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 void
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 ungetEventHandler(ctkEventHandler* handler,
                        const ctkServiceReference& handlerRef)
 {
@@ -134,9 +180,9 @@ ungetEventHandler(ctkEventHandler* handler,
   }
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 void
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 checkNull(void* object, const QString& name)
 {
   if(object == 0)
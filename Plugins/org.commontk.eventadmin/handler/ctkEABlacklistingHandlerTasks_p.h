@@ -30,28 +30,24 @@
 #include <service/event/ctkEventConstants.h>
 #include <service/event/ctkEventHandler.h>
 
-#include "ctkEATopicHandlerFilters_p.h"
-#include "ctkEAFilters_p.h"
+#include "ctkEATopicHandlerIndex_p.h"
 #include "ctkEABlackList_p.h"
 
 /**
  * This class is an implementation of the ctkEAHandlerTasks interface that does provide
- * blacklisting of event handlers. Furthermore, handlers are determined from the
- * framework on any call to <tt>createHandlerTasks()</tt> hence, there is no
- * book-keeping of <tt>ctkEventHandler</tt> services while they come and go but a
- * query for each sent event. In order to do this, an ldap-filter is created that
- * will match applicable <tt>ctkEventHandler</tt> references. In order to ease some of
- * the overhead pains of this approach some light caching is going on.
+ * blacklisting of event handlers. Furthermore, handlers are determined from a
+ * topic index of the <tt>ctkEventHandler</tt> services that is updated while they
+ * come and go, hence there is no query of the framework for each sent event.
  */
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 class ctkEABlacklistingHandlerTasks :
     public ctkEAHandlerTasks<
-    ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> >
+    ctkEABlacklistingHandlerTasks<BlackList, Filters> >
 {
 
 private:
 
-  typedef ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> Self;
+  typedef ctkEABlacklistingHandlerTasks<BlackList, Filters> Self;
 
   // The blacklist that holds blacklisted event handler service references
   ctkEABlackList<BlackList>* const blackList;
@@ -59,13 +55,9 @@ private:
   // The context of the plugin used to get the actual event handler services
   ctkPluginContext* const context;
 
-  // Used to create the filters that can determine applicable event handlers for
-  // a given event
-  ctkEATopicHandlerFilters<TopicHandlerFilters>* topicHandlerFilters;
-
-  // Used to create the filters that are used to determine whether an applicable
-  // event handler is interested in a particular event
-  ctkEAFilters<Filters>* filters;
+  // Used to determine the applicable event handlers for a given event and
+  // their filters that determine whether a handler is interested in it
+  ctkEATopicHandlerIndex<Filters>* handlerIndex;
 
 public:
 
@@ -74,13 +66,11 @@ public:
    *
    * @param context The context of the plugin
    * @param blackList The set to use for keeping track of blacklisted references
-   * @param topicHandlerFilters The factory for topic handler filters
-   * @param filters The factory for <tt>ctkLDAPSearchFilter</tt> objects
+   * @param handlerIndex The opened topic index of the event handlers
    */
   ctkEABlacklistingHandlerTasks(ctkPluginContext* context,
                                 ctkEABlackList<BlackList>* blackList,
-                                ctkEATopicHandlerFilters<TopicHandlerFilters>* topicHandlerFilters,
-                                ctkEAFilters<Filters>* filters);
+                                ctkEATopicHandlerIndex<Filters>* handlerIndex);
 
   ~ctkEABlacklistingHandlerTasks();
 
@@ -96,6 +86,21 @@ public:
    */
   QList<ctkEAHandlerTask<Self> > createHandlerTasks(const ctkEvent& event);
 
+  /**
+   * Create the handler tasks for the events. The handlers of a topic are
+   * determined once for all events of the batch. A handler receiving batches
+   * gets a single task with all its events, at the position of its first event;
+   * other handlers get a task per event.
+   *
+   * @param events The events for which' handlers delivery tasks must be created
+   *
+   * @return The delivery tasks for the handlers matching the given events, in
+   *      the order of the events
+   *
+   * @see ctkHandlerTasks#createHandlerTasks(const QList<ctkEvent>&)
+   */
+  QList<ctkEAHandlerTask<Self> > createHandlerTasks(const QList<ctkEvent>& events);
+
   /**
    * Blacklist the given service reference. This is a private method and only
    * public due to its usage in a friend class.
@@ -152,6 +157,12 @@ private:
 
   NullEventHandler nullEventHandler;
 
+  /*
+   * Return whether the event is delivered to the handler, blacklisting the
+   * handler if its EVENT_FILTER is invalid.
+   */
+  bool accepts(const ctkEATopicHandler& handler, const ctkEvent& event);
+
   /*
    * This is a utility method that will throw a <tt>ctkInvalidArgumentException</tt>
    * in case that the given object is null. The message will be of the form name +
@@ -20,43 +20,30 @@
 =============================================================================*/
 
 
-#ifndef CTKSOAPCONNECTIONRUNNABLE_P_H
-#define CTKSOAPCONNECTIONRUNNABLE_P_H
+#ifndef CTKEASERVICELISTENER_P_H
+#define CTKEASERVICELISTENER_P_H
 
 #include <QObject>
-#include <QRunnable>
-#include <QTcpSocket>
 
-#include <qtsoap.h>
+#include <ctkServiceEvent.h>
 
-class ctkSoapConnectionRunnable : public QObject, public QRunnable
+/**
+ * Receives the service events for the event admin classes that are
+ * templates and hence cannot declare slots themselves.
+ */
+class ctkEAServiceListener : public QObject
 {
   Q_OBJECT
 
-public:
+public Q_SLOTS:
 
-  ctkSoapConnectionRunnable(int socketDescriptor);
-  virtual ~ctkSoapConnectionRunnable();
-
-  void run();
-
-Q_SIGNALS:
-
-  void incomingSoapMessage(const QtSoapMessage& message, QtSoapMessage* reply);
-  void incomingWSDLMessage(const QString& message, QString* reply);
-
-protected Q_SLOTS:
-
-  void aboutToQuit();
-
-private:
-
-  void readClient(QTcpSocket& socket);
-
-  int socketDescriptor;
-
-  QAtomicInt isAboutToQuit;
+  /**
+   * Slot connected to service events.
+   *
+   * @param event The service event from the framework
+   */
+  virtual void serviceChanged(const ctkServiceEvent& event) = 0;
 
 };
 
-#endif // CTKSOAPCONNECTIONRUNNABLE_P_H
+#endif // CTKEASERVICELISTENER_P_H
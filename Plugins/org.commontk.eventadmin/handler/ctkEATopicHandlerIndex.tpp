@@ -0,0 +1,323 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include <ctkException.h>
+#include <ctkPluginConstants.h>
+#include <service/event/ctkEventConstants.h>
+#include <service/event/ctkEventHandler.h>
+
+template<class Filters>
+ctkEATopicHandlerIndex<Filters>::Node::
+~Node()
+{
+  qDeleteAll(children);
+}
+
+template<class Filters>
+bool
+ctkEATopicHandlerIndex<Filters>::Node::
+isEmpty() const
+{
+  return children.isEmpty() && handlers.isEmpty() && wildcardHandlers.isEmpty();
+}
+
+template<class Filters>
+ctkEATopicHandlerIndex<Filters>::
+ctkEATopicHandlerIndex(ctkPluginContext* context,
+                       ctkEAFilters<Filters>* filters,
+                       bool requireTopic)
+  : context(context), filters(filters), requireTopic(requireTopic)
+{
+  if (context == 0)
+  {
+    throw ctkInvalidArgumentException("Context may not be null");
+  }
+
+  if (filters == 0)
+  {
+    throw ctkInvalidArgumentException("Filters may not be null");
+  }
+}
+
+template<class Filters>
+ctkEATopicHandlerIndex<Filters>::
+~ctkEATopicHandlerIndex()
+{
+  try
+  {
+    context->disconnectServiceListener(this, "serviceChanged");
+  }
+  catch (const ctkIllegalStateException&)
+  {
+    // the plugin is already stopped
+  }
+
+  qDeleteAll(handlers);
+  delete filters;
+}
+
+template<class Filters>
+void
+ctkEATopicHandlerIndex<Filters>::
+open()
+{
+  // listen first, so that no handler registered in between is missed
+  context->connectServiceListener(this, "serviceChanged",
+                                  QString("(") + ctkPluginConstants::OBJECTCLASS + "="
+                                  + qobject_interface_iid<ctkEventHandler*>() + ")");
+
+  QList<ctkServiceReference> refs = context->getServiceReferences<ctkEventHandler>();
+
+  QWriteLocker l(&lock);
+  foreach (ctkServiceReference ref, refs)
+  {
+    // a handler already known from a service event has the latest properties
+    if (!handlers.contains(ref) && ref.getPlugin())
+    {
+      addHandler(ref);
+    }
+  }
+}
+
+template<class Filters>
+QList<ctkEATopicHandler>
+ctkEATopicHandlerIndex<Filters>::
+getHandlers(const QString& topic) const
+{
+  QList<ctkEATopicHandler> result;
+  QList<const Handler*> appended;
+
+  QReadLocker l(&lock);
+
+  if (!requireTopic)
+  {
+    appendHandlers(noTopicHandlers, result, appended);
+  }
+
+  // walk down the levels of the topic - as a simple example:
+  // topic=org/commontk/TEST
+  // result = handlers of *, org/*, org/commontk/* and org/commontk/TEST
+  const Node* node = &root;
+  int start = 0;
+  forever
+  {
+    appendHandlers(node->wildcardHandlers, result, appended);
+
+    int end = topic.indexOf('/', start);
+    const QString name = QString::fromRawData(topic.constData() + start,
+                                              (end < 0 ? topic.size() : end) - start);
+    node = node->children.value(name);
+    if (node == 0)
+    {
+      break;
+    }
+    if (end < 0)
+    {
+      appendHandlers(node->handlers, result, appended);
+      break;
+    }
+    start = end + 1;
+  }
+
+  return result;
+}
+
+template<class Filters>
+void
+ctkEATopicHandlerIndex<Filters>::
+serviceChanged(const ctkServiceEvent& event)
+{
+  QWriteLocker l(&lock);
+
+  switch (event.getType())
+  {
+  case ctkServiceEvent::REGISTERED:
+  case ctkServiceEvent::MODIFIED:
+    addHandler(event.getServiceReference());
+    break;
+  case ctkServiceEvent::UNREGISTERING:
+    removeHandler(event.getServiceReference());
+    break;
+  default:
+    break;
+  }
+}
+
+template<class Filters>
+void
+ctkEATopicHandlerIndex<Filters>::
+addHandler(const ctkServiceReference& ref)
+{
+  // the topics or the filter of a modified handler may have changed
+  removeHandler(ref);
+
+  Handler* handler = new Handler;
+  handler->handler.ref = ref;
+  handler->topics = getTopics(ref);
+
+  try
+  {
+    handler->handler.filter = filters->createFilter(
+          ref.getProperty(ctkEventConstants::EVENT_FILTER).toString());
+  }
+  catch (const ctkInvalidArgumentException& e)
+  {
+    handler->handler.filterError = e.what();
+  }
+
+  QVariant delivery = ref.getProperty(ctkEventConstants::EVENT_DELIVERY);
+  handler->handler.batch = delivery.toStringList().contains(ctkEventConstants::DELIVERY_ASYNC_BATCH);
+
+  if (handler->topics.isEmpty())
+  {
+    noTopicHandlers.push_back(handler);
+  }
+
+  foreach (QString topic, handler->topics)
+  {
+    if (topic == "*")
+    {
+      root.wildcardHandlers.push_back(handler);
+    }
+    else if (topic.endsWith("/*"))
+    {
+      getNode(topic.left(topic.size() - 2))->wildcardHandlers.push_back(handler);
+    }
+    else
+    {
+      getNode(topic)->handlers.push_back(handler);
+    }
+  }
+
+  handlers.insert(ref, handler);
+}
+
+template<class Filters>
+void
+ctkEATopicHandlerIndex<Filters>::
+removeHandler(const ctkServiceReference& ref)
+{
+  Handler* handler = handlers.take(ref);
+  if (handler == 0)
+  {
+    return;
+  }
+
+  if (handler->topics.isEmpty())
+  {
+    noTopicHandlers.removeAll(handler);
+  }
+
+  foreach (QString topic, handler->topics)
+  {
+    if (topic == "*")
+    {
+      root.wildcardHandlers.removeAll(handler);
+    }
+    else if (topic.endsWith("/*"))
+    {
+      removeFromNode(&root, topic.left(topic.size() - 2).split('/'), 0, true, handler);
+    }
+    else
+    {
+      removeFromNode(&root, topic.split('/'), 0, false, handler);
+    }
+  }
+
+  delete handler;
+}
+
+template<class Filters>
+typename ctkEATopicHandlerIndex<Filters>::Node*
+ctkEATopicHandlerIndex<Filters>::
+getNode(const QString& path)
+{
+  Node* node = &root;
+  foreach (QString name, path.split('/'))
+  {
+    Node*& child = node->children[name];
+    if (child == 0)
+    {
+      child = new Node;
+    }
+    node = child;
+  }
+  return node;
+}
+
+template<class Filters>
+void
+ctkEATopicHandlerIndex<Filters>::
+removeFromNode(Node* node, const QStringList& path, int level,
+               bool wildcard, Handler* handler)
+{
+  if (level == path.size())
+  {
+    (wildcard ? node->wildcardHandlers : node->handlers).removeAll(handler);
+    return;
+  }
+
+  Node* child = node->children.value(path[level]);
+  if (child == 0)
+  {
+    return;
+  }
+
+  removeFromNode(child, path, level + 1, wildcard, handler);
+  if (child->isEmpty())
+  {
+    node->children.remove(path[level]);
+    delete child;
+  }
+}
+
+template<class Filters>
+void
+ctkEATopicHandlerIndex<Filters>::
+appendHandlers(const QList<Handler*>& nodeHandlers,
+               QList<ctkEATopicHandler>& result,
+               QList<const Handler*>& appended)
+{
+  for (int i = 0; i < nodeHandlers.size(); ++i)
+  {
+    const Handler* handler = nodeHandlers.at(i);
+    // only a handler with several topics can be found on several nodes
+    if (handler->topics.size() > 1)
+    {
+      if (appended.contains(handler))
+      {
+        continue;
+      }
+      appended.push_back(handler);
+    }
+    result.push_back(handler->handler);
+  }
+}
+
+template<class Filters>
+QStringList
+ctkEATopicHandlerIndex<Filters>::
+getTopics(const ctkServiceReference& ref)
+{
+  // a single topic is converted to a list with that topic
+  return ref.getProperty(ctkEventConstants::EVENT_TOPIC).toStringList();
+}
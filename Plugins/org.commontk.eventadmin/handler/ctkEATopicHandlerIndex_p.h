@@ -0,0 +1,180 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEATOPICHANDLERINDEX_P_H
+#define CTKEATOPICHANDLERINDEX_P_H
+
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QStringList>
+
+#include <ctkPluginContext.h>
+#include <ctkServiceReference.h>
+
+#include "ctkEAServiceListener_p.h"
+#include "ctkEAFilters_p.h"
+
+/**
+ * An event handler subscribed to a topic, together with its precompiled
+ * <tt>EVENT_FILTER</tt>.
+ */
+struct ctkEATopicHandler
+{
+  ctkServiceReference ref;
+
+  ctkLDAPSearchFilter filter;
+
+  // The reason why the EVENT_FILTER of the handler is invalid or an empty
+  // string if the filter is valid
+  QString filterError;
+
+  // Whether the handler receives the events of a batch in a single call,
+  // by having <tt>async.batch</tt> as one of its <tt>EVENT_DELIVERY</tt> values
+  bool batch;
+
+  ctkEATopicHandler() : batch(false) {}
+};
+
+/**
+ * This class keeps track of the <tt>ctkEventHandler</tt> services in a trie of
+ * the topics they subscribed to. The trie is updated from the service events of
+ * the handlers, hence the handlers of an event are found by walking the levels
+ * of its topic instead of querying the framework with an ldap-filter for each
+ * event. A handler subscribed to <tt>org/commontk/*</tt> is kept as a wildcard
+ * handler of the <tt>org/commontk</tt> node and matches the topics below it.
+ *
+ * The <tt>EVENT_FILTER</tt> of a handler is created once, when the handler is
+ * registered or its properties are modified.
+ */
+template<class Filters>
+class ctkEATopicHandlerIndex : public ctkEAServiceListener
+{
+
+private:
+
+  struct Handler
+  {
+    ctkEATopicHandler handler;
+
+    QStringList topics;
+  };
+
+  struct Node
+  {
+    // The sub-topics of this node, by their name
+    QHash<QString, Node*> children;
+
+    // The handlers subscribed to the topic of this node
+    QList<Handler*> handlers;
+
+    // The handlers subscribed to all topics below this node
+    QList<Handler*> wildcardHandlers;
+
+    ~Node();
+
+    bool isEmpty() const;
+  };
+
+  // The context of the plugin used to track the event handler services
+  ctkPluginContext* const context;
+
+  // Used to create the filters of the event handlers
+  ctkEAFilters<Filters>* const filters;
+
+  const bool requireTopic;
+
+  mutable QReadWriteLock lock;
+
+  Node root;
+
+  // The handlers without an EVENT_TOPIC property
+  QList<Handler*> noTopicHandlers;
+
+  QHash<ctkServiceReference, Handler*> handlers;
+
+public:
+
+  /**
+   * The constructor of the index. The index is empty until it is opened.
+   *
+   * @param context The context of the plugin
+   * @param filters The factory for the <tt>ctkLDAPSearchFilter</tt> objects of
+   *        the handlers
+   * @param requireTopic Whether handlers without an <tt>EVENT_TOPIC</tt>
+   *        property are ignored or receive all events
+   */
+  ctkEATopicHandlerIndex(ctkPluginContext* context,
+                         ctkEAFilters<Filters>* filters,
+                         bool requireTopic);
+
+  ~ctkEATopicHandlerIndex();
+
+  /**
+   * Start tracking the registered <tt>ctkEventHandler</tt> services.
+   */
+  void open();
+
+  /**
+   * Get the event handlers that subscribed to the given topic. A handler
+   * is returned once, even if several of its topics match.
+   *
+   * @param topic The topic of an event
+   *
+   * @return The handlers subscribed to the topic
+   */
+  QList<ctkEATopicHandler> getHandlers(const QString& topic) const;
+
+  void serviceChanged(const ctkServiceEvent& event);
+
+private:
+
+  void addHandler(const ctkServiceReference& ref);
+
+  void removeHandler(const ctkServiceReference& ref);
+
+  /*
+   * Get the node of the given topic path, creating the missing nodes.
+   */
+  Node* getNode(const QString& path);
+
+  /*
+   * Remove the handler from the node of the given topic path and the nodes
+   * which are empty afterwards.
+   */
+  void removeFromNode(Node* node, const QStringList& path, int level,
+                      bool wildcard, Handler* handler);
+
+  /*
+   * Append the handlers to the result, skipping the handlers with several
+   * topics that were already appended.
+   */
+  static void appendHandlers(const QList<Handler*>& nodeHandlers,
+                             QList<ctkEATopicHandler>& result,
+                             QList<const Handler*>& appended);
+
+  static QStringList getTopics(const ctkServiceReference& ref);
+};
+
+#include "ctkEATopicHandlerIndex.tpp"
+
+#endif // CTKEATOPICHANDLERINDEX_P_H
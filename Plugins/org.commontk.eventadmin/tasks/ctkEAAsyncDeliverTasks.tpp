@@ -28,17 +28,71 @@ private:
 
   typedef ctkEAAsyncDeliverTasks<SyncDeliverTasks, HandlerTask> TopClass;
 
+  // QTime wraps at midnight
+  static const int MSECS_PER_DAY = 24 * 60 * 60 * 1000;
+
+  struct Pending
+  {
+    Pending(const HandlerTask& task, int postedAt)
+      : task(task), postedAt(postedAt)
+    {}
+
+    HandlerTask task;
+
+    // The time the last event of the task was posted at
+    int postedAt;
+  };
+
   TopClass* tc;
 
-  QList<HandlerTask> tasks;
+  QList<Pending*> tasks;
+
+  // The last pending task of each handler, which later tasks for the
+  // handler may be appended to or coalesced with
+  QHash<ctkServiceReference, Pending*> lastPending;
+
   QMutex tasksMutex;
   QThread* key;
 
+  // Call only when holding the tasksMutex
+  void enqueue(const HandlerTask& task, int postedAt)
+  {
+    const ctkServiceReference ref = task.getHandlerRef();
+    Pending* last = lastPending.value(ref);
+    if (last)
+    {
+      const int window = task.getCoalesceWindow();
+      int since = postedAt - last->postedAt;
+      if (since < 0) since += MSECS_PER_DAY;
+      if (window > 0 && since <= window && last->task.coalesce(task))
+      {
+        last->postedAt = postedAt;
+        return;
+      }
+      if (last->task.isBatch() && task.isBatch())
+      {
+        last->task.append(task);
+        last->postedAt = postedAt;
+        return;
+      }
+    }
+
+    Pending* pending = new Pending(task, postedAt);
+    tasks.push_back(pending);
+    lastPending.insert(ref, pending);
+  }
+
 public:
 
   TaskExecuter(TopClass* tc, const QList<HandlerTask>& tasks, QThread* key)
-    : tc(tc), tasks(tasks), key(key)
+    : tc(tc), key(key)
+  {
+    add(tasks);
+  }
+
+  ~TaskExecuter()
   {
+    qDeleteAll(tasks);
   }
 
   void run()
@@ -50,7 +104,14 @@ public:
 
       {
         QMutexLocker l(&tasksMutex);
-        currTasks.push_back(tasks.takeFirst());
+        Pending* pending = tasks.takeFirst();
+        const ctkServiceReference ref = pending->task.getHandlerRef();
+        if (lastPending.value(ref) == pending)
+        {
+          lastPending.remove(ref);
+        }
+        currTasks.push_back(pending->task);
+        delete pending;
       }
       tc->deliver_task->execute(currTasks);
       {
@@ -59,7 +120,7 @@ public:
         if (!running)
         {
           ctkEARunnable* runnable = tc->running_threads.take(key);
-          if (runnable->autoDelete() && !--runnable->ref) delete runnable;
+          if (runnable->autoDelete() && !runnable->ref.deref()) delete runnable;
         }
       }
     } while (running);
@@ -67,8 +128,12 @@ public:
 
   void add(const QList<HandlerTask>& newTasks)
   {
+    const int postedAt = tc->clock.elapsed() % MSECS_PER_DAY;
     QMutexLocker l(&tasksMutex);
-    tasks.append(newTasks);
+    foreach (const HandlerTask& task, newTasks)
+    {
+      enqueue(task, postedAt);
+    }
   }
 };
 
@@ -76,6 +141,7 @@ template<class SyncDeliverTasks, class HandlerTask>
 ctkEAAsyncDeliverTasks<SyncDeliverTasks, HandlerTask>::ctkEAAsyncDeliverTasks(ctkEADefaultThreadPool* pool, DeliverTask* deliverTask)
  : pool(pool), deliver_task(deliverTask)
 {
+  clock.start();
 }
 
 template<class SyncDeliverTasks, class HandlerTask>
@@ -93,7 +159,7 @@ void ctkEAAsyncDeliverTasks<SyncDeliverTasks, HandlerTask>::execute(const QList<
     else
     {
       executer = new TaskExecuter(this, tasks, currentThread);
-      ++executer->ref;
+      executer->ref.ref();
       running_threads.insert(currentThread, executer);
     }
   }
@@ -26,10 +26,18 @@
 #include "ctkEADeliverTask_p.h"
 #include <dispatch/ctkEADefaultThreadPool_p.h>
 
+#include <QTime>
+
 class ctkEARunnable;
 
 /**
  * This class does the actual work of the asynchronous event dispatch.
+ *
+ * The tasks posted by a thread wait in the queue of the executer of that
+ * thread. A task for a handler receiving batches is appended to the waiting
+ * task of the same handler, and an event with the <tt>event.coalesce</tt>
+ * property replaces a waiting event of the same topic for the same handler
+ * if that was posted within the given window.
  */
 template<class SyncDeliverTasks, class HandlerTask>
 class ctkEAAsyncDeliverTasks : public ctkEADeliverTask<ctkEAAsyncDeliverTasks<SyncDeliverTasks,HandlerTask>, HandlerTask>
@@ -52,6 +60,9 @@ private:
   QHash<QThread*, ctkEARunnable*> running_threads;
   QMutex running_threads_mutex;
 
+  /** The milliseconds of the times the events were posted at */
+  QTime clock;
+
 public:
 
   /**
@@ -19,6 +19,7 @@
 
 =============================================================================*/
 
+#include <service/event/ctkEventConstants.h>
 #include <service/event/ctkEventHandler.h>
 
 #include <ctkEventAdminActivator_p.h>
@@ -60,16 +61,17 @@ private:
 
 template<class BlacklistingHandlerTasks>
 ctkEAHandlerTask<BlacklistingHandlerTasks>::ctkEAHandlerTask(const ctkServiceReference& eventHandlerRef,
-                                                             const ctkEvent& event, BlacklistingHandlerTasks* handlerTasks)
-  : eventHandlerRef(eventHandlerRef), event(event), handlerTasks(handlerTasks)
+                                                             const ctkEvent& event, BlacklistingHandlerTasks* handlerTasks,
+                                                             bool batch)
+  : eventHandlerRef(eventHandlerRef), batch(batch), handlerTasks(handlerTasks)
 {
-
+  events.push_back(event);
 }
 
 template<class BlacklistingHandlerTasks>
 ctkEAHandlerTask<BlacklistingHandlerTasks>::ctkEAHandlerTask(const Self& task)
-  : eventHandlerRef(task.eventHandlerRef), event(task.event),
-    handlerTasks(task.handlerTasks)
+  : eventHandlerRef(task.eventHandlerRef), events(task.events),
+    batch(task.batch), handlerTasks(task.handlerTasks)
 {
 
 }
@@ -79,7 +81,8 @@ ctkEAHandlerTask<BlacklistingHandlerTasks>&
 ctkEAHandlerTask<BlacklistingHandlerTasks>::operator=(const Self& task)
 {
   eventHandlerRef = task.eventHandlerRef;
-  event = task.event;
+  events = task.events;
+  batch = task.batch;
   handlerTasks = task.handlerTasks;
   return *this;
 }
@@ -91,22 +94,76 @@ QString ctkEAHandlerTask<BlacklistingHandlerTasks>::getHandlerClassName() const
   return handler->metaObject()->className();
 }
 
+template<class BlacklistingHandlerTasks>
+ctkServiceReference ctkEAHandlerTask<BlacklistingHandlerTasks>::getHandlerRef() const
+{
+  return eventHandlerRef;
+}
+
+template<class BlacklistingHandlerTasks>
+bool ctkEAHandlerTask<BlacklistingHandlerTasks>::isBatch() const
+{
+  return batch;
+}
+
+template<class BlacklistingHandlerTasks>
+int ctkEAHandlerTask<BlacklistingHandlerTasks>::getCoalesceWindow() const
+{
+  return events.back().getProperty(ctkEventConstants::EVENT_COALESCE).toInt();
+}
+
+template<class BlacklistingHandlerTasks>
+void ctkEAHandlerTask<BlacklistingHandlerTasks>::append(const Self& task)
+{
+  events << task.events;
+}
+
+template<class BlacklistingHandlerTasks>
+bool ctkEAHandlerTask<BlacklistingHandlerTasks>::coalesce(const Self& task)
+{
+  if (events.back().getTopic() != task.events.back().getTopic())
+  {
+    return false;
+  }
+  events.back() = task.events.back();
+  return true;
+}
+
 template<class BlacklistingHandlerTasks>
 void ctkEAHandlerTask<BlacklistingHandlerTasks>::execute()
 {
   // Get the service object
   ctkEventHandler* const handler = _GetAndUngetEventHandler(handlerTasks, eventHandlerRef).getHandler();
 
-  try
+  if (batch)
   {
-    handler->handleEvent(event);
+    try
+    {
+      handler->handleEvents(events);
+    }
+    catch (const std::exception& e)
+    {
+      CTK_WARN_SR_EXC(ctkEventAdminActivator::getLogService(), eventHandlerRef, &e)
+          << "Exception during event dispatch [" << events.size() << " events of topic "
+          << events.front().getTopic() << "| Plugin("
+          << eventHandlerRef.getPlugin()->getSymbolicName() << ")]";
+    }
+    return;
   }
-  catch (const std::exception& e)
+
+  foreach (const ctkEvent& event, events)
   {
-    // The spec says that we must catch exceptions and log them:
-    CTK_WARN_SR_EXC(ctkEventAdminActivator::getLogService(), eventHandlerRef, &e)
-        << "Exception during event dispatch [" << event.getTopic() << "| Plugin("
-        << eventHandlerRef.getPlugin()->getSymbolicName() << ")]";
+    try
+    {
+      handler->handleEvent(event);
+    }
+    catch (const std::exception& e)
+    {
+      // The spec says that we must catch exceptions and log them:
+      CTK_WARN_SR_EXC(ctkEventAdminActivator::getLogService(), eventHandlerRef, &e)
+          << "Exception during event dispatch [" << event.getTopic() << "| Plugin("
+          << eventHandlerRef.getPlugin()->getSymbolicName() << ")]";
+    }
   }
 }
 
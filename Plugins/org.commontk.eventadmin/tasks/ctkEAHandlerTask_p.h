@@ -24,13 +24,16 @@
 #define CTKEAHANDLERTASK_P_H
 
 #include <QAtomicInt>
+#include <QList>
 
 #include <ctkServiceReference.h>
 #include <service/event/ctkEvent.h>
 
 /**
- * A task that will deliver its event to its <tt>ctkEventHandler</tt> when executed
- * or blacklist the handler, respectively.
+ * A task that will deliver its events to its <tt>ctkEventHandler</tt> when executed
+ * or blacklist the handler, respectively. A task holds a single event unless
+ * the handler receives batches, in which case the events posted together or
+ * still waiting for the handler are appended to one task.
  */
 template<class BlacklistingHandlerTasks>
 class ctkEAHandlerTask
@@ -43,8 +46,11 @@ private:
   // The service reference of the handler
   ctkServiceReference eventHandlerRef;
 
-  // The event to deliver to the handler
-  ctkEvent event;
+  // The events to deliver to the handler
+  QList<ctkEvent> events;
+
+  // Whether the events are delivered in a single handleEvents call
+  bool batch;
 
   // Used to blacklist the service or get the service object for the reference
   BlacklistingHandlerTasks* handlerTasks;
@@ -60,9 +66,11 @@ public:
    * @param event The event to deliver
    * @param handlerTasks Used to blacklist the service or get the service object
    *      for the reference
+   * @param batch Whether the handler receives batches of events
    */
   ctkEAHandlerTask(const ctkServiceReference& eventHandlerRef,
-                   const ctkEvent& event, BlacklistingHandlerTasks* handlerTasks);
+                   const ctkEvent& event, BlacklistingHandlerTasks* handlerTasks,
+                   bool batch = false);
 
   ctkEAHandlerTask(const Self& task);
 
@@ -74,7 +82,37 @@ public:
   QString getHandlerClassName() const;
 
   /**
-   * Deliver the event to the handler.
+   * Return the service reference of the handler
+   */
+  ctkServiceReference getHandlerRef() const;
+
+  /**
+   * Return whether the handler receives batches of events
+   */
+  bool isBatch() const;
+
+  /**
+   * Return the <tt>event.coalesce</tt> window of the last event in ms, or 0
+   * if the event may not be coalesced.
+   */
+  int getCoalesceWindow() const;
+
+  /**
+   * Append the events of the given task for the same handler. Only batch
+   * tasks may be appended to each other.
+   */
+  void append(const Self& task);
+
+  /**
+   * Replace the last event by the last event of the given task for the same
+   * handler, if both have the same topic.
+   *
+   * @return <tt>true</tt> if the event was replaced
+   */
+  bool coalesce(const Self& task);
+
+  /**
+   * Deliver the events to the handler.
    */
   void execute();
 
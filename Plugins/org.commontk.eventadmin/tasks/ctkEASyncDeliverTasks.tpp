@@ -24,6 +24,7 @@
 
 #include <dispatch/ctkEADefaultThreadPool_p.h>
 #include <dispatch/ctkEASyncMasterThread_p.h>
+#include <dispatch/ctkEASyncWatchdog_p.h>
 #include <util/ctkEARendezvous_p.h>
 #include <util/ctkEATimeoutException_p.h>
 
@@ -88,21 +89,54 @@ private:
   const QList<HandlerTask>& tasks;
 };
 
+template<class HandlerTask>
+class _WatchedDelivery : public ctkEASyncWatchdog::Delivery
+{
+public:
+
+  _WatchedDelivery(ctkEASyncWatchdog* watchdog, const QList<HandlerTask>& tasks, int timeout)
+    : ctkEASyncWatchdog::Delivery(timeout), watchdog(watchdog), tasks(tasks)
+  {
+    watchdog->add(this);
+  }
+
+  ~_WatchedDelivery()
+  {
+    watchdog->remove(this);
+  }
+
+protected:
+
+  void expired(int task)
+  {
+    HandlerTask expiredTask = tasks.at(task);
+    expiredTask.blackListHandler();
+  }
+
+private:
+
+  ctkEASyncWatchdog* watchdog;
+  const QList<HandlerTask>& tasks;
+};
+
 template<class HandlerTask>
 ctkEASyncDeliverTasks<HandlerTask>::ctkEASyncDeliverTasks(
   ctkEADefaultThreadPool* pool, ctkEASyncMasterThread* syncMasterThread,
-  long timeout, const QList<QString>& ignoreTimeout)
-  : pool(pool), syncMasterThread(syncMasterThread)
+  ctkEASyncWatchdog* syncWatchdog, long timeout, const QList<QString>& ignoreTimeout,
+  bool inlineDelivery)
+  : pool(pool), syncMasterThread(syncMasterThread), syncWatchdog(syncWatchdog)
 {
-  update(timeout, ignoreTimeout);
+  update(timeout, ignoreTimeout, inlineDelivery);
 }
 
 template<class HandlerTask>
-void ctkEASyncDeliverTasks<HandlerTask>::update(long timeout, const QList<QString>& ignoreTimeout)
+void ctkEASyncDeliverTasks<HandlerTask>::update(long timeout, const QList<QString>& ignoreTimeout,
+                                                bool inlineDelivery)
 {
   {
     QMutexLocker l(&mutex);
     this->timeout = timeout;
+    this->inlineDelivery = inlineDelivery;
   }
 
   if (ignoreTimeout.isEmpty())
@@ -134,6 +168,17 @@ void ctkEASyncDeliverTasks<HandlerTask>::update(long timeout, const QList<QStrin
 template<class HandlerTask>
 void ctkEASyncDeliverTasks<HandlerTask>::execute(const QList<HandlerTask>& tasks)
 {
+  bool inlineDelivery = false;
+  {
+    QMutexLocker l(&mutex);
+    inlineDelivery = this->inlineDelivery;
+  }
+  if (inlineDelivery)
+  {
+    executeInline(tasks);
+    return;
+  }
+
   _RunInSyncMaster<HandlerTask> runnable(this, tasks);
   runnable.setAutoDelete(false);
   syncMasterThread->syncRun(&runnable);
@@ -194,6 +239,42 @@ void ctkEASyncDeliverTasks<HandlerTask>::executeInSyncMaster(const QList<Handler
   }
 }
 
+template<class HandlerTask>
+void ctkEASyncDeliverTasks<HandlerTask>::executeInline(const QList<HandlerTask>& tasks)
+{
+  long t = 0;
+  {
+    QMutexLocker l(&mutex);
+    t = timeout;
+  }
+
+  if (t <= 0)
+  {
+    foreach(HandlerTask task, tasks)
+    {
+      task.execute();
+    }
+    return;
+  }
+
+  _WatchedDelivery<HandlerTask> delivery(syncWatchdog, tasks, t);
+  for (int i = 0; i < tasks.size(); ++i)
+  {
+    HandlerTask task = tasks.at(i);
+    if (!useTimeout(task))
+    {
+      task.execute();
+    }
+    else
+    {
+      // the watchdog blacklists the handler if it does not return in time
+      delivery.startTask(i);
+      task.execute();
+      delivery.finishTask();
+    }
+  }
+}
+
 template<class HandlerTask>
 bool ctkEASyncDeliverTasks<HandlerTask>::useTimeout(const HandlerTask& task)
 {
@@ -29,6 +29,7 @@
 
 class ctkEADefaultThreadPool;
 class ctkEASyncMasterThread;
+class ctkEASyncWatchdog;
 
 /**
  * This class does the actual work of the synchronous event delivery.
@@ -54,6 +55,11 @@ class ctkEASyncMasterThread;
  * If during an event delivery a new event should be delivered from
  * within the event handler, the timeout handler is stopped for the
  * delivery time of the inner event!
+ * <p>
+ * With inline delivery, the handlers are always called by the calling
+ * thread and the ctkEASyncWatchdog blacklists the handlers which do not
+ * return in time. The calling thread is then blocked until the handler
+ * returns, but no thread hand-off takes place for each handler.
  */
 template<class HandlerTask>
 class ctkEASyncDeliverTasks : public ctkEADeliverTask<ctkEASyncDeliverTasks<HandlerTask>, HandlerTask>
@@ -67,9 +73,15 @@ private:
   /** This is a ctkEAInterruptibleThread used to execute the handlers */
   ctkEASyncMasterThread* syncMasterThread;
 
+  /** The thread enforcing the timeouts of inline deliveries */
+  ctkEASyncWatchdog* syncWatchdog;
+
   /** The timeout for event handlers, 0 = disabled. */
   long timeout;
 
+  /** Whether the handlers are called by the calling thread. */
+  bool inlineDelivery;
+
   /**
    * The matcher interface for checking if timeout handling
    * is disabled for the handler.
@@ -109,11 +121,13 @@ public:
    * Construct a new sync deliver tasks.
    * @param pool The thread pool used to spin-off new threads.
    * @param timeout The timeout for an event handler, 0 = disabled
+   * @param inlineDelivery Whether the handlers are called by the calling thread
    */
   ctkEASyncDeliverTasks(ctkEADefaultThreadPool* pool, ctkEASyncMasterThread* syncMasterThread,
-                        long timeout, const QList<QString>& ignoreTimeout);
+                        ctkEASyncWatchdog* syncWatchdog, long timeout,
+                        const QList<QString>& ignoreTimeout, bool inlineDelivery);
 
-  void update(long timeout, const QList<QString>& ignoreTimeout);
+  void update(long timeout, const QList<QString>& ignoreTimeout, bool inlineDelivery);
 
   /**
    * This blocks an unrelated thread used to send a synchronous event until the
@@ -127,6 +141,14 @@ public:
 
   void executeInSyncMaster(const QList<HandlerTask>& tasks);
 
+  /**
+   * Call the handlers in the calling thread, the timeouts being enforced by
+   * the watchdog thread.
+   *
+   * @param tasks The event handler dispatch tasks to execute
+   */
+  void executeInline(const QList<HandlerTask>& tasks);
+
 private:
 
   /**
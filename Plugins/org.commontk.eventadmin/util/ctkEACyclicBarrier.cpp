@@ -40,16 +40,16 @@ ctkEACyclicBarrier::ctkEACyclicBarrier(int parties, ctkEARunnable* command)
     count_(parties), resets_(0)
 {
   if (parties <= 0) throw ctkInvalidArgumentException("parties cannot be negative");
-  if (barrierCommand_) ++barrierCommand_->ref;
+  if (barrierCommand_) barrierCommand_->ref.ref();
 }
 
 ctkEARunnable* ctkEACyclicBarrier::setBarrierCommand(ctkEARunnable* command)
 {
   QMutexLocker lock(&mutex);
   ctkEARunnable* old = barrierCommand_;
-  --old->ref;
+  old->ref.deref();
   barrierCommand_ = command;
-  ++barrierCommand_->ref;
+  barrierCommand_->ref.ref();
   return old;
 }
 
@@ -112,7 +112,7 @@ int ctkEACyclicBarrier::doBarrier(bool timed, long msecs)
       {
         const bool autoDelete = barrierCommand_->autoDelete();
         barrierCommand_->run();
-        if (autoDelete && !--barrierCommand_->ref) delete barrierCommand_;
+        if (autoDelete && !barrierCommand_->ref.deref()) delete barrierCommand_;
       }
       return 0;
     }
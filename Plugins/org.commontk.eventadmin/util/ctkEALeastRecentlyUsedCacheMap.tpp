@@ -22,7 +22,7 @@
 
 template<typename K, typename V>
 ctkEALeastRecentlyUsedCacheMap<K,V>::
-ctkEALeastRecentlyUsedCacheMap(int maxSize)
+ctkEALeastRecentlyUsedCacheMap(int maxSize, int shards)
   : maxSize(maxSize)
 {
   if(0 >= maxSize)
@@ -30,9 +30,30 @@ ctkEALeastRecentlyUsedCacheMap(int maxSize)
     throw ctkInvalidArgumentException("Size must be positive");
   }
 
-  // We need one more entry then m_maxSize in the cache and a HashMap is
-  // expanded when it reaches 3/4 of its size hence, the funny numbers.
-  cache.reserve(((maxSize + 1) * 4)/3);
+  if(0 >= shards || shards > maxSize)
+  {
+    throw ctkInvalidArgumentException("Shards must be positive and not exceed the size");
+  }
+
+  for (int i = 0; i < shards; ++i)
+  {
+    Shard* shard = new Shard;
+    shard->maxSize = maxSize / shards + (i < maxSize % shards ? 1 : 0);
+    shard->history.previous = &shard->history;
+    shard->history.next = &shard->history;
+    // We need one more entry then maxSize in the cache and a HashMap is
+    // expanded when it reaches 3/4 of its size hence, the funny numbers.
+    shard->cache.reserve(((shard->maxSize + 1) * 4)/3);
+    this->shards.push_back(shard);
+  }
+}
+
+template<typename K, typename V>
+ctkEALeastRecentlyUsedCacheMap<K,V>::
+~ctkEALeastRecentlyUsedCacheMap()
+{
+  clear();
+  qDeleteAll(shards);
 }
 
 template<typename K, typename V>
@@ -40,17 +61,7 @@ const V
 ctkEALeastRecentlyUsedCacheMap<K,V>::
 value(const K& key) const
 {
-  QMutexLocker lock(&mutex);
-  if (cache.contains(key))
-  {
-    history.removeAll(key);
-    history.push_back(key);
-    return cache.value(key);
-  }
-  else
-  {
-    return V();
-  }
+  return value(key, V());
 }
 
 template<typename K, typename V>
@@ -58,12 +69,14 @@ const V
 ctkEALeastRecentlyUsedCacheMap<K,V>::
 value(const K& key, const V& defaultValue) const
 {
-  QMutexLocker lock(&mutex);
-  if (cache.contains(key))
+  Shard* shard = this->shard(key);
+  QMutexLocker lock(&shard->mutex);
+  Node* node = shard->cache.value(key);
+  if (node)
   {
-    history.removeAll(key);
-    history.push_back(key);
-    return cache.value(key);
+    unlink(node);
+    append(shard, node);
+    return node->value;
   }
   else
   {
@@ -76,19 +89,30 @@ void
 ctkEALeastRecentlyUsedCacheMap<K,V>::
 insert(const K& key, const V& value)
 {
-  QMutexLocker lock(&mutex);
+  Shard* shard = this->shard(key);
+  QMutexLocker lock(&shard->mutex);
 
-  if (cache.contains(key))
+  Node* node = shard->cache.value(key);
+  if (node)
   {
-    history.removeAll(key);
+    node->value = value;
+    unlink(node);
   }
+  else
+  {
+    node = new Node;
+    node->key = key;
+    node->value = value;
+    shard->cache.insert(key, node);
+  }
+  append(shard, node);
 
-  cache.insert(key, value);
-  history.push_back(key);
-
-  if(maxSize < cache.size())
+  if(shard->maxSize < shard->cache.size())
   {
-    cache.remove(history.takeFirst());
+    Node* leastRecentlyUsed = shard->history.next;
+    unlink(leastRecentlyUsed);
+    shard->cache.remove(leastRecentlyUsed->key);
+    delete leastRecentlyUsed;
   }
 }
 
@@ -97,13 +121,18 @@ const V
 ctkEALeastRecentlyUsedCacheMap<K,V>::
 remove(const K& key)
 {
-  QMutexLocker lock(&mutex);
-  if (cache.contains(key))
+  Shard* shard = this->shard(key);
+  QMutexLocker lock(&shard->mutex);
+  Node* node = shard->cache.take(key);
+  if (node == 0)
   {
-    history.removeAll(key);
+    return V();
   }
 
-  return cache.take(key);
+  unlink(node);
+  const V value = node->value;
+  delete node;
+  return value;
 }
 
 template<typename K, typename V>
@@ -111,8 +140,13 @@ int
 ctkEALeastRecentlyUsedCacheMap<K,V>::
 size() const
 {
-  QMutexLocker lock(&mutex);
-  return cache.size();
+  int size = 0;
+  foreach (Shard* shard, shards)
+  {
+    QMutexLocker lock(&shard->mutex);
+    size += shard->cache.size();
+  }
+  return size;
 }
 
 template<typename K, typename V>
@@ -120,8 +154,40 @@ void
 ctkEALeastRecentlyUsedCacheMap<K,V>::
 clear()
 {
-  QMutexLocker lock(&mutex);
-  cache.clear();
-  history.clear();
+  foreach (Shard* shard, shards)
+  {
+    QMutexLocker lock(&shard->mutex);
+    qDeleteAll(shard->cache);
+    shard->cache.clear();
+    shard->history.previous = &shard->history;
+    shard->history.next = &shard->history;
+  }
+}
+
+template<typename K, typename V>
+typename ctkEALeastRecentlyUsedCacheMap<K,V>::Shard*
+ctkEALeastRecentlyUsedCacheMap<K,V>::
+shard(const K& key) const
+{
+  return shards.size() == 1 ? shards.front() : shards.at(qHash(key) % shards.size());
+}
+
+template<typename K, typename V>
+void
+ctkEALeastRecentlyUsedCacheMap<K,V>::
+unlink(Node* node)
+{
+  node->previous->next = node->next;
+  node->next->previous = node->previous;
 }
 
+template<typename K, typename V>
+void
+ctkEALeastRecentlyUsedCacheMap<K,V>::
+append(Shard* shard, Node* node)
+{
+  node->previous = shard->history.previous;
+  node->next = &shard->history;
+  shard->history.previous->next = node;
+  shard->history.previous = node;
+}
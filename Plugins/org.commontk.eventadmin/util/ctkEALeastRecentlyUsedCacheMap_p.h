@@ -24,8 +24,10 @@
 #define CTKEALEASTRECENTLYUSEDCACHEMAP_P_H
 
 #include <QHash>
-#include <QList>
 #include <QMutex>
+#include <QVector>
+
+#include <ctkException.h>
 
 #include "ctkEACacheMap_p.h"
 
@@ -33,6 +35,12 @@
  * This class implements a least recently used cache map. It will hold
  * a given size of key-value pairs and drop the least recently used entry once this
  * size is reached. This class is thread safe.
+ *
+ * The entries are kept in a hash of nodes which are linked in their order of use,
+ * hence looking up, adding and dropping an entry takes constant time. The cache
+ * can be split into shards, each having its own lock and an equal part of the
+ * size, so that threads using different keys do not wait for each other. The
+ * least recently used entry is then dropped from the shard of the added key.
  */
 template<typename K, typename V>
 class ctkEALeastRecentlyUsedCacheMap : public ctkEACacheMap<K,V, ctkEALeastRecentlyUsedCacheMap<K,V> >
@@ -40,19 +48,36 @@ class ctkEALeastRecentlyUsedCacheMap : public ctkEACacheMap<K,V, ctkEALeastRecen
 
 private:
 
-  // The internal lock for this object
-  mutable QMutex mutex;
+  struct Node
+  {
+    K key;
+    V value;
 
-  // The max number of entries in the cache. Once reached entries are replaced
-  const int maxSize;
+    Node* previous;
+    Node* next;
+  };
+
+  struct Shard
+  {
+    // The internal lock for this shard
+    QMutex mutex;
+
+    // The max number of entries in this shard. Once reached entries are replaced
+    int maxSize;
 
-  // The cache
-  QHash<K,V> cache;
+    // The cache
+    QHash<K, Node*> cache;
+
+    // The sentinel of the circular list of the entries in their order of use.
+    // history.next is the least recently used entry and history.previous the
+    // most recently used one.
+    Node history;
+  };
+
+  // The max number of entries in the cache
+  const int maxSize;
 
-  // The history used to determine the least recently used entries. The end of the
-  // list is the most recently used key. In other words history.front() returns
-  // the least recently used key.
-  mutable QList<K> history;
+  QVector<Shard*> shards;
 
 public:
 
@@ -65,8 +90,12 @@ public:
    * new ones.
    *
    * @param maxSize The max number of entries in the cache
+   * @param shards The number of parts of the cache with their own lock, at most
+   *        <tt>maxSize</tt>
    */
-  ctkEALeastRecentlyUsedCacheMap(int maxSize);
+  ctkEALeastRecentlyUsedCacheMap(int maxSize, int shards = 1);
+
+  ~ctkEALeastRecentlyUsedCacheMap();
 
   /**
    * Returns the value for the key in case there is one. Additionally, the
@@ -123,6 +152,16 @@ public:
    */
   void clear();
 
+private:
+
+  Shard* shard(const K& key) const;
+
+  static void unlink(Node* node);
+
+  // Make the node the most recently used entry of the shard
+  static void append(Shard* shard, Node* node);
+
+  Q_DISABLE_COPY(ctkEALeastRecentlyUsedCacheMap)
 };
 
 #include "ctkEALeastRecentlyUsedCacheMap.tpp"
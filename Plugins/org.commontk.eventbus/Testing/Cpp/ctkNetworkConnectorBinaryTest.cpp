@@ -0,0 +1,266 @@
+/*
+ *  ctkNetworkConnectorBinaryTest.cpp
+ *  ctkNetworkConnectorBinaryTest
+ *
+ *  See Licence at: http://tiny.cc/QXJ4D
+ *
+ */
+
+#include "ctkTestSuite.h"
+#include <ctkNetworkConnectorBinary.h>
+#include <ctkNetworkConnectorQXMLRPC.h>
+#include <ctkEventBusManager.h>
+
+#include <QApplication>
+
+#include <algorithm>
+
+using namespace ctkEventBus;
+
+//-------------------------------------------------------------------------
+/**
+ Class name: testObjectCustomForNetworkConnectorBinary
+ Custom object needed for testing.
+ */
+class testObjectCustomForNetworkConnectorBinary : public QObject {
+    Q_OBJECT
+
+public:
+    /// constructor.
+    testObjectCustomForNetworkConnectorBinary();
+
+    /// Return tha var's value.
+    int var() {return m_Var;}
+
+public Q_SLOTS:
+    /// Test slot that will increment the value of m_Var when an UPDATE_OBJECT event is raised.
+    void updateObject();
+
+Q_SIGNALS:
+    void objectModified();
+
+private:
+    int m_Var; ///< Test var.
+};
+
+testObjectCustomForNetworkConnectorBinary::testObjectCustomForNetworkConnectorBinary() : m_Var(0) {
+}
+
+void testObjectCustomForNetworkConnectorBinary::updateObject() {
+    m_Var++;
+}
+
+//-------------------------------------------------------------------------
+/**
+ Class name: testReplyRecorderForNetworkConnectorBinary
+ Records the time of the replies notified by the connectors, the replies
+ being matched in order with the time the requests were sent.
+ */
+class testReplyRecorderForNetworkConnectorBinary : public QObject {
+    Q_OBJECT
+
+public:
+    /// Record the time a request is sent.
+    void requestSent() {m_Sent.append(m_Clock.elapsed());}
+
+    /// Start a new measure.
+    void reset() {m_Clock.start(); m_Sent.clear(); m_Latencies.clear();}
+
+    /// Return the number of replies received.
+    int replies() {return m_Latencies.count();}
+
+    /// Return the milliseconds since the measure started.
+    int elapsed() {return m_Clock.elapsed();}
+
+    /// Return the latency within which 99% of the replies were received.
+    int latencyPercentile99() {
+        QList<int> latencies = m_Latencies;
+        std::sort(latencies.begin(), latencies.end());
+        return latencies.isEmpty() ? 0 : latencies.at((latencies.count() * 99 - 1) / 100);
+    }
+
+public Q_SLOTS:
+    /// Callback of the remoteCommunicationDone and remoteCommunicationFailed events.
+    void replyReceived() {
+        if(m_Latencies.count() < m_Sent.count()) {
+            m_Latencies.append(m_Clock.elapsed() - m_Sent.at(m_Latencies.count()));
+        }
+    }
+
+private:
+    QTime m_Clock;
+    QList<int> m_Sent;
+    QList<int> m_Latencies;
+};
+
+/**
+ Class name: ctkNetworkConnectorBinaryTest
+ This class implements the test suite for ctkNetworkConnectorBinary.
+ */
+
+//! <title>
+//ctkNetworkConnectorBinary
+//! </title>
+//! <description>
+//ctkNetworkConnectorBinary provides the connection with a binary protocol
+//over TCP or a local socket.
+//! </description>
+
+class ctkNetworkConnectorBinaryTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    /// Initialize test variables
+    void initTestCase() {
+        m_EventBus = ctkEventBusManager::instance();
+        m_NetWorkConnectorBinary = new ctkEventBus::ctkNetworkConnectorBinary();
+        m_ObjectTest = new testObjectCustomForNetworkConnectorBinary();
+        m_Recorder = new testReplyRecorderForNetworkConnectorBinary();
+
+        // The remote requests call the slot of the object through this topic.
+        ctkRegisterLocalSignal("ctk/local/eventBus/binaryUpdate", m_ObjectTest, "objectModified()");
+        ctkRegisterLocalCallback("ctk/local/eventBus/binaryUpdate", m_ObjectTest, "updateObject()");
+
+        ctkRegisterLocalCallback("ctk/local/eventBus/remoteCommunicationDone", m_Recorder, "replyReceived()");
+        ctkRegisterLocalCallback("ctk/local/eventBus/remoteCommunicationFailed", m_Recorder, "replyReceived()");
+    }
+
+    /// Cleanup tes variables memory allocation.
+    void cleanupTestCase() {
+        if(m_ObjectTest) {
+            delete m_ObjectTest;
+            m_ObjectTest = NULL;
+        }
+        delete m_Recorder;
+        delete m_NetWorkConnectorBinary;
+        m_EventBus->shutdown();
+    }
+
+    /// Check the existence of the ctkNetworkConnectorBinary instance.
+    void ctkNetworkConnectorBinaryConstructorTest();
+
+    /// Check the delivery of pipelined requests over TCP.
+    void ctkNetworkConnectorBinaryCommunictionTest();
+
+    /// Check the delivery of batched requests over a local socket.
+    void ctkNetworkConnectorBinaryLocalBatchTest();
+
+    /// Report the events/sec and the p99 latency of the binary and the xml-rpc connectors over the loopback.
+    void ctkNetworkConnectorBinaryBenchmarkTest();
+
+private:
+    /// Send the given number of requests updating m_ObjectTest.
+    void sendUpdates(ctkNetworkConnector *connector, const QString &method, int count);
+
+    /// Process the events until the given number of replies is received, at most for the given time.
+    bool waitForReplies(int count, int msecs);
+
+    ctkEventBusManager *m_EventBus; ///< event bus instance
+    ctkNetworkConnectorBinary *m_NetWorkConnectorBinary; ///< EventBus test variable instance.
+    testObjectCustomForNetworkConnectorBinary *m_ObjectTest;
+    testReplyRecorderForNetworkConnectorBinary *m_Recorder;
+};
+
+void ctkNetworkConnectorBinaryTest::sendUpdates(ctkNetworkConnector *connector, const QString &method, int count) {
+    QVariantList eventParameters;
+    eventParameters.append("ctk/local/eventBus/binaryUpdate");
+    eventParameters.append(ctkEventTypeLocal);
+    eventParameters.append(ctkSignatureTypeCallback);
+    eventParameters.append("updateObject()");
+
+    QVariantList dataParameters;
+
+    ctkEventArgumentsList listToSend;
+    listToSend.append(ctkEventArgument(QVariantList, eventParameters));
+    listToSend.append(ctkEventArgument(QVariantList, dataParameters));
+
+    for(int i = 0; i < count; ++i) {
+        m_Recorder->requestSent();
+        connector->send(method, &listToSend);
+    }
+}
+
+bool ctkNetworkConnectorBinaryTest::waitForReplies(int count, int msecs) {
+    QTime dieTime = QTime::currentTime().addMSecs(msecs);
+    while(m_Recorder->replies() < count && QTime::currentTime() < dieTime) {
+       QCoreApplication::processEvents(QEventLoop::AllEvents, 3);
+    }
+    return m_Recorder->replies() >= count;
+}
+
+void ctkNetworkConnectorBinaryTest::ctkNetworkConnectorBinaryConstructorTest() {
+    QVERIFY(m_NetWorkConnectorBinary != NULL);
+    QCOMPARE(m_NetWorkConnectorBinary->protocol(), QString("BINARY"));
+}
+
+void ctkNetworkConnectorBinaryTest::ctkNetworkConnectorBinaryCommunictionTest() {
+    m_NetWorkConnectorBinary->createServer(8010);
+    m_NetWorkConnectorBinary->startListen();
+    m_NetWorkConnectorBinary->createClient("localhost", 8010);
+
+    // the requests are written without waiting for the previous replies.
+    int var = m_ObjectTest->var();
+    m_Recorder->reset();
+    sendUpdates(m_NetWorkConnectorBinary, "ctk/remote/eventBus/comunication/send/binary", 10);
+    QVERIFY(waitForReplies(10, 3000));
+    QCOMPARE(m_ObjectTest->var(), var + 10);
+    QCOMPARE(m_NetWorkConnectorBinary->pendingRequests(), 0);
+}
+
+void ctkNetworkConnectorBinaryTest::ctkNetworkConnectorBinaryLocalBatchTest() {
+    ctkNetworkConnectorBinary connector;
+    connector.createLocalServer("ctkNetworkConnectorBinaryTest");
+    connector.startListen();
+    connector.createLocalClient("ctkNetworkConnectorBinaryTest");
+    connector.setBatchSize(10);
+
+    // 2 full frames are written at once, the last 5 requests when returning to the event loop.
+    int var = m_ObjectTest->var();
+    m_Recorder->reset();
+    sendUpdates(&connector, "ctk/remote/eventBus/comunication/send/binary", 25);
+    QCOMPARE(connector.pendingRequests(), 25);
+    QVERIFY(waitForReplies(25, 3000));
+    QCOMPARE(m_ObjectTest->var(), var + 25);
+}
+
+void ctkNetworkConnectorBinaryTest::ctkNetworkConnectorBinaryBenchmarkTest() {
+    const int events = 2000;
+
+    ctkNetworkConnectorQXMLRPC xmlrpc;
+    xmlrpc.createServer(8011);
+    xmlrpc.startListen();
+    xmlrpc.createClient("localhost", 8011);
+
+    ctkNetworkConnectorBinary binary;
+    binary.createServer(8012);
+    binary.startListen();
+    binary.createClient("localhost", 8012);
+
+    ctkNetworkConnectorBinary batched;
+    batched.createServer(8013);
+    batched.startListen();
+    batched.createClient("localhost", 8013);
+    batched.setBatchSize(100);
+
+    QList<ctkNetworkConnector *> connectors;
+    connectors << &xmlrpc << &binary << &batched;
+    QStringList methods;
+    methods << "ctk/remote/eventBus/comunication/send/xmlrpc"
+            << "ctk/remote/eventBus/comunication/send/binary"
+            << "ctk/remote/eventBus/comunication/send/binary";
+    QStringList names;
+    names << "xml-rpc" << "binary" << "binary, batches of 100";
+
+    for(int i = 0; i < connectors.count(); ++i) {
+        m_Recorder->reset();
+        sendUpdates(connectors.at(i), methods.at(i), events);
+        QVERIFY(waitForReplies(events, 60000));
+        int elapsed = qMax(1, m_Recorder->elapsed());
+        qDebug("%s", QString("%1: %2 events/s, p99 latency %3 ms")
+               .arg(names.at(i)).arg(events * 1000LL / elapsed)
+               .arg(m_Recorder->latencyPercentile99()).toAscii().data());
+    }
+}
+
+CTK_REGISTER_TEST(ctkNetworkConnectorBinaryTest);
+#include "ctkNetworkConnectorBinaryTest.moc"
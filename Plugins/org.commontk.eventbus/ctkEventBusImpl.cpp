@@ -40,6 +40,14 @@ void ctkEventBusImpl::postEvent(const ::ctkEvent& event)
   dispatchEvent(event, true);
 }
 
+void ctkEventBusImpl::postEvents(const QList< ::ctkEvent>& events)
+{
+  foreach (const ::ctkEvent& event, events)
+  {
+    dispatchEvent(event, true);
+  }
+}
+
 void ctkEventBusImpl::sendEvent(const ::ctkEvent& event)
 {
   dispatchEvent(event, false);
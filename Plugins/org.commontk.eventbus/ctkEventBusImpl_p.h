@@ -45,6 +45,7 @@ public:
   ctkEventBusImpl();
 
   void postEvent(const ctkEvent& event);
+  void postEvents(const QList<ctkEvent>& events);
   void sendEvent(const ctkEvent& event);
 
   void publishSignal(const QObject* publisher, const char* signal, const QString& topic, Qt::ConnectionType type = Qt::QueuedConnection);
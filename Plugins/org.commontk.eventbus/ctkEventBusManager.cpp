@@ -10,6 +10,7 @@
 
 #include "ctkEventBusManager.h"
 #include "ctkTopicRegistry.h"
+#include "ctkNetworkConnectorBinary.h"
 #include "ctkNetworkConnectorQtSoap.h"
 #include "ctkNetworkConnectorQXMLRPC.h"
 
@@ -67,6 +68,7 @@ void ctkEventBusManager::shutdown() {
 void ctkEventBusManager::initializeNetworkConnectors() {
     plugNetworkConnector("SOAP", new ctkNetworkConnectorQtSoap());
     plugNetworkConnector("XMLRPC", new ctkNetworkConnectorQXMLRPC());
+    plugNetworkConnector("BINARY", new ctkNetworkConnectorBinary());
 }
 
 bool ctkEventBusManager::addEventProperty(ctkBusEvent &props) const {
@@ -0,0 +1,503 @@
+/*
+ *  ctkNetworkConnectorBinary.cpp
+ *  ctkEventBus
+ *
+ *  See Licence at: http://tiny.cc/QXJ4D
+ *
+ */
+
+#include "ctkNetworkConnectorBinary.h"
+#include "ctkEventBusManager.h"
+
+#include <QDataStream>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QtEndian>
+
+using namespace ctkEventBus;
+
+namespace {
+
+/// size of the length which precedes each frame.
+const int FRAME_LENGTH_SIZE = sizeof(quint32);
+
+/// larger frames are rejected, their length being corrupt.
+const quint32 MAX_FRAME_LENGTH = 64 * 1024 * 1024;
+
+/// frames with more requests are rejected, their count being corrupt.
+const quint32 MAX_FRAME_REQUESTS = 64 * 1024;
+
+/// the number of arguments of a request is written on one byte.
+const int MAX_REQUEST_ARGUMENTS = 255;
+
+void initializeStream(QDataStream &stream) {
+    stream.setVersion(QDataStream::Qt_4_6);
+}
+
+/// write the length of the frame in front of it.
+void setFrameLength(QByteArray &frame) {
+    qToBigEndian<quint32>(frame.size() - FRAME_LENGTH_SIZE, reinterpret_cast<uchar *>(frame.data()));
+}
+
+}
+
+ctkNetworkConnectorBinary::ctkNetworkConnectorBinary() : ctkNetworkConnector(),
+    m_TcpSocket(NULL), m_LocalSocket(NULL), m_Socket(NULL), m_Port(0),
+    m_TcpServer(NULL), m_LocalServer(NULL), m_ServerPort(0),
+    m_BatchCount(0), m_BatchSize(1), m_FlushTimer(NULL), m_Sequence(0), m_PendingRequests(0) {
+    m_Protocol = "BINARY";
+
+    m_FlushTimer = new QTimer(this);
+    m_FlushTimer->setSingleShot(true);
+    m_FlushTimer->setInterval(0);
+    connect(m_FlushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+void ctkNetworkConnectorBinary::initializeForEventBus() {
+    ctkRegisterRemoteSignal("ctk/remote/eventBus/comunication/send/binary", this, "remoteCommunication(const QString, ctkEventArgumentsList *)");
+    ctkRegisterRemoteCallback("ctk/remote/eventBus/comunication/send/binary", this, "send(const QString, ctkEventArgumentsList *)");
+}
+
+ctkNetworkConnectorBinary::~ctkNetworkConnectorBinary() {
+    stopClient();
+    stopServer();
+}
+
+//retrieve an instance of the object
+ctkNetworkConnector *ctkNetworkConnectorBinary::clone() {
+    ctkNetworkConnectorBinary *copy = new ctkNetworkConnectorBinary();
+    copy->setBatchSize(m_BatchSize);
+    return copy;
+}
+
+void ctkNetworkConnectorBinary::setBatchSize(int maxRequests) {
+    m_BatchSize = qMax(1, maxRequests);
+    if(m_BatchCount >= m_BatchSize) {
+        flush();
+    }
+}
+
+int ctkNetworkConnectorBinary::batchSize() const {
+    return m_BatchSize;
+}
+
+int ctkNetworkConnectorBinary::pendingRequests() const {
+    return m_PendingRequests;
+}
+
+void ctkNetworkConnectorBinary::createClient(const QString hostName, const unsigned int port) {
+    // keep the connection to the same server open.
+    if(m_TcpSocket != NULL && m_Host == hostName && m_Port == port) {
+        connectClient();
+        return;
+    }
+    stopClient();
+
+    m_TcpSocket = new QTcpSocket(this);
+    m_Socket = m_TcpSocket;
+    m_Host = hostName;
+    m_Port = port;
+    connect(m_Socket, SIGNAL(connected()), this, SLOT(clientConnected()));
+    connect(m_Socket, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+    connect(m_Socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(clientError()));
+    connect(m_Socket, SIGNAL(readyRead()), this, SLOT(processReplies()));
+    connectClient();
+}
+
+void ctkNetworkConnectorBinary::createLocalClient(const QString serverName) {
+    if(m_LocalSocket != NULL && m_Host == serverName) {
+        connectClient();
+        return;
+    }
+    stopClient();
+
+    m_LocalSocket = new QLocalSocket(this);
+    m_Socket = m_LocalSocket;
+    m_Host = serverName;
+    m_Port = 0;
+    connect(m_Socket, SIGNAL(connected()), this, SLOT(clientConnected()));
+    connect(m_Socket, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+    connect(m_Socket, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(clientError()));
+    connect(m_Socket, SIGNAL(readyRead()), this, SLOT(processReplies()));
+    connectClient();
+}
+
+void ctkNetworkConnectorBinary::connectClient() {
+    if(m_TcpSocket && m_TcpSocket->state() == QAbstractSocket::UnconnectedState) {
+        m_TcpSocket->connectToHost(m_Host, m_Port);
+    } else if(m_LocalSocket && m_LocalSocket->state() == QLocalSocket::UnconnectedState) {
+        m_LocalSocket->connectToServer(m_Host);
+    }
+}
+
+bool ctkNetworkConnectorBinary::isClientConnected() const {
+    if(m_TcpSocket) {
+        return m_TcpSocket->state() == QAbstractSocket::ConnectedState;
+    }
+    return m_LocalSocket && m_LocalSocket->state() == QLocalSocket::ConnectedState;
+}
+
+void ctkNetworkConnectorBinary::stopClient() {
+    if(m_Socket) {
+        m_Socket->disconnect(this);
+        delete m_Socket;
+        m_Socket = NULL;
+        m_TcpSocket = NULL;
+        m_LocalSocket = NULL;
+    }
+    m_FlushTimer->stop();
+    m_Buffer.clear();
+    m_Unsent.clear();
+    m_Batch.clear();
+    m_BatchCount = 0;
+    m_PendingRequests = 0;
+}
+
+void ctkNetworkConnectorBinary::createServer(const unsigned int port) {
+    stopServer();
+    m_TcpServer = new QTcpServer(this);
+    m_ServerPort = port;
+}
+
+void ctkNetworkConnectorBinary::createLocalServer(const QString serverName) {
+    stopServer();
+    m_LocalServer = new QLocalServer(this);
+    m_ServerName = serverName;
+}
+
+void ctkNetworkConnectorBinary::stopServer() {
+    foreach(QIODevice *connection, m_Connections.keys()) {
+        connection->disconnect(this);
+        delete connection;
+    }
+    m_Connections.clear();
+    if(m_TcpServer) {
+        delete m_TcpServer;
+        m_TcpServer = NULL;
+    }
+    if(m_LocalServer) {
+        delete m_LocalServer;
+        m_LocalServer = NULL;
+    }
+}
+
+void ctkNetworkConnectorBinary::startListen() {
+    bool listening(false);
+    if(m_TcpServer) {
+        connect(m_TcpServer, SIGNAL(newConnection()), this, SLOT(acceptConnection()), Qt::UniqueConnection);
+        listening = m_TcpServer->isListening() || m_TcpServer->listen(QHostAddress::Any, m_ServerPort);
+        if(listening) {
+            qDebug() << "Listening for binary requests on port" << m_ServerPort;
+        } else {
+            qDebug() << "Error listening port" << m_ServerPort;
+        }
+    } else if(m_LocalServer) {
+        connect(m_LocalServer, SIGNAL(newConnection()), this, SLOT(acceptConnection()), Qt::UniqueConnection);
+        if(!m_LocalServer->isListening()) {
+            // remove a socket file left by a crashed server.
+            QLocalServer::removeServer(m_ServerName);
+        }
+        listening = m_LocalServer->isListening() || m_LocalServer->listen(m_ServerName);
+        if(listening) {
+            qDebug() << "Listening for binary requests on local server" << m_ServerName;
+        } else {
+            qDebug() << "Error listening on local server" << m_ServerName;
+        }
+    } else {
+        qWarning("%s", tr("Server can not start. Create it first, then call startListen again!!").toAscii().data());
+    }
+}
+
+void ctkNetworkConnectorBinary::send(const QString event_id, ctkEventArgumentsList *argList) {
+    if(m_Socket == NULL) {
+        qWarning("%s", tr("Client can not send. Create it first, then call send again!!").toAscii().data());
+        return;
+    }
+
+    QList<QVariantList> arguments;
+    if(argList != NULL) {
+        int i=0, size = argList->count();
+        for(;i<size;i++) {
+            QString typeArgument;
+            typeArgument = argList->at(i).name();
+            if(typeArgument != "QVariantList") {
+                qWarning("%s", tr("Remote Dispatcher need to have arguments that are QVariantList").toAscii().data());
+                return;
+            }
+            arguments.append(*static_cast<QVariantList *>(argList->at(i).data()));
+        }
+        if(size == 0) {
+            qWarning("%s", tr("Remote Dispatcher need to have at least one argument that is a QVariantList").toAscii().data());
+            return;
+        }
+        if(size > MAX_REQUEST_ARGUMENTS) {
+            qWarning("%s", tr("Remote Dispatcher can not send more than %1 arguments").arg(MAX_REQUEST_ARGUMENTS).toAscii().data());
+            return;
+        }
+    }
+
+    QDataStream out(&m_Batch, QIODevice::WriteOnly | QIODevice::Append);
+    initializeStream(out);
+    out << event_id.toUtf8() << quint8(arguments.count());
+    foreach(const QVariantList &argument, arguments) {
+        out << argument;
+    }
+    ++m_BatchCount;
+    ++m_Sequence;
+    ++m_PendingRequests;
+
+    if(m_BatchCount >= m_BatchSize) {
+        flush();
+    } else if(!m_FlushTimer->isActive()) {
+        m_FlushTimer->start();
+    }
+}
+
+QByteArray ctkNetworkConnectorBinary::takeFrame() {
+    QByteArray frame;
+    {
+        QDataStream out(&frame, QIODevice::WriteOnly);
+        initializeStream(out);
+        out << quint32(0) << quint8(RequestFrame) << quint32(m_Sequence - m_BatchCount) << quint32(m_BatchCount);
+    }
+    frame.append(m_Batch);
+    setFrameLength(frame);
+
+    m_Batch.clear();
+    m_BatchCount = 0;
+    return frame;
+}
+
+void ctkNetworkConnectorBinary::flush() {
+    m_FlushTimer->stop();
+    if(m_BatchCount == 0 || m_Socket == NULL) {
+        return;
+    }
+
+    QByteArray frame = takeFrame();
+    if(isClientConnected()) {
+        m_Socket->write(frame);
+    } else {
+        // written as soon as the connection is established.
+        m_Unsent.append(frame);
+        connectClient();
+    }
+}
+
+void ctkNetworkConnectorBinary::clientConnected() {
+    if(m_TcpSocket) {
+        // the requests are small, do not delay them to coalesce segments.
+        m_TcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    }
+    if(!m_Unsent.isEmpty()) {
+        m_Socket->write(m_Unsent);
+        m_Unsent.clear();
+    }
+}
+
+void ctkNetworkConnectorBinary::clientDisconnected() {
+    failRequests();
+}
+
+void ctkNetworkConnectorBinary::clientError() {
+    // a connection which could not be established is not disconnected, an
+    // established one is disconnected after the error.
+    failRequests();
+}
+
+void ctkNetworkConnectorBinary::failRequests() {
+    // the requests written to the closed connection will not be answered, and
+    // the ones waiting for the connection are not kept for a later one. The
+    // requests still batched are written when the next flush reconnects.
+    int lost = m_PendingRequests - m_BatchCount;
+    m_Unsent.clear();
+    m_Buffer.clear();
+    m_PendingRequests -= lost;
+    for(int i = 0; i < lost; ++i) {
+        ctkEventBusManager::instance()->notifyEvent("ctk/local/eventBus/remoteCommunicationFailed", ctkEventTypeLocal);
+    }
+}
+
+bool ctkNetworkConnectorBinary::takeFrames(QByteArray &buffer, QList<QByteArray> &frames) {
+    int offset = 0;
+    bool valid = true;
+    while(buffer.size() - offset >= FRAME_LENGTH_SIZE) {
+        const quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(buffer.constData() + offset));
+        if(length > MAX_FRAME_LENGTH) {
+            valid = false;
+            break;
+        }
+        if(quint32(buffer.size() - offset - FRAME_LENGTH_SIZE) < length) {
+            break;
+        }
+        frames.append(buffer.mid(offset + FRAME_LENGTH_SIZE, length));
+        offset += FRAME_LENGTH_SIZE + length;
+    }
+    buffer.remove(0, offset);
+    return valid;
+}
+
+void ctkNetworkConnectorBinary::processReplies() {
+    m_Buffer.append(m_Socket->readAll());
+    QList<QByteArray> frames;
+    bool valid = takeFrames(m_Buffer, frames);
+    foreach(const QByteArray &frame, frames) {
+        QDataStream in(frame);
+        initializeStream(in);
+        quint8 type; quint32 first, count;
+        in >> type >> first >> count;
+        if(in.status() != QDataStream::Ok || type != ReplyFrame || count > quint32(m_PendingRequests)) {
+            valid = false;
+            break;
+        }
+        for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            quint8 ok;
+            in >> ok;
+            if(in.status() != QDataStream::Ok) {
+                valid = false;
+                break;
+            }
+            --m_PendingRequests;
+            if(ok) {
+                ctkEventBusManager::instance()->notifyEvent("ctk/local/eventBus/remoteCommunicationDone", ctkEventTypeLocal);
+            } else {
+                ctkEventBusManager::instance()->notifyEvent("ctk/local/eventBus/remoteCommunicationFailed", ctkEventTypeLocal);
+            }
+        }
+    }
+
+    if(!valid) {
+        // the replies cannot be matched with the requests anymore.
+        qWarning("%s", tr("Invalid reply received from the binary server, closing the connection").toAscii().data());
+        m_Socket->close();
+        failRequests();
+    }
+}
+
+void ctkNetworkConnectorBinary::acceptConnection() {
+    forever {
+        QIODevice *connection(NULL);
+        if(m_TcpServer && m_TcpServer->hasPendingConnections()) {
+            QTcpSocket *socket = m_TcpServer->nextPendingConnection();
+            socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            connection = socket;
+        } else if(m_LocalServer && m_LocalServer->hasPendingConnections()) {
+            connection = m_LocalServer->nextPendingConnection();
+        }
+        if(connection == NULL) {
+            break;
+        }
+        m_Connections.insert(connection, QByteArray());
+        connect(connection, SIGNAL(readyRead()), this, SLOT(processRequests()));
+        connect(connection, SIGNAL(disconnected()), this, SLOT(connectionClosed()));
+    }
+}
+
+void ctkNetworkConnectorBinary::processRequests() {
+    QIODevice *connection = qobject_cast<QIODevice *>(sender());
+    if(connection == NULL || !m_Connections.contains(connection)) {
+        return;
+    }
+
+    QByteArray &buffer = m_Connections[connection];
+    buffer.append(connection->readAll());
+
+    // the replies to all the frames received are written at once.
+    QByteArray replies;
+    QList<QByteArray> frames;
+    bool valid = takeFrames(buffer, frames);
+    foreach(const QByteArray &frame, frames) {
+        QDataStream in(frame);
+        initializeStream(in);
+        quint8 type; quint32 first, count;
+        in >> type >> first >> count;
+        if(in.status() != QDataStream::Ok || type != RequestFrame || count > MAX_FRAME_REQUESTS) {
+            valid = false;
+            break;
+        }
+
+        QByteArray reply;
+        QDataStream out(&reply, QIODevice::WriteOnly);
+        initializeStream(out);
+        out << quint32(0) << quint8(ReplyFrame) << first << count;
+        for(quint32 i = 0; i < count && valid; ++i) {
+            QByteArray topic;
+            quint8 argumentsCount(0);
+            in >> topic >> argumentsCount;
+            QList<QVariantList> arguments;
+            for(int a = 0; a < argumentsCount && in.status() == QDataStream::Ok; ++a) {
+                QVariantList argument;
+                in >> argument;
+                arguments.append(argument);
+            }
+            // a truncated or corrupt frame cannot be answered request by request.
+            valid = in.status() == QDataStream::Ok;
+            bool ok = valid && dispatchRequest(QString::fromUtf8(topic), arguments);
+            out << quint8(ok ? 1 : 0);
+        }
+        if(!valid) {
+            break;
+        }
+        setFrameLength(reply);
+        replies.append(reply);
+    }
+
+    if(!replies.isEmpty()) {
+        connection->write(replies);
+    }
+    if(!valid) {
+        // the client fails its unanswered requests when the connection is closed.
+        qWarning("%s", tr("Invalid request received by the binary server, closing the connection").toAscii().data());
+        connection->close();
+    }
+}
+
+bool ctkNetworkConnectorBinary::dispatchRequest(const QString &topic, const QList<QVariantList> &arguments) {
+    Q_UNUSED(topic);
+
+    //first parameter is ctkEventBus message
+    enum {
+      EVENT_PARAMETERS,
+      DATA_PARAMETERS,
+    };
+
+    enum {
+      EVENT_ID,
+      EVENT_ITEM_TYPE,
+      EVENT_SIGNATURE_TYPE,
+      EVENT_METHOD_SIGNATURE,
+    };
+
+    if(arguments.count() == 0 || arguments.at(EVENT_PARAMETERS).count() == 0) {
+        return false;
+    }
+
+    //first argument regards local signal to be called.
+    QString id_name = arguments.at(EVENT_PARAMETERS).at(EVENT_ID).toString();
+    if(!ctkEventBusManager::instance()->isLocalSignalPresent(id_name)) {
+        return false;
+    }
+
+    QVariantList p;
+    if(arguments.count() > DATA_PARAMETERS) {
+        p = arguments.at(DATA_PARAMETERS);
+    }
+    ctkEventArgumentsList argList;
+    if(p.count() != 0) {
+        argList.push_back(Q_ARG(QVariantList, p));
+    }
+
+    ctkBusEvent dictionary(id_name,ctkEventTypeLocal,0,NULL,"");
+    ctkEventBusManager::instance()->notifyEvent(dictionary, argList.isEmpty() ? NULL : &argList);
+    return true;
+}
+
+void ctkNetworkConnectorBinary::connectionClosed() {
+    QIODevice *connection = qobject_cast<QIODevice *>(sender());
+    if(connection && m_Connections.remove(connection)) {
+        connection->deleteLater();
+    }
+}
@@ -0,0 +1,159 @@
+/*
+ *  ctkNetworkConnectorBinary.h
+ *  ctkEventBus
+ *
+ *  See Licence at: http://tiny.cc/QXJ4D
+ *
+ */
+
+#ifndef CTKNETWORKCONNECTORBINARY_H
+#define CTKNETWORKCONNECTORBINARY_H
+
+// include list
+#include "ctkNetworkConnector.h"
+
+class QIODevice;
+class QLocalServer;
+class QLocalSocket;
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+namespace ctkEventBus {
+
+/**
+ Class name: ctkNetworkConnectorBinary
+ This class is the implementation class for client/server objects that works over network
+ with a compact binary protocol, over TCP or over a local socket (a named pipe on Windows).
+ Each frame is a 32 bit length followed by a QDataStream payload holding the sequence number
+ of its first request, the number of requests and, for each request, the utf-8 topic and the
+ QVariantList arguments. The server answers with a frame holding the status of each request.
+ The client keeps its connection open, reconnecting when it was closed, and does not wait for
+ the replies before sending the next requests. With batching enabled, the requests sent
+ before control returns to the event loop are written as a single frame.
+ */
+class org_commontk_eventbus_EXPORT ctkNetworkConnectorBinary : public ctkNetworkConnector {
+    Q_OBJECT
+
+public:
+    /// object constructor.
+    ctkNetworkConnectorBinary();
+
+    /// object destructor.
+    /*virtual*/ ~ctkNetworkConnectorBinary();
+
+    /// create the unique instance of the client, connected over TCP.
+    /*virtual*/ void createClient(const QString hostName, const unsigned int port);
+
+    /// create the unique instance of the server, listening on a TCP port.
+    /*virtual*/ void createServer(const unsigned int port);
+
+    /// create the unique instance of the client, connected to the local server with the given name.
+    void createLocalClient(const QString serverName);
+
+    /// create the unique instance of the server, listening as a local server with the given name.
+    void createLocalServer(const QString serverName);
+
+    /// Start the server.
+    /*virtual*/ void startListen();
+
+    //retrieve an instance of the object
+    /*virtual*/ ctkNetworkConnector *clone();
+
+    /// register all the signals and slots
+    /*virtual*/ void initializeForEventBus();
+
+    /// Write at most maxRequests requests per frame, 1 disabling batching (the default).
+    void setBatchSize(int maxRequests);
+
+    /// Return the maximum number of requests written per frame.
+    int batchSize() const;
+
+    /// Return the number of requests sent which have not been answered yet.
+    int pendingRequests() const;
+
+public Q_SLOTS:
+    /// Allow to send a network request.
+    /** The arguments have to be QVariantList, as for the other connectors. */
+    /*virtual*/ void send(const QString event_id, ctkEventArgumentsList *argList);
+
+    /// write the requests batched so far.
+    void flush();
+
+private Q_SLOTS:
+    /// callback for the client which writes the requests queued while connecting.
+    void clientConnected();
+
+    /// callback for the client which fails the requests left unanswered.
+    void clientDisconnected();
+
+    /// callback for the client which fails the requests left unanswered when the connection failed.
+    void clientError();
+
+    /// callback for the client which retrieve the replies from the server
+    void processReplies();
+
+    /// callback for the server which accepts a new connection.
+    void acceptConnection();
+
+    /// callback for the server which receive requests to be processed
+    void processRequests();
+
+    /// callback for the server which forgets a closed connection.
+    void connectionClosed();
+
+private:
+    enum FrameType {
+        RequestFrame = 1,
+        ReplyFrame = 2
+    };
+
+    /// connect the client if its connection is closed.
+    void connectClient();
+
+    /// return true if the client is connected.
+    bool isClientConnected() const;
+
+    /// destroy the client instance.
+    void stopClient();
+
+    /// stop and destroy the server instance.
+    void stopServer();
+
+    /// wrap the batched requests into a frame.
+    QByteArray takeFrame();
+
+    /// notify the failure of the requests written or waiting for the connection.
+    void failRequests();
+
+    /// remove the complete frames from the start of the buffer, returning false if a frame is too large.
+    static bool takeFrames(QByteArray &buffer, QList<QByteArray> &frames);
+
+    /// notify the local event bus of a request received by the server, returning true if it was dispatched.
+    bool dispatchRequest(const QString &topic, const QList<QVariantList> &arguments);
+
+    QTcpSocket *m_TcpSocket; ///< client connection over TCP
+    QLocalSocket *m_LocalSocket; ///< client connection over a local socket
+    QIODevice *m_Socket; ///< the client connection in use
+    QString m_Host; ///< host name, or local server name, of the server
+    unsigned int m_Port; ///< port of the server, 0 for a local server
+
+    QTcpServer *m_TcpServer; ///< server listening on a TCP port
+    QLocalServer *m_LocalServer; ///< server listening as a local server
+    unsigned int m_ServerPort; ///< port to listen on
+    QString m_ServerName; ///< local server name to listen on
+    QHash<QIODevice *, QByteArray> m_Connections; ///< partial frames received by the server, by connection
+
+    QByteArray m_Buffer; ///< partial frames received by the client
+    QByteArray m_Unsent; ///< frames written while the client is connecting
+    QByteArray m_Batch; ///< requests not written yet
+    int m_BatchCount; ///< number of requests not written yet
+    int m_BatchSize; ///< maximum number of requests per frame
+    QTimer *m_FlushTimer; ///< writes the batch when control returns to the event loop
+    quint32 m_Sequence; ///< sequence number of the next request
+    int m_PendingRequests; ///< number of requests not answered yet
+};
+
+} //namespace ctkEventBus
+
+#endif // CTKNETWORKCONNECTORBINARY_H